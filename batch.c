@@ -0,0 +1,333 @@
+/*
+* Fichier : batch.c
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Implémente le mode non interactif. La chaîne est analysée une fois, les fichiers passent par le
+ *           pipeline lecture -> calcul -> écriture et chaque thread de calcul garde ses tampons de
+ *           convolution d'un fichier à l'autre.
+ */
+
+#include "batch.h"
+#include "bmp_io.h"
+#include "bmp_file.h"
+#include "chain.h"
+#include "cache.h"
+#include "pipeline.h"
+#include "threadpool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+void batch_usage(const char *programme) {
+    printf("Usage : %s --in <fichier.bmp|dossier> --out <dossier> --chain <filtres>\n", programme);
+    printf("         [--jobs N] [--readers N] [--writers N] [--budget Mo] [--io-block Ko] [--scale 1|2|4|8]\n");
+    printf("Filtres (séparés par des virgules) : negative, brightness:N, grayscale, threshold:N, equalize,\n");
+    printf("                                     box, gaussian, outline, emboss, sharpen,\n");
+    printf("                                     rotate90, rotate180, rotate270, fliph, flipv, transpose, transverse\n");
+    printf("Suffixe @LxH+X+Y : filtre limité à un rectangle, par exemple gaussian@200x100+40+60\n");
+    printf("--jobs : threads de calcul (défaut : nombre de cœurs) ; --readers / --writers : threads d'E/S (défaut : 1)\n");
+    printf("--budget : mémoire maximale des images en cours de traitement, en Mo (défaut : 512, 0 : illimité)\n");
+    printf("--io-block : taille des blocs lus ou écrits en un appel, en Ko (défaut : 8192)\n");
+    printf("--scale : réduction 1/2, 1/4 ou 1/8 par moyenne, appliquée pendant la lecture (miniatures)\n");
+    printf("--cache : dossier d'un cache de résultats (mêmes pixels et même chaîne, ou même début de chaîne :\n");
+    printf("          résultat relu au lieu d'être recalculé) ; --cache-size : sa taille maximale en Mo (défaut : 1024)\n");
+    printf("Sans argument, le programme démarre le menu interactif ; avec --lazy seul, le menu diffère les filtres\n");
+    printf("et les applique ensemble (opérations ponctuelles fusionnées) avant la sauvegarde ou l'affichage.\n");
+    printf("Avec --proxy <apercu.bmp>, chaque filtre est en plus appliqué aussitôt à une copie réduite (aperçu).\n");
+}
+
+// Entier d'option dans [min, max] ; renvoie 0 si succès, -1 sinon (message affiché)
+static int lire_entier_option(const char *option, const char *valeur, long min, long max, int *resultat) {
+    char *fin;
+    long n = strtol(valeur, &fin, 10);
+    if (*valeur == '\0' || *fin != '\0' || n < min || n > max) {
+        printf("Erreur : %s attend un entier entre %ld et %ld.\n", option, min, max);
+        return -1;
+    }
+    *resultat = (int)n;
+    return 0;
+}
+
+int batch_parseArgs(int argc, char **argv, t_batch_options *options) {
+    options->input = NULL;
+    options->output = NULL;
+    options->chain = NULL;
+    options->jobs = 0;
+    options->readers = 1;
+    options->writers = 1;
+    options->budget = (size_t)512 << 20;
+    options->ioBlock = 0;
+    options->scale = 1;
+    options->cache = NULL;
+    options->cacheSize = CACHE_SIZE_DEFAULT;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            batch_usage(argv[0]);
+            return -1;
+        }
+        if (i + 1 >= argc) {
+            printf("Erreur : valeur manquante après %s.\n", arg);
+            batch_usage(argv[0]);
+            return -1;
+        }
+        const char *valeur = argv[++i];
+        if (strcmp(arg, "--in") == 0) {
+            options->input = valeur;
+        } else if (strcmp(arg, "--out") == 0) {
+            options->output = valeur;
+        } else if (strcmp(arg, "--chain") == 0) {
+            options->chain = valeur;
+        } else if (strcmp(arg, "--jobs") == 0) {
+            if (lire_entier_option(arg, valeur, 0, 1024, &options->jobs) != 0) return -1;
+        } else if (strcmp(arg, "--readers") == 0) {
+            if (lire_entier_option(arg, valeur, 1, 64, &options->readers) != 0) return -1;
+        } else if (strcmp(arg, "--writers") == 0) {
+            if (lire_entier_option(arg, valeur, 1, 64, &options->writers) != 0) return -1;
+        } else if (strcmp(arg, "--budget") == 0) {
+            int mo;
+            if (lire_entier_option(arg, valeur, 0, 1 << 20, &mo) != 0) return -1;
+            options->budget = (size_t)mo << 20;
+        } else if (strcmp(arg, "--io-block") == 0) {
+            int ko;
+            if (lire_entier_option(arg, valeur, 4, 1 << 20, &ko) != 0) return -1;
+            options->ioBlock = (size_t)ko << 10;
+        } else if (strcmp(arg, "--cache") == 0) {
+            options->cache = valeur;
+        } else if (strcmp(arg, "--cache-size") == 0) {
+            int mo;
+            if (lire_entier_option(arg, valeur, 0, 1 << 24, &mo) != 0) return -1;
+            options->cacheSize = (size_t)mo << 20;
+        } else if (strcmp(arg, "--scale") == 0) {
+            if (lire_entier_option(arg, valeur, 1, 8, &options->scale) != 0) return -1;
+            if ((options->scale & (options->scale - 1)) != 0) {
+                printf("Erreur : --scale attend 1, 2, 4 ou 8.\n");
+                return -1;
+            }
+        } else {
+            printf("Erreur : option inconnue %s.\n", arg);
+            batch_usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (options->input == NULL || options->output == NULL || options->chain == NULL) {
+        printf("Erreur : --in, --out et --chain sont obligatoires.\n");
+        batch_usage(argv[0]);
+        return -1;
+    }
+    return 0;
+}
+
+// Vrai si le nom se termine par .bmp (sans tenir compte de la casse)
+static int est_bmp(const char *nom) {
+    size_t n = strlen(nom);
+    if (n < 4) {
+        return 0;
+    }
+    const char *ext = nom + n - 4;
+    return ext[0] == '.' && tolower((unsigned char)ext[1]) == 'b' &&
+           tolower((unsigned char)ext[2]) == 'm' && tolower((unsigned char)ext[3]) == 'p';
+}
+
+static int est_dossier(const char *chemin) {
+    struct stat st;
+    return stat(chemin, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+static char *joindre(const char *dossier, const char *nom) {
+    size_t n = strlen(dossier);
+    int separateur = n > 0 && dossier[n - 1] != '/' && dossier[n - 1] != '\\';
+    char *chemin = malloc(n + separateur + strlen(nom) + 1);
+    if (chemin != NULL) {
+        sprintf(chemin, "%s%s%s", dossier, separateur ? "/" : "", nom);
+    }
+    return chemin;
+}
+
+// Nom de fichier sans le dossier
+static const char *nom_de_base(const char *chemin) {
+    const char *nom = chemin;
+    for (const char *c = chemin; *c != '\0'; c++) {
+        if (*c == '/' || *c == '\\') {
+            nom = c + 1;
+        }
+    }
+    return nom;
+}
+
+static int comparer_noms(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// Liste des fichiers BMP à traiter (triée) ; renvoie le nombre de fichiers ou -1
+static int lister_entrees(const char *entree, char ***fichiers) {
+    *fichiers = NULL;
+
+    if (!est_dossier(entree)) {
+        *fichiers = malloc(sizeof(char *));
+        if (*fichiers == NULL || ((*fichiers)[0] = joindre("", entree)) == NULL) {
+            free(*fichiers);
+            *fichiers = NULL;
+            return -1;
+        }
+        return 1;
+    }
+
+    DIR *dir = opendir(entree);
+    if (dir == NULL) {
+        printf("Erreur : impossible d'ouvrir le dossier %s.\n", entree);
+        return -1;
+    }
+
+    int nb = 0;
+    int capacite = 0;
+    struct dirent *e;
+    while ((e = readdir(dir)) != NULL) {
+        if (!est_bmp(e->d_name)) {
+            continue;
+        }
+        char *chemin = joindre(entree, e->d_name);
+        if (chemin == NULL || est_dossier(chemin)) {
+            free(chemin);
+            continue;
+        }
+        if (nb == capacite) {
+            capacite = capacite > 0 ? capacite * 2 : 64;
+            char **agrandi = realloc(*fichiers, sizeof(char *) * capacite);
+            if (agrandi == NULL) {
+                free(chemin);
+                break;
+            }
+            *fichiers = agrandi;
+        }
+        (*fichiers)[nb++] = chemin;
+    }
+    closedir(dir);
+
+    if (nb > 1) {
+        qsort(*fichiers, nb, sizeof(char *), comparer_noms);
+    }
+    return nb;
+}
+
+static double maintenant_ms(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// Compte rendu d'une image, appelé par le pipeline depuis le thread qui l'a terminée
+static void rapporter(const t_pipeline_job *job, void *user) {
+    (void)user;
+    if (job->ok && job->reused > 0) {
+        printf("[OK] %s -> %s (%.1f ms, %d opération(s) relue(s) du cache)\n", job->input, job->output, job->ms,
+               job->reused);
+    } else if (job->ok) {
+        printf("[OK] %s -> %s (%.1f ms)\n", job->input, job->output, job->ms);
+    } else {
+        printf("[ECHEC] %s : étape %s (%s)\n", job->input, job->error, bmp_strerror(job->status));
+    }
+}
+
+int batch_run(const t_batch_options *options) {
+    t_bmp_status status;
+    char message[128];
+    t_chain *chain = chain_parse(options->chain, &status, message, sizeof(message));
+    if (chain == NULL) {
+        printf("Erreur : %s.\n", message[0] != '\0' ? message : bmp_strerror(status));
+        return -1;
+    }
+
+    if (bmp_makeDirectory(options->output) != 0) {
+        printf("Erreur : impossible de créer le dossier de sortie %s.\n", options->output);
+        chain_free(chain);
+        return -1;
+    }
+
+    char **fichiers;
+    int nb = lister_entrees(options->input, &fichiers);
+    if (nb <= 0) {
+        if (nb == 0) {
+            printf("Aucun fichier BMP trouvé dans %s.\n", options->input);
+        }
+        chain_free(chain);
+        return nb == 0 ? 0 : -1;
+    }
+
+    bmp_setIoBlockSize(options->ioBlock);
+
+    t_result_cache *cache = NULL;
+    if (options->cache != NULL) {
+        cache = cache_open(options->cache, options->cacheSize, &status);
+        if (cache == NULL) {
+            // Le traitement reste possible sans cache
+            printf("Attention : cache %s indisponible (%s), traitement sans cache.\n", options->cache,
+                   bmp_strerror(status));
+        }
+    }
+
+    t_pipeline_config config;
+    pipeline_defaultConfig(&config);
+    config.workers = options->jobs > 0 ? options->jobs : threadpool_cpuCount();
+    config.readers = options->readers;
+    config.writers = options->writers;
+    config.queueCapacity = 2 * config.workers;
+    config.memoryBudget = options->budget;
+    config.decodeScale = options->scale;
+    config.onDone = rapporter;
+    config.cache = cache;
+
+    // Un seul fichier : les threads de calcul, inoccupés pendant la lecture, découpent son chargement
+    if (nb == 1) config.decodeThreads = config.workers;
+
+    // Pas plus de threads par étage que de fichiers
+    if (config.workers > nb) config.workers = nb;
+    if (config.readers > nb) config.readers = nb;
+    if (config.writers > nb) config.writers = nb;
+
+    t_pipeline_job *jobs = calloc(nb, sizeof(t_pipeline_job));
+    int echecs = jobs != NULL ? 0 : -1;
+    for (int i = 0; i < nb && echecs == 0; i++) {
+        jobs[i].input = fichiers[i];
+        jobs[i].output = joindre(options->output, nom_de_base(fichiers[i]));
+        if (jobs[i].output == NULL) {
+            echecs = -1;
+        }
+    }
+
+    double debut = maintenant_ms();
+    if (echecs == 0) {
+        char forme[256];
+        chain_format(chain, forme, sizeof(forme));
+        printf("Traitement de %d fichier(s) : %d lecteur(s), %d thread(s) de calcul, %d écrivain(s) : %s\n",
+               nb, config.readers, config.workers, config.writers, forme);
+        echecs = pipeline_run(&config, chain, jobs, nb);
+    }
+    if (echecs < 0) {
+        printf("Erreur : initialisation du traitement par lot impossible.\n");
+    } else {
+        printf("Terminé : %d réussi(s), %d échec(s) en %.1f ms\n", nb - echecs, echecs, maintenant_ms() - debut);
+    }
+    if (cache != NULL) {
+        t_cache_stats stats;
+        cache_getStats(cache, &stats);
+        printf("Cache : %ld relu(s), %ld repris d'un préfixe, %ld calculé(s) ; %d entrée(s), %.1f Mo, "
+               "%ld supprimée(s)\n", stats.hits, stats.partialHits, stats.misses, stats.entries,
+               stats.bytes / 1048576.0, stats.evictions);
+        cache_close(cache);
+    }
+
+    for (int i = 0; i < nb; i++) {
+        if (jobs != NULL) free((char *)jobs[i].output);
+        free(fichiers[i]);
+    }
+    free(jobs);
+    free(fichiers);
+    chain_free(chain);
+    return echecs;
+}
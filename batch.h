@@ -0,0 +1,37 @@
+/*
+* Fichier : batch.h
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Mode non interactif : applique une chaîne de filtres à un fichier ou à tous les BMP d'un
+ *           dossier, dans un seul processus, lectures, calculs et écritures se recouvrant (voir pipeline.h).
+ *           Exemple : iprocess --in images/ --out sortie/ --chain "gaussian,sharpen,brightness:20" --jobs 4
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stddef.h>
+
+typedef struct {
+    const char *input;      // fichier BMP ou dossier
+    const char *output;     // dossier de sortie (créé si besoin)
+    const char *chain;      // chaîne de filtres (voir chain.h)
+    int jobs;               // threads de calcul, 0 : nombre de cœurs
+    int readers;            // threads de lecture
+    int writers;            // threads d'écriture
+    size_t budget;          // octets d'images décodées en vol (0 : illimité)
+    size_t ioBlock;         // taille des blocs d'entrée/sortie en octets (0 : défaut)
+    int scale;              // réduction au chargement : 1, 2, 4 ou 8
+    const char *cache;      // dossier du cache de résultats (NULL : sans cache, voir cache.h)
+    size_t cacheSize;       // taille maximale du cache en octets (0 : illimitée)
+} t_batch_options;
+
+// Analyse des arguments de la ligne de commande ; renvoie 0 si succès, -1 sinon (usage affiché)
+int batch_parseArgs(int argc, char **argv, t_batch_options *options);
+
+// Affiche l'aide du mode non interactif
+void batch_usage(const char *programme);
+
+// Exécute le traitement ; renvoie le nombre d'images en échec, ou -1 si rien n'a pu être lancé
+int batch_run(const t_batch_options *options);
+
+#endif // BATCH_H
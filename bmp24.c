@@ -4,35 +4,40 @@
 
 
 #include "bmp24.h"
+#include "kernels.h"
+#include "bmp_size.h"
+#include "bmp_file.h"
+#include "threadpool.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>   // pour round()
+#include <errno.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 
 // --- Fonctions d'allocation ---
 
 // Allocation d'un tableau 2D de pixels
 t_pixel **bmp24_allocateDataPixels(int width, int height) {
     if (width <= 0 || height <= 0) {
-        printf("Erreur : dimensions invalides (%d x %d).\n", width, height);
         return NULL;
     }
 
-    t_pixel **pixels = malloc(height * sizeof(t_pixel *));
+    t_pixel **pixels = malloc((size_t)height * sizeof(t_pixel *));
     if (pixels == NULL) {
-        printf("Erreur d'allocation : lignes de pixels.\n");
         return NULL;
     }
 
     for (int i = 0; i < height; i++) {
-        pixels[i] = malloc(width * sizeof(t_pixel));
+        pixels[i] = malloc((size_t)width * sizeof(t_pixel));
         if (pixels[i] == NULL) {
             // Libérer les lignes déjà allouées en cas d'échec
             for (int j = 0; j < i; j++) {
                 free(pixels[j]);
             }
             free(pixels);
-            printf("Erreur d'allocation : ligne %d.\n", i);
             return NULL;
         }
     }
@@ -54,17 +59,18 @@ void bmp24_freeDataPixels(t_pixel **pixels, int height) {
 
 // Allocation d'une structure t_bmp24 complète
 t_bmp24 *bmp24_allocate(int width, int height, int colorDepth) {
-    if (width <= 0 || height <= 0 || colorDepth != 24) {
-        printf("Erreur : paramètres invalides (w=%d, h=%d, depth=%d).\n", width, height, colorDepth);
+    if (width <= 0 || height <= 0 || (colorDepth != 24 && colorDepth != 32)) {
         return NULL;
     }
 
     t_bmp24 *img = malloc(sizeof(t_bmp24));
     if (img == NULL) {
-        printf("Erreur d'allocation de t_bmp24.\n");
         return NULL;
     }
 
+    // En-têtes à zéro : compression BI_RGB par défaut pour les images créées en mémoire
+    memset(&img->header, 0, sizeof(img->header));
+    memset(&img->header_info, 0, sizeof(img->header_info));
     img->width = width;
     img->height = height;
     img->colorDepth = colorDepth;
@@ -90,63 +96,324 @@ void bmp24_free(t_bmp24 *img) {
 
 // --- Fonctions de base ---
 
-// Chargement d'une image BMP 24 bits (CORRIGÉ)
-t_bmp24 *bmp24_loadImage(const char *filename) {
+// Conversion d'une ligne entre deux formats entrelacés (3 ou 4 octets par pixel) avec échange R/B :
+// sert dans les deux sens (fichier BGR(A) -> t_pixel RGB(A) et t_pixel -> fichier)
+static void convertir_ligne(uint8_t *dst, int dstBytes, const uint8_t *src, int srcBytes, int width) {
+    const t_kernels *k = kernels_get();
+    if (srcBytes == 3 && dstBytes == 3) {
+        k->swapRB(dst, src, width);
+    } else if (srcBytes == 4 && dstBytes == 4) {
+        k->swapRB4(dst, src, width);
+    } else if (srcBytes == 3) {
+        k->swapRB3to4(dst, src, width);
+    } else {
+        k->swapRB4to3(dst, src, width);
+    }
+}
+
+// Position et largeur d'un masque de bits (0 si masque vide)
+static void analyser_masque(uint32_t mask, int *shift, int *bits) {
+    *shift = 0;
+    *bits = 0;
+    if (mask == 0) return;
+    while (((mask >> *shift) & 1) == 0) (*shift)++;
+    while (*shift + *bits < 32 && ((mask >> (*shift + *bits)) & 1)) (*bits)++;
+}
+
+// Extraction d'un canal selon son masque, ramené sur 8 bits
+static uint8_t extraire_canal(uint32_t v, uint32_t mask, int shift, int bits, uint8_t defaut) {
+    if (mask == 0) return defaut;
+    uint64_t val = (v & mask) >> shift;
+    if (bits == 8) return (uint8_t)val;
+    uint64_t max = (1ULL << bits) - 1;
+    return (uint8_t)((val * 255 + max / 2) / max);
+}
+
+// Conversion d'une ligne BI_BITFIELDS dont les masques ne sont pas les masques standard
+static void convertir_ligne_masques(t_pixel *dst, const uint8_t *src, int width, const uint32_t masks[4]) {
+    int shift[4], bits[4];
+    for (int c = 0; c < 4; c++) {
+        analyser_masque(masks[c], &shift[c], &bits[c]);
+    }
+    for (int j = 0; j < width; j++) {
+        uint32_t v = (uint32_t)src[4 * j] | ((uint32_t)src[4 * j + 1] << 8) |
+                     ((uint32_t)src[4 * j + 2] << 16) | ((uint32_t)src[4 * j + 3] << 24);
+        dst[j].red   = extraire_canal(v, masks[0], shift[0], bits[0], 0);
+        dst[j].green = extraire_canal(v, masks[1], shift[1], bits[1], 0);
+        dst[j].blue  = extraire_canal(v, masks[2], shift[2], bits[2], 0);
+#ifdef BMP24_PIXEL32
+        dst[j].alpha = extraire_canal(v, masks[3], shift[3], bits[3], 255);
+#endif
+    }
+}
+
+// Ouverture et lecture des en-têtes (14 + 40 octets) ; renvoie NULL si le fichier n'est pas un BMP lisible
+static FILE *ouvrir(const char *filename, t_bmp_header *header, t_bmp_info *info, t_bmp_status *status) {
     if (filename == NULL) {
-        printf("Erreur : nom de fichier invalide.\n");
+        bmp_setStatus(status, BMP_ERR_ARGUMENT);
         return NULL;
     }
 
     FILE *f = fopen(filename, "rb");
     if (f == NULL) {
-        printf("Erreur : impossible d'ouvrir %s\n", filename);
+        bmp_setStatus(status, BMP_ERR_OPEN);
         return NULL;
     }
 
     // Lire l'en-tête de fichier BMP (14 octets)
-    t_bmp_header header;
-    if (fread(&header, sizeof(t_bmp_header), 1, f) != 1) {
-        printf("Erreur : impossible de lire l'en-tête BMP.\n");
+    if (fread(header, sizeof(t_bmp_header), 1, f) != 1) {
+        bmp_setStatus(status, BMP_ERR_READ);
         fclose(f);
         return NULL;
     }
 
     // Vérifier la signature BMP
-    if (header.type != BMP_TYPE) {
-        printf("Erreur : le fichier n'est pas un BMP valide (type = 0x%X, attendu 0x%X).\n",
-               header.type, BMP_TYPE);
+    if (header->type != BMP_TYPE) {
+        bmp_setStatus(status, BMP_ERR_FORMAT);
         fclose(f);
         return NULL;
     }
 
     // Lire l'en-tête d'information (40 octets)
-    t_bmp_info info;
-    if (fread(&info, sizeof(t_bmp_info), 1, f) != 1) {
-        printf("Erreur : impossible de lire les informations BMP.\n");
+    if (fread(info, sizeof(t_bmp_info), 1, f) != 1) {
+        bmp_setStatus(status, BMP_ERR_READ);
         fclose(f);
         return NULL;
     }
 
-    // Vérifier que c'est bien du 24 bits
-    if (info.bits != 24) {
-        printf("Erreur : l'image n'est pas en 24 bits (bits = %d).\n", info.bits);
-        fclose(f);
+    return f;
+}
+
+// Chargement d'une image BMP 24 bits ou 32 bits (BI_RGB ou BI_BITFIELDS)
+t_bmp24 *bmp24_loadImage(const char *filename, t_bmp_status *status) {
+    return bmp24_loadImageParallel(filename, 1, status);
+}
+
+t_bmp24 *bmp24_loadImageParallel(const char *filename, int threads, t_bmp_status *status) {
+    t_bmp_header header;
+    t_bmp_info info;
+    FILE *f = ouvrir(filename, &header, &info, status);
+    if (f == NULL) {
         return NULL;
     }
+    t_bmp24 *img = bmp24_readFromFileParallel(f, &header, &info, threads, status);
+    fclose(f);
+    return img;
+}
+
+t_bmp24 *bmp24_loadImageScaled(const char *filename, int scale, t_bmp_status *status) {
+    t_bmp_header header;
+    t_bmp_info info;
+    FILE *f = ouvrir(filename, &header, &info, status);
+    if (f == NULL) {
+        return NULL;
+    }
+    t_bmp24 *img = bmp24_readFromFileScaled(f, &header, &info, scale, status);
+    fclose(f);
+    return img;
+}
+
+
+// Vérification de la profondeur, de la compression et des dimensions
+t_bmp_status bmp24_parseFormat(const t_bmp_info *info, t_bmp24_format *fmt) {
+    // Vérifier que c'est bien du 24 ou du 32 bits
+    if (info->bits != 24 && info->bits != 32) {
+        return BMP_ERR_UNSUPPORTED;
+    }
+
+    // Compressions acceptées : BI_RGB, et BI_BITFIELDS pour le 32 bits
+    fmt->bitfields = (info->compression == BI_BITFIELDS || info->compression == BI_ALPHABITFIELDS);
+    if (info->compression != BI_RGB && !(fmt->bitfields && info->bits == 32)) {
+        return BMP_ERR_UNSUPPORTED;
+    }
+
+    // Masques de couleur : dans l'en-tête étendu (V2 et suivants) ou juste après les 40 octets
+    fmt->masks[0] = BMP_MASK_RED;
+    fmt->masks[1] = BMP_MASK_GREEN;
+    fmt->masks[2] = BMP_MASK_BLUE;
+    fmt->masks[3] = BMP_MASK_ALPHA;
+    fmt->nbMasks = 0;
+    if (fmt->bitfields) {
+        fmt->nbMasks = (info->size >= 56 || info->compression == BI_ALPHABITFIELDS) ? 4 : 3;
+        fmt->masks[3] = 0;
+    }
+
+    // Récupérer les dimensions (INT32_MIN n'a pas de valeur absolue représentable)
+    if (info->width <= 0 || info->height == 0 || info->height == INT32_MIN) {
+        return BMP_ERR_DIMENSIONS;
+    }
+    fmt->width = info->width;
+    fmt->height = abs(info->height);  // Utiliser abs() pour gérer les hauteurs négatives
+    fmt->topDown = (info->height < 0);
+
+    // Taille d'une ligne avec padding (multiple de 4), calculée en 64 bits
+    fmt->bytesPerPixel = info->bits / 8;
+    if (!bmp_rowSize(fmt->width, info->bits, &fmt->rowSize) ||
+        !bmp_imageSize(fmt->width, fmt->height, info->bits, &fmt->imageSize)) {
+        return BMP_ERR_TOO_LARGE;
+    }
+    return BMP_OK;
+}
+
+// Conversion d'une ligne du fichier (BGR(A) ou masques) en pixels
+void bmp24_decodeRow(const t_bmp24_format *fmt, const uint8_t *line, t_pixel *dst) {
+    bool masquesStandard = (fmt->masks[0] == BMP_MASK_RED && fmt->masks[1] == BMP_MASK_GREEN &&
+                            fmt->masks[2] == BMP_MASK_BLUE);
+
+    // Copier les pixels (format BGR(A) vers RGB(A))
+    if (masquesStandard) {
+        convertir_ligne((uint8_t *)dst, sizeof(t_pixel), line, fmt->bytesPerPixel, fmt->width);
+#ifdef BMP24_PIXEL32
+        // BI_BITFIELDS sans masque alpha : le quatrième octet n'a pas de sens, pixel opaque
+        if (fmt->bitfields && fmt->masks[3] != BMP_MASK_ALPHA) {
+            for (int j = 0; j < fmt->width; j++) {
+                dst[j].alpha = 255;
+            }
+        }
+#endif
+    } else {
+        convertir_ligne_masques(dst, line, fmt->width, fmt->masks);
+    }
+}
+
+// Conversion de la i-ème ligne du fichier vers la ligne correspondante de l'image
+static void decoder_ligne(t_bmp24 *img, const t_bmp24_format *fmt, int i, const uint8_t *line) {
+    // Les BMP sont stockés du bas vers le haut par défaut (sauf si hauteur négative)
+    int destRow = fmt->topDown ? i : (fmt->height - 1 - i);
+    bmp24_decodeRow(fmt, line, img->data[destRow]);
+}
+
+void bmp24_encodeRow(const t_pixel *src, int width, int bits, uint8_t *line, size_t rowSize) {
+    size_t utile = (size_t)width * (bits / 8);
+    convertir_ligne(line, bits / 8, (const uint8_t *)src, sizeof(t_pixel), width);
+    memset(line + utile, 0, rowSize - utile);
+}
+
+// Lecture séquentielle des pixels par blocs de plusieurs lignes, décodées ensuite depuis le tampon
+static t_bmp_status lire_sequentiel(FILE *f, t_bmp24 *img, const t_bmp24_format *fmt, uint32_t offset) {
+    // Se positionner au début des données
+    if (fseek(f, offset, SEEK_SET) != 0) {
+        return BMP_ERR_READ;
+    }
+
+    size_t parBloc = bmp_rowsPerBlock(fmt->rowSize, (size_t)fmt->height);
+    unsigned char *bloc = malloc(parBloc * fmt->rowSize);
+    if (bloc == NULL) {
+        return BMP_ERR_MEMORY;
+    }
 
-    // Récupérer les dimensions
-    int width = info.width;
-    int height = abs(info.height);  // Utiliser abs() pour gérer les hauteurs négatives
-    bool topDown = (info.height < 0);
+    t_bmp_status res = BMP_OK;
+    for (int i = 0; i < fmt->height && res == BMP_OK; ) {
+        int n = fmt->height - i < (int)parBloc ? fmt->height - i : (int)parBloc;
+        if (!bmp_readFully(f, bloc, (size_t)n * fmt->rowSize)) {
+            res = BMP_ERR_READ;
+            break;
+        }
+        for (int k = 0; k < n; k++) {
+            decoder_ligne(img, fmt, i + k, bloc + (size_t)k * fmt->rowSize);
+        }
+        i += n;
+    }
+
+    free(bloc);
+    return res;
+}
+
+#ifndef _WIN32
+// Lecture partagée par les threads, chacun lisant ses lignes avec pread, sans position partagée
+typedef struct {
+    t_bmp24 *img;
+    const t_bmp24_format *fmt;
+    int fd;
+    off_t offset;           // début des pixels dans le fichier
+} t_lecture24;
+
+// Lit exactement size octets à la position offset ; renvoie false si les données sont tronquées
+static bool lire_position(int fd, unsigned char *dst, size_t size, off_t offset) {
+    while (size > 0) {
+        ssize_t n = pread(fd, dst, size, offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        dst += n;
+        size -= (size_t)n;
+        offset += n;
+    }
+    return true;
+}
+
+// Tranche de lignes du fichier [debut, fin) (voir threadpool_split)
+static int lire_tranche(void *arg, int debut, int fin) {
+    const t_lecture24 *t = arg;
+    const t_bmp24_format *fmt = t->fmt;
+    size_t parBloc = bmp_rowsPerBlock(fmt->rowSize, (size_t)(fin - debut));
+    unsigned char *bloc = malloc(parBloc * fmt->rowSize);
+    if (bloc == NULL) {
+        return BMP_ERR_MEMORY;
+    }
+
+    t_bmp_status res = BMP_OK;
+    for (int i = debut; i < fin; ) {
+        int n = fin - i < (int)parBloc ? fin - i : (int)parBloc;
+        if (!lire_position(t->fd, bloc, (size_t)n * fmt->rowSize, t->offset + (off_t)i * (off_t)fmt->rowSize)) {
+            res = BMP_ERR_READ;
+            break;
+        }
+        // Chaque thread convertit directement dans ses propres lignes de destination
+        for (int k = 0; k < n; k++) {
+            decoder_ligne(t->img, fmt, i + k, bloc + (size_t)k * fmt->rowSize);
+        }
+        i += n;
+    }
+
+    free(bloc);
+    return res;
+}
+
+// Lecture parallèle : la zone des pixels est découpée en nbThreads tranches de lignes contiguës
+static t_bmp_status lire_parallele(FILE *f, t_bmp24 *img, const t_bmp24_format *fmt, uint32_t offset,
+                                   int nbThreads) {
+    t_lecture24 lecture = { img, fmt, fileno(f), (off_t)offset };
+    return (t_bmp_status)threadpool_split(nbThreads, fmt->height, lire_tranche, &lecture);
+}
+#endif
+
+// Lecture des masques éventuels et des pixels, les 54 octets d'en-têtes ayant déjà été lus depuis f
+t_bmp24 *bmp24_readFromFile(FILE *f, const t_bmp_header *hdr, const t_bmp_info *inf, t_bmp_status *status) {
+    return bmp24_readFromFileParallel(f, hdr, inf, 1, status);
+}
+
+// Format des pixels et masques éventuels, qui suivent l'en-tête d'information dans le fichier
+static t_bmp_status lire_format(FILE *f, const t_bmp_info *info, t_bmp24_format *fmt) {
+    t_bmp_status res = bmp24_parseFormat(info, fmt);
+    if (res != BMP_OK) {
+        return res;
+    }
+    if (fmt->nbMasks > 0 && fread(fmt->masks, sizeof(uint32_t), fmt->nbMasks, f) != (size_t)fmt->nbMasks) {
+        return BMP_ERR_READ;
+    }
+    return BMP_OK;
+}
 
-    printf("Debug: Dimensions lues - largeur: %d, hauteur: %d (original: %d)\n",
-           width, height, info.height);
-    printf("Debug: Offset des données: %u\n", header.offset);
+t_bmp24 *bmp24_readFromFileParallel(FILE *f, const t_bmp_header *hdr, const t_bmp_info *inf, int threads,
+                                    t_bmp_status *status) {
+    t_bmp_header header = *hdr;
+    t_bmp_info info = *inf;
+
+    t_bmp24_format fmt;
+    t_bmp_status res = lire_format(f, &info, &fmt);
+    if (res != BMP_OK) {
+        bmp_setStatus(status, res);
+        return NULL;
+    }
 
     // Allouer la structure complète
-    t_bmp24 *img = bmp24_allocate(width, height, 24);
+    t_bmp24 *img = bmp24_allocate(fmt.width, fmt.height, info.bits);
     if (img == NULL) {
-        fclose(f);
+        bmp_setStatus(status, BMP_ERR_MEMORY);
         return NULL;
     }
 
@@ -154,137 +421,352 @@ t_bmp24 *bmp24_loadImage(const char *filename) {
     img->header = header;
     img->header_info = info;
 
-    // Se positionner au début des données
-    if (fseek(f, header.offset, SEEK_SET) != 0) {
-        printf("Erreur : impossible de se positionner aux données (offset %u).\n", header.offset);
+    // Un thread par tranche d'au moins BMP24_PARALLEL_MIN octets ; en dessous, la lecture reste séquentielle
+    if (threads <= 0) {
+        threads = threadpool_cpuCount();
+    }
+    size_t maxThreads = fmt.imageSize / BMP24_PARALLEL_MIN;
+    if ((size_t)threads > maxThreads) {
+        threads = maxThreads == 0 ? 1 : (int)maxThreads;
+    }
+    if (threads > fmt.height) {
+        threads = fmt.height;
+    }
+
+#ifndef _WIN32
+    if (threads > 1) {
+        res = lire_parallele(f, img, &fmt, header.offset, threads);
+    } else
+#endif
+    {
+        res = lire_sequentiel(f, img, &fmt, header.offset);
+    }
+
+    if (res != BMP_OK) {
+        bmp_setStatus(status, res);
         bmp24_free(img);
-        fclose(f);
         return NULL;
     }
+    bmp_setStatus(status, BMP_OK);
+    return img;
+}
 
-    // Calcul de la taille d'une ligne avec padding (multiple de 4)
-    int bytesPerPixel = 3;
-    int rowSize = ((width * bytesPerPixel + 3) / 4) * 4;
-    printf("Debug: Taille de ligne avec padding: %d octets\n", rowSize);
+// Moyenne arrondie d'une somme de n valeurs
+static inline uint8_t moyenne(uint32_t somme, uint32_t n) {
+    return (uint8_t)((somme + n / 2) / n);
+}
 
-    unsigned char *line = malloc(rowSize);
-    if (line == NULL) {
-        bmp24_free(img);
-        fclose(f);
-        printf("Erreur : allocation ligne temporaire.\n");
+t_bmp24 *bmp24_readFromFileScaled(FILE *f, const t_bmp_header *hdr, const t_bmp_info *inf, int scale,
+                                  t_bmp_status *status) {
+    if (scale == 1) {
+        return bmp24_readFromFile(f, hdr, inf, status);
+    }
+    if (scale != 2 && scale != 4 && scale != 8) {
+        bmp_setStatus(status, BMP_ERR_ARGUMENT);
         return NULL;
     }
+    int decalage = scale == 2 ? 1 : (scale == 4 ? 2 : 3);
 
-    // Lecture des données pixels
-    // Les BMP sont stockés du bas vers le haut par défaut (sauf si hauteur négative)
-    for (int i = 0; i < height; i++) {
-        size_t bytesRead = fread(line, 1, rowSize, f);
-        if (bytesRead != rowSize) {
-            printf("Erreur : lecture incomplète ligne %d (%zu octets lus sur %d attendus).\n",
-                   i, bytesRead, rowSize);
-            free(line);
-            bmp24_free(img);
-            fclose(f);
-            return NULL;
-        }
+    t_bmp24_format fmt;
+    t_bmp_status res = lire_format(f, inf, &fmt);
+    if (res != BMP_OK) {
+        bmp_setStatus(status, res);
+        return NULL;
+    }
 
-        // Déterminer la ligne de destination
-        int destRow = topDown ? i : (height - 1 - i);
+    // Dimensions réduites, arrondies au-dessus : les blocs du bord droit et du dernier groupe de lignes
+    // sont moyennés sur les pixels présents
+    int width = (fmt.width + scale - 1) / scale;
+    int height = (fmt.height + scale - 1) / scale;
+    t_bmp24 *img = bmp24_allocate(width, height, inf->bits);
+    if (img == NULL) {
+        bmp_setStatus(status, BMP_ERR_MEMORY);
+        return NULL;
+    }
+    img->header = *hdr;
+    img->header_info = *inf;
+    img->header_info.width = width;
+    img->header_info.height = fmt.topDown ? -height : height;
+
+    // Un bloc de lignes du fichier, une ligne décodée et les sommes d'une ligne réduite : l'image
+    // pleine résolution n'est jamais allouée
+    size_t parBloc = bmp_rowsPerBlock(fmt.rowSize, (size_t)fmt.height);
+    unsigned char *bloc = malloc(parBloc * fmt.rowSize);
+    t_pixel *ligne = malloc((size_t)fmt.width * sizeof(t_pixel));
+    uint32_t *sommes = calloc((size_t)width * 4, sizeof(uint32_t));
+    if (bloc == NULL || ligne == NULL || sommes == NULL) {
+        res = BMP_ERR_MEMORY;
+    } else if (fseek(f, hdr->offset, SEEK_SET) != 0) {
+        res = BMP_ERR_READ;
+    }
 
-        // Copier les pixels (format BGR vers RGB)
-        for (int j = 0; j < width; j++) {
-            int pixelOffset = j * bytesPerPixel;
-            img->data[destRow][j].blue  = line[pixelOffset];
-            img->data[destRow][j].green = line[pixelOffset + 1];
-            img->data[destRow][j].red   = line[pixelOffset + 2];
+    // Les groupes de lignes partent du haut de l'image affichée : dans un fichier bottom-up, le groupe
+    // incomplet est le premier lu, d'où l'avance donnée à l'indice des lignes
+    int avance = fmt.topDown ? 0 : (scale - fmt.height % scale) % scale;
+    for (int i = 0; i < fmt.height && res == BMP_OK; ) {
+        int n = fmt.height - i < (int)parBloc ? fmt.height - i : (int)parBloc;
+        if (!bmp_readFully(f, bloc, (size_t)n * fmt.rowSize)) {
+            res = BMP_ERR_READ;
+            break;
+        }
+        for (int k = 0; k < n; k++, i++) {
+            bmp24_decodeRow(&fmt, bloc + (size_t)k * fmt.rowSize, ligne);
+            for (int x = 0; x < fmt.width; x++) {
+                uint32_t *s = sommes + (size_t)(x >> decalage) * 4;
+                s[0] += ligne[x].red;
+                s[1] += ligne[x].green;
+                s[2] += ligne[x].blue;
+#ifdef BMP24_PIXEL32
+                s[3] += ligne[x].alpha;
+#endif
+            }
+
+            // Dernière ligne d'un groupe : moyenne, puis remise à zéro des sommes
+            int j = i + avance;
+            if ((j + 1) % scale != 0 && i + 1 != fmt.height) {
+                continue;
+            }
+            int sortie = j / scale;
+            int destRow = fmt.topDown ? sortie : height - 1 - sortie;
+            uint32_t lignes = (uint32_t)(j - sortie * scale + 1 - (sortie == 0 ? avance : 0));
+            for (int x = 0; x < width; x++) {
+                uint32_t colonnes = (uint32_t)(fmt.width - x * scale < scale ? fmt.width - x * scale : scale);
+                uint32_t nb = lignes * colonnes;
+                uint32_t *s = sommes + (size_t)x * 4;
+                img->data[destRow][x].red = moyenne(s[0], nb);
+                img->data[destRow][x].green = moyenne(s[1], nb);
+                img->data[destRow][x].blue = moyenne(s[2], nb);
+#ifdef BMP24_PIXEL32
+                img->data[destRow][x].alpha = moyenne(s[3], nb);
+#endif
+            }
+            memset(sommes, 0, (size_t)width * 4 * sizeof(uint32_t));
         }
     }
 
-    free(line);
-    fclose(f);
-    printf("Image %s chargée avec succès (%dx%d, %s).\n",
-           filename, width, height, topDown ? "top-down" : "bottom-up");
+    free(bloc);
+    free(ligne);
+    free(sommes);
+    if (res != BMP_OK) {
+        bmp_setStatus(status, res);
+        bmp24_free(img);
+        return NULL;
+    }
+    bmp_setStatus(status, BMP_OK);
     return img;
 }
 
-// Sauvegarde d'une image BMP 24 bits (CORRIGÉ)
-void bmp24_saveImage(const char *filename, t_bmp24 *img) {
-    if (filename == NULL || img == NULL || img->data == NULL) {
-        printf("Erreur : paramètres invalides pour la sauvegarde.\n");
-        return;
+// Décodage depuis la mémoire : chaque ligne est convertie directement depuis le tampon
+t_bmp24 *bmp24_decode(const unsigned char *buffer, size_t size, t_bmp_status *status) {
+    if (buffer == NULL) {
+        bmp_setStatus(status, BMP_ERR_ARGUMENT);
+        return NULL;
+    }
+    if (size < HEADER_SIZE + INFO_SIZE) {
+        bmp_setStatus(status, BMP_ERR_READ);
+        return NULL;
     }
 
-    FILE *f = fopen(filename, "wb");
-    if (f == NULL) {
-        printf("Erreur : impossible de créer le fichier %s\n", filename);
-        return;
+    t_bmp_header header;
+    t_bmp_info info;
+    memcpy(&header, buffer, HEADER_SIZE);
+    memcpy(&info, buffer + HEADER_SIZE, INFO_SIZE);
+    if (header.type != BMP_TYPE) {
+        bmp_setStatus(status, BMP_ERR_FORMAT);
+        return NULL;
+    }
+
+    t_bmp24_format fmt;
+    t_bmp_status res = bmp24_parseFormat(&info, &fmt);
+    if (res != BMP_OK) {
+        bmp_setStatus(status, res);
+        return NULL;
+    }
+    if (fmt.nbMasks > 0) {
+        if (size - (HEADER_SIZE + INFO_SIZE) < fmt.nbMasks * sizeof(uint32_t)) {
+            bmp_setStatus(status, BMP_ERR_READ);
+            return NULL;
+        }
+        memcpy(fmt.masks, buffer + HEADER_SIZE + INFO_SIZE, fmt.nbMasks * sizeof(uint32_t));
+    }
+
+    if (header.offset > size || size - header.offset < fmt.imageSize) {
+        bmp_setStatus(status, BMP_ERR_READ);
+        return NULL;
+    }
+
+    t_bmp24 *img = bmp24_allocate(fmt.width, fmt.height, info.bits);
+    if (img == NULL) {
+        bmp_setStatus(status, BMP_ERR_MEMORY);
+        return NULL;
+    }
+    img->header = header;
+    img->header_info = info;
+
+    const uint8_t *pixels = buffer + header.offset;
+    for (int i = 0; i < fmt.height; i++) {
+        decoder_ligne(img, &fmt, i, pixels + (size_t)i * fmt.rowSize);
     }
+    bmp_setStatus(status, BMP_OK);
+    return img;
+}
 
+// En-têtes d'enregistrement d'une image : 24 bits, ou 32 bits si colorDepth == 32
+// (BI_BITFIELDS avec en-tête V4 si l'image a été chargée ainsi, BI_RGB sinon)
+bool bmp24_prepareHeaders(const t_bmp24 *img, bool topDown, t_bmp_header *header, t_bmp_info *info,
+                          t_bmp_v4ext *ext, size_t *rowSize, size_t *fileSize) {
     int width = img->width;
     int height = img->height;
-    int bytesPerPixel = 3;
-    int rowSize = ((width * bytesPerPixel + 3) / 4) * 4;
-    int imageSize = rowSize * height;
-    int fileSize = 54 + imageSize;  // 14 (header) + 40 (info) + données
+    int bits = (img->colorDepth == 32) ? 32 : 24;
+    bool bitfields = (bits == 32 && (img->header_info.compression == BI_BITFIELDS ||
+                                     img->header_info.compression == BI_ALPHABITFIELDS));
+    int infoSize = bitfields ? INFO_V4_SIZE : INFO_SIZE;
+    size_t imageSize;
+    if (!bmp_rowSize(width, bits, rowSize) || !bmp_imageSize(width, height, bits, &imageSize) ||
+        !bmp_addSize(imageSize, HEADER_SIZE + infoSize, fileSize)) {
+        return false;
+    }
 
     // Préparer l'en-tête de fichier
-    t_bmp_header header;
-    header.type = BMP_TYPE;
-    header.size = fileSize;
-    header.reserved1 = 0;
-    header.reserved2 = 0;
-    header.offset = 54;
-
+    header->type = BMP_TYPE;
+    header->size = *fileSize > UINT32_MAX ? 0 : (uint32_t)*fileSize;  // au-delà de 4 Go : champ ignoré, mis à 0
+    header->reserved1 = 0;
+    header->reserved2 = 0;
+    header->offset = HEADER_SIZE + infoSize;
 
     // Préparer l'en-tête d'information
+    info->size = infoSize;
+    info->width = width;
+    info->height = topDown ? -height : height;  // Positif = bottom-up
+    info->planes = 1;
+    info->bits = bits;
+    info->compression = bitfields ? BI_BITFIELDS : BI_RGB;
+    info->imagesize = imageSize > UINT32_MAX ? 0 : (uint32_t)imageSize;
+    info->xresolution = 2835;  // 72 DPI
+    info->yresolution = 2835;
+    info->ncolors = 0;
+    info->importantcolors = 0;
+
+    // Masques standard de l'en-tête V4
+    memset(ext, 0, sizeof(*ext));
+    ext->redMask = BMP_MASK_RED;
+    ext->greenMask = BMP_MASK_GREEN;
+    ext->blueMask = BMP_MASK_BLUE;
+    ext->alphaMask = BMP_MASK_ALPHA;
+    ext->csType = 0x73524742;  // 'sRGB'
+    return true;
+}
+
+// Sauvegarde d'une image BMP 24 bits, ou 32 bits si colorDepth == 32
+t_bmp_status bmp24_saveImage(const char *filename, const t_bmp24 *img) {
+    if (filename == NULL || img == NULL || img->data == NULL) {
+        return BMP_ERR_ARGUMENT;
+    }
+
+    t_bmp_header header;
     t_bmp_info info;
-    info.size = 40;
-    info.width = width;
-    info.height = height;  // Positif = bottom-up
-    info.planes = 1;
-    info.bits = 24;
-    info.compression = 0;
-    info.imagesize = imageSize;
-    info.xresolution = 2835;  // 72 DPI
-    info.yresolution = 2835;
-    info.ncolors = 0;
-    info.importantcolors = 0;
+    t_bmp_v4ext ext;
+    size_t rowSize, fileSize;
+    if (!bmp24_prepareHeaders(img, false, &header, &info, &ext, &rowSize, &fileSize)) {
+        return BMP_ERR_TOO_LARGE;
+    }
+    int height = img->height;
 
-    // Écriture des en-têtes
-    fwrite(&header, sizeof(t_bmp_header), 1, f);
-    fwrite(&info, sizeof(t_bmp_info), 1, f);
+    // Les lignes sont converties par blocs ; chaque bloc part en un seul writev (le premier avec les en-têtes)
+    size_t parBloc = bmp_rowsPerBlock(rowSize, (size_t)height);
+    unsigned char *bloc = malloc(parBloc * rowSize);
+    if (bloc == NULL) {
+        return BMP_ERR_MEMORY;
+    }
 
-    // Allouer une ligne avec padding
-    unsigned char *line = calloc(rowSize, sizeof(unsigned char));
-    if (line == NULL) {
-        printf("Erreur d'allocation mémoire pour la ligne temporaire.\n");
-        fclose(f);
-        return;
+    t_bmp_writer w;
+    t_bmp_status res = bmp_writerOpen(&w, filename);
+    if (res != BMP_OK) {
+        free(bloc);
+        return res;
     }
 
-    // Écriture ligne par ligne (du bas vers le haut pour BMP standard)
-    for (int i = 0; i < height; i++) {
-        int srcRow = height - 1 - i;  // Inverser l'ordre des lignes
-
-        // Remplir la ligne (format RGB vers BGR)
-        for (int j = 0; j < width; j++) {
-            int pixelOffset = j * bytesPerPixel;
-            line[pixelOffset]     = img->data[srcRow][j].blue;
-            line[pixelOffset + 1] = img->data[srcRow][j].green;
-            line[pixelOffset + 2] = img->data[srcRow][j].red;
+    // Écriture des en-têtes
+    res = bmp_writerPush(&w, &header, sizeof(t_bmp_header));
+    if (res == BMP_OK) {
+        res = bmp_writerPush(&w, &info, sizeof(t_bmp_info));
+    }
+    if (res == BMP_OK && info.size == INFO_V4_SIZE) {
+        res = bmp_writerPush(&w, &ext, sizeof(t_bmp_v4ext));
+    }
+
+    // Lignes du bas vers le haut pour BMP standard, format RGB(A) vers BGR(A)
+    for (int i = 0; i < height && res == BMP_OK; ) {
+        int n = height - i < (int)parBloc ? height - i : (int)parBloc;
+        for (int k = 0; k < n; k++) {
+            bmp24_encodeRow(img->data[height - 1 - (i + k)], img->width, info.bits,
+                            bloc + (size_t)k * rowSize, rowSize);
         }
+        res = bmp_writerPush(&w, bloc, (size_t)n * rowSize);
+        if (res == BMP_OK) {
+            res = bmp_writerFlush(&w);
+        }
+        i += n;
+    }
+
+    res = bmp_writerClose(&w, res);
+    free(bloc);
+    return res;
+}
+
+size_t bmp24_encodedSize(const t_bmp24 *img) {
+    if (img == NULL || img->data == NULL) {
+        return 0;
+    }
+    t_bmp_header header;
+    t_bmp_info info;
+    t_bmp_v4ext ext;
+    size_t rowSize, fileSize;
+    if (!bmp24_prepareHeaders(img, false, &header, &info, &ext, &rowSize, &fileSize)) {
+        return 0;
+    }
+    return fileSize;
+}
 
-        // Écrire la ligne complète (avec padding)
-        fwrite(line, sizeof(unsigned char), rowSize, f);
+t_bmp_status bmp24_encode(const t_bmp24 *img, unsigned char *buffer, size_t size, size_t *written) {
+    if (written != NULL) {
+        *written = 0;
+    }
+    if (img == NULL || img->data == NULL || buffer == NULL) {
+        return BMP_ERR_ARGUMENT;
     }
 
-    free(line);
-    fclose(f);
-    printf("Image sauvegardée dans %s\n", filename);
+    t_bmp_header header;
+    t_bmp_info info;
+    t_bmp_v4ext ext;
+    size_t rowSize, fileSize;
+    if (!bmp24_prepareHeaders(img, false, &header, &info, &ext, &rowSize, &fileSize)) {
+        return BMP_ERR_TOO_LARGE;
+    }
+    if (size < fileSize) {
+        return BMP_ERR_BUFFER;
+    }
+
+    memcpy(buffer, &header, HEADER_SIZE);
+    memcpy(buffer + HEADER_SIZE, &info, INFO_SIZE);
+    if (info.size == INFO_V4_SIZE) {
+        memcpy(buffer + HEADER_SIZE + INFO_SIZE, &ext, sizeof(t_bmp_v4ext));
+    }
+
+    // Lignes converties directement dans le tampon, du bas vers le haut, padding à zéro
+    uint8_t *dst = buffer + header.offset;
+    for (int i = 0; i < img->height; i++) {
+        bmp24_encodeRow(img->data[img->height - 1 - i], img->width, info.bits, dst, rowSize);
+        dst += rowSize;
+    }
+    if (written != NULL) {
+        *written = fileSize;
+    }
+    return BMP_OK;
 }
 
 // Affichage des informations de l'image
-void bmp24_printInfo(t_bmp24 *img) {
+void bmp24_printInfo(const t_bmp24 *img) {
     if (img == NULL) {
         printf("Aucune image à afficher.\n");
         return;
@@ -303,70 +785,97 @@ void bmp24_printInfo(t_bmp24 *img) {
 // --- Fonctions de traitement d'image ---
 
 // Application d'un filtre négatif
-void bmp24_negative(t_bmp24 *img) {
+t_bmp_status bmp24_negative(t_bmp24 *img) {
     if (img == NULL || img->data == NULL) {
-        printf("Erreur : image invalide ou non chargée.\n");
-        return;
+        return BMP_ERR_ARGUMENT;
     }
 
     for (int i = 0; i < img->height; i++) {
-        for (int j = 0; j < img->width; j++) {
-            img->data[i][j].red   = 255 - img->data[i][j].red;
-            img->data[i][j].green = 255 - img->data[i][j].green;
-            img->data[i][j].blue  = 255 - img->data[i][j].blue;
-        }
+        bmp24_negativeRow(img->data[i], img->width);
     }
+    return BMP_OK;
+}
 
-    printf("Filtre négatif appliqué avec succès.\n");
+void bmp24_negativeRow(t_pixel *row, int width) {
+    // Les canaux d'une ligne sont contigus : on inverse tous les octets (sauf l'alpha)
+#ifdef BMP24_PIXEL32
+    kernels_get()->invert4((uint8_t *)row, width);
+#else
+    kernels_get()->invert((uint8_t *)row, (size_t)width * sizeof(t_pixel));
+#endif
 }
 
 // Ajustement de la luminosité
-void bmp24_brightness(t_bmp24 *img, int value) {
+t_bmp_status bmp24_brightness(t_bmp24 *img, int value) {
     if (img == NULL || img->data == NULL) {
-        printf("Erreur : image invalide ou non chargée.\n");
-        return;
-    }
-
-    if (value < -255 || value > 255) {
-        printf("Attention : valeur de luminosité hors limites recommandées [-255, 255].\n");
+        return BMP_ERR_ARGUMENT;
     }
 
     for (int i = 0; i < img->height; i++) {
-        for (int j = 0; j < img->width; j++) {
-            // Ajustement avec saturation dans [0, 255]
-            int r = img->data[i][j].red + value;
-            int g = img->data[i][j].green + value;
-            int b = img->data[i][j].blue + value;
-
-            img->data[i][j].red   = (r > 255) ? 255 : (r < 0 ? 0 : r);
-            img->data[i][j].green = (g > 255) ? 255 : (g < 0 ? 0 : g);
-            img->data[i][j].blue  = (b > 255) ? 255 : (b < 0 ? 0 : b);
-        }
+        bmp24_brightnessRow(img->data[i], img->width, value);
     }
+    return BMP_OK;
+}
 
-    printf("Luminosité ajustée de %+d.\n", value);
+void bmp24_brightnessRow(t_pixel *row, int width, int value) {
+    // Ajustement avec saturation dans [0, 255], même décalage sur les trois canaux
+#ifdef BMP24_PIXEL32
+    kernels_get()->addSat4((uint8_t *)row, width, value);
+#else
+    kernels_get()->addSat((uint8_t *)row, (size_t)width * sizeof(t_pixel), value);
+#endif
 }
 
 // Conversion en niveaux de gris
-void bmp24_grayscale(t_bmp24 *img) {
+t_bmp_status bmp24_grayscale(t_bmp24 *img) {
     if (img == NULL || img->data == NULL) {
-        printf("Erreur : image invalide ou non chargée.\n");
-        return;
+        return BMP_ERR_ARGUMENT;
     }
 
     for (int i = 0; i < img->height; i++) {
-        for (int j = 0; j < img->width; j++) {
-            t_pixel *p = &img->data[i][j];
-            // Pondération standard de luminance (ITU-R BT.709)
-            uint8_t gris = (uint8_t)(0.299 * p->red + 0.587 * p->green + 0.114 * p->blue);
-            p->red = p->green = p->blue = gris;
-        }
+        bmp24_grayscaleRow(img->data[i], img->width);
     }
+    return BMP_OK;
+}
 
-    printf("Filtre niveaux de gris appliqué avec succès.\n");
+// Pondération standard de luminance (ITU-R BT.709)
+static inline uint8_t luminance(uint8_t red, uint8_t green, uint8_t blue) {
+    return (uint8_t)(0.299 * red + 0.587 * green + 0.114 * blue);
 }
 
-t_pixel bmp24_convolution(t_bmp24 *img, int x, int y, float **kernel, int kernelSize) {
+void bmp24_grayscaleRow(t_pixel *row, int width) {
+    for (int j = 0; j < width; j++) {
+        t_pixel *p = &row[j];
+        p->red = p->green = p->blue = luminance(p->red, p->green, p->blue);
+    }
+}
+
+void bmp24_grayscaleLutRow(t_pixel *row, int width, const uint8_t before[256], const uint8_t after[256]) {
+    for (int j = 0; j < width; j++) {
+        t_pixel *p = &row[j];
+        uint8_t gris = before != NULL ? luminance(before[p->red], before[p->green], before[p->blue])
+                                      : luminance(p->red, p->green, p->blue);
+        p->red = p->green = p->blue = after[gris];
+    }
+}
+
+void bmp24_applyLutRow(t_pixel *row, int width, const uint8_t lut[256]) {
+#ifdef BMP24_PIXEL32
+    // L'alpha n'est pas touché par les opérations ponctuelles
+    for (int j = 0; j < width; j++) {
+        row[j].red = lut[row[j].red];
+        row[j].green = lut[row[j].green];
+        row[j].blue = lut[row[j].blue];
+    }
+#else
+    kernels_get()->applyLut((uint8_t *)row, (size_t)width * sizeof(t_pixel), lut);
+#endif
+}
+
+// Convolution d'un pixel à partir des lignes rows[0..nbRows) : l'image entière ou une fenêtre de lignes
+// consécutives ; les voisins hors de ces lignes sont ignorés
+static t_pixel convoluer_lignes(const t_pixel *const *rows, int nbRows, int width, int x, int y,
+                                float **kernel, int kernelSize) {
     int n = kernelSize / 2;
     float red = 0, green = 0, blue = 0;
 
@@ -375,11 +884,11 @@ t_pixel bmp24_convolution(t_bmp24 *img, int x, int y, float **kernel, int kernel
             int xi = x + i;
             int yj = y + j;
 
-            if (xi < 0 || xi >= img->height || yj < 0 || yj >= img->width)
+            if (xi < 0 || xi >= nbRows || yj < 0 || yj >= width)
                 continue;
 
             float coeff = kernel[i + n][j + n];
-            t_pixel p = img->data[xi][yj];
+            t_pixel p = rows[xi][yj];
             red   += coeff * p.red;
             green += coeff * p.green;
             blue  += coeff * p.blue;
@@ -387,117 +896,396 @@ t_pixel bmp24_convolution(t_bmp24 *img, int x, int y, float **kernel, int kernel
     }
 
     t_pixel result;
+#ifdef BMP24_PIXEL32
+    result.alpha = rows[x][y].alpha;   // l'alpha n'est pas filtré
+#endif
     result.red   = (red   > 255) ? 255 : (red < 0 ? 0 : round(red));
     result.green = (green > 255) ? 255 : (green < 0 ? 0 : round(green));
     result.blue  = (blue  > 255) ? 255 : (blue < 0 ? 0 : round(blue));
     return result;
 }
 
-void bmp24_applyFilter(t_bmp24 *img, float **kernel, int kernelSize) {
-    if (img == NULL || img->data == NULL) return;
+t_pixel bmp24_convolution(t_bmp24 *img, int x, int y, float **kernel, int kernelSize) {
+    return convoluer_lignes((const t_pixel *const *)img->data, img->height, img->width, x, y, kernel, kernelSize);
+}
 
-    t_pixel **copy = bmp24_allocateDataPixels(img->width, img->height);
-    if (copy == NULL) return;
+t_bmp_status bmp24_applyFilter(t_bmp24 *img, float **kernel, int kernelSize) {
+    t_bmp24_scratch scratch = {NULL, 0, 0};
+    t_bmp_status res = bmp24_applyFilterScratch(img, kernel, kernelSize, &scratch);
+    bmp24_freeScratch(&scratch);
+    return res;
+}
 
-    for (int i = 0; i < img->height; i++) {
-        for (int j = 0; j < img->width; j++) {
-            copy[i][j] = bmp24_convolution(img, i, j, kernel, kernelSize);
+t_bmp_status bmp24_applyFilterScratch(t_bmp24 *img, float **kernel, int kernelSize, t_bmp24_scratch *scratch) {
+    if (img == NULL || img->data == NULL || scratch == NULL) return BMP_ERR_ARGUMENT;
+    if (kernel == NULL || kernelSize <= 0 || kernelSize % 2 == 0) return BMP_ERR_ARGUMENT;
+
+    // Lignes de destination : celles de scratch si les dimensions correspondent
+    if (scratch->pixels == NULL || scratch->width != img->width || scratch->height != img->height) {
+        bmp24_freeScratch(scratch);
+        scratch->pixels = bmp24_allocateDataPixels(img->width, img->height);
+        if (scratch->pixels == NULL) return BMP_ERR_MEMORY;
+        scratch->width = img->width;
+        scratch->height = img->height;
+    }
+    t_pixel **copy = scratch->pixels;
+
+    float *flat = malloc(sizeof(float) * (size_t)kernelSize * kernelSize);
+    const t_pixel **rows = malloc(sizeof(t_pixel *) * img->height);
+    if (flat == NULL || rows == NULL) {
+        free(flat);
+        free(rows);
+        return BMP_ERR_MEMORY;
+    }
+    for (int i = 0; i < kernelSize; i++) {
+        for (int j = 0; j < kernelSize; j++) {
+            flat[i * kernelSize + j] = kernel[i][j];
         }
     }
+    for (int i = 0; i < img->height; i++) {
+        rows[i] = img->data[i];
+    }
+
+    for (int i = 0; i < img->height; i++) {
+        bmp24_filterRow(copy[i], rows, img->height, i, img->width, kernel, flat, kernelSize);
+    }
+
+    free(flat);
+    free(rows);
 
-    bmp24_freeDataPixels(img->data, img->height);
+    // Échange : les anciennes lignes servent de destination à la convolution suivante
+    scratch->pixels = img->data;
     img->data = copy;
+    return BMP_OK;
 }
 
-void bmp24_boxBlur(t_bmp24 *img) {
-    float **kernel = malloc(3 * sizeof(float *));
-    for (int i = 0; i < 3; i++) {
-        kernel[i] = malloc(3 * sizeof(float));
-        for (int j = 0; j < 3; j++) {
-            kernel[i][j] = 1.0f / 9.0f;
+// Convolution des colonnes [debut, fin) de la ligne row : dst[j - debut] pour la colonne j. Si debut > 0, dst doit
+// être précédé de kernelSize / 2 pixels du même tableau : le pointeur de destination passé au noyau vectorisé
+// est décalé comme les lignes source (rien n'y est écrit).
+static void filtrer_segment(t_pixel *dst, const t_pixel *const *rows, int nbRows, int row, int width, int debut,
+                            int fin, float **kernel, const float *flat, int kernelSize) {
+    int n = kernelSize / 2;
+    // Colonnes à voisinage horizontal complet, confiées au noyau vectorisé
+    int lo = debut > n ? debut : n;
+    int hi = fin < width - n ? fin : width - n;
+    if (row >= n && row < nbRows - n && lo < hi) {
+        // Ligne intérieure : voisinage vertical complet, noyau vectorisé hors colonnes de bord
+        const uint8_t *pile[16];
+        const uint8_t **lignes = kernelSize <= 16 ? pile : malloc(sizeof(uint8_t *) * kernelSize);
+        if (lignes != NULL) {
+            for (int ky = 0; ky < kernelSize; ky++) {
+                lignes[ky] = (const uint8_t *)(rows[row + ky - n] + (lo - n));
+            }
+            kernels_get()->convolveRow((uint8_t *)(dst + (lo - debut - n)), lignes, (size_t)n * sizeof(t_pixel),
+                                       (size_t)(hi - lo + n) * sizeof(t_pixel), sizeof(t_pixel),
+                                       flat, kernelSize, KERNEL_ROUND_NEAREST);
+            if (lignes != pile) {
+                free(lignes);
+            }
+        } else {
+            // Mémoire insuffisante pour un très grand noyau : chemin scalaire
+            for (int j = lo; j < hi; j++) {
+                dst[j - debut] = convoluer_lignes(rows, nbRows, width, row, j, kernel, kernelSize);
+            }
+        }
+#ifdef BMP24_PIXEL32
+        // Le noyau a aussi convolué les octets alpha : on remet ceux d'origine
+        for (int j = lo; j < hi; j++) {
+            dst[j - debut].alpha = rows[row][j].alpha;
+        }
+#endif
+        for (int j = debut; j < lo; j++) {
+            dst[j - debut] = convoluer_lignes(rows, nbRows, width, row, j, kernel, kernelSize);
+        }
+        for (int j = hi; j < fin; j++) {
+            dst[j - debut] = convoluer_lignes(rows, nbRows, width, row, j, kernel, kernelSize);
+        }
+    } else {
+        // Lignes de bord : les voisins hors image sont ignorés
+        for (int j = debut; j < fin; j++) {
+            dst[j - debut] = convoluer_lignes(rows, nbRows, width, row, j, kernel, kernelSize);
         }
     }
-    bmp24_applyFilter(img, kernel, 3);
-    for (int i = 0; i < 3; i++) free(kernel[i]);
-    free(kernel);
 }
 
-void bmp24_gaussianBlur(t_bmp24 *img) {
-    float values[3][3] = {
+void bmp24_filterRow(t_pixel *dst, const t_pixel *const *rows, int nbRows, int row, int width,
+                     float **kernel, const float *flat, int kernelSize) {
+    filtrer_segment(dst, rows, nbRows, row, width, 0, width, kernel, flat, kernelSize);
+}
+
+void bmp24_freeScratch(t_bmp24_scratch *scratch) {
+    if (scratch != NULL) {
+        bmp24_freeDataPixels(scratch->pixels, scratch->height);
+        scratch->pixels = NULL;
+        scratch->width = 0;
+        scratch->height = 0;
+    }
+}
+
+// --- Noyaux 3x3 prédéfinis ---
+
+static const float noyaux_predefinis[5][3][3] = {
+    // BMP24_KERNEL_BOX_BLUR
+    {
+        {1 / 9.0f, 1 / 9.0f, 1 / 9.0f},
+        {1 / 9.0f, 1 / 9.0f, 1 / 9.0f},
+        {1 / 9.0f, 1 / 9.0f, 1 / 9.0f}
+    },
+    // BMP24_KERNEL_GAUSSIAN_BLUR
+    {
         {1 / 16.0f, 2 / 16.0f, 1 / 16.0f},
         {2 / 16.0f, 4 / 16.0f, 2 / 16.0f},
         {1 / 16.0f, 2 / 16.0f, 1 / 16.0f}
-    };
+    },
+    // BMP24_KERNEL_OUTLINE
+    {
+        {-1, -1, -1},
+        {-1,  8, -1},
+        {-1, -1, -1}
+    },
+    // BMP24_KERNEL_EMBOSS
+    {
+        {-2, -1, 0},
+        {-1,  1, 1},
+        { 0,  1, 2}
+    },
+    // BMP24_KERNEL_SHARPEN
+    {
+        { 0, -1,  0},
+        {-1,  5, -1},
+        { 0, -1,  0}
+    }
+};
 
-    float **kernel = malloc(3 * sizeof(float *));
-    for (int i = 0; i < 3; i++) {
-        kernel[i] = malloc(3 * sizeof(float));
-        for (int j = 0; j < 3; j++) {
-            kernel[i][j] = values[i][j];
+// Noyau kernelSize x kernelSize alloué ligne par ligne (libéré par bmp24_freeKernel), non initialisé
+static float **allouer_noyau(int kernelSize) {
+    float **kernel = malloc((size_t)kernelSize * sizeof(float *));
+    if (kernel == NULL) {
+        return NULL;
+    }
+    for (int i = 0; i < kernelSize; i++) {
+        kernel[i] = malloc((size_t)kernelSize * sizeof(float));
+        if (kernel[i] == NULL) {
+            bmp24_freeKernel(kernel, i);
+            return NULL;
         }
     }
-
-    bmp24_applyFilter(img, kernel, 3);
-    for (int i = 0; i < 3; i++) free(kernel[i]);
-    free(kernel);
+    return kernel;
 }
 
-void bmp24_outline(t_bmp24 *img) {
-    float values[3][3] = {
-        {-1, -1, -1},
-        {-1,  8, -1},
-        {-1, -1, -1}
-    };
+float **bmp24_createKernel(t_bmp24_kernel type) {
+    if (type < BMP24_KERNEL_BOX_BLUR || type > BMP24_KERNEL_SHARPEN) {
+        return NULL;
+    }
 
-    float **kernel = malloc(3 * sizeof(float *));
+    float **kernel = allouer_noyau(3);
+    if (kernel == NULL) {
+        return NULL;
+    }
     for (int i = 0; i < 3; i++) {
-        kernel[i] = malloc(3 * sizeof(float));
         for (int j = 0; j < 3; j++) {
-            kernel[i][j] = values[i][j];
+            kernel[i][j] = noyaux_predefinis[type][i][j];
         }
     }
-
-    bmp24_applyFilter(img, kernel, 3);
-    for (int i = 0; i < 3; i++) free(kernel[i]);
-    free(kernel);
+    return kernel;
 }
 
-void bmp24_emboss(t_bmp24 *img) {
-    float values[3][3] = {
-        {-2, -1, 0},
-        {-1,  1, 1},
-        { 0,  1, 2}
-    };
+float **bmp24_scaleKernel(float **kernel, int kernelSize, double scale) {
+    if (kernel == NULL || kernelSize <= 0 || kernelSize % 2 == 0 || !(scale >= 1)) {
+        return NULL;
+    }
 
-    float **kernel = malloc(3 * sizeof(float *));
-    for (int i = 0; i < 3; i++) {
-        kernel[i] = malloc(3 * sizeof(float));
-        for (int j = 0; j < 3; j++) {
-            kernel[i][j] = values[i][j];
+    // poids[a * kernelSize + i] : part du coefficient de décalage a - n reportée sur le décalage i - n de l'image
+    // réduite. Le décalage devient (a - n) / scale, réparti linéairement entre ses deux voisins entiers.
+    int n = kernelSize / 2;
+    double *poids = calloc((size_t)kernelSize * kernelSize, sizeof(double));
+    float **res = allouer_noyau(kernelSize);
+    if (poids == NULL || res == NULL) {
+        free(poids);
+        bmp24_freeKernel(res, kernelSize);
+        return NULL;
+    }
+    for (int a = 0; a < kernelSize; a++) {
+        double u = (a - n) / scale;
+        int i0 = (int)floor(u);
+        double f = u - i0;
+        poids[a * kernelSize + i0 + n] += 1 - f;
+        if (f > 0) {
+            poids[a * kernelSize + i0 + 1 + n] += f;
         }
     }
 
-    bmp24_applyFilter(img, kernel, 3);
-    for (int i = 0; i < 3; i++) free(kernel[i]);
-    free(kernel);
+    for (int i = 0; i < kernelSize; i++) {
+        for (int j = 0; j < kernelSize; j++) {
+            double somme = 0;
+            for (int a = 0; a < kernelSize; a++) {
+                for (int b = 0; b < kernelSize; b++) {
+                    somme += kernel[a][b] * poids[a * kernelSize + i] * poids[b * kernelSize + j];
+                }
+            }
+            res[i][j] = (float)somme;
+        }
+    }
+    free(poids);
+    return res;
 }
 
-void bmp24_sharpen(t_bmp24 *img) {
-    float values[3][3] = {
-        { 0, -1,  0},
-        {-1,  5, -1},
-        { 0, -1,  0}
-    };
+void bmp24_freeKernel(float **kernel, int kernelSize) {
+    if (kernel != NULL) {
+        for (int i = 0; i < kernelSize; i++) {
+            free(kernel[i]);
+        }
+        free(kernel);
+    }
+}
 
-    float **kernel = malloc(3 * sizeof(float *));
-    for (int i = 0; i < 3; i++) {
-        kernel[i] = malloc(3 * sizeof(float));
-        for (int j = 0; j < 3; j++) {
-            kernel[i][j] = values[i][j];
+// Applique un noyau prédéfini
+static t_bmp_status appliquer_noyau(t_bmp24 *img, t_bmp24_kernel type) {
+    float **kernel = bmp24_createKernel(type);
+    if (kernel == NULL) {
+        return BMP_ERR_MEMORY;
+    }
+    t_bmp_status res = bmp24_applyFilter(img, kernel, 3);
+    bmp24_freeKernel(kernel, 3);
+    return res;
+}
+
+t_bmp_status bmp24_boxBlur(t_bmp24 *img) {
+    return appliquer_noyau(img, BMP24_KERNEL_BOX_BLUR);
+}
+
+t_bmp_status bmp24_gaussianBlur(t_bmp24 *img) {
+    return appliquer_noyau(img, BMP24_KERNEL_GAUSSIAN_BLUR);
+}
+
+t_bmp_status bmp24_outline(t_bmp24 *img) {
+    return appliquer_noyau(img, BMP24_KERNEL_OUTLINE);
+}
+
+t_bmp_status bmp24_emboss(t_bmp24 *img) {
+    return appliquer_noyau(img, BMP24_KERNEL_EMBOSS);
+}
+
+t_bmp_status bmp24_sharpen(t_bmp24 *img) {
+    return appliquer_noyau(img, BMP24_KERNEL_SHARPEN);
+}
+
+// --- Vues sur un rectangle ---
+
+static bool vue_valide(const t_bmp24_view *view) {
+    return view != NULL && view->image != NULL && view->rows != NULL && view->width > 0 && view->height > 0;
+}
+
+t_bmp_status bmp24_view(t_bmp24 *img, int x, int y, int width, int height, t_bmp24_view *view) {
+    if (img == NULL || img->data == NULL || view == NULL || x < 0 || y < 0 || width <= 0 || height <= 0 ||
+        x >= img->width || width > img->width - x || y >= img->height || height > img->height - y) {
+        return BMP_ERR_ARGUMENT;
+    }
+
+    view->image = img;
+    view->rows = img->data + y;
+    view->x = x;
+    view->y = y;
+    view->width = width;
+    view->height = height;
+    return BMP_OK;
+}
+
+t_bmp_status bmp24_viewNegative(const t_bmp24_view *view) {
+    if (!vue_valide(view)) {
+        return BMP_ERR_ARGUMENT;
+    }
+
+    for (int i = 0; i < view->height; i++) {
+        bmp24_negativeRow(view->rows[i] + view->x, view->width);
+    }
+    return BMP_OK;
+}
+
+t_bmp_status bmp24_viewBrightness(const t_bmp24_view *view, int value) {
+    if (!vue_valide(view)) {
+        return BMP_ERR_ARGUMENT;
+    }
+
+    for (int i = 0; i < view->height; i++) {
+        bmp24_brightnessRow(view->rows[i] + view->x, view->width, value);
+    }
+    return BMP_OK;
+}
+
+t_bmp_status bmp24_viewGrayscale(const t_bmp24_view *view) {
+    if (!vue_valide(view)) {
+        return BMP_ERR_ARGUMENT;
+    }
+
+    for (int i = 0; i < view->height; i++) {
+        bmp24_grayscaleRow(view->rows[i] + view->x, view->width);
+    }
+    return BMP_OK;
+}
+
+t_bmp_status bmp24_viewApplyFilter(const t_bmp24_view *view, float **kernel, int kernelSize) {
+    if (!vue_valide(view) || kernel == NULL || kernelSize <= 0 || kernelSize % 2 == 0) {
+        return BMP_ERR_ARGUMENT;
+    }
+
+    // Résultat du rectangle seul, chaque ligne précédée de la marge demandée par filtrer_segment
+    const t_bmp24 *img = view->image;
+    int n = kernelSize / 2;
+    size_t largeur = (size_t)view->width + n;
+    size_t taille;
+    if (!bmp_mulSize(largeur * sizeof(t_pixel), (size_t)view->height, &taille)) {
+        return BMP_ERR_TOO_LARGE;
+    }
+    t_pixel *resultat = malloc(taille);
+    float *flat = malloc(sizeof(float) * (size_t)kernelSize * kernelSize);
+    if (resultat == NULL || flat == NULL) {
+        free(resultat);
+        free(flat);
+        return BMP_ERR_MEMORY;
+    }
+    for (int i = 0; i < kernelSize; i++) {
+        for (int j = 0; j < kernelSize; j++) {
+            flat[i * kernelSize + j] = kernel[i][j];
         }
     }
 
-    bmp24_applyFilter(img, kernel, 3);
-    for (int i = 0; i < 3; i++) free(kernel[i]);
-    free(kernel);
-}
\ No newline at end of file
+    const t_pixel *const *rows = (const t_pixel *const *)img->data;
+    for (int i = 0; i < view->height; i++) {
+        filtrer_segment(resultat + (size_t)i * largeur + n, rows, img->height, view->y + i, img->width, view->x,
+                        view->x + view->width, kernel, flat, kernelSize);
+    }
+
+    // Recopie une fois toutes les lignes calculées : les voisins lus étaient ceux d'origine
+    for (int i = 0; i < view->height; i++) {
+        memcpy(view->rows[i] + view->x, resultat + (size_t)i * largeur + n, (size_t)view->width * sizeof(t_pixel));
+    }
+
+    free(resultat);
+    free(flat);
+    return BMP_OK;
+}
+
+t_bmp_status bmp24_viewSave(const char *filename, const t_bmp24_view *view) {
+    if (filename == NULL || !vue_valide(view)) {
+        return BMP_ERR_ARGUMENT;
+    }
+
+    // Image dont les lignes pointent dans celles du rectangle : seuls largeur, hauteur, profondeur et
+    // compression comptent à l'écriture
+    t_pixel **lignes = malloc((size_t)view->height * sizeof(t_pixel *));
+    if (lignes == NULL) {
+        return BMP_ERR_MEMORY;
+    }
+    for (int i = 0; i < view->height; i++) {
+        lignes[i] = view->rows[i] + view->x;
+    }
+    t_bmp24 vue = *view->image;
+    vue.width = view->width;
+    vue.height = view->height;
+    vue.data = lignes;
+
+    t_bmp_status res = bmp24_saveImage(filename, &vue);
+    free(lignes);
+    return res;
+}
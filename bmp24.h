@@ -8,6 +8,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include "bmp_status.h"
 
 // --- Constantes utiles ---
 #define BITMAP_MAGIC       0x00
@@ -22,16 +23,42 @@
 
 #define HEADER_SIZE        0x0E
 #define INFO_SIZE          0x28
+#define INFO_V4_SIZE       0x6C
 #define DEFAULT_DEPTH      0x18
 
+// Valeurs du champ compression
+#define BI_RGB             0
+#define BI_BITFIELDS       3
+#define BI_ALPHABITFIELDS  6
+
+// Masques standard d'un BMP 32 bits (octets B, G, R, A dans le fichier)
+#define BMP_MASK_RED       0x00FF0000u
+#define BMP_MASK_GREEN     0x0000FF00u
+#define BMP_MASK_BLUE      0x000000FFu
+#define BMP_MASK_ALPHA     0xFF000000u
+
+// Chargement parallèle : octets de pixels minimum par thread
+#define BMP24_PARALLEL_MIN ((size_t)4 << 20)
+
 // --- Structures ---
 
 // Structure pour un pixel RGB
+// Avec l'option CMake IPROCESS_PIXEL32 (BMP24_PIXEL32), chaque pixel occupe 4 octets alignés :
+// un pixel = un élément 32 bits d'un registre SIMD, et l'alpha des BMP 32 bits est conservé.
+#ifdef BMP24_PIXEL32
 typedef struct {
     uint8_t red;
     uint8_t green;
     uint8_t blue;
+    uint8_t alpha;
 } t_pixel;
+#else
+typedef struct {
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+} t_pixel;
+#endif
 
 // En-tête de fichier BMP
 typedef struct __attribute__((__packed__)) {
@@ -59,7 +86,21 @@ typedef struct __attribute__((__packed__)) {
 } t_bmp_info;
 
 
-// Structure pour une image BMP 24 bits
+// Extension BITMAPV4HEADER : suit t_bmp_info lorsque size == INFO_V4_SIZE
+typedef struct __attribute__((__packed__)) {
+    uint32_t redMask;
+    uint32_t greenMask;
+    uint32_t blueMask;
+    uint32_t alphaMask;
+    uint32_t csType;
+    uint8_t endpoints[36];
+    uint32_t gammaRed;
+    uint32_t gammaGreen;
+    uint32_t gammaBlue;
+} t_bmp_v4ext;
+
+
+// Structure pour une image BMP 24 bits (ou 32 bits BGRA : colorDepth == 32)
 typedef struct {
     t_bmp_header header;
     t_bmp_info header_info;
@@ -69,34 +110,149 @@ typedef struct {
     t_pixel **data;
 } t_bmp24;
 
+// Format des pixels d'un fichier, déduit de l'en-tête d'information (bmp24_parseFormat)
+typedef struct {
+    int width;
+    int height;
+    bool topDown;           // hauteur négative : lignes stockées du haut vers le bas
+    int bytesPerPixel;
+    bool bitfields;
+    int nbMasks;            // masques à lire après les 40 octets d'en-tête (0 hors BI_BITFIELDS)
+    uint32_t masks[4];
+    size_t rowSize;         // octets par ligne du fichier, padding compris
+    size_t imageSize;
+} t_bmp24_format;
+
+// Vue sur un rectangle d'une image 24/32 bits, sans copie (bmp24_view) : la ligne i de la vue commence au
+// pixel x de rows[i], rows désignant les lignes de l'image à partir de la ligne y (ligne 0 en haut). Les
+// traitements sur une vue ne parcourent que le rectangle ; les convolutions lisent le voisinage réel dans
+// l'image autour du rectangle.
+typedef struct {
+    t_bmp24 *image;
+    t_pixel **rows;
+    int x;
+    int y;
+    int width;
+    int height;
+} t_bmp24_view;
+
+// Tampon de travail réutilisable d'une convolution à l'autre (un par thread en traitement par lot)
+typedef struct {
+    t_pixel **pixels;
+    int width;
+    int height;
+} t_bmp24_scratch;
+
 // --- Fonctions de base ---
-t_bmp24 *bmp24_loadImage(const char *filename);
-void bmp24_saveImage(const char *filename, t_bmp24 *img);
+// Silencieuses comme celles de bmp8.h : NULL + *status (optionnel) pour les chargements, t_bmp_status sinon
+t_bmp24 *bmp24_loadImage(const char *filename, t_bmp_status *status);
+t_bmp_status bmp24_saveImage(const char *filename, const t_bmp24 *img);
 void bmp24_free(t_bmp24 *img);
-void bmp24_printInfo(t_bmp24 *img);
+void bmp24_printInfo(const t_bmp24 *img);
+
+// Lecture depuis un fichier déjà ouvert dont les en-têtes (14 + 40 octets) ont été lus (utilisé par bmp_open)
+t_bmp24 *bmp24_readFromFile(FILE *f, const t_bmp_header *header, const t_bmp_info *info, t_bmp_status *status);
+
+// Chargement parallèle des grandes images : la zone des pixels est découpée en tranches de lignes, chaque
+// thread lit la sienne avec pread à sa position et la convertit directement dans les lignes de l'image.
+// threads <= 0 : nombre de cœurs ; au plus un thread par BMP24_PARALLEL_MIN octets de pixels (lecture
+// séquentielle en dessous, et toujours sous Windows). f n'est plus positionné de façon utile au retour.
+t_bmp24 *bmp24_loadImageParallel(const char *filename, int threads, t_bmp_status *status);
+t_bmp24 *bmp24_readFromFileParallel(FILE *f, const t_bmp_header *header, const t_bmp_info *info, int threads,
+                                    t_bmp_status *status);
+
+// Chargement réduit (miniatures) : scale vaut 1, 2, 4 ou 8 ; chaque pixel est la moyenne d'un bloc
+// scale x scale, calculée pendant la lecture des lignes. Les blocs sont alignés sur le coin haut gauche de
+// l'image affichée, quel que soit le sens de stockage : seuls ceux du bord droit et du bas sont partiels.
+// Seule l'image réduite est allouée.
+t_bmp24 *bmp24_loadImageScaled(const char *filename, int scale, t_bmp_status *status);
+t_bmp24 *bmp24_readFromFileScaled(FILE *f, const t_bmp_header *header, const t_bmp_info *info, int scale,
+                                  t_bmp_status *status);
+
+// Décodage et encodage en mémoire, sans fichier (les pixels sont toujours convertis : BGR(A) -> t_pixel)
+t_bmp24 *bmp24_decode(const unsigned char *buffer, size_t size, t_bmp_status *status);
+size_t bmp24_encodedSize(const t_bmp24 *img);                               // taille exacte du fichier encodé
+t_bmp_status bmp24_encode(const t_bmp24 *img, unsigned char *buffer, size_t size,
+                          size_t *written);                                 // *written : octets écrits
 
-// --- Fonctions d'allocation ---
+// Accès ligne par ligne, pour lire ou écrire un flux sans disposer de l'image entière (voir stream.h)
+t_bmp_status bmp24_parseFormat(const t_bmp_info *info, t_bmp24_format *fmt);   // masques laissés par défaut
+void bmp24_decodeRow(const t_bmp24_format *fmt, const uint8_t *line, t_pixel *dst);
+void bmp24_encodeRow(const t_pixel *src, int width, int bits, uint8_t *line, size_t rowSize);
+// En-têtes d'enregistrement de img (seuls largeur, hauteur, profondeur et compression sont lus) ;
+// faux si l'image est trop grande
+bool bmp24_prepareHeaders(const t_bmp24 *img, bool topDown, t_bmp_header *header, t_bmp_info *info,
+                          t_bmp_v4ext *ext, size_t *rowSize, size_t *fileSize);
+
+// --- Fonctions d'allocation (NULL si paramètres invalides ou mémoire insuffisante) ---
 t_bmp24 *bmp24_allocate(int width, int height, int colorDepth);
 t_pixel **bmp24_allocateDataPixels(int width, int height);
 void bmp24_freeDataPixels(t_pixel **pixels, int height);
 
 // --- Fonctions de traitement d'image ---
-void bmp24_negative(t_bmp24 *img);
-void bmp24_brightness(t_bmp24 *img, int value);
-void bmp24_grayscale(t_bmp24 *img);
+t_bmp_status bmp24_negative(t_bmp24 *img);
+t_bmp_status bmp24_brightness(t_bmp24 *img, int value);
+t_bmp_status bmp24_grayscale(t_bmp24 *img);
+
+// Mêmes traitements sur une seule ligne de width pixels
+void bmp24_negativeRow(t_pixel *row, int width);
+void bmp24_brightnessRow(t_pixel *row, int width, int value);
+void bmp24_grayscaleRow(t_pixel *row, int width);
+
+// Table de correspondance lut appliquée aux trois canaux de chaque pixel (alpha inchangé)
+void bmp24_applyLutRow(t_pixel *row, int width, const uint8_t lut[256]);
+// Niveaux de gris encadrés de deux tables : canaux passés par before (optionnelle), luminance, puis after[gris]
+// recopié sur les trois canaux
+void bmp24_grayscaleLutRow(t_pixel *row, int width, const uint8_t before[256], const uint8_t after[256]);
+
+// --- Vues : rectangle de width x height pixels à partir de (x, y), entièrement dans l'image ---
+t_bmp_status bmp24_view(t_bmp24 *img, int x, int y, int width, int height, t_bmp24_view *view);
+t_bmp_status bmp24_viewNegative(const t_bmp24_view *view);
+t_bmp_status bmp24_viewBrightness(const t_bmp24_view *view, int value);
+t_bmp_status bmp24_viewGrayscale(const t_bmp24_view *view);
+// Convolution du rectangle : chaque pixel prend la valeur qu'il aurait avec bmp24_applyFilter
+t_bmp_status bmp24_viewApplyFilter(const t_bmp24_view *view, float **kernel, int kernelSize);
+// Enregistre le rectangle comme une image à part entière (profondeur de l'image), sans copier ses pixels
+t_bmp_status bmp24_viewSave(const char *filename, const t_bmp24_view *view);
 
 // --- Fonctions de filtres de convolution ---
 t_pixel bmp24_convolution(t_bmp24 *img, int x, int y, float **kernel, int kernelSize);
-void bmp24_boxBlur(t_bmp24 *img);
-void bmp24_gaussianBlur(t_bmp24 *img);
-void bmp24_outline(t_bmp24 *img);
-void bmp24_emboss(t_bmp24 *img);
-void bmp24_sharpen(t_bmp24 *img);
+t_bmp_status bmp24_boxBlur(t_bmp24 *img);
+t_bmp_status bmp24_gaussianBlur(t_bmp24 *img);
+t_bmp_status bmp24_outline(t_bmp24 *img);
+t_bmp_status bmp24_emboss(t_bmp24 *img);
+t_bmp_status bmp24_sharpen(t_bmp24 *img);
 
 
 
+// --- Noyaux 3x3 prédéfinis ---
+typedef enum {
+    BMP24_KERNEL_BOX_BLUR = 0,
+    BMP24_KERNEL_GAUSSIAN_BLUR,
+    BMP24_KERNEL_OUTLINE,
+    BMP24_KERNEL_EMBOSS,
+    BMP24_KERNEL_SHARPEN
+} t_bmp24_kernel;
+
+float **bmp24_createKernel(t_bmp24_kernel type);   // noyau 3x3 alloué, à libérer avec bmp24_freeKernel
+void bmp24_freeKernel(float **kernel, int kernelSize);
+// Noyau équivalent sur une image réduite d'un facteur scale (>= 1) : chaque coefficient est reporté à son
+// décalage divisé par scale (interpolation linéaire), la somme des coefficients est conservée. Même taille,
+// alloué (bmp24_freeKernel) ; NULL si paramètres invalides ou mémoire insuffisante.
+float **bmp24_scaleKernel(float **kernel, int kernelSize, double scale);
+
 // --- Fonctions de convolution générique ---
-void bmp24_applyFilter(t_bmp24 *img, float **kernel, int kernelSize);
+t_bmp_status bmp24_applyFilter(t_bmp24 *img, float **kernel, int kernelSize);
+
+// Variante de bmp24_applyFilter qui réutilise scratch ; les lignes de l'image et de scratch sont échangées
+t_bmp_status bmp24_applyFilterScratch(t_bmp24 *img, float **kernel, int kernelSize, t_bmp24_scratch *scratch);
+void bmp24_freeScratch(t_bmp24_scratch *scratch);
+
+// Convolution d'une ligne : rows[0..nbRows) sont des lignes consécutives de l'image (toute l'image ou une
+// fenêtre), row l'indice de la ligne filtrée ; au-delà de la fenêtre, les voisins sont considérés hors image.
+// flat contient le noyau à plat (kernelSize * kernelSize).
+void bmp24_filterRow(t_pixel *dst, const t_pixel *const *rows, int nbRows, int row, int width,
+                     float **kernel, const float *flat, int kernelSize);
 t_pixel bmp24_convolution(t_bmp24 *img, int x, int y, float **kernel, int kernelSize);
 
 
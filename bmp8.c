@@ -11,138 +11,409 @@
 
 
 #include "bmp8.h"
+#include "kernels.h"
+#include "bmp_size.h"
+#include "bmp_file.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 // Fonction utilitaire pour lire un entier sur 4 octets à partir d'un tableau d'octets
 unsigned int lire_entier(const unsigned char *buffer, int offset) {
-    unsigned int b0 = buffer[offset];
-    unsigned int b1 = buffer[offset + 1] << 8;
-    unsigned int b2 = buffer[offset + 2] << 16;
-    unsigned int b3 = buffer[offset + 3] << 24;
+    // Conversion avant décalage : un octet promu en int décalé de 24 bits déborderait sur le bit de signe
+    uint32_t b0 = (uint32_t)buffer[offset];
+    uint32_t b1 = (uint32_t)buffer[offset + 1] << 8;
+    uint32_t b2 = (uint32_t)buffer[offset + 2] << 16;
+    uint32_t b3 = (uint32_t)buffer[offset + 3] << 24;
     return b0 | b1 | b2 | b3;
 }
 
+// Écriture d'un entier 32 bits little-endian dans un en-tête
+static void ecrire_entier(unsigned char *buffer, int offset, uint32_t value) {
+    buffer[offset] = (unsigned char)value;
+    buffer[offset + 1] = (unsigned char)(value >> 8);
+    buffer[offset + 2] = (unsigned char)(value >> 16);
+    buffer[offset + 3] = (unsigned char)(value >> 24);
+}
+
 // Chargement d'une image BMP 8 bits
-t_bmp8 * bmp8_loadImage(const char * filename) {
-    FILE *file = fopen(filename, "rb");
-    if (file == NULL) {
-        fprintf(stderr, "Erreur : Impossible d'ouvrir le fichier %s.\n", filename);
+t_bmp8 * bmp8_loadImage(const char * filename, t_bmp_status * status) {
+    return bmp8_loadImageScaled(filename, 1, status);
+}
+
+t_bmp8 * bmp8_loadImageScaled(const char * filename, int scale, t_bmp_status * status) {
+    if (filename == NULL) {
+        bmp_setStatus(status, BMP_ERR_ARGUMENT);
         return NULL;
     }
 
-    // Allocation mémoire pour une image t_bmp8
-    t_bmp8 *img = (t_bmp8 *)malloc(sizeof(t_bmp8));
-    if (img == NULL) {
-        fprintf(stderr, "Erreur : Allocation mémoire échouée pour l'image.\n");
-        fclose(file);
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL) {
+        bmp_setStatus(status, BMP_ERR_OPEN);
         return NULL;
     }
 
     // Lecture de l'en-tête BMP (54 octets)
-    if (fread(img->header, sizeof(unsigned char), 54, file) != 54) {
-        fprintf(stderr, "Erreur : Impossible de lire l'en-tête BMP.\n");
-        free(img);
+    unsigned char header[54];
+    if (fread(header, sizeof(unsigned char), 54, file) != 54) {
+        bmp_setStatus(status, BMP_ERR_READ);
         fclose(file);
         return NULL;
     }
 
     // Vérification de la signature BMP
-    if (img->header[0] != 'B' || img->header[1] != 'M') {
-        fprintf(stderr, "Erreur : Ce n'est pas un fichier BMP valide.\n");
-        free(img);
+    if (header[0] != 'B' || header[1] != 'M') {
+        bmp_setStatus(status, BMP_ERR_FORMAT);
         fclose(file);
         return NULL;
     }
 
-    // Lecture de la profondeur de couleur (offset 28)
-    img->colorDepth = lire_entier(img->header, 28);
+    t_bmp8 *img = bmp8_readFromFileScaled(file, header, scale, status);
+    fclose(file);
+    return img;
+}
+
+// Vérification de l'en-tête de 54 octets et calcul des dimensions ; commun aux lectures depuis un
+// fichier, depuis la mémoire et depuis un flux
+t_bmp_status bmp8_parseHeader(t_bmp8 *img, const unsigned char *header) {
+    memcpy(img->header, header, 54);
+
+    // Lecture de la profondeur de couleur (offset 28, 2 octets)
+    img->colorDepth = img->header[28] | (img->header[29] << 8);
     if (img->colorDepth != 8) {
-        fprintf(stderr, "Erreur : L'image n'est pas en 8 bits (profondeur = %d).\n", img->colorDepth);
+        return BMP_ERR_UNSUPPORTED;
+    }
+
+    // Seules les images non compressées sont supportées (pas de RLE8)
+    unsigned int compression = lire_entier(img->header, 30);
+    if (compression != 0) {
+        return BMP_ERR_UNSUPPORTED;
+    }
+
+    // Récupération des dimensions (entiers signés : hauteur négative = image top-down)
+    int32_t width = (int32_t)lire_entier(img->header, 18);     // offset 18
+    int32_t height = (int32_t)lire_entier(img->header, 22);    // offset 22
+    if (width <= 0 || height == 0 || height == INT32_MIN) {
+        return BMP_ERR_DIMENSIONS;
+    }
+    img->width = (unsigned int)width;
+    img->height = (unsigned int)(height < 0 ? -height : height);
+
+    // Taille des données calculée en 64 bits, lignes complétées à 4 octets. Le champ de l'en-tête
+    // (offset 34) n'est qu'indicatif (nul, tronqué à 32 bits ou faux) : il est ignoré.
+    if (!bmp_imageSize(img->width, img->height, 8, &img->dataSize)) {
+        return BMP_ERR_TOO_LARGE;
+    }
+    return BMP_OK;
+}
+
+// Lecture de la palette et des pixels, l'en-tête (54 octets) ayant déjà été lu depuis file
+t_bmp8 * bmp8_readFromFile(FILE * file, const unsigned char * header, t_bmp_status * status) {
+    // Allocation mémoire pour une image t_bmp8
+    t_bmp8 *img = (t_bmp8 *)malloc(sizeof(t_bmp8));
+    if (img == NULL) {
+        bmp_setStatus(status, BMP_ERR_MEMORY);
+        return NULL;
+    }
+    img->ownsData = 1;
+
+    t_bmp_status res = bmp8_parseHeader(img, header);
+    if (res != BMP_OK) {
+        bmp_setStatus(status, res);
         free(img);
-        fclose(file);
         return NULL;
     }
 
     // Lecture de la table de couleurs (1024 octets pour 8 bits)
     if (fread(img->colorTable, sizeof(unsigned char), 1024, file) != 1024) {
-        fprintf(stderr, "Erreur : Impossible de lire la table de couleurs.\n");
+        bmp_setStatus(status, BMP_ERR_READ);
         free(img);
-        fclose(file);
         return NULL;
     }
 
-    // Récupération des dimensions et taille des données
-    img->width = lire_entier(img->header, 18);     // offset 18
-    img->height = lire_entier(img->header, 22);    // offset 22
-    img->dataSize = lire_entier(img->header, 34);  // offset 34
+    // Allocation mémoire pour les données de l'image
+    img->data = (unsigned char *)malloc(sizeof(unsigned char) * img->dataSize);
+    if (img->data == NULL) {
+        bmp_setStatus(status, BMP_ERR_MEMORY);
+        free(img);
+        return NULL;
+    }
 
-    // Si dataSize est nul, on le calcule manuellement
-    if (img->dataSize == 0) {
-        img->dataSize = img->width * img->height;
+    // Lecture des données de l'image, directement dans le tampon final
+    if (!bmp_readFully(file, img->data, img->dataSize)) {
+        bmp_setStatus(status, BMP_ERR_READ);
+        free(img->data);
+        free(img);
+        return NULL;
     }
 
-    // Allocation mémoire pour les données de l'image
-    img->data = (unsigned char *)malloc(sizeof(unsigned char) * img->dataSize);
+    bmp_setStatus(status, BMP_OK);
+    return img;
+}
+
+// Nouvelles dimensions d'une image : champs de t_bmp8 et en-tête (signe de la hauteur conservé, tailles)
+static void redimensionner_entete(t_bmp8 *img, unsigned int width, unsigned int height) {
+    size_t rowSize;
+    bmp_rowSize(width, 8, &rowSize);
+    img->width = width;
+    img->height = height;
+    img->dataSize = rowSize * height;
+
+    int32_t hauteur = (int32_t)lire_entier(img->header, 22);
+    ecrire_entier(img->header, 2, (uint32_t)(BMP8_DATA_OFFSET + img->dataSize));
+    ecrire_entier(img->header, 18, width);
+    ecrire_entier(img->header, 22, (uint32_t)(hauteur < 0 ? -(int32_t)height : (int32_t)height));
+    ecrire_entier(img->header, 34, (uint32_t)img->dataSize);
+}
+
+t_bmp8 * bmp8_allocateLike(const t_bmp8 * model, unsigned int width, unsigned int height) {
+    size_t dataSize;
+    if (model == NULL || width == 0 || height == 0 || width > INT32_MAX || height > INT32_MAX ||
+        !bmp_imageSize(width, height, 8, &dataSize)) {
+        return NULL;
+    }
+    t_bmp8 *img = (t_bmp8 *)malloc(sizeof(t_bmp8));
+    if (img == NULL) {
+        return NULL;
+    }
+    memcpy(img->header, model->header, 54);
+    memcpy(img->colorTable, model->colorTable, 1024);
+    img->colorDepth = 8;
+    img->ownsData = 1;
+    redimensionner_entete(img, width, height);
+    img->data = (unsigned char *)calloc(img->dataSize, 1);
     if (img->data == NULL) {
-        fprintf(stderr, "Erreur : Allocation mémoire échouée pour les données d'image.\n");
         free(img);
-        fclose(file);
         return NULL;
     }
+    return img;
+}
 
-    // Lecture des données de l'image
-    if (fread(img->data, sizeof(unsigned char), img->dataSize, file) != img->dataSize) {
-        fprintf(stderr, "Erreur : Impossible de lire toutes les données de l'image.\n");
+// Lecture réduite : chaque pixel de sortie est la moyenne d'un bloc scale x scale, calculée pendant
+// que les lignes arrivent ; seule l'image réduite est allouée
+t_bmp8 * bmp8_readFromFileScaled(FILE * file, const unsigned char * header, int scale, t_bmp_status * status) {
+    if (scale == 1) {
+        return bmp8_readFromFile(file, header, status);
+    }
+    if (scale != 2 && scale != 4 && scale != 8) {
+        bmp_setStatus(status, BMP_ERR_ARGUMENT);
+        return NULL;
+    }
+    int decalage = scale == 2 ? 1 : (scale == 4 ? 2 : 3);
+
+    t_bmp8 *img = (t_bmp8 *)malloc(sizeof(t_bmp8));
+    if (img == NULL) {
+        bmp_setStatus(status, BMP_ERR_MEMORY);
+        return NULL;
+    }
+    img->ownsData = 1;
+    img->data = NULL;
+
+    t_bmp_status res = bmp8_parseHeader(img, header);
+    if (res != BMP_OK) {
+        bmp_setStatus(status, res);
+        free(img);
+        return NULL;
+    }
+    if (fread(img->colorTable, sizeof(unsigned char), 1024, file) != 1024) {
+        bmp_setStatus(status, BMP_ERR_READ);
+        free(img);
+        return NULL;
+    }
+
+    // Dimensions réduites arrondies au-dessus ; les lignes restent dans l'ordre du fichier. Les groupes de
+    // lignes partent du haut de l'image affichée : dans un fichier bottom-up, le groupe incomplet est le
+    // premier lu, d'où l'avance donnée à l'indice des lignes
+    unsigned int srcWidth = img->width;
+    unsigned int srcHeight = img->height;
+    int32_t hauteur = (int32_t)lire_entier(img->header, 22);
+    unsigned int avance = hauteur > 0 ? (scale - srcHeight % scale) % scale : 0;
+    size_t srcRow = img->dataSize / srcHeight;
+    redimensionner_entete(img, (srcWidth + scale - 1) / scale, (srcHeight + scale - 1) / scale);
+    size_t rowSize = img->dataSize / img->height;
+
+    size_t parBloc = bmp_rowsPerBlock(srcRow, srcHeight);
+    unsigned char *bloc = malloc(parBloc * srcRow);
+    uint32_t *sommes = calloc(img->width, sizeof(uint32_t));
+    img->data = calloc(img->dataSize, 1);
+    if (bloc == NULL || sommes == NULL || img->data == NULL) {
+        res = BMP_ERR_MEMORY;
+    }
+
+    for (unsigned int i = 0; i < srcHeight && res == BMP_OK; ) {
+        unsigned int n = srcHeight - i < parBloc ? srcHeight - i : (unsigned int)parBloc;
+        if (!bmp_readFully(file, bloc, (size_t)n * srcRow)) {
+            res = BMP_ERR_READ;
+            break;
+        }
+        for (unsigned int k = 0; k < n; k++, i++) {
+            const unsigned char *ligne = bloc + (size_t)k * srcRow;
+            for (unsigned int x = 0; x < srcWidth; x++) {
+                sommes[x >> decalage] += ligne[x];
+            }
+
+            // Dernière ligne d'un groupe : moyenne arrondie, puis remise à zéro des sommes
+            unsigned int j = i + avance;
+            if ((j + 1) % scale != 0 && i + 1 != srcHeight) {
+                continue;
+            }
+            unsigned int sortie = j / scale;
+            unsigned char *dst = img->data + (size_t)sortie * rowSize;
+            unsigned int lignes = j % scale + 1 - (sortie == 0 ? avance : 0);
+            for (unsigned int x = 0; x < img->width; x++) {
+                unsigned int reste = srcWidth - x * scale;
+                unsigned int nb = lignes * (reste < (unsigned int)scale ? reste : (unsigned int)scale);
+                dst[x] = (unsigned char)((sommes[x] + nb / 2) / nb);
+            }
+            memset(sommes, 0, img->width * sizeof(uint32_t));
+        }
+    }
+
+    free(bloc);
+    free(sommes);
+    if (res != BMP_OK) {
+        bmp_setStatus(status, res);
         free(img->data);
         free(img);
-        fclose(file);
         return NULL;
     }
+    bmp_setStatus(status, BMP_OK);
+    return img;
+}
 
-    fclose(file);
+// Décodage commun aux deux variantes : en-tête et palette copiés, pixels laissés à l'appelant
+static t_bmp8 * decoder(const unsigned char * buffer, size_t size, t_bmp_status * status) {
+    if (buffer == NULL) {
+        bmp_setStatus(status, BMP_ERR_ARGUMENT);
+        return NULL;
+    }
+    if (size < BMP8_DATA_OFFSET) {
+        bmp_setStatus(status, BMP_ERR_READ);
+        return NULL;
+    }
+    if (buffer[0] != 'B' || buffer[1] != 'M') {
+        bmp_setStatus(status, BMP_ERR_FORMAT);
+        return NULL;
+    }
+
+    t_bmp8 *img = (t_bmp8 *)malloc(sizeof(t_bmp8));
+    if (img == NULL) {
+        bmp_setStatus(status, BMP_ERR_MEMORY);
+        return NULL;
+    }
+    t_bmp_status res = bmp8_parseHeader(img, buffer);
+    if (res != BMP_OK) {
+        bmp_setStatus(status, res);
+        free(img);
+        return NULL;
+    }
+
+    // Pixels placés juste après la palette, comme pour la lecture depuis un fichier
+    if (size - BMP8_DATA_OFFSET < img->dataSize) {
+        bmp_setStatus(status, BMP_ERR_READ);
+        free(img);
+        return NULL;
+    }
+    memcpy(img->colorTable, buffer + 54, 1024);
+    img->data = NULL;
     return img;
 }
 
-// Sauvegarde d'une image BMP
-void bmp8_saveImage(const char *filename, t_bmp8 *img) {
+t_bmp8 * bmp8_decode(const unsigned char * buffer, size_t size, t_bmp_status * status) {
+    t_bmp8 *img = decoder(buffer, size, status);
     if (img == NULL) {
-        fprintf(stderr, "Erreur : Image invalide pour la sauvegarde.\n");
-        return;
+        return NULL;
     }
 
-    FILE *f = fopen(filename, "wb");
-    if (f == NULL) {
-        fprintf(stderr, "Erreur : Impossible d'ouvrir le fichier %s en écriture.\n", filename);
-        return;
+    img->data = (unsigned char *)malloc(img->dataSize);
+    if (img->data == NULL) {
+        bmp_setStatus(status, BMP_ERR_MEMORY);
+        free(img);
+        return NULL;
     }
+    memcpy(img->data, buffer + BMP8_DATA_OFFSET, img->dataSize);
+    img->ownsData = 1;
+    bmp_setStatus(status, BMP_OK);
+    return img;
+}
 
-    // Écriture de l'en-tête BMP (54 octets)
-    fwrite(img->header, sizeof(unsigned char), 54, f);
+t_bmp8 * bmp8_decodeInPlace(unsigned char * buffer, size_t size, t_bmp_status * status) {
+    t_bmp8 *img = decoder(buffer, size, status);
+    if (img == NULL) {
+        return NULL;
+    }
 
-    // Écriture de la table de couleurs (1024 octets pour image 8 bits)
-    fwrite(img->colorTable, sizeof(unsigned char), 1024, f);
+    // Même disposition en mémoire que dans le fichier : les pixels restent dans le tampon
+    img->data = buffer + BMP8_DATA_OFFSET;
+    img->ownsData = 0;
+    bmp_setStatus(status, BMP_OK);
+    return img;
+}
+
+size_t bmp8_encodedSize(const t_bmp8 * img) {
+    if (img == NULL || img->data == NULL || img->dataSize > SIZE_MAX - BMP8_DATA_OFFSET) {
+        return 0;
+    }
+    return BMP8_DATA_OFFSET + img->dataSize;
+}
 
-    // Écriture des données de l'image (pixels)
-    fwrite(img->data, sizeof(unsigned char), img->dataSize, f);
+t_bmp_status bmp8_encode(const t_bmp8 * img, unsigned char * buffer, size_t size, size_t * written) {
+    size_t total = bmp8_encodedSize(img);
+    if (written != NULL) {
+        *written = 0;
+    }
+    if (total == 0 || buffer == NULL) {
+        return BMP_ERR_ARGUMENT;
+    }
+    if (size < total) {
+        return BMP_ERR_BUFFER;
+    }
 
-    fclose(f);
-    printf("Image sauvegardée dans %s\n", filename);
+    memcpy(buffer, img->header, 54);
+    memcpy(buffer + 54, img->colorTable, 1024);
+    memmove(buffer + BMP8_DATA_OFFSET, img->data, img->dataSize);   // img->data peut pointer dans buffer
+    if (written != NULL) {
+        *written = total;
+    }
+    return BMP_OK;
+}
+
+// Sauvegarde d'une image BMP
+t_bmp_status bmp8_saveImage(const char *filename, const t_bmp8 *img) {
+    if (filename == NULL || img == NULL || img->data == NULL) {
+        return BMP_ERR_ARGUMENT;
+    }
+
+    t_bmp_writer w;
+    t_bmp_status res = bmp_writerOpen(&w, filename);
+    if (res != BMP_OK) {
+        return res;
+    }
+
+    // En-tête BMP (54 octets), table de couleurs (1024 octets) et pixels rassemblés en un seul writev
+    res = bmp_writerPush(&w, img->header, 54);
+    if (res == BMP_OK) {
+        res = bmp_writerPush(&w, img->colorTable, 1024);
+    }
+    if (res == BMP_OK) {
+        res = bmp_writerPush(&w, img->data, img->dataSize);
+    }
+    return bmp_writerClose(&w, res);
 }
 
 // Libération de la mémoire d'une image
 void bmp8_free(t_bmp8 *img) {
     if (img != NULL) {
-        if (img->data != NULL) {
+        if (img->data != NULL && img->ownsData) {
             free(img->data);
         }
         free(img);
     }
 }
 
-// Affichage des informations de l'image
-void bmp8_printInfo(t_bmp8 *img) {
+// Affichage des informations de l'image (seule fonction d'affichage, appelée à la demande)
+void bmp8_printInfo(const t_bmp8 *img) {
     if (img == NULL) {
         printf("Aucune image à afficher.\n");
         return;
@@ -152,154 +423,157 @@ void bmp8_printInfo(t_bmp8 *img) {
     printf("Largeur      : %u pixels\n", img->width);
     printf("Hauteur      : %u pixels\n", img->height);
     printf("Profondeur   : %u bits\n", img->colorDepth);
-    printf("Taille image : %u octets\n", img->dataSize);
+    printf("Taille image : %zu octets\n", img->dataSize);
     printf("-------------------------------\n");
 }
 
 // Ajustement de la luminosité
-void bmp8_brightness(t_bmp8 *img, int value) {
+t_bmp_status bmp8_brightness(t_bmp8 *img, int value) {
     if (img == NULL || img->data == NULL) {
-        printf("Erreur : image non chargée ou invalide.\n");
-        return;
-    }
-
-    for (unsigned int i = 0; i < img->dataSize; i++) {
-        int pixel = img->data[i] + value;
-
-        // Clamp dans l'intervalle [0, 255]
-        if (pixel > 255) {
-            pixel = 255;
-        } else if (pixel < 0) {
-            pixel = 0;
-        }
-
-        img->data[i] = (unsigned char)pixel;
+        return BMP_ERR_ARGUMENT;
     }
 
-    printf("Luminosité ajustée de %+d.\n", value);
+    // Addition saturée dans l'intervalle [0, 255]
+    kernels_get()->addSat(img->data, img->dataSize, value);
+    return BMP_OK;
 }
 
 // Application d'un filtre négatif
-void bmp8_negative(t_bmp8 *img) {
+t_bmp_status bmp8_negative(t_bmp8 *img) {
     if (img == NULL || img->data == NULL) {
-        printf("Erreur : image non chargée ou invalide.\n");
-        return;
-    }
-
-    for (unsigned int i = 0; i < img->dataSize; i++) {
-        img->data[i] = 255 - img->data[i];
+        return BMP_ERR_ARGUMENT;
     }
 
-    printf("Filtre négatif appliqué avec succès.\n");
+    kernels_get()->invert(img->data, img->dataSize);
+    return BMP_OK;
 }
 
 // Binarisation avec seuil
-void bmp8_threshold(t_bmp8 *img, int threshold) {
-    if (img == NULL || img->data == NULL) {
-        printf("Erreur : image non chargée ou invalide.\n");
-        return;
+t_bmp_status bmp8_threshold(t_bmp8 *img, int threshold) {
+    if (img == NULL || img->data == NULL || threshold < 0 || threshold > 255) {
+        return BMP_ERR_ARGUMENT;
     }
 
-    if (threshold < 0 || threshold > 255) {
-        printf("Erreur : le seuil doit être entre 0 et 255.\n");
-        return;
-    }
-
-    for (unsigned int i = 0; i < img->dataSize; i++) {
-        if (img->data[i] >= threshold) {
-            img->data[i] = 255;  // Blanc
-        } else {
-            img->data[i] = 0;    // Noir
-        }
-    }
-
-    printf("Binarisation appliquée avec un seuil de %d.\n", threshold);
+    // Blanc au-dessus du seuil, noir en dessous
+    kernels_get()->threshold(img->data, img->dataSize, threshold);
+    return BMP_OK;
 }
 
 // Application d'un filtre de convolution
-void bmp8_applyFilter(t_bmp8 *img, float **kernel, int kernelSize) {
-    if (img == NULL || img->data == NULL) {
-        printf("Erreur : image non chargée ou invalide.\n");
-        return;
+t_bmp_status bmp8_applyFilter(t_bmp8 *img, float **kernel, int kernelSize) {
+    t_bmp8_scratch scratch = {NULL, 0};
+    t_bmp_status res = bmp8_applyFilterScratch(img, kernel, kernelSize, &scratch);
+    bmp8_freeScratch(&scratch);
+    return res;
+}
+
+t_bmp_status bmp8_applyFilterScratch(t_bmp8 *img, float **kernel, int kernelSize, t_bmp8_scratch *scratch) {
+    if (img == NULL || img->data == NULL || scratch == NULL) {
+        return BMP_ERR_ARGUMENT;
     }
 
+    // Le noyau doit être de taille impaire et > 0
     if (kernel == NULL || kernelSize <= 0 || kernelSize % 2 == 0) {
-        printf("Erreur : noyau de convolution invalide (doit être impair et > 0).\n");
-        return;
+        return BMP_ERR_ARGUMENT;
     }
 
     int width = img->width;
     int height = img->height;
     int offset = kernelSize / 2;
-
-    // Allocation temporaire pour stocker les nouvelles valeurs
-    unsigned char *newData = malloc(img->dataSize);
-    if (newData == NULL) {
-        printf("Erreur : impossible d'allouer de la mémoire pour l'image filtrée.\n");
-        return;
+    // Lignes complétées à 4 octets : l'écart entre deux lignes n'est pas width
+    size_t rowSize = height > 0 ? img->dataSize / (size_t)height : 0;
+
+    // Tampon de destination : celui de scratch, agrandi seulement s'il est trop petit
+    if (scratch->capacity < img->dataSize) {
+        free(scratch->data);
+        scratch->data = malloc(img->dataSize);
+        scratch->capacity = scratch->data != NULL ? img->dataSize : 0;
+        if (scratch->data == NULL) {
+            return BMP_ERR_MEMORY;
+        }
     }
+    unsigned char *newData = scratch->data;
 
     // Initialiser avec les valeurs originales (pour les bordures)
-    for (unsigned int i = 0; i < img->dataSize; i++) {
-        newData[i] = img->data[i];
-    }
-
-    // Appliquer la convolution sur chaque pixel (hors bordures)
-    for (int y = offset; y < height - offset; y++) {
-        for (int x = offset; x < width - offset; x++) {
-            float sum = 0.0f;
-
-            // Appliquer le noyau autour du pixel (x, y)
-            for (int ky = -offset; ky <= offset; ky++) {
-                for (int kx = -offset; kx <= offset; kx++) {
-                    int ix = x + kx;
-                    int iy = y + ky;
-                    int imageIndex = iy * width + ix;
-                    float pixel = (float)img->data[imageIndex];
-                    sum += pixel * kernel[ky + offset][kx + offset];
-                }
-            }
-
-            // Clamp dans [0,255]
-            if (sum < 0) sum = 0;
-            if (sum > 255) sum = 255;
+    memcpy(newData, img->data, img->dataSize);
+
+    // Noyau mis à plat pour les noyaux vectorisés
+    float *flat = malloc(sizeof(float) * (size_t)kernelSize * kernelSize);
+    const unsigned char **rows = malloc(sizeof(unsigned char *) * kernelSize);
+    if (flat == NULL || rows == NULL) {
+        free(flat);
+        free(rows);
+        return BMP_ERR_MEMORY;
+    }
+    for (int ky = 0; ky < kernelSize; ky++) {
+        for (int kx = 0; kx < kernelSize; kx++) {
+            flat[ky * kernelSize + kx] = kernel[ky][kx];
+        }
+    }
 
-            newData[y * width + x] = (unsigned char)sum;
+    // Appliquer la convolution sur chaque pixel (hors bordures), une ligne à la fois
+    const t_kernels *k = kernels_get();
+    for (int y = offset; y < height - offset && width - offset > offset; y++) {
+        for (int ky = 0; ky < kernelSize; ky++) {
+            rows[ky] = img->data + (size_t)(y + ky - offset) * rowSize;
         }
+        k->convolveRow(newData + (size_t)y * rowSize, rows, offset, width - offset,
+                       1, flat, kernelSize, KERNEL_ROUND_TRUNC);
     }
 
-    // Copier les nouvelles valeurs dans l'image
-    for (unsigned int i = 0; i < img->dataSize; i++) {
-        img->data[i] = newData[i];
+    free(flat);
+    free(rows);
+
+    // Échange des tampons : l'ancien devient le tampon de travail de la convolution suivante.
+    // Des pixels prêtés par l'appelant (bmp8_decodeInPlace) restent en place : on y recopie le résultat.
+    if (img->ownsData) {
+        scratch->data = img->data;
+        scratch->capacity = img->dataSize;
+        img->data = newData;
+    } else {
+        memcpy(img->data, newData, img->dataSize);
     }
+    return BMP_OK;
+}
 
-    free(newData);
-    printf("Filtre appliqué avec succès.\n");
+void bmp8_freeScratch(t_bmp8_scratch *scratch) {
+    if (scratch != NULL) {
+        free(scratch->data);
+        scratch->data = NULL;
+        scratch->capacity = 0;
+    }
 }
 //part 3
 
-unsigned int * bmp8_computeHistogram(t_bmp8 * img) {
+uint64_t * bmp8_computeHistogram(const t_bmp8 * img) {
     if (img == NULL || img->data == NULL) return NULL;
 
-    unsigned int *hist = calloc(256, sizeof(unsigned int));
+    uint64_t *hist = calloc(256, sizeof(uint64_t));
     if (!hist) return NULL;
 
-    for (unsigned int i = 0; i < img->dataSize; i++) {
-        hist[img->data[i]]++;
+    // Le noyau compte sur 32 bits : on l'appelle par blocs et on cumule sur 64 bits
+    const t_kernels *k = kernels_get();
+    for (size_t debut = 0; debut < img->dataSize; debut += BMP_IO_CHUNK) {
+        size_t n = img->dataSize - debut < BMP_IO_CHUNK ? img->dataSize - debut : BMP_IO_CHUNK;
+        unsigned int partiel[256] = {0};
+        k->histogram(img->data + debut, n, partiel);
+        for (int v = 0; v < 256; v++) {
+            hist[v] += partiel[v];
+        }
     }
 
     return hist;
 }
 
-unsigned int * bmp8_computeCDF(unsigned int * hist) {
+unsigned int * bmp8_computeCDF(uint64_t * hist) {
     if (!hist) return NULL;
 
     unsigned int *hist_eq = malloc(256 * sizeof(unsigned int));
     if (!hist_eq) return NULL;
 
-    unsigned int cdf[256] = {0};
-    unsigned int total = 0;
-    unsigned int cdf_min = 0;
+    uint64_t cdf[256] = {0};
+    uint64_t total = 0;
+    uint64_t cdf_min = 0;
 
     // Calcul du CDF brut
     for (int i = 0; i < 256; i++) {
@@ -317,15 +591,232 @@ unsigned int * bmp8_computeCDF(unsigned int * hist) {
 
     // Normalisation du CDF pour obtenir les nouvelles valeurs [0, 255]
     for (int i = 0; i < 256; i++) {
-        hist_eq[i] = round(((float)(cdf[i] - cdf_min) / (total - cdf_min)) * 255);
+        hist_eq[i] = round(((float)(cdf[i] - cdf_min) / (float)(total - cdf_min)) * 255);
     }
 
     return hist_eq;
 }
-void bmp8_equalize(t_bmp8 * img, unsigned int * hist_eq) {
-    if (!img || !img->data || !hist_eq) return;
+t_bmp_status bmp8_equalize(t_bmp8 * img, unsigned int * hist_eq) {
+    if (!img || !img->data || !hist_eq) return BMP_ERR_ARGUMENT;
+
+    // Table de correspondance sur 8 bits pour le noyau applyLut
+    unsigned char lut[256];
+    for (int i = 0; i < 256; i++) {
+        lut[i] = (unsigned char) hist_eq[i];
+    }
+
+    kernels_get()->applyLut(img->data, img->dataSize, lut);
+    return BMP_OK;
+}
+
+// --- Vues sur un rectangle ---
+
+// Indice dans data de la ligne y de l'image affichée (0 en haut)
+static size_t ligne_fichier(const t_bmp8 *img, int y) {
+    int32_t hauteur = (int32_t)lire_entier(img->header, 22);
+    return hauteur > 0 ? (size_t)img->height - 1 - (size_t)y : (size_t)y;
+}
+
+static unsigned char *ligne_vue(const t_bmp8_view *view, int i) {
+    return view->origin + (ptrdiff_t)i * view->stride;
+}
 
-    for (unsigned int i = 0; i < img->dataSize; i++) {
-        img->data[i] = (unsigned char) hist_eq[img->data[i]];
+static int vue_valide(const t_bmp8_view *view) {
+    return view != NULL && view->image != NULL && view->origin != NULL && view->width > 0 && view->height > 0;
+}
+
+t_bmp_status bmp8_view(t_bmp8 *img, int x, int y, int width, int height, t_bmp8_view *view) {
+    if (img == NULL || img->data == NULL || view == NULL || x < 0 || y < 0 || width <= 0 || height <= 0 ||
+        (unsigned int)x >= img->width || (unsigned int)width > img->width - (unsigned int)x ||
+        (unsigned int)y >= img->height || (unsigned int)height > img->height - (unsigned int)y) {
+        return BMP_ERR_ARGUMENT;
+    }
+
+    size_t rowSize = img->dataSize / img->height;
+    view->image = img;
+    view->origin = img->data + ligne_fichier(img, y) * rowSize + (size_t)x;
+    view->stride = (int32_t)lire_entier(img->header, 22) > 0 ? -(ptrdiff_t)rowSize : (ptrdiff_t)rowSize;
+    view->x = x;
+    view->y = y;
+    view->width = width;
+    view->height = height;
+    return BMP_OK;
+}
+
+t_bmp_status bmp8_viewBrightness(const t_bmp8_view *view, int value) {
+    if (!vue_valide(view)) {
+        return BMP_ERR_ARGUMENT;
+    }
+
+    const t_kernels *k = kernels_get();
+    for (int i = 0; i < view->height; i++) {
+        k->addSat(ligne_vue(view, i), (size_t)view->width, value);
+    }
+    return BMP_OK;
+}
+
+t_bmp_status bmp8_viewNegative(const t_bmp8_view *view) {
+    if (!vue_valide(view)) {
+        return BMP_ERR_ARGUMENT;
+    }
+
+    const t_kernels *k = kernels_get();
+    for (int i = 0; i < view->height; i++) {
+        k->invert(ligne_vue(view, i), (size_t)view->width);
+    }
+    return BMP_OK;
+}
+
+t_bmp_status bmp8_viewThreshold(const t_bmp8_view *view, int threshold) {
+    if (!vue_valide(view) || threshold < 0 || threshold > 255) {
+        return BMP_ERR_ARGUMENT;
+    }
+
+    const t_kernels *k = kernels_get();
+    for (int i = 0; i < view->height; i++) {
+        k->threshold(ligne_vue(view, i), (size_t)view->width, threshold);
+    }
+    return BMP_OK;
+}
+
+uint64_t * bmp8_viewHistogram(const t_bmp8_view * view) {
+    if (!vue_valide(view)) return NULL;
+
+    uint64_t *hist = calloc(256, sizeof(uint64_t));
+    if (!hist) return NULL;
+
+    // Une ligne compte moins de 2^31 pixels : le noyau (compteurs 32 bits) est appelé ligne par ligne
+    const t_kernels *k = kernels_get();
+    for (int i = 0; i < view->height; i++) {
+        unsigned int partiel[256] = {0};
+        k->histogram(ligne_vue(view, i), (size_t)view->width, partiel);
+        for (int v = 0; v < 256; v++) {
+            hist[v] += partiel[v];
+        }
+    }
+    return hist;
+}
+
+t_bmp_status bmp8_viewEqualize(const t_bmp8_view *view, unsigned int *hist_eq) {
+    if (!vue_valide(view) || !hist_eq) return BMP_ERR_ARGUMENT;
+
+    unsigned char lut[256];
+    for (int i = 0; i < 256; i++) {
+        lut[i] = (unsigned char) hist_eq[i];
     }
+
+    const t_kernels *k = kernels_get();
+    for (int i = 0; i < view->height; i++) {
+        k->applyLut(ligne_vue(view, i), (size_t)view->width, lut);
+    }
+    return BMP_OK;
+}
+
+t_bmp_status bmp8_viewApplyFilter(const t_bmp8_view *view, float **kernel, int kernelSize) {
+    if (!vue_valide(view) || kernel == NULL || kernelSize <= 0 || kernelSize % 2 == 0) {
+        return BMP_ERR_ARGUMENT;
+    }
+
+    const t_bmp8 *img = view->image;
+    int offset = kernelSize / 2;
+    size_t rowSize = img->dataSize / img->height;
+
+    // Colonnes convoluées : celles du rectangle à au moins offset colonnes des bords de l'image
+    int debut = view->x > offset ? view->x : offset;
+    int fin = view->x + view->width < (int)img->width - offset ? view->x + view->width : (int)img->width - offset;
+
+    // Résultat du rectangle seul, chaque ligne précédée de offset octets : le pointeur de destination passé au
+    // noyau est décalé comme les lignes source et reste dans le tampon
+    size_t largeur = (size_t)view->width + offset;
+    size_t taille;
+    if (!bmp_mulSize(largeur, (size_t)view->height, &taille)) {
+        return BMP_ERR_TOO_LARGE;
+    }
+    unsigned char *resultat = malloc(taille);
+    float *flat = malloc(sizeof(float) * (size_t)kernelSize * kernelSize);
+    const unsigned char **rows = malloc(sizeof(unsigned char *) * kernelSize);
+    if (resultat == NULL || flat == NULL || rows == NULL) {
+        free(resultat);
+        free(flat);
+        free(rows);
+        return BMP_ERR_MEMORY;
+    }
+    for (int ky = 0; ky < kernelSize; ky++) {
+        for (int kx = 0; kx < kernelSize; kx++) {
+            flat[ky * kernelSize + kx] = kernel[ky][kx];
+        }
+    }
+
+    // Même orientation que bmp8_applyFilter : le noyau est appliqué aux lignes dans l'ordre du fichier
+    const t_kernels *k = kernels_get();
+    for (int i = 0; i < view->height; i++) {
+        unsigned char *dst = resultat + (size_t)i * largeur + offset;
+        memcpy(dst, ligne_vue(view, i), (size_t)view->width);
+        size_t f = ligne_fichier(img, view->y + i);
+        if (f < (size_t)offset || f + offset >= img->height || debut >= fin) {
+            continue;
+        }
+        for (int ky = 0; ky < kernelSize; ky++) {
+            rows[ky] = img->data + (f + ky - offset) * rowSize + (debut - offset);
+        }
+        k->convolveRow(dst + (debut - view->x) - offset, rows, offset, (size_t)(fin - debut + offset),
+                       1, flat, kernelSize, KERNEL_ROUND_TRUNC);
+    }
+
+    // Recopie une fois toutes les lignes calculées : les voisins lus étaient ceux d'origine
+    for (int i = 0; i < view->height; i++) {
+        memcpy(ligne_vue(view, i), resultat + (size_t)i * largeur + offset, (size_t)view->width);
+    }
+
+    free(resultat);
+    free(flat);
+    free(rows);
+    return BMP_OK;
+}
+
+t_bmp_status bmp8_viewSave(const char *filename, const t_bmp8_view *view) {
+    if (filename == NULL || !vue_valide(view)) {
+        return BMP_ERR_ARGUMENT;
+    }
+
+    // En-tête de l'image aux dimensions du rectangle (même orientation)
+    t_bmp8 entete;
+    memcpy(entete.header, view->image->header, 54);
+    redimensionner_entete(&entete, (unsigned int)view->width, (unsigned int)view->height);
+    size_t rowSize = entete.dataSize / entete.height;
+    int basEnHaut = (int32_t)lire_entier(entete.header, 22) > 0;
+
+    // Lignes du rectangle complétées à 4 octets dans un bloc (octets de complément laissés à 0)
+    size_t parBloc = bmp_rowsPerBlock(rowSize, entete.height);
+    unsigned char *bloc = calloc(parBloc, rowSize);
+    if (bloc == NULL) {
+        return BMP_ERR_MEMORY;
+    }
+
+    t_bmp_writer w;
+    t_bmp_status res = bmp_writerOpen(&w, filename);
+    if (res != BMP_OK) {
+        free(bloc);
+        return res;
+    }
+    res = bmp_writerPush(&w, entete.header, 54);
+    if (res == BMP_OK) {
+        res = bmp_writerPush(&w, view->image->colorTable, 1024);
+    }
+    for (int i = 0; i < view->height && res == BMP_OK; ) {
+        int n = view->height - i < (int)parBloc ? view->height - i : (int)parBloc;
+        for (int j = 0; j < n; j++) {
+            int ligne = basEnHaut ? view->height - 1 - (i + j) : i + j;
+            memcpy(bloc + (size_t)j * rowSize, ligne_vue(view, ligne), (size_t)view->width);
+        }
+        res = bmp_writerPush(&w, bloc, (size_t)n * rowSize);
+        if (res == BMP_OK) {
+            res = bmp_writerFlush(&w);
+        }
+        i += n;
+    }
+
+    res = bmp_writerClose(&w, res);
+    free(bloc);
+    return res;
 }
@@ -14,6 +14,9 @@
 #define BMP8_H
 
 #include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "bmp_status.h"
 
 // Structure pour une image BMP 8 bits
 typedef struct {
@@ -23,29 +26,94 @@ typedef struct {
     unsigned int width;
     unsigned int height;
     unsigned int colorDepth;
-    unsigned int dataSize;
+    size_t dataSize;        // lignes complétées à 4 octets comprises ; peut dépasser 4 Go
+    int ownsData;           // 0 : data pointe dans un tampon de l'appelant (bmp8_decodeInPlace), non libéré
 } t_bmp8;
 
-// Fonctions de base
-t_bmp8 * bmp8_loadImage(const char * filename);
-void bmp8_saveImage(const char * filename, t_bmp8 * img);
+// Position des pixels dans un fichier BMP 8 bits : en-tête (54 octets) + palette (1024 octets)
+#define BMP8_DATA_OFFSET (54 + 1024)
+
+// Tampon de travail réutilisable d'une convolution à l'autre (un par thread en traitement par lot)
+typedef struct {
+    unsigned char * data;
+    size_t capacity;
+} t_bmp8_scratch;
+
+// Vue sur un rectangle d'une image 8 bits, sans copie (bmp8_view). Les coordonnées sont celles de l'image
+// affichée (ligne 0 en haut) : la ligne i de la vue commence à origin + i * stride, stride étant négatif
+// pour une image rangée du bas vers le haut. Les traitements sur une vue ne parcourent que le rectangle ;
+// les convolutions lisent le voisinage réel dans l'image autour du rectangle.
+typedef struct {
+    t_bmp8 * image;
+    unsigned char * origin;
+    ptrdiff_t stride;
+    int x;
+    int y;
+    int width;
+    int height;
+} t_bmp8_view;
+
+// Fonctions de base. Aucune n'écrit sur la sortie standard (sauf bmp8_printInfo) : les chargements
+// renvoient NULL et déposent la cause dans *status (qui peut être NULL), les autres renvoient un t_bmp_status.
+t_bmp8 * bmp8_loadImage(const char * filename, t_bmp_status * status);
+t_bmp_status bmp8_saveImage(const char * filename, const t_bmp8 * img);
 void bmp8_free(t_bmp8 * img);
-void bmp8_printInfo(t_bmp8 * img);
+void bmp8_printInfo(const t_bmp8 * img);
+
+// Lecture depuis un fichier déjà ouvert dont l'en-tête de 54 octets a été lu (utilisé par bmp_open)
+t_bmp8 * bmp8_readFromFile(FILE * file, const unsigned char * header, t_bmp_status * status);
+
+// Chargement réduit (miniatures) : scale vaut 1, 2, 4 ou 8 ; chaque pixel est la moyenne d'un bloc
+// scale x scale, calculée pendant la lecture, sans allouer l'image pleine résolution. Les blocs sont alignés
+// sur le coin haut gauche de l'image affichée, quel que soit le sens de stockage
+t_bmp8 * bmp8_loadImageScaled(const char * filename, int scale, t_bmp_status * status);
+t_bmp8 * bmp8_readFromFileScaled(FILE * file, const unsigned char * header, int scale, t_bmp_status * status);
+
+// Image vide (pixels à 0) de width x height reprenant l'en-tête, l'orientation et la palette de model ;
+// NULL si les dimensions sont invalides ou si l'allocation échoue
+t_bmp8 * bmp8_allocateLike(const t_bmp8 * model, unsigned int width, unsigned int height);
+
+// Vérification d'un en-tête de 54 octets ; renseigne header, width, height, colorDepth et dataSize de img
+t_bmp_status bmp8_parseHeader(t_bmp8 * img, const unsigned char * header);
+
+// Décodage et encodage en mémoire, sans fichier
+t_bmp8 * bmp8_decode(const unsigned char * buffer, size_t size, t_bmp_status * status);   // pixels copiés
+t_bmp8 * bmp8_decodeInPlace(unsigned char * buffer, size_t size, t_bmp_status * status);  // pixels laissés dans
+                                                                       // buffer, qui doit rester valide jusqu'à bmp8_free
+size_t bmp8_encodedSize(const t_bmp8 * img);                           // taille exacte du fichier encodé, 0 si erreur
+t_bmp_status bmp8_encode(const t_bmp8 * img, unsigned char * buffer, size_t size,
+                         size_t * written);                            // *written : octets écrits (peut être NULL)
 
 // Fonctions de traitement d'image
-void bmp8_brightness(t_bmp8 *img, int value);
-void bmp8_negative(t_bmp8 *img);
-void bmp8_threshold(t_bmp8 *img, int threshold);
-void bmp8_applyFilter(t_bmp8 *img, float **kernel, int kernelSize);
+t_bmp_status bmp8_brightness(t_bmp8 *img, int value);
+t_bmp_status bmp8_negative(t_bmp8 *img);
+t_bmp_status bmp8_threshold(t_bmp8 *img, int threshold);
+t_bmp_status bmp8_applyFilter(t_bmp8 *img, float **kernel, int kernelSize);
+
+// Variante de bmp8_applyFilter qui réutilise scratch ; les tampons de l'image et de scratch sont échangés
+t_bmp_status bmp8_applyFilterScratch(t_bmp8 *img, float **kernel, int kernelSize, t_bmp8_scratch *scratch);
+void bmp8_freeScratch(t_bmp8_scratch *scratch);
 
 // Fonction utilitaire
 unsigned int lire_entier(const unsigned char *buffer, int offset);
 
 //part 3
 
-unsigned int * bmp8_computeHistogram(t_bmp8 * img);
-unsigned int * bmp8_computeCDF(unsigned int * hist);
-void bmp8_equalize(t_bmp8 * img, unsigned int * hist_eq);
+uint64_t * bmp8_computeHistogram(const t_bmp8 * img);
+unsigned int * bmp8_computeCDF(uint64_t * hist);
+t_bmp_status bmp8_equalize(t_bmp8 * img, unsigned int * hist_eq);
+
+// Vues : rectangle de width x height pixels à partir de (x, y), entièrement dans l'image (BMP_ERR_ARGUMENT sinon)
+t_bmp_status bmp8_view(t_bmp8 * img, int x, int y, int width, int height, t_bmp8_view * view);
+t_bmp_status bmp8_viewBrightness(const t_bmp8_view * view, int value);
+t_bmp_status bmp8_viewNegative(const t_bmp8_view * view);
+t_bmp_status bmp8_viewThreshold(const t_bmp8_view * view, int threshold);
+uint64_t * bmp8_viewHistogram(const t_bmp8_view * view);              // histogramme du seul rectangle
+t_bmp_status bmp8_viewEqualize(const t_bmp8_view * view, unsigned int * hist_eq);
+// Convolution du rectangle, mêmes règles que bmp8_applyFilter (troncature, pixels du bord de l'image inchangés)
+t_bmp_status bmp8_viewApplyFilter(const t_bmp8_view * view, float **kernel, int kernelSize);
+// Enregistre le rectangle comme une image à part entière (en-tête et palette de l'image), sans la copier
+t_bmp_status bmp8_viewSave(const char * filename, const t_bmp8_view * view);
 
 
 #endif // BMP8_H
\ No newline at end of file
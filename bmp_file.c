@@ -0,0 +1,154 @@
+/*
+* Fichier : bmp_file.c
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Implémente les entrées/sorties par blocs : taille de bloc partagée (atomique), écriture
+ *           rassemblée par writev sous POSIX (fwrite sans tampon sous Windows), lecture par tranches.
+ */
+
+#include "bmp_file.h"
+#include "bmp_size.h"
+#include <stdatomic.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#endif
+
+static _Atomic size_t taille_bloc = BMP_IO_BLOCK_DEFAULT;
+
+size_t bmp_ioBlockSize(void) {
+    return atomic_load_explicit(&taille_bloc, memory_order_relaxed);
+}
+
+void bmp_setIoBlockSize(size_t size) {
+    atomic_store_explicit(&taille_bloc, size == 0 ? BMP_IO_BLOCK_DEFAULT : size, memory_order_relaxed);
+}
+
+size_t bmp_rowsPerBlock(size_t rowSize, size_t height) {
+    size_t n = rowSize == 0 ? height : bmp_ioBlockSize() / rowSize;
+    if (n > height) {
+        n = height;
+    }
+    return n == 0 ? 1 : n;
+}
+
+t_bmp_status bmp_writerOpen(t_bmp_writer *w, const char *filename) {
+    w->count = 0;
+#ifdef _WIN32
+    w->file = fopen(filename, "wb");
+    if (w->file == NULL) {
+        return BMP_ERR_OPEN;
+    }
+    // Les blocs sont déjà gros : pas de copie dans le tampon de stdio
+    setvbuf(w->file, NULL, _IONBF, 0);
+#else
+    w->fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (w->fd < 0) {
+        return BMP_ERR_OPEN;
+    }
+#endif
+    return BMP_OK;
+}
+
+t_bmp_status bmp_writerPush(t_bmp_writer *w, const void *data, size_t size) {
+    if (size == 0) {
+        return BMP_OK;
+    }
+    if (w->count == BMP_WRITER_PARTS) {
+        t_bmp_status res = bmp_writerFlush(w);
+        if (res != BMP_OK) {
+            return res;
+        }
+    }
+    w->parts[w->count].data = data;
+    w->parts[w->count].size = size;
+    w->count++;
+    return BMP_OK;
+}
+
+t_bmp_status bmp_writerFlush(t_bmp_writer *w) {
+#ifdef _WIN32
+    for (int i = 0; i < w->count; i++) {
+        if (fwrite(w->parts[i].data, 1, w->parts[i].size, w->file) != w->parts[i].size) {
+            w->count = 0;
+            return BMP_ERR_WRITE;
+        }
+    }
+#else
+    struct iovec iov[BMP_WRITER_PARTS];
+    for (int i = 0; i < w->count; i++) {
+        iov[i].iov_base = (void *)w->parts[i].data;
+        iov[i].iov_len = w->parts[i].size;
+    }
+
+    // Écriture partielle (signal, morceaux de plus de 2 Go) : on reprend là où le noyau s'est arrêté
+    int premier = 0;
+    while (premier < w->count) {
+        ssize_t n = writev(w->fd, iov + premier, w->count - premier);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            w->count = 0;
+            return BMP_ERR_WRITE;
+        }
+        size_t reste = (size_t)n;
+        while (premier < w->count && reste >= iov[premier].iov_len) {
+            reste -= iov[premier].iov_len;
+            premier++;
+        }
+        if (premier < w->count) {
+            iov[premier].iov_base = (char *)iov[premier].iov_base + reste;
+            iov[premier].iov_len -= reste;
+        }
+    }
+#endif
+    w->count = 0;
+    return BMP_OK;
+}
+
+t_bmp_status bmp_writerClose(t_bmp_writer *w, t_bmp_status res) {
+    if (res == BMP_OK) {
+        res = bmp_writerFlush(w);
+    }
+#ifdef _WIN32
+    if (fclose(w->file) != 0 && res == BMP_OK) {
+        res = BMP_ERR_WRITE;
+    }
+#else
+    if (close(w->fd) != 0 && res == BMP_OK) {
+        res = BMP_ERR_WRITE;
+    }
+#endif
+    return res;
+}
+
+bool bmp_readFully(FILE *f, void *buffer, size_t size) {
+    unsigned char *dst = buffer;
+    for (size_t lu = 0; lu < size; ) {
+        size_t bloc = size - lu < BMP_IO_CHUNK ? size - lu : BMP_IO_CHUNK;
+        if (fread(dst + lu, 1, bloc, f) != bloc) {
+            return false;
+        }
+        lu += bloc;
+    }
+    return true;
+}
+
+int bmp_makeDirectory(const char *path) {
+#ifdef _WIN32
+    int res = _mkdir(path);
+#else
+    int res = mkdir(path, 0755);
+#endif
+    struct stat st;
+    if (res != 0 && !(errno == EEXIST && stat(path, &st) == 0 && S_ISDIR(st.st_mode))) {
+        return -1;
+    }
+    return 0;
+}
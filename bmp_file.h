@@ -0,0 +1,68 @@
+/*
+* Fichier : bmp_file.h
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Entrées/sorties fichier par gros blocs. Les lignes sont converties dans un tampon de la taille
+ *           d'un bloc puis lues ou écrites en un seul appel ; à l'écriture, les en-têtes et les blocs
+ *           sont rassemblés par writev, si bien qu'une image courante s'enregistre en quelques appels
+ *           système au lieu d'un par ligne.
+ */
+
+#ifndef BMP_FILE_H
+#define BMP_FILE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "bmp_status.h"
+
+// Taille de bloc par défaut (octets)
+#define BMP_IO_BLOCK_DEFAULT ((size_t)8 << 20)
+
+// Nombre maximal de morceaux rassemblés dans un même writev
+#define BMP_WRITER_PARTS 16
+
+// Taille de bloc courante, commune à tous les threads
+size_t bmp_ioBlockSize(void);
+
+// Change la taille de bloc ; 0 rétablit la valeur par défaut
+void bmp_setIoBlockSize(size_t size);
+
+// Nombre de lignes de rowSize octets par bloc, au moins 1 et au plus height
+size_t bmp_rowsPerBlock(size_t rowSize, size_t height);
+
+typedef struct {
+    const void *data;
+    size_t size;
+} t_bmp_part;
+
+// Écriture rassemblée : les morceaux ajoutés ne sont pas copiés et doivent rester valides jusqu'au
+// prochain bmp_writerFlush (ou bmp_writerClose)
+typedef struct {
+#ifdef _WIN32
+    FILE *file;
+#else
+    int fd;
+#endif
+    t_bmp_part parts[BMP_WRITER_PARTS];
+    int count;
+} t_bmp_writer;
+
+// Crée (ou tronque) filename
+t_bmp_status bmp_writerOpen(t_bmp_writer *w, const char *filename);
+
+// Ajoute un morceau ; les morceaux en attente sont écrits d'abord si la liste est pleine
+t_bmp_status bmp_writerPush(t_bmp_writer *w, const void *data, size_t size);
+
+// Écrit tous les morceaux en attente (un writev, repris en cas d'écriture partielle)
+t_bmp_status bmp_writerFlush(t_bmp_writer *w);
+
+// Écrit ce qui reste si res vaut BMP_OK, ferme le fichier et renvoie le premier échec rencontré
+t_bmp_status bmp_writerClose(t_bmp_writer *w, t_bmp_status res);
+
+// Lit exactement size octets (par tranches de BMP_IO_CHUNK) ; renvoie false si les données sont tronquées
+bool bmp_readFully(FILE *f, void *buffer, size_t size);
+
+// Crée le dossier path (dossier parent existant requis) ; renvoie 0 si succès ou s'il existe déjà, -1 sinon
+int bmp_makeDirectory(const char *path);
+
+#endif // BMP_FILE_H
@@ -0,0 +1,264 @@
+/*
+* Fichier : bmp_io.c
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Implémente le chargement unifié : lecture unique des 54 octets d'en-tête, aiguillage sur la
+ *           profondeur et la compression vers bmp8_readFromFile ou bmp24_readFromFile.
+ */
+
+#include "bmp_io.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Chargement commun : threads pour la lecture parallèle des images 24/32 bits, scale pour la réduction
+static t_image *charger(const char *filename, int threads, int scale, t_bmp_status *status) {
+    if (filename == NULL) {
+        bmp_setStatus(status, BMP_ERR_ARGUMENT);
+        return NULL;
+    }
+
+    FILE *f = fopen(filename, "rb");
+    if (f == NULL) {
+        bmp_setStatus(status, BMP_ERR_OPEN);
+        return NULL;
+    }
+
+    // En-tête de fichier (14 octets) + en-tête d'information (40 octets), lus une seule fois
+    unsigned char raw[HEADER_SIZE + INFO_SIZE];
+    if (fread(raw, 1, sizeof(raw), f) != sizeof(raw)) {
+        bmp_setStatus(status, BMP_ERR_READ);
+        fclose(f);
+        return NULL;
+    }
+
+    t_bmp_header header;
+    t_bmp_info info;
+    memcpy(&header, raw, HEADER_SIZE);
+    memcpy(&info, raw + HEADER_SIZE, INFO_SIZE);
+
+    if (header.type != BMP_TYPE) {
+        bmp_setStatus(status, BMP_ERR_FORMAT);
+        fclose(f);
+        return NULL;
+    }
+
+    t_image *img = malloc(sizeof(t_image));
+    if (img == NULL) {
+        bmp_setStatus(status, BMP_ERR_MEMORY);
+        fclose(f);
+        return NULL;
+    }
+    img->type = IMAGE_NONE;
+
+    if (info.bits == 8 && info.compression == BI_RGB) {
+        img->bmp8 = bmp8_readFromFileScaled(f, raw, scale, status);
+        if (img->bmp8 != NULL) {
+            img->type = IMAGE_BMP8;
+        }
+    } else if ((info.bits == 24 && info.compression == BI_RGB) ||
+               (info.bits == 32 && (info.compression == BI_RGB || info.compression == BI_BITFIELDS ||
+                                    info.compression == BI_ALPHABITFIELDS))) {
+        img->bmp24 = scale == 1 ? bmp24_readFromFileParallel(f, &header, &info, threads, status)
+                                : bmp24_readFromFileScaled(f, &header, &info, scale, status);
+        if (img->bmp24 != NULL) {
+            img->type = IMAGE_BMP24;
+        }
+    } else {
+        bmp_setStatus(status, BMP_ERR_UNSUPPORTED);
+    }
+
+    fclose(f);
+
+    if (img->type == IMAGE_NONE) {
+        free(img);
+        return NULL;
+    }
+    return img;
+}
+
+t_image *bmp_open(const char *filename, t_bmp_status *status) {
+    return charger(filename, 1, 1, status);
+}
+
+t_image *bmp_openParallel(const char *filename, int threads, t_bmp_status *status) {
+    return charger(filename, threads, 1, status);
+}
+
+t_image *bmp_openScaled(const char *filename, int scale, t_bmp_status *status) {
+    return charger(filename, 1, scale, status);
+}
+
+// Aiguillage commun à bmp_decode et bmp_decodeInPlace
+static t_image *decoder(unsigned char *mutableBuffer, const unsigned char *buffer, size_t size,
+                        t_bmp_status *status) {
+    if (buffer == NULL) {
+        bmp_setStatus(status, BMP_ERR_ARGUMENT);
+        return NULL;
+    }
+    if (size < HEADER_SIZE + INFO_SIZE) {
+        bmp_setStatus(status, BMP_ERR_READ);
+        return NULL;
+    }
+
+    t_bmp_info info;
+    memcpy(&info, buffer + HEADER_SIZE, INFO_SIZE);
+
+    t_image *img = malloc(sizeof(t_image));
+    if (img == NULL) {
+        bmp_setStatus(status, BMP_ERR_MEMORY);
+        return NULL;
+    }
+    img->type = IMAGE_NONE;
+
+    if (info.bits == 8) {
+        img->bmp8 = mutableBuffer != NULL ? bmp8_decodeInPlace(mutableBuffer, size, status)
+                                          : bmp8_decode(buffer, size, status);
+        if (img->bmp8 != NULL) {
+            img->type = IMAGE_BMP8;
+        }
+    } else {
+        img->bmp24 = bmp24_decode(buffer, size, status);
+        if (img->bmp24 != NULL) {
+            img->type = IMAGE_BMP24;
+        }
+    }
+
+    if (img->type == IMAGE_NONE) {
+        free(img);
+        return NULL;
+    }
+    return img;
+}
+
+t_image *bmp_decode(const unsigned char *buffer, size_t size, t_bmp_status *status) {
+    return decoder(NULL, buffer, size, status);
+}
+
+t_image *bmp_decodeInPlace(unsigned char *buffer, size_t size, t_bmp_status *status) {
+    return decoder(buffer, buffer, size, status);
+}
+
+size_t bmp_encodedSize(const t_image *img) {
+    if (img == NULL || img->type == IMAGE_NONE) {
+        return 0;
+    }
+    return img->type == IMAGE_BMP8 ? bmp8_encodedSize(img->bmp8) : bmp24_encodedSize(img->bmp24);
+}
+
+t_bmp_status bmp_encode(const t_image *img, unsigned char *buffer, size_t size, size_t *written) {
+    if (img == NULL || img->type == IMAGE_NONE) {
+        if (written != NULL) {
+            *written = 0;
+        }
+        return BMP_ERR_ARGUMENT;
+    }
+    return img->type == IMAGE_BMP8 ? bmp8_encode(img->bmp8, buffer, size, written)
+                                   : bmp24_encode(img->bmp24, buffer, size, written);
+}
+
+t_bmp_status bmp_save(const char *filename, const t_image *img) {
+    if (img == NULL || img->type == IMAGE_NONE) {
+        return BMP_ERR_ARGUMENT;
+    }
+    return img->type == IMAGE_BMP8 ? bmp8_saveImage(filename, img->bmp8) : bmp24_saveImage(filename, img->bmp24);
+}
+
+t_bmp_status bmp_saveRect(const char *filename, const t_image *img, const t_bmp_rect *rect) {
+    if (img == NULL || img->type == IMAGE_NONE || rect == NULL) {
+        return BMP_ERR_ARGUMENT;
+    }
+
+    t_bmp_status res;
+    if (img->type == IMAGE_BMP8) {
+        t_bmp8_view vue;
+        res = bmp8_view(img->bmp8, rect->x, rect->y, rect->width, rect->height, &vue);
+        return res == BMP_OK ? bmp8_viewSave(filename, &vue) : res;
+    }
+    t_bmp24_view vue;
+    res = bmp24_view(img->bmp24, rect->x, rect->y, rect->width, rect->height, &vue);
+    return res == BMP_OK ? bmp24_viewSave(filename, &vue) : res;
+}
+
+int bmp_parseRect(const char *text, t_bmp_rect *rect) {
+    if (text == NULL || rect == NULL) {
+        return -1;
+    }
+    int w, h, x, y, fin = 0;
+    if (sscanf(text, "%dx%d+%d+%d%n", &w, &h, &x, &y, &fin) != 4 || text[fin] != '\0' || w <= 0 || h <= 0 ||
+        x < 0 || y < 0) {
+        return -1;
+    }
+    rect->x = x;
+    rect->y = y;
+    rect->width = w;
+    rect->height = h;
+    return 0;
+}
+
+int bmp_clipRect(t_bmp_rect *rect, int width, int height) {
+    if (rect->width <= 0 || rect->height <= 0) {
+        return 0;
+    }
+    // Origine hors de l'image à gauche ou en haut : seule la partie à l'intérieur est conservée
+    if (rect->x < 0) {
+        rect->width += rect->x;
+        rect->x = 0;
+    }
+    if (rect->y < 0) {
+        rect->height += rect->y;
+        rect->y = 0;
+    }
+    if (rect->x >= width || rect->y >= height) {
+        return 0;
+    }
+    if (rect->width > width - rect->x) {
+        rect->width = width - rect->x;
+    }
+    if (rect->height > height - rect->y) {
+        rect->height = height - rect->y;
+    }
+    return rect->width > 0 && rect->height > 0;
+}
+
+void bmp_printInfo(const t_image *img) {
+    if (img == NULL || img->type == IMAGE_NONE) {
+        printf("Aucune image à afficher.\n");
+        return;
+    }
+
+    if (img->type == IMAGE_BMP8) {
+        bmp8_printInfo(img->bmp8);
+    } else {
+        bmp24_printInfo(img->bmp24);
+    }
+}
+
+void bmp_close(t_image *img) {
+    if (img != NULL) {
+        if (img->type == IMAGE_BMP8) {
+            bmp8_free(img->bmp8);
+        } else if (img->type == IMAGE_BMP24) {
+            bmp24_free(img->bmp24);
+        }
+        free(img);
+    }
+}
+
+const char *bmp_strerror(t_bmp_status status) {
+    switch (status) {
+        case BMP_OK:              return "succès";
+        case BMP_ERR_ARGUMENT:    return "paramètre invalide";
+        case BMP_ERR_OPEN:        return "fichier impossible à ouvrir";
+        case BMP_ERR_READ:        return "données incomplètes";
+        case BMP_ERR_WRITE:       return "écriture incomplète";
+        case BMP_ERR_FORMAT:      return "pas un fichier BMP valide";
+        case BMP_ERR_UNSUPPORTED: return "profondeur ou compression non supportée";
+        case BMP_ERR_DIMENSIONS:  return "dimensions invalides";
+        case BMP_ERR_TOO_LARGE:   return "image trop grande";
+        case BMP_ERR_MEMORY:      return "mémoire insuffisante";
+        case BMP_ERR_BUFFER:      return "tampon de sortie trop petit";
+        case BMP_ERR_CHAIN:       return "chaîne de filtres invalide";
+        case BMP_ERR_DEPTH:       return "opération indisponible pour cette profondeur";
+    }
+    return "erreur inconnue";
+}
@@ -0,0 +1,79 @@
+/*
+* Fichier : bmp_io.h
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Point d'entrée unique de chargement : bmp_open lit l'en-tête une seule fois, choisit le
+ *           chargeur selon la profondeur et la compression, et renvoie une image étiquetée (8 ou 24 bits).
+ */
+
+#ifndef BMP_IO_H
+#define BMP_IO_H
+
+#include "bmp8.h"
+#include "bmp24.h"
+
+// Type d'image contenu dans un t_image
+typedef enum {
+    IMAGE_NONE  = 0,
+    IMAGE_BMP8  = 8,
+    IMAGE_BMP24 = 24    // images 24 et 32 bits (t_bmp24.colorDepth précise)
+} t_image_type;
+
+// Image étiquetée : un seul des deux pointeurs est valide selon type
+typedef struct {
+    t_image_type type;
+    union {
+        t_bmp8 *bmp8;
+        t_bmp24 *bmp24;
+    };
+} t_image;
+
+// Rectangle d'une image affichée (ligne 0 en haut), noté "LxH+X+Y" en ligne de commande et dans les chaînes
+typedef struct {
+    int x;
+    int y;
+    int width;
+    int height;
+} t_bmp_rect;
+
+// Chargement : un seul fopen, une seule lecture de l'en-tête. En cas d'échec, renvoie NULL et dépose la
+// cause dans *status (status peut être NULL) ; rien n'est affiché.
+t_image *bmp_open(const char *filename, t_bmp_status *status);
+
+// Variante de bmp_open dont les images 24/32 bits sont lues par plusieurs threads (voir
+// bmp24_readFromFileParallel ; threads <= 0 : nombre de cœurs)
+t_image *bmp_openParallel(const char *filename, int threads, t_bmp_status *status);
+
+// Variante de bmp_open qui réduit l'image pendant la lecture (scale : 1, 2, 4 ou 8 ; voir
+// bmp24_readFromFileScaled et bmp8_readFromFileScaled)
+t_image *bmp_openScaled(const char *filename, int scale, t_bmp_status *status);
+
+// Décodage depuis un tampon mémoire contenant un fichier BMP complet. bmp_decodeInPlace laisse les pixels
+// 8 bits dans buffer (sans copie) : buffer doit alors rester valide jusqu'à bmp_close.
+t_image *bmp_decode(const unsigned char *buffer, size_t size, t_bmp_status *status);
+t_image *bmp_decodeInPlace(unsigned char *buffer, size_t size, t_bmp_status *status);
+
+// Encodage dans un tampon fourni par l'appelant, de taille au moins bmp_encodedSize(img) (0 si image
+// invalide) ; *written reçoit le nombre d'octets écrits (written peut être NULL)
+size_t bmp_encodedSize(const t_image *img);
+t_bmp_status bmp_encode(const t_image *img, unsigned char *buffer, size_t size, size_t *written);
+
+// Sauvegarde dans le format de l'image
+t_bmp_status bmp_save(const char *filename, const t_image *img);
+
+// Enregistre seulement le rectangle rect de l'image (vue bmp8_view / bmp24_view, sans copie de l'image)
+t_bmp_status bmp_saveRect(const char *filename, const t_image *img, const t_bmp_rect *rect);
+
+// Rectangle d'après "LxH+X+Y" ; renvoie 0 si succès, -1 sinon
+int bmp_parseRect(const char *text, t_bmp_rect *rect);
+
+// Intersection de rect avec une image de width x height pixels (une origine négative réduit la largeur ou la
+// hauteur d'autant et est ramenée à 0) ; renvoie 0 si elle est vide
+int bmp_clipRect(t_bmp_rect *rect, int width, int height);
+
+// Affichage des informations (sur la sortie standard, à la demande de l'appelant)
+void bmp_printInfo(const t_image *img);
+
+// Libération de l'image et de son contenu
+void bmp_close(t_image *img);
+
+#endif // BMP_IO_H
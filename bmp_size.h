@@ -0,0 +1,53 @@
+/*
+* Fichier : bmp_size.h
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Calculs de tailles en size_t avec détection des dépassements, communs aux images 8, 24 et
+ *           32 bits. Toutes les tailles de lignes, de plans et d'images passent par ces fonctions pour que
+ *           les images de plusieurs gigaoctets soient traitées sans débordement silencieux.
+ */
+
+#ifndef BMP_SIZE_H
+#define BMP_SIZE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Taille maximale d'un bloc lu ou écrit en un seul appel à fread/fwrite
+#define BMP_IO_CHUNK ((size_t)1 << 26)
+
+// *out = a * b ; renvoie false en cas de dépassement
+static inline bool bmp_mulSize(size_t a, size_t b, size_t *out) {
+    if (a != 0 && b > SIZE_MAX / a) {
+        return false;
+    }
+    *out = a * b;
+    return true;
+}
+
+// *out = a + b ; renvoie false en cas de dépassement
+static inline bool bmp_addSize(size_t a, size_t b, size_t *out) {
+    if (b > SIZE_MAX - a) {
+        return false;
+    }
+    *out = a + b;
+    return true;
+}
+
+// Taille d'une ligne BMP de width pixels de bits bits, complétée à un multiple de 4 octets
+static inline bool bmp_rowSize(size_t width, unsigned int bits, size_t *out) {
+    size_t rowBits;
+    if (!bmp_mulSize(width, bits, &rowBits) || !bmp_addSize(rowBits, 31, &rowBits)) {
+        return false;
+    }
+    *out = rowBits / 32 * 4;
+    return true;
+}
+
+// Taille des données pixels d'une image BMP (lignes complétées comprises)
+static inline bool bmp_imageSize(size_t width, size_t height, unsigned int bits, size_t *out) {
+    size_t rowSize;
+    return bmp_rowSize(width, bits, &rowSize) && bmp_mulSize(rowSize, height, out);
+}
+
+#endif // BMP_SIZE_H
@@ -0,0 +1,40 @@
+/*
+* Fichier : bmp_status.h
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Codes de retour communs à toute la bibliothèque. Les fonctions n'écrivent rien sur la sortie
+ *           standard : elles renvoient un t_bmp_status (ou le déposent dans un paramètre status), que
+ *           l'appelant traduit en message avec bmp_strerror s'il le souhaite.
+ */
+
+#ifndef BMP_STATUS_H
+#define BMP_STATUS_H
+
+#include <stddef.h>
+
+typedef enum {
+    BMP_OK = 0,
+    BMP_ERR_ARGUMENT,       // pointeur nul, valeur hors limites, noyau invalide
+    BMP_ERR_OPEN,           // fichier impossible à ouvrir ou à créer
+    BMP_ERR_READ,           // données tronquées
+    BMP_ERR_WRITE,          // écriture incomplète
+    BMP_ERR_FORMAT,         // pas un BMP, en-tête incohérent
+    BMP_ERR_UNSUPPORTED,    // profondeur ou compression non gérée
+    BMP_ERR_DIMENSIONS,     // largeur ou hauteur invalide
+    BMP_ERR_TOO_LARGE,      // tailles dépassant size_t
+    BMP_ERR_MEMORY,         // allocation impossible
+    BMP_ERR_BUFFER,         // tampon de sortie trop petit
+    BMP_ERR_CHAIN,          // chaîne de filtres invalide
+    BMP_ERR_DEPTH           // opération non disponible pour cette profondeur
+} t_bmp_status;
+
+// Message (en français) associé à un code ; ne renvoie jamais NULL
+const char *bmp_strerror(t_bmp_status status);
+
+// Dépose status dans *out si out n'est pas nul (paramètres status optionnels)
+static inline void bmp_setStatus(t_bmp_status *out, t_bmp_status status) {
+    if (out != NULL) {
+        *out = status;
+    }
+}
+
+#endif // BMP_STATUS_H
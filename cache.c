@@ -0,0 +1,442 @@
+/*
+* Fichier : cache.c
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Implémente le cache de résultats : empreinte rapide des pixels (deux accumulateurs de 64 bits
+ *           mélangés par multiplication), index en mémoire des entrées du dossier protégé par un mutex,
+ *           écriture par fichier temporaire renommé (une entrée n'est jamais lue à moitié écrite) et
+ *           suppression des entrées les moins récemment utilisées au-delà de la taille maximale.
+ */
+
+#include "cache.h"
+#include "bmp_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <utime.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+// Clé : empreinte de 128 bits en hexadécimal, nom de fichier <clé>.bmp
+#define CLE_TAILLE 32
+#define NOM_TAILLE (CLE_TAILLE + 4)
+
+typedef struct {
+    char name[NOM_TAILLE + 1];
+    size_t size;
+    uint64_t usage;             // ordre de la dernière utilisation (plus grand : plus récente)
+} t_entree;
+
+struct s_result_cache {
+    char *dir;
+    size_t maxBytes;
+    pthread_mutex_t lock;       // protège les champs ci-dessous
+    t_entree *entries;
+    int count;
+    int capacity;
+    size_t bytes;
+    uint64_t clock;
+    unsigned long temporaires;  // numéro du prochain fichier temporaire
+    t_cache_stats stats;
+};
+
+// --- Empreinte ---
+
+#define PREMIER_1 0x9E3779B97F4A7C15ull
+#define PREMIER_2 0xC2B2AE3D27D4EB4Full
+
+static inline uint64_t rotation(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+// Ajoute n octets à l'empreinte, 8 par 8 ; les deux accumulateurs sont indépendants (calculés en parallèle)
+static void hacher(t_cache_hash *h, const void *data, size_t n) {
+    const uint8_t *p = data;
+    uint64_t a = h->lo;
+    uint64_t b = h->hi;
+    for (; n >= 8; p += 8, n -= 8) {
+        uint64_t w;
+        memcpy(&w, p, 8);
+        a = rotation(a ^ w, 31) * PREMIER_1;
+        b = rotation(b + w, 27) * PREMIER_2;
+    }
+    // Reste et longueur du reste dans un dernier mot
+    uint64_t w = n;
+    for (size_t i = 0; i < n; i++) {
+        w |= (uint64_t)p[i] << (8 * (i + 1));
+    }
+    h->lo = rotation(a ^ w, 31) * PREMIER_1;
+    h->hi = rotation(b + w, 27) * PREMIER_2;
+}
+
+// Mélange final (murmur3) : chaque bit de l'empreinte dépend de tous les octets
+static uint64_t melanger(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDull;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+static void finaliser(t_cache_hash *h) {
+    uint64_t lo = melanger(h->lo + h->hi);
+    h->hi = melanger(h->hi ^ lo);
+    h->lo = lo;
+}
+
+static void hacher_entier(t_cache_hash *h, int64_t v) {
+    hacher(h, &v, sizeof(v));
+}
+
+t_cache_hash cache_hashImage(const t_image *img) {
+    t_cache_hash h = {PREMIER_1, PREMIER_2};
+    if (img == NULL) {
+        return h;
+    }
+    hacher_entier(&h, img->type);
+    if (img->type == IMAGE_BMP8 && img->bmp8 != NULL && img->bmp8->data != NULL) {
+        hacher(&h, img->bmp8->header, sizeof(img->bmp8->header));
+        hacher(&h, img->bmp8->colorTable, sizeof(img->bmp8->colorTable));
+        hacher(&h, img->bmp8->data, img->bmp8->dataSize);
+    } else if (img->type == IMAGE_BMP24 && img->bmp24 != NULL && img->bmp24->data != NULL) {
+        const t_bmp24 *bmp = img->bmp24;
+        hacher_entier(&h, bmp->width);
+        hacher_entier(&h, bmp->height);
+        hacher_entier(&h, bmp->colorDepth);
+        hacher_entier(&h, bmp->header_info.compression);
+        for (int i = 0; i < bmp->height; i++) {
+            hacher(&h, bmp->data[i], (size_t)bmp->width * sizeof(t_pixel));
+        }
+    }
+    finaliser(&h);
+    return h;
+}
+
+// Nom de l'entrée du préfixe ops[0 .. count) de la chaîne pour ces pixels ; -1 si la mémoire manque
+static int nom_entree(const t_cache_hash *pixels, const t_chain *chain, int count, char nom[NOM_TAILLE + 1]) {
+    t_chain prefixe = *chain;
+    prefixe.count = count;
+    int longueur = chain_format(&prefixe, NULL, 0);
+    char *forme = longueur >= 0 ? malloc((size_t)longueur + 1) : NULL;
+    if (forme == NULL) {
+        return -1;
+    }
+    chain_format(&prefixe, forme, (size_t)longueur + 1);
+
+    t_cache_hash h = {PREMIER_2, PREMIER_1};
+    hacher_entier(&h, CACHE_VERSION);
+    hacher(&h, pixels, sizeof(*pixels));
+    hacher(&h, forme, (size_t)longueur);
+    finaliser(&h);
+    free(forme);
+
+    snprintf(nom, NOM_TAILLE + 1, "%016llx%016llx.bmp", (unsigned long long)h.hi, (unsigned long long)h.lo);
+    return 0;
+}
+
+// --- Index des entrées (appelé sous cache->lock) ---
+
+// Chemin dir/nom (suffixe optionnel), alloué ; NULL si la mémoire manque
+static char *chemin_entree(const t_result_cache *cache, const char *nom, const char *suffixe) {
+    size_t n = strlen(cache->dir) + 1 + strlen(nom) + (suffixe != NULL ? strlen(suffixe) : 0) + 1;
+    char *chemin = malloc(n);
+    if (chemin != NULL) {
+        snprintf(chemin, n, "%s/%s%s", cache->dir, nom, suffixe != NULL ? suffixe : "");
+    }
+    return chemin;
+}
+
+static int chercher(const t_result_cache *cache, const char *nom) {
+    for (int i = 0; i < cache->count; i++) {
+        if (strcmp(cache->entries[i].name, nom) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void retirer(t_result_cache *cache, int i) {
+    cache->bytes -= cache->entries[i].size;
+    cache->entries[i] = cache->entries[--cache->count];
+}
+
+static int ajouter(t_result_cache *cache, const char *nom, size_t size, uint64_t usage) {
+    if (cache->count == cache->capacity) {
+        int capacite = cache->capacity > 0 ? cache->capacity * 2 : 64;
+        t_entree *agrandi = realloc(cache->entries, sizeof(t_entree) * capacite);
+        if (agrandi == NULL) {
+            return -1;
+        }
+        cache->entries = agrandi;
+        cache->capacity = capacite;
+    }
+    t_entree *e = &cache->entries[cache->count++];
+    snprintf(e->name, sizeof(e->name), "%s", nom);
+    e->size = size;
+    e->usage = usage;
+    cache->bytes += size;
+    return 0;
+}
+
+// Supprime les entrées les moins récemment utilisées tant que la taille maximale est dépassée
+static void evincer(t_result_cache *cache) {
+    while (cache->maxBytes > 0 && cache->bytes > cache->maxBytes && cache->count > 0) {
+        int plus_ancienne = 0;
+        for (int i = 1; i < cache->count; i++) {
+            if (cache->entries[i].usage < cache->entries[plus_ancienne].usage) {
+                plus_ancienne = i;
+            }
+        }
+        char *chemin = chemin_entree(cache, cache->entries[plus_ancienne].name, NULL);
+        if (chemin != NULL) {
+            remove(chemin);
+            free(chemin);
+        }
+        retirer(cache, plus_ancienne);
+        cache->stats.evictions++;
+    }
+}
+
+// --- Ouverture ---
+
+// Nom d'entrée valide : CLE_TAILLE chiffres hexadécimaux minuscules suivis de .bmp
+static int est_nom_entree(const char *nom) {
+    if (strlen(nom) != NOM_TAILLE || strcmp(nom + CLE_TAILLE, ".bmp") != 0) {
+        return 0;
+    }
+    for (int i = 0; i < CLE_TAILLE; i++) {
+        if (!((nom[i] >= '0' && nom[i] <= '9') || (nom[i] >= 'a' && nom[i] <= 'f'))) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Ordre de reprise des entrées existantes : date de modification croissante (usage y est provisoire)
+static int comparer_dates(const void *a, const void *b) {
+    uint64_t x = ((const t_entree *)a)->usage;
+    uint64_t y = ((const t_entree *)b)->usage;
+    return x < y ? -1 : x > y;
+}
+
+t_result_cache *cache_open(const char *dir, size_t maxBytes, t_bmp_status *status) {
+    if (dir == NULL || *dir == '\0') {
+        bmp_setStatus(status, BMP_ERR_ARGUMENT);
+        return NULL;
+    }
+    if (bmp_makeDirectory(dir) != 0) {
+        bmp_setStatus(status, BMP_ERR_OPEN);
+        return NULL;
+    }
+    DIR *d = opendir(dir);
+    if (d == NULL) {
+        bmp_setStatus(status, BMP_ERR_OPEN);
+        return NULL;
+    }
+
+    t_result_cache *cache = calloc(1, sizeof(t_result_cache));
+    if (cache == NULL || (cache->dir = malloc(strlen(dir) + 1)) == NULL) {
+        free(cache);
+        closedir(d);
+        bmp_setStatus(status, BMP_ERR_MEMORY);
+        return NULL;
+    }
+    strcpy(cache->dir, dir);
+    cache->maxBytes = maxBytes;
+    pthread_mutex_init(&cache->lock, NULL);
+
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        if (!est_nom_entree(e->d_name)) {
+            continue;
+        }
+        char *chemin = chemin_entree(cache, e->d_name, NULL);
+        struct stat st;
+        if (chemin != NULL && stat(chemin, &st) == 0 && S_ISREG(st.st_mode)) {
+            ajouter(cache, e->d_name, (size_t)st.st_size, (uint64_t)st.st_mtime);
+        }
+        free(chemin);
+    }
+    closedir(d);
+
+    if (cache->count > 1) {
+        qsort(cache->entries, cache->count, sizeof(t_entree), comparer_dates);
+    }
+    for (int i = 0; i < cache->count; i++) {
+        cache->entries[i].usage = (uint64_t)i + 1;
+    }
+    cache->clock = (uint64_t)cache->count;
+    // Taille maximale réduite depuis la dernière ouverture
+    evincer(cache);
+    cache->stats.evictions = 0;
+
+    bmp_setStatus(status, BMP_OK);
+    return cache;
+}
+
+void cache_close(t_result_cache *cache) {
+    if (cache != NULL) {
+        pthread_mutex_destroy(&cache->lock);
+        free(cache->entries);
+        free(cache->dir);
+        free(cache);
+    }
+}
+
+// --- Lecture et écriture des entrées ---
+
+// Image de l'entrée nom, NULL si elle n'est pas (ou plus) dans le cache
+static t_image *relire(t_result_cache *cache, const char *nom) {
+    pthread_mutex_lock(&cache->lock);
+    int present = chercher(cache, nom) >= 0;
+    pthread_mutex_unlock(&cache->lock);
+    char *chemin = present ? chemin_entree(cache, nom, NULL) : NULL;
+    if (chemin == NULL) {
+        return NULL;
+    }
+
+    t_image *img = bmp_open(chemin, NULL);
+    pthread_mutex_lock(&cache->lock);
+    int i = chercher(cache, nom);
+    if (img == NULL && i >= 0) {
+        // Entrée illisible (supprimée par un autre processus, tronquée) : oubliée
+        remove(chemin);
+        retirer(cache, i);
+    } else if (i >= 0) {
+        cache->entries[i].usage = ++cache->clock;
+    }
+    pthread_mutex_unlock(&cache->lock);
+    if (img != NULL) {
+        // La date de modification porte l'ordre d'utilisation jusqu'à la prochaine ouverture du cache
+        utime(chemin, NULL);
+    }
+    free(chemin);
+    return img;
+}
+
+// Enregistre img sous le nom nom : fichier temporaire propre à l'appel, renommé une fois complet
+static void enregistrer(t_result_cache *cache, const char *nom, const t_image *img) {
+    char suffixe[48];
+    pthread_mutex_lock(&cache->lock);
+    snprintf(suffixe, sizeof(suffixe), ".%ld.%lu.tmp", (long)getpid(), cache->temporaires++);
+    pthread_mutex_unlock(&cache->lock);
+
+    char *temporaire = chemin_entree(cache, nom, suffixe);
+    char *chemin = chemin_entree(cache, nom, NULL);
+    struct stat st;
+    if (temporaire == NULL || chemin == NULL || bmp_save(temporaire, img) != BMP_OK ||
+        stat(temporaire, &st) != 0 || rename(temporaire, chemin) != 0) {
+        if (temporaire != NULL) {
+            remove(temporaire);
+        }
+        free(temporaire);
+        free(chemin);
+        return;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+    int i = chercher(cache, nom);
+    if (i >= 0) {
+        // Même résultat calculé par un autre thread : le fichier a simplement été remplacé
+        retirer(cache, i);
+    }
+    if (ajouter(cache, nom, (size_t)st.st_size, ++cache->clock) != 0) {
+        remove(chemin);
+    }
+    evincer(cache);
+    pthread_mutex_unlock(&cache->lock);
+    free(temporaire);
+    free(chemin);
+}
+
+// --- Application d'une chaîne ---
+
+// Nombre d'opérations appliquées après l'étape s du plan
+static int fin_etape(const t_chain *chain, const t_chain_step *plan, int nbSteps, int s) {
+    return s + 1 < nbSteps ? plan[s + 1].first : chain->count;
+}
+
+// Étape dont le résultat vaut d'être gardé : recalculer les opérations ponctuelles ne coûte qu'un passage
+// (dans t_chain_op_type, equalize est suivie des convolutions puis des transformations géométriques)
+static int est_couteuse(const t_chain *chain, const t_chain_step *etape) {
+    return etape->type == CHAIN_STEP_OP && chain->ops[etape->first].type >= CHAIN_EQUALIZE;
+}
+
+t_bmp_status cache_applyChain(t_result_cache *cache, const t_chain *chain, t_image **img, t_chain_scratch *scratch,
+                              int *reused) {
+    if (reused != NULL) {
+        *reused = 0;
+    }
+    if (cache == NULL || chain == NULL || img == NULL || *img == NULL || (*img)->type == IMAGE_NONE) {
+        return BMP_ERR_ARGUMENT;
+    }
+    int p = (*img)->type == IMAGE_BMP8 ? 0 : 1;
+    const t_chain_step *plan = chain->plan[p];
+    int nbSteps = chain->nbSteps[p];
+    if (nbSteps == 0) {
+        return BMP_OK;
+    }
+
+    // Noms des entrées après chaque étape
+    t_cache_hash pixels = cache_hashImage(*img);
+    char (*noms)[NOM_TAILLE + 1] = malloc(sizeof(*noms) * nbSteps);
+    if (noms == NULL) {
+        return chain_apply(chain, *img, scratch);
+    }
+    for (int s = 0; s < nbSteps; s++) {
+        if (nom_entree(&pixels, chain, fin_etape(chain, plan, nbSteps, s), noms[s]) != 0) {
+            free(noms);
+            return chain_apply(chain, *img, scratch);
+        }
+    }
+
+    // Plus long préfixe déjà calculé
+    int depart = 0;
+    for (int s = nbSteps - 1; s >= 0 && depart == 0; s--) {
+        t_image *lue = relire(cache, noms[s]);
+        if (lue != NULL) {
+            bmp_close(*img);
+            *img = lue;
+            depart = s + 1;
+        }
+    }
+
+    t_bmp_status res = BMP_OK;
+    for (int s = depart; s < nbSteps && res == BMP_OK; s++) {
+        res = chain_applySteps(chain, *img, s, s + 1, scratch);
+        if (res == BMP_OK && (s == nbSteps - 1 || est_couteuse(chain, &plan[s]))) {
+            enregistrer(cache, noms[s], *img);
+        }
+    }
+    free(noms);
+
+    pthread_mutex_lock(&cache->lock);
+    if (depart == nbSteps) {
+        cache->stats.hits++;
+    } else if (depart > 0) {
+        cache->stats.partialHits++;
+    } else {
+        cache->stats.misses++;
+    }
+    pthread_mutex_unlock(&cache->lock);
+    if (reused != NULL && depart > 0) {
+        *reused = fin_etape(chain, plan, nbSteps, depart - 1);
+    }
+    return res;
+}
+
+void cache_getStats(t_result_cache *cache, t_cache_stats *stats) {
+    pthread_mutex_lock(&cache->lock);
+    *stats = cache->stats;
+    stats->bytes = cache->bytes;
+    stats->entries = cache->count;
+    pthread_mutex_unlock(&cache->lock);
+}
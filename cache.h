@@ -0,0 +1,62 @@
+/*
+* Fichier : cache.h
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Cache de résultats sur disque, adressé par le contenu. La clé d'une entrée combine l'empreinte des
+ *           pixels d'entrée et la forme normalisée de la chaîne (voir chain_format), ou d'un de ses préfixes :
+ *           retraiter les mêmes images avec la même chaîne relit le résultat sans rien recalculer, et une chaîne
+ *           dont seule la fin a changé repart du dernier résultat intermédiaire gardé. La taille du cache est
+ *           bornée : les entrées les moins récemment utilisées sont supprimées.
+ */
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "chain.h"
+
+// Taille maximale par défaut du cache, en octets
+#define CACHE_SIZE_DEFAULT ((size_t)1 << 30)
+
+// Version des résultats : à incrémenter quand un filtre change de résultat, pour ne plus relire les anciens
+#define CACHE_VERSION 1
+
+typedef struct s_result_cache t_result_cache;
+
+// Empreinte de 128 bits (non cryptographique)
+typedef struct {
+    uint64_t lo;
+    uint64_t hi;
+} t_cache_hash;
+
+typedef struct {
+    size_t bytes;           // taille des entrées gardées
+    int entries;
+    long hits;              // images relues du cache sans aucun calcul
+    long partialHits;       // images reprises après un préfixe de la chaîne relu du cache
+    long misses;            // images calculées entièrement
+    long evictions;         // entrées supprimées pour respecter la taille maximale
+} t_cache_stats;
+
+// Ouvre (ou crée) le cache du dossier dir, limité à maxBytes octets (0 : illimité). Les entrées déjà présentes
+// (fichiers <clé>.bmp) sont reprises, leur date de modification donnant l'ordre des dernières utilisations.
+// Renvoie NULL en cas d'échec, avec la cause dans *status (optionnel).
+t_result_cache *cache_open(const char *dir, size_t maxBytes, t_bmp_status *status);
+void cache_close(t_result_cache *cache);
+
+// Empreinte des pixels d'une image et de ce qui, hors pixels, se retrouve dans le fichier enregistré
+// (dimensions, profondeur, compression ; en-tête et palette d'une image 8 bits)
+t_cache_hash cache_hashImage(const t_image *img);
+
+// Applique la chaîne à *img en passant par le cache (appelable depuis plusieurs threads, chacun avec son
+// scratch) : le plus long préfixe déjà calculé pour ces pixels est relu et seules les étapes suivantes sont
+// appliquées. Le résultat final est enregistré, ainsi que les résultats intermédiaires après chaque étape
+// coûteuse (convolution, égalisation, transformation géométrique). *img peut être remplacée par l'image relue
+// (l'ancienne est libérée). *reused (optionnel) : nombre d'opérations de la chaîne relues du cache.
+// Une erreur du cache (disque plein, entrée illisible) n'est jamais une erreur du traitement.
+t_bmp_status cache_applyChain(t_result_cache *cache, const t_chain *chain, t_image **img, t_chain_scratch *scratch,
+                              int *reused);
+
+void cache_getStats(t_result_cache *cache, t_cache_stats *stats);
+
+#endif // CACHE_H
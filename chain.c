@@ -0,0 +1,681 @@
+/*
+* Fichier : chain.c
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Analyse et application des chaînes de filtres. Les noyaux de convolution et les plans
+ *           d'exécution (opérations ponctuelles fusionnées) sont créés une fois par chaîne ; les convolutions
+ *           passent par les variantes *_applyFilterScratch pour réutiliser les tampons du thread appelant.
+ */
+
+#include "chain.h"
+#include "transform.h"
+#include "kernels.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdarg.h>
+#include <math.h>
+
+// Noms des opérations, dans l'ordre de t_chain_op_type
+static const char *noms_operations[] = {
+    "negative", "brightness", "grayscale", "threshold", "equalize",
+    "box", "gaussian", "outline", "emboss", "sharpen",
+    "rotate90", "rotate180", "rotate270", "fliph", "flipv", "transpose", "transverse"
+};
+
+#define NB_OPERATIONS ((int)(sizeof(noms_operations) / sizeof(noms_operations[0])))
+
+// Noyau prédéfini associé à une convolution de la chaîne
+static t_bmp24_kernel noyau_operation(t_chain_op_type type) {
+    return (t_bmp24_kernel)(BMP24_KERNEL_BOX_BLUR + (type - CHAIN_BOX_BLUR));
+}
+
+static int est_convolution(t_chain_op_type type) {
+    return type >= CHAIN_BOX_BLUR && type <= CHAIN_SHARPEN;
+}
+
+int chain_isGeometric(t_chain_op_type type) {
+    return type >= CHAIN_ROTATE90 && type <= CHAIN_TRANSVERSE;
+}
+
+// Message d'erreur d'analyse, écrit dans le tampon de l'appelant s'il en a fourni un
+static void decrire(char *message, size_t size, const char *format, ...) {
+    if (message == NULL || size == 0) {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, size, format, args);
+    va_end(args);
+}
+
+// Analyse d'un élément "nom" ou "nom:valeur" (espaces autour déjà retirés)
+static int analyser_operation(const char *token, t_chain_op *op, char *message, size_t size) {
+    const char *deux_points = strchr(token, ':');
+    size_t longueur = deux_points != NULL ? (size_t)(deux_points - token) : strlen(token);
+
+    int type = -1;
+    for (int i = 0; i < NB_OPERATIONS; i++) {
+        if (strlen(noms_operations[i]) == longueur && strncmp(token, noms_operations[i], longueur) == 0) {
+            type = i;
+            break;
+        }
+    }
+    if (type < 0) {
+        decrire(message, size, "opération inconnue \"%s\"", token);
+        return -1;
+    }
+
+    op->type = (t_chain_op_type)type;
+    op->value = 0;
+    op->hasRect = 0;
+
+    int parametree = (op->type == CHAIN_BRIGHTNESS || op->type == CHAIN_THRESHOLD);
+    if (!parametree) {
+        if (deux_points != NULL) {
+            decrire(message, size, "l'opération %s ne prend pas de paramètre", noms_operations[type]);
+            return -1;
+        }
+        return 0;
+    }
+
+    if (deux_points == NULL || deux_points[1] == '\0') {
+        decrire(message, size, "l'opération %s attend une valeur (%s:N)", noms_operations[type], noms_operations[type]);
+        return -1;
+    }
+
+    char *fin;
+    long valeur = strtol(deux_points + 1, &fin, 10);
+    long min = op->type == CHAIN_BRIGHTNESS ? -255 : 0;
+    if (*fin != '\0' || valeur < min || valeur > 255) {
+        decrire(message, size, "valeur invalide pour %s (attendu un entier entre %ld et 255)",
+                noms_operations[type], min);
+        return -1;
+    }
+    op->value = (int)valeur;
+    return 0;
+}
+
+// Rectangle "LxH+X+Y" d'une opération
+static int analyser_rectangle(const char *texte, t_chain_op *op, char *message, size_t size) {
+    if (chain_isGeometric(op->type)) {
+        decrire(message, size, "l'opération %s s'applique à l'image entière", noms_operations[op->type]);
+        return -1;
+    }
+    if (bmp_parseRect(texte, &op->rect) != 0) {
+        decrire(message, size, "rectangle invalide \"%s\" (attendu LxH+X+Y)", texte);
+        return -1;
+    }
+    op->hasRect = 1;
+    return 0;
+}
+
+// --- Plan d'exécution ---
+
+// Indice du plan d'un type d'image dans t_chain.plan
+static int indice_plan(t_image_type type) {
+    return type == IMAGE_BMP8 ? 0 : 1;
+}
+
+// Opération sur l'image entière qui peut rejoindre une table de correspondance : chaque octet des canaux ne
+// dépend que de lui-même (ou, pour les niveaux de gris en 24 bits, des trois canaux du même pixel)
+static int est_fusionnable(const t_chain_op *op, int bmp24) {
+    if (op->hasRect) {
+        return 0;
+    }
+    switch (op->type) {
+        case CHAIN_NEGATIVE:
+        case CHAIN_BRIGHTNESS:
+        case CHAIN_GRAYSCALE:
+            return 1;
+        case CHAIN_THRESHOLD:
+            // BMP_ERR_DEPTH en 24 bits : l'opération reste seule pour que l'erreur soit la même
+            return !bmp24;
+        default:
+            return 0;
+    }
+}
+
+static void table_identite(uint8_t lut[256]) {
+    for (int v = 0; v < 256; v++) {
+        lut[v] = (uint8_t)v;
+    }
+}
+
+static int est_identite(const uint8_t lut[256]) {
+    for (int v = 0; v < 256; v++) {
+        if (lut[v] != v) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Table d'une opération ponctuelle, obtenue en lui passant les 256 valeurs d'octet avec les noyaux utilisés
+// sur l'image : la composition des tables est exacte, saturations comprises
+static void table_operation(const t_chain_op *op, uint8_t lut[256]) {
+    const t_kernels *k = kernels_get();
+    table_identite(lut);
+    switch (op->type) {
+        case CHAIN_NEGATIVE:
+            k->invert(lut, 256);
+            break;
+        case CHAIN_BRIGHTNESS:
+            k->addSat(lut, 256, op->value);
+            break;
+        case CHAIN_THRESHOLD:
+            k->threshold(lut, 256, op->value);
+            break;
+        default:
+            break;
+    }
+}
+
+// Niveaux de gris d'un pixel déjà gris (g, g, g), calculés par bmp24_grayscaleRow elle-même
+static void table_gris(uint8_t lut[256]) {
+    t_pixel pixels[256];
+    memset(pixels, 0, sizeof(pixels));
+    for (int v = 0; v < 256; v++) {
+        pixels[v].red = pixels[v].green = pixels[v].blue = (uint8_t)v;
+    }
+    bmp24_grayscaleRow(pixels, 256);
+    for (int v = 0; v < 256; v++) {
+        lut[v] = pixels[v].red;
+    }
+}
+
+// lut devient etape(lut(v)) : etape est appliquée après lut
+static void composer(uint8_t lut[256], const uint8_t etape[256]) {
+    for (int v = 0; v < 256; v++) {
+        lut[v] = etape[lut[v]];
+    }
+}
+
+// Réduit les opérations fusionnables ops[debut .. fin) à une seule étape. En 24 bits, les tables qui précèdent
+// les premiers niveaux de gris sont appliquées aux trois canaux (before) ; tout ce qui suit ne touche plus que
+// le canal gris (lut), y compris d'autres niveaux de gris. Renvoie 0 si les opérations se compensent (rien à
+// faire, par exemple deux négatifs).
+static int fusionner(const t_chain *chain, int debut, int fin, int bmp24, t_chain_step *etape) {
+    uint8_t table[256];
+    int gris = 0;
+    etape->first = debut;
+    etape->count = fin - debut;
+    etape->hasBefore = 0;
+    table_identite(etape->before);
+    table_identite(etape->lut);
+    for (int i = debut; i < fin; i++) {
+        const t_chain_op *op = &chain->ops[i];
+        if (op->type == CHAIN_GRAYSCALE) {
+            if (!bmp24) {
+                // Une image 8 bits est déjà en niveaux de gris
+                continue;
+            }
+            if (!gris) {
+                memcpy(etape->before, etape->lut, sizeof(etape->before));
+                table_identite(etape->lut);
+                gris = 1;
+            } else {
+                table_gris(table);
+                composer(etape->lut, table);
+            }
+            continue;
+        }
+        table_operation(op, table);
+        composer(etape->lut, table);
+    }
+    if (gris) {
+        etape->type = CHAIN_STEP_GRAY_LUT;
+        etape->hasBefore = !est_identite(etape->before);
+        return 1;
+    }
+    etape->type = CHAIN_STEP_LUT;
+    return !est_identite(etape->lut);
+}
+
+// Plan d'exécution pour les images 8 bits (bmp24 = 0) ou 24/32 bits ; NULL si la mémoire manque
+static t_chain_step *planifier(const t_chain *chain, int bmp24, int *nbSteps) {
+    t_chain_step *plan = malloc(sizeof(t_chain_step) * (chain->count > 0 ? chain->count : 1));
+    if (plan == NULL) {
+        return NULL;
+    }
+
+    int n = 0;
+    int i = 0;
+    while (i < chain->count) {
+        int fin = i;
+        while (fin < chain->count && est_fusionnable(&chain->ops[fin], bmp24)) {
+            fin++;
+        }
+        // Une opération ponctuelle seule garde son noyau dédié, plus rapide qu'une table (sauf les niveaux de
+        // gris en 8 bits, qui n'ont aucun effet)
+        if (fin - i >= 2 || (fin - i == 1 && !bmp24 && chain->ops[i].type == CHAIN_GRAYSCALE)) {
+            if (fusionner(chain, i, fin, bmp24, &plan[n])) {
+                n++;
+            }
+            i = fin;
+        } else {
+            plan[n].type = CHAIN_STEP_OP;
+            plan[n].first = i;
+            plan[n].count = 1;
+            plan[n].hasBefore = 0;
+            n++;
+            i++;
+        }
+    }
+    *nbSteps = n;
+    return plan;
+}
+
+t_chain *chain_parse(const char *spec, t_bmp_status *status, char *message, size_t size) {
+    decrire(message, size, "%s", "");
+    if (spec == NULL) {
+        decrire(message, size, "chaîne de filtres absente");
+        bmp_setStatus(status, BMP_ERR_ARGUMENT);
+        return NULL;
+    }
+
+    t_chain *chain = calloc(1, sizeof(t_chain));
+    char *copie = malloc(strlen(spec) + 1);
+    // Au plus une opération par virgule + 1
+    int capacite = 1;
+    for (const char *c = spec; *c != '\0'; c++) {
+        if (*c == ',') capacite++;
+    }
+    if (chain != NULL) {
+        chain->ops = malloc(sizeof(t_chain_op) * capacite);
+    }
+    if (chain == NULL || copie == NULL || chain->ops == NULL) {
+        bmp_setStatus(status, BMP_ERR_MEMORY);
+        free(copie);
+        chain_free(chain);
+        return NULL;
+    }
+    strcpy(copie, spec);
+
+    char *debut = copie;
+    while (debut != NULL) {
+        char *virgule = strchr(debut, ',');
+        if (virgule != NULL) {
+            *virgule = '\0';
+        }
+
+        // Retrait des espaces autour de l'élément
+        while (isspace((unsigned char)*debut)) debut++;
+        char *fin = debut + strlen(debut);
+        while (fin > debut && isspace((unsigned char)fin[-1])) fin--;
+        *fin = '\0';
+
+        if (*debut == '\0') {
+            decrire(message, size, "élément vide dans la chaîne de filtres");
+            bmp_setStatus(status, BMP_ERR_CHAIN);
+            free(copie);
+            chain_free(chain);
+            return NULL;
+        }
+        // Rectangle éventuel après '@'
+        char *arobase = strchr(debut, '@');
+        if (arobase != NULL) {
+            *arobase = '\0';
+        }
+        if (analyser_operation(debut, &chain->ops[chain->count], message, size) != 0 ||
+            (arobase != NULL && analyser_rectangle(arobase + 1, &chain->ops[chain->count], message, size) != 0)) {
+            bmp_setStatus(status, BMP_ERR_CHAIN);
+            free(copie);
+            chain_free(chain);
+            return NULL;
+        }
+        chain->count++;
+
+        debut = virgule != NULL ? virgule + 1 : NULL;
+    }
+    free(copie);
+
+    // Noyaux créés une seule fois pour toutes les images
+    for (int i = 0; i < chain->count; i++) {
+        t_chain_op_type type = chain->ops[i].type;
+        if (est_convolution(type) && chain->kernels[type - CHAIN_BOX_BLUR] == NULL) {
+            chain->kernels[type - CHAIN_BOX_BLUR] = bmp24_createKernel(noyau_operation(type));
+            if (chain->kernels[type - CHAIN_BOX_BLUR] == NULL) {
+                bmp_setStatus(status, BMP_ERR_MEMORY);
+                chain_free(chain);
+                return NULL;
+            }
+        }
+    }
+
+    for (int p = 0; p < 2; p++) {
+        chain->plan[p] = planifier(chain, p, &chain->nbSteps[p]);
+        if (chain->plan[p] == NULL) {
+            bmp_setStatus(status, BMP_ERR_MEMORY);
+            chain_free(chain);
+            return NULL;
+        }
+    }
+
+    bmp_setStatus(status, BMP_OK);
+    return chain;
+}
+
+void chain_free(t_chain *chain) {
+    if (chain != NULL) {
+        for (int i = 0; i < 5; i++) {
+            bmp24_freeKernel(chain->kernels[i], 3);
+        }
+        free(chain->plan[0]);
+        free(chain->plan[1]);
+        free(chain->ops);
+        free(chain);
+    }
+}
+
+// Égalisation d'histogramme d'une image 8 bits
+static t_bmp_status egaliser(t_bmp8 *img) {
+    uint64_t *hist = bmp8_computeHistogram(img);
+    if (hist == NULL) {
+        return BMP_ERR_MEMORY;
+    }
+    unsigned int *hist_eq = bmp8_computeCDF(hist);
+    free(hist);
+    if (hist_eq == NULL) {
+        return BMP_ERR_MEMORY;
+    }
+    t_bmp_status res = bmp8_equalize(img, hist_eq);
+    free(hist_eq);
+    return res;
+}
+
+static t_bmp_status appliquer_bmp8(const t_chain *chain, const t_chain_op *op, t_bmp8 *img,
+                                   t_chain_scratch *scratch) {
+    switch (op->type) {
+        case CHAIN_NEGATIVE:
+            return bmp8_negative(img);
+        case CHAIN_BRIGHTNESS:
+            return bmp8_brightness(img, op->value);
+        case CHAIN_GRAYSCALE:
+            // Une image 8 bits est déjà en niveaux de gris
+            return BMP_OK;
+        case CHAIN_THRESHOLD:
+            return bmp8_threshold(img, op->value);
+        case CHAIN_EQUALIZE:
+            return egaliser(img);
+        default:
+            return bmp8_applyFilterScratch(img, chain->kernels[op->type - CHAIN_BOX_BLUR], 3, &scratch->bmp8);
+    }
+}
+
+static t_bmp_status appliquer_bmp24(const t_chain *chain, const t_chain_op *op, t_bmp24 *img,
+                                    t_chain_scratch *scratch) {
+    switch (op->type) {
+        case CHAIN_NEGATIVE:
+            return bmp24_negative(img);
+        case CHAIN_BRIGHTNESS:
+            return bmp24_brightness(img, op->value);
+        case CHAIN_GRAYSCALE:
+            return bmp24_grayscale(img);
+        case CHAIN_THRESHOLD:
+        case CHAIN_EQUALIZE:
+            // Disponibles pour les images 8 bits uniquement
+            return BMP_ERR_DEPTH;
+        default:
+            return bmp24_applyFilterScratch(img, chain->kernels[op->type - CHAIN_BOX_BLUR], 3, &scratch->bmp24);
+    }
+}
+
+// Égalisation d'après l'histogramme du seul rectangle
+static t_bmp_status egaliser_vue(const t_bmp8_view *vue) {
+    uint64_t *hist = bmp8_viewHistogram(vue);
+    if (hist == NULL) {
+        return BMP_ERR_MEMORY;
+    }
+    unsigned int *hist_eq = bmp8_computeCDF(hist);
+    free(hist);
+    if (hist_eq == NULL) {
+        return BMP_ERR_MEMORY;
+    }
+    t_bmp_status res = bmp8_viewEqualize(vue, hist_eq);
+    free(hist_eq);
+    return res;
+}
+
+// Opération limitée à un rectangle : seuls ses pixels sont parcourus (les convolutions lisent aussi leur
+// voisinage dans l'image)
+static t_bmp_status appliquer_rectangle(const t_chain *chain, const t_chain_op *op, t_image *img) {
+    t_bmp_rect r = op->rect;
+    t_bmp_status res;
+    if (img->type == IMAGE_BMP8) {
+        t_bmp8_view vue;
+        if (!bmp_clipRect(&r, (int)img->bmp8->width, (int)img->bmp8->height)) {
+            return BMP_OK;
+        }
+        res = bmp8_view(img->bmp8, r.x, r.y, r.width, r.height, &vue);
+        if (res != BMP_OK) {
+            return res;
+        }
+        switch (op->type) {
+            case CHAIN_NEGATIVE:
+                return bmp8_viewNegative(&vue);
+            case CHAIN_BRIGHTNESS:
+                return bmp8_viewBrightness(&vue, op->value);
+            case CHAIN_GRAYSCALE:
+                return BMP_OK;
+            case CHAIN_THRESHOLD:
+                return bmp8_viewThreshold(&vue, op->value);
+            case CHAIN_EQUALIZE:
+                return egaliser_vue(&vue);
+            default:
+                return bmp8_viewApplyFilter(&vue, chain->kernels[op->type - CHAIN_BOX_BLUR], 3);
+        }
+    }
+
+    t_bmp24_view vue;
+    if (!bmp_clipRect(&r, img->bmp24->width, img->bmp24->height)) {
+        return BMP_OK;
+    }
+    res = bmp24_view(img->bmp24, r.x, r.y, r.width, r.height, &vue);
+    if (res != BMP_OK) {
+        return res;
+    }
+    switch (op->type) {
+        case CHAIN_NEGATIVE:
+            return bmp24_viewNegative(&vue);
+        case CHAIN_BRIGHTNESS:
+            return bmp24_viewBrightness(&vue, op->value);
+        case CHAIN_GRAYSCALE:
+            return bmp24_viewGrayscale(&vue);
+        case CHAIN_THRESHOLD:
+        case CHAIN_EQUALIZE:
+            return BMP_ERR_DEPTH;
+        default:
+            return bmp24_viewApplyFilter(&vue, chain->kernels[op->type - CHAIN_BOX_BLUR], 3);
+    }
+}
+
+// Opération seule, sans fusion
+static t_bmp_status appliquer_operation(const t_chain *chain, const t_chain_op *op, t_image *img,
+                                        t_chain_scratch *scratch) {
+    if (chain_isGeometric(op->type)) {
+        // Un seul thread : en traitement par lot, les images sont déjà réparties sur les cœurs
+        return transform_image(img, (t_transform)(TRANSFORM_ROTATE90 + (op->type - CHAIN_ROTATE90)), 1);
+    }
+    if (op->hasRect) {
+        return appliquer_rectangle(chain, op, img);
+    }
+    if (img->type == IMAGE_BMP8) {
+        return appliquer_bmp8(chain, op, img->bmp8, scratch);
+    }
+    return appliquer_bmp24(chain, op, img->bmp24, scratch);
+}
+
+// Étape fusionnée : un seul passage sur l'image
+static t_bmp_status appliquer_tables(const t_chain_step *etape, t_image *img) {
+    if (img->type == IMAGE_BMP8) {
+        if (img->bmp8->data == NULL) {
+            return BMP_ERR_ARGUMENT;
+        }
+        kernels_get()->applyLut(img->bmp8->data, img->bmp8->dataSize, etape->lut);
+        return BMP_OK;
+    }
+
+    t_bmp24 *bmp = img->bmp24;
+    if (bmp->data == NULL) {
+        return BMP_ERR_ARGUMENT;
+    }
+    if (etape->type == CHAIN_STEP_LUT) {
+        for (int i = 0; i < bmp->height; i++) {
+            bmp24_applyLutRow(bmp->data[i], bmp->width, etape->lut);
+        }
+        return BMP_OK;
+    }
+    const uint8_t *before = etape->hasBefore ? etape->before : NULL;
+    for (int i = 0; i < bmp->height; i++) {
+        bmp24_grayscaleLutRow(bmp->data[i], bmp->width, before, etape->lut);
+    }
+    return BMP_OK;
+}
+
+t_bmp_status chain_apply(const t_chain *chain, t_image *img, t_chain_scratch *scratch) {
+    if (chain == NULL || img == NULL || img->type == IMAGE_NONE) {
+        return BMP_ERR_ARGUMENT;
+    }
+    return chain_applySteps(chain, img, 0, chain->nbSteps[indice_plan(img->type)], scratch);
+}
+
+t_bmp_status chain_applySteps(const t_chain *chain, t_image *img, int first, int last, t_chain_scratch *scratch) {
+    if (chain == NULL || img == NULL || img->type == IMAGE_NONE || scratch == NULL) {
+        return BMP_ERR_ARGUMENT;
+    }
+    int p = indice_plan(img->type);
+    if (first < 0 || last > chain->nbSteps[p] || first > last) {
+        return BMP_ERR_ARGUMENT;
+    }
+
+    for (int s = first; s < last; s++) {
+        const t_chain_step *etape = &chain->plan[p][s];
+        t_bmp_status res = etape->type == CHAIN_STEP_OP
+                           ? appliquer_operation(chain, &chain->ops[etape->first], img, scratch)
+                           : appliquer_tables(etape, img);
+        if (res != BMP_OK) {
+            return res;
+        }
+    }
+    return BMP_OK;
+}
+
+t_bmp_status chain_applyScaled(const t_chain *chain, t_image *img, double scale, t_chain_scratch *scratch) {
+    if (chain == NULL || !(scale >= 1)) {
+        return BMP_ERR_ARGUMENT;
+    }
+    if (scale == 1) {
+        return chain_apply(chain, img, scratch);
+    }
+
+    // Copie de la chaîne à l'échelle de l'image ; les plans d'exécution ne dépendent pas de ces valeurs
+    t_chain reduite = *chain;
+    reduite.ops = malloc(sizeof(t_chain_op) * (chain->count > 0 ? chain->count : 1));
+    t_bmp_status res = reduite.ops != NULL ? BMP_OK : BMP_ERR_MEMORY;
+    for (int i = 0; i < 5; i++) {
+        reduite.kernels[i] = NULL;
+        if (res == BMP_OK && chain->kernels[i] != NULL) {
+            reduite.kernels[i] = bmp24_scaleKernel(chain->kernels[i], 3, scale);
+            if (reduite.kernels[i] == NULL) {
+                res = BMP_ERR_MEMORY;
+            }
+        }
+    }
+    if (res == BMP_OK) {
+        for (int i = 0; i < chain->count; i++) {
+            t_chain_op op = chain->ops[i];
+            if (op.hasRect) {
+                int x1 = (int)ceil((op.rect.x + (double)op.rect.width) / scale);
+                int y1 = (int)ceil((op.rect.y + (double)op.rect.height) / scale);
+                op.rect.x = (int)(op.rect.x / scale);
+                op.rect.y = (int)(op.rect.y / scale);
+                op.rect.width = x1 - op.rect.x;
+                op.rect.height = y1 - op.rect.y;
+            }
+            reduite.ops[i] = op;
+        }
+        res = chain_apply(&reduite, img, scratch);
+    }
+
+    for (int i = 0; i < 5; i++) {
+        bmp24_freeKernel(reduite.kernels[i], 3);
+    }
+    free(reduite.ops);
+    return res;
+}
+
+int chain_passCount(const t_chain *chain, t_image_type type) {
+    return chain != NULL && type != IMAGE_NONE ? chain->nbSteps[indice_plan(type)] : 0;
+}
+
+int chain_pointLut(const t_chain *chain, t_image_type type, unsigned char lut[256]) {
+    if (chain == NULL || type == IMAGE_NONE) {
+        return 0;
+    }
+    int p = indice_plan(type);
+    if (chain->nbSteps[p] == 0) {
+        table_identite(lut);
+        return 1;
+    }
+    if (chain->nbSteps[p] > 1) {
+        return 0;
+    }
+    const t_chain_step *etape = &chain->plan[p][0];
+    if (etape->type == CHAIN_STEP_LUT) {
+        memcpy(lut, etape->lut, 256);
+        return 1;
+    }
+    if (etape->type == CHAIN_STEP_OP) {
+        const t_chain_op *op = &chain->ops[etape->first];
+        if (!op->hasRect && (op->type == CHAIN_NEGATIVE || op->type == CHAIN_BRIGHTNESS ||
+                             (op->type == CHAIN_THRESHOLD && type == IMAGE_BMP8))) {
+            table_operation(op, lut);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void chain_freeScratch(t_chain_scratch *scratch) {
+    if (scratch != NULL) {
+        bmp8_freeScratch(&scratch->bmp8);
+        bmp24_freeScratch(&scratch->bmp24);
+    }
+}
+
+int chain_format(const t_chain *chain, char *buffer, size_t size) {
+    int total = 0;
+    if (buffer != NULL && size > 0) {
+        buffer[0] = '\0';
+    }
+    if (chain == NULL) {
+        return 0;
+    }
+
+    for (int i = 0; i < chain->count; i++) {
+        const t_chain_op *op = &chain->ops[i];
+        size_t reste = (size_t)total < size ? size - (size_t)total : 0;
+        char *dst = reste > 0 ? buffer + total : NULL;
+        int n;
+        if (op->type == CHAIN_BRIGHTNESS || op->type == CHAIN_THRESHOLD) {
+            n = snprintf(dst, reste, "%s%s:%d", i > 0 ? "," : "", noms_operations[op->type], op->value);
+        } else {
+            n = snprintf(dst, reste, "%s%s", i > 0 ? "," : "", noms_operations[op->type]);
+        }
+        if (n < 0) {
+            return -1;
+        }
+        total += n;
+        if (op->hasRect) {
+            reste = (size_t)total < size ? size - (size_t)total : 0;
+            n = snprintf(reste > 0 ? buffer + total : NULL, reste, "@%dx%d+%d+%d", op->rect.width, op->rect.height,
+                         op->rect.x, op->rect.y);
+            if (n < 0) {
+                return -1;
+            }
+            total += n;
+        }
+    }
+    return total;
+}
@@ -0,0 +1,113 @@
+/*
+* Fichier : chain.h
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Chaîne de filtres déclarative, par exemple "gaussian,sharpen,brightness:20". Un filtre suivi de
+ *           @LxH+X+Y ne traite que ce rectangle (vue sur l'image, sans copie), par exemple "box@120x40+300+210".
+ *           La chaîne est analysée une seule fois puis appliquée à autant d'images que voulu, y compris depuis
+ *           plusieurs threads (chaque thread fournit son propre t_chain_scratch).
+ */
+
+#ifndef CHAIN_H
+#define CHAIN_H
+
+#include <stddef.h>
+#include "bmp_io.h"
+
+// Opérations reconnues (nom dans la chaîne entre parenthèses)
+typedef enum {
+    CHAIN_NEGATIVE = 0,     // negative
+    CHAIN_BRIGHTNESS,       // brightness:N   (N dans [-255, 255])
+    CHAIN_GRAYSCALE,        // grayscale      (sans effet sur une image 8 bits)
+    CHAIN_THRESHOLD,        // threshold:N    (8 bits uniquement, N dans [0, 255])
+    CHAIN_EQUALIZE,         // equalize       (8 bits uniquement)
+    CHAIN_BOX_BLUR,         // box
+    CHAIN_GAUSSIAN_BLUR,    // gaussian
+    CHAIN_OUTLINE,          // outline
+    CHAIN_EMBOSS,           // emboss
+    CHAIN_SHARPEN,          // sharpen
+    CHAIN_ROTATE90,         // rotate90       (transformations géométriques, voir transform.h)
+    CHAIN_ROTATE180,        // rotate180
+    CHAIN_ROTATE270,        // rotate270
+    CHAIN_FLIP_H,           // fliph
+    CHAIN_FLIP_V,           // flipv
+    CHAIN_TRANSPOSE,        // transpose
+    CHAIN_TRANSVERSE        // transverse
+} t_chain_op_type;
+
+typedef struct {
+    t_chain_op_type type;
+    int value;              // paramètre de brightness et threshold
+    int hasRect;            // 1 : opération limitée à rect (coupé aux bords de chaque image, ignoré s'il en sort)
+    t_bmp_rect rect;
+} t_chain_op;
+
+// Étape du plan d'exécution : une opération, ou une suite d'opérations ponctuelles fusionnées en un seul
+// passage sur l'image
+typedef enum {
+    CHAIN_STEP_OP = 0,      // ops[first] seule
+    CHAIN_STEP_LUT,         // ops[first .. first + count) réduites à une table de correspondance (lut)
+    CHAIN_STEP_GRAY_LUT     // 24 bits : table before, niveaux de gris, puis table lut sur le seul canal gris
+} t_chain_step_type;
+
+typedef struct {
+    t_chain_step_type type;
+    int first;
+    int count;
+    int hasBefore;              // CHAIN_STEP_GRAY_LUT : before n'est pas l'identité
+    unsigned char before[256];
+    unsigned char lut[256];
+} t_chain_step;
+
+typedef struct {
+    t_chain_op *ops;
+    int count;
+    float **kernels[5];     // noyaux 3x3 des convolutions utilisées, partagés en lecture seule
+    // Plans d'exécution calculés à l'analyse, pour les images 8 bits et 24/32 bits : les opérations ponctuelles
+    // consécutives (négatif, luminosité, seuil) sont composées en une table, les luminosités successives
+    // repliées en un seul décalage saturé, et les opérations qui suivent des niveaux de gris ne calculent
+    // plus qu'un canal. Le résultat est identique, octet pour octet, à l'application opération par opération.
+    t_chain_step *plan[2];  // plan[0] : 8 bits, plan[1] : 24/32 bits
+    int nbSteps[2];
+} t_chain;
+
+// Tampons de travail d'un thread, conservés d'une image à l'autre
+typedef struct {
+    t_bmp8_scratch bmp8;
+    t_bmp24_scratch bmp24;
+} t_chain_scratch;
+
+// Analyse d'une chaîne ; renvoie NULL si elle est invalide, avec la cause dans *status et une explication
+// dans message (tous deux optionnels : status peut être NULL, message NULL ou size 0)
+t_chain *chain_parse(const char *spec, t_bmp_status *status, char *message, size_t size);
+void chain_free(t_chain *chain);
+
+// Vrai pour les transformations géométriques (rotate*, flip*, transpose, transverse), qui ont besoin de
+// l'image entière et peuvent échanger largeur et hauteur (elles n'acceptent pas de rectangle)
+int chain_isGeometric(t_chain_op_type type);
+
+// Application de toutes les opérations dans l'ordre (selon le plan d'exécution de la profondeur de l'image) ;
+// s'arrête à la première erreur (BMP_ERR_DEPTH pour threshold ou equalize sur une image 24 bits)
+t_bmp_status chain_apply(const t_chain *chain, t_image *img, t_chain_scratch *scratch);
+
+// Étapes [first, last) seulement du plan d'exécution de la profondeur de l'image (plan[0] ou plan[1]) : pour
+// reprendre une chaîne après un préfixe déjà calculé. Après l'étape s, les opérations ops[0 .. fin) ont été
+// appliquées, fin valant plan[s + 1].first, ou count après la dernière étape.
+t_bmp_status chain_applySteps(const t_chain *chain, t_image *img, int first, int last, t_chain_scratch *scratch);
+
+// Comme chain_apply, sur une image réduite d'un facteur scale (>= 1) par rapport à celles que vise la chaîne
+// (aperçu) : les noyaux de convolution sont rééchantillonnés (bmp24_scaleKernel) et les rectangles réduits
+t_bmp_status chain_applyScaled(const t_chain *chain, t_image *img, double scale, t_chain_scratch *scratch);
+
+// Nombre de passages sur l'image du plan d'exécution pour ce type d'image (0 si la chaîne est sans effet)
+int chain_passCount(const t_chain *chain, t_image_type type);
+
+// Vrai si toute la chaîne se réduit, pour ce type d'image, à une table de correspondance appliquée à chaque
+// octet des canaux ; la table est alors écrite dans lut (voir history_begin)
+int chain_pointLut(const t_chain *chain, t_image_type type, unsigned char lut[256]);
+
+void chain_freeScratch(t_chain_scratch *scratch);
+
+// Écrit la forme normalisée de la chaîne dans buffer ; renvoie la longueur nécessaire (comme snprintf)
+int chain_format(const t_chain *chain, char *buffer, size_t size);
+
+#endif // CHAIN_H
@@ -0,0 +1,111 @@
+/*
+* Fichier : cpu.c
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Implémente la détection des extensions SIMD via cpuid/xgetbv et la lecture de la
+ *           variable d'environnement IPROCESS_CPU.
+ */
+
+#include "cpu.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+
+// Lecture du registre XCR0 : indique quels registres étendus l'OS sauvegarde
+static uint64_t lire_xcr0(void) {
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64_t)edx << 32) | eax;
+}
+#endif
+
+t_cpu_level cpu_detect(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return CPU_LEVEL_SCALAR;
+    }
+
+    int ssse3   = (ecx >> 9) & 1;
+    int sse41   = (ecx >> 19) & 1;
+    int osxsave = (ecx >> 27) & 1;
+    int avx     = (ecx >> 28) & 1;
+
+    if (!ssse3 || !sse41) {
+        return CPU_LEVEL_SCALAR;
+    }
+
+    // Sans XSAVE activé par l'OS, les registres YMM/ZMM ne sont pas utilisables
+    if (!osxsave || !avx) {
+        return CPU_LEVEL_SSE4;
+    }
+
+    uint64_t xcr0 = lire_xcr0();
+    if ((xcr0 & 0x6) != 0x6) {   // états XMM et YMM
+        return CPU_LEVEL_SSE4;
+    }
+
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return CPU_LEVEL_SSE4;
+    }
+
+    int avx2     = (ebx >> 5) & 1;
+    int avx512f  = (ebx >> 16) & 1;
+    int avx512bw = (ebx >> 30) & 1;
+
+    if (!avx2) {
+        return CPU_LEVEL_SSE4;
+    }
+
+    if (avx512f && avx512bw && (xcr0 & 0xE6) == 0xE6) {   // états opmask + ZMM
+        return CPU_LEVEL_AVX512;
+    }
+
+    return CPU_LEVEL_AVX2;
+#else
+    return CPU_LEVEL_SCALAR;
+#endif
+}
+
+const char *cpu_levelName(t_cpu_level level) {
+    switch (level) {
+        case CPU_LEVEL_SSE4:   return "sse4";
+        case CPU_LEVEL_AVX2:   return "avx2";
+        case CPU_LEVEL_AVX512: return "avx512";
+        default:               return "scalar";
+    }
+}
+
+t_cpu_level cpu_selectLevel(void) {
+    t_cpu_level level = cpu_detect();
+
+    const char *env = getenv(CPU_ENV_VAR);
+    if (env == NULL || env[0] == '\0') {
+        return level;
+    }
+
+    t_cpu_level demande;
+    if (strcmp(env, "scalar") == 0) {
+        demande = CPU_LEVEL_SCALAR;
+    } else if (strcmp(env, "sse4") == 0) {
+        demande = CPU_LEVEL_SSE4;
+    } else if (strcmp(env, "avx2") == 0) {
+        demande = CPU_LEVEL_AVX2;
+    } else if (strcmp(env, "avx512") == 0) {
+        demande = CPU_LEVEL_AVX512;
+    } else {
+        // Valeur inconnue : ignorée sans message, l'appelant peut afficher le niveau retenu
+        return level;
+    }
+
+    // On ne peut pas forcer un niveau que le processeur ne supporte pas
+    if (demande > level) {
+        return level;
+    }
+
+    return demande;
+}
@@ -0,0 +1,31 @@
+/*
+* Fichier : cpu.h
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Détection des extensions SIMD du processeur (cpuid) au démarrage du programme.
+ *           Le niveau retenu peut être abaissé par la variable d'environnement IPROCESS_CPU
+ *           (scalar, sse4, avx2, avx512) pour tester les différents chemins de code.
+ */
+
+#ifndef CPU_H
+#define CPU_H
+
+// Niveaux de jeu d'instructions, du moins au plus performant
+typedef enum {
+    CPU_LEVEL_SCALAR = 0,
+    CPU_LEVEL_SSE4   = 1,   // SSSE3 + SSE4.1
+    CPU_LEVEL_AVX2   = 2,   // AVX2 (registres YMM activés par l'OS)
+    CPU_LEVEL_AVX512 = 3    // AVX-512 F + BW (registres ZMM activés par l'OS)
+} t_cpu_level;
+
+#define CPU_ENV_VAR "IPROCESS_CPU"
+
+// Niveau maximal supporté par le matériel (interrogation cpuid)
+t_cpu_level cpu_detect(void);
+
+// Niveau effectif : celui du matériel, éventuellement abaissé par IPROCESS_CPU (valeur invalide ignorée)
+t_cpu_level cpu_selectLevel(void);
+
+// Nom lisible d'un niveau ("scalar", "sse4", "avx2", "avx512")
+const char *cpu_levelName(t_cpu_level level);
+
+#endif // CPU_H
@@ -0,0 +1,171 @@
+/*
+* Fichier : dzi.c
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Implémente l'export Deep Zoom : création des dossiers, découpage de chaque niveau en tuiles
+ *           réparties sur plusieurs threads (chaque tuile est une vue sur les lignes du niveau, sans copie),
+ *           réduction vers le niveau suivant, puis manifeste XML.
+ */
+
+#include "dzi.h"
+#include "pyramid.h"
+#include "bmp_file.h"
+#include "threadpool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Découpage d'un niveau, partagé par les threads d'écriture
+typedef struct {
+    const t_bmp24 *niveau;
+    const char *dossier;        // <base>_files/<niveau>
+    int tileSize;
+    int overlap;
+    int colonnes;
+} t_decoupage;
+
+void dzi_defaultOptions(t_dzi_options *options) {
+    options->tileSize = DZI_TILE_DEFAULT;
+    options->overlap = DZI_OVERLAP_DEFAULT;
+    options->threads = 0;
+}
+
+int dzi_levelCount(int width, int height) {
+    int n = 1;
+    while (width > 1 || height > 1) {
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+        n++;
+    }
+    return n;
+}
+
+// Tuiles [debut, fin) du niveau, numérotées ligne par ligne
+static int ecrire_tuiles(void *arg, int debut, int fin) {
+    const t_decoupage *d = arg;
+    const t_bmp24 *niv = d->niveau;
+    size_t n = strlen(d->dossier) + 32;
+    char *chemin = malloc(n);
+    t_pixel **lignes = malloc((size_t)(d->tileSize + 2 * d->overlap) * sizeof(t_pixel *));
+    if (chemin == NULL || lignes == NULL) {
+        free(chemin);
+        free(lignes);
+        return BMP_ERR_MEMORY;
+    }
+
+    // Vue sur les lignes du niveau : seuls largeur, hauteur, profondeur et compression comptent à l'écriture
+    t_bmp24 vue = *niv;
+    vue.data = lignes;
+
+    int res = BMP_OK;
+    for (int t = debut; t < fin && res == BMP_OK; t++) {
+        int col = t % d->colonnes, lig = t / d->colonnes;
+        int x0 = col * d->tileSize - (col > 0 ? d->overlap : 0);
+        int y0 = lig * d->tileSize - (lig > 0 ? d->overlap : 0);
+        int x1 = (col + 1) * d->tileSize + d->overlap;
+        int y1 = (lig + 1) * d->tileSize + d->overlap;
+        vue.width = (x1 < niv->width ? x1 : niv->width) - x0;
+        vue.height = (y1 < niv->height ? y1 : niv->height) - y0;
+        for (int y = 0; y < vue.height; y++) {
+            lignes[y] = niv->data[y0 + y] + x0;
+        }
+        snprintf(chemin, n, "%s/%d_%d.bmp", d->dossier, col, lig);
+        res = bmp24_saveImage(chemin, &vue);
+    }
+
+    free(chemin);
+    free(lignes);
+    return res;
+}
+
+// Toutes les tuiles d'un niveau, dans <base>_files/<numéro>
+static t_bmp_status decouper_niveau(const t_bmp24 *niveau, const char *racine, int numero,
+                                    const t_dzi_options *options) {
+    size_t n = strlen(racine) + 16;
+    char *dossier = malloc(n);
+    if (dossier == NULL) {
+        return BMP_ERR_MEMORY;
+    }
+    snprintf(dossier, n, "%s/%d", racine, numero);
+    if (bmp_makeDirectory(dossier) != 0) {
+        free(dossier);
+        return BMP_ERR_OPEN;
+    }
+
+    t_decoupage d = { niveau, dossier, options->tileSize, options->overlap,
+                      (niveau->width + options->tileSize - 1) / options->tileSize };
+    int lignes = (niveau->height + options->tileSize - 1) / options->tileSize;
+    int res = threadpool_split(options->threads, d.colonnes * lignes, ecrire_tuiles, &d);
+    free(dossier);
+    return (t_bmp_status)res;
+}
+
+static t_bmp_status ecrire_manifeste(const char *base, const t_bmp24 *img, const t_dzi_options *options) {
+    size_t n = strlen(base) + 5;
+    char *chemin = malloc(n);
+    if (chemin == NULL) {
+        return BMP_ERR_MEMORY;
+    }
+    snprintf(chemin, n, "%s.dzi", base);
+    FILE *f = fopen(chemin, "w");
+    free(chemin);
+    if (f == NULL) {
+        return BMP_ERR_OPEN;
+    }
+
+    fprintf(f, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+    fprintf(f, "<Image xmlns=\"http://schemas.microsoft.com/deepzoom/2008\" Format=\"bmp\" Overlap=\"%d\" "
+               "TileSize=\"%d\">\n", options->overlap, options->tileSize);
+    fprintf(f, "  <Size Width=\"%d\" Height=\"%d\"/>\n", img->width, img->height);
+    fprintf(f, "</Image>\n");
+    int erreur = ferror(f);
+    if (fclose(f) != 0 || erreur) {
+        return BMP_ERR_WRITE;
+    }
+    return BMP_OK;
+}
+
+t_bmp_status dzi_export(const t_bmp24 *img, const char *base, const t_dzi_options *options) {
+    t_dzi_options defaut;
+    if (options == NULL) {
+        dzi_defaultOptions(&defaut);
+        options = &defaut;
+    }
+    if (img == NULL || img->data == NULL || img->width <= 0 || img->height <= 0 || base == NULL ||
+        options->tileSize <= 0 || options->overlap < 0 || options->overlap > options->tileSize / 2) {
+        return BMP_ERR_ARGUMENT;
+    }
+
+    size_t n = strlen(base) + 8;
+    char *racine = malloc(n);
+    if (racine == NULL) {
+        return BMP_ERR_MEMORY;
+    }
+    snprintf(racine, n, "%s_files", base);
+    if (bmp_makeDirectory(racine) != 0) {
+        free(racine);
+        return BMP_ERR_OPEN;
+    }
+
+    // Du niveau le plus élevé (l'image elle-même) au niveau 0 ; seul le niveau courant est conservé
+    const t_bmp24 *niveau = img;
+    t_bmp_status res = BMP_OK;
+    for (int numero = dzi_levelCount(img->width, img->height) - 1; numero >= 0 && res == BMP_OK; numero--) {
+        res = decouper_niveau(niveau, racine, numero, options);
+        if (res == BMP_OK && numero > 0) {
+            t_bmp24 *suivant = pyramid_reduceBmp24(niveau, options->threads, &res);
+            if (niveau != img) {
+                bmp24_free((t_bmp24 *)niveau);
+            }
+            niveau = suivant;
+        }
+    }
+    if (niveau != img) {
+        bmp24_free((t_bmp24 *)niveau);
+    }
+    free(racine);
+
+    if (res == BMP_OK) {
+        res = ecrire_manifeste(base, img, options);
+    }
+    return res;
+}
@@ -0,0 +1,35 @@
+/*
+* Fichier : dzi.h
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Export d'une image 24/32 bits en arborescence de tuiles Deep Zoom (DZI) pour les visionneuses web :
+ *           <base>.dzi (manifeste XML) et <base>_files/<niveau>/<colonne>_<ligne>.bmp, le niveau le plus élevé
+ *           étant l'image entière et le niveau 0 un seul pixel. Les niveaux sont produits un par un par
+ *           pyramid_reduceBmp24 et leurs tuiles écrites en parallèle, directement depuis les lignes de l'image :
+ *           au plus deux niveaux réduits sont en mémoire à la fois (le quart puis le seizième de l'image).
+ */
+
+#ifndef DZI_H
+#define DZI_H
+
+#include "bmp24.h"
+
+#define DZI_TILE_DEFAULT 256
+#define DZI_OVERLAP_DEFAULT 1
+
+typedef struct {
+    int tileSize;       // côté des tuiles, hors recouvrement
+    int overlap;        // pixels partagés avec chaque tuile voisine (0 à tileSize / 2)
+    int threads;        // threads de réduction et d'écriture, 0 : nombre de cœurs
+} t_dzi_options;
+
+// Valeurs par défaut : tuiles de 256 pixels, recouvrement de 1, tous les cœurs
+void dzi_defaultOptions(t_dzi_options *options);
+
+// Nombre de niveaux de l'arborescence : ceil(log2(max(largeur, hauteur))) + 1
+int dzi_levelCount(int width, int height);
+
+// Écrit l'arborescence de img sous base (chemin sans extension, dossier parent existant) ; le manifeste est
+// écrit en dernier, une fois toutes les tuiles en place
+t_bmp_status dzi_export(const t_bmp24 *img, const char *base, const t_dzi_options *options);
+
+#endif // DZI_H
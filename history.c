@@ -0,0 +1,729 @@
+/*
+* Fichier : history.c
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Implémente l'historique annuler / rétablir : tables de correspondance inversées, différences
+ *           (ou exclusif) compressées par bandes de lignes, images précédentes pour les changements de taille,
+ *           pile d'étapes bornée par un budget mémoire, version de référence en tuiles des images 24/32 bits.
+ */
+
+#include "history.h"
+#include "kernels.h"
+#include "tiled24.h"
+#include "bmp_size.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Une bande de la différence avant / après ; la même différence sert à annuler et à rétablir
+typedef struct {
+    unsigned char *data;    // NULL : bande inchangée
+    size_t size;
+    bool brut;              // différence gardée telle quelle, la compression ne la réduisant pas
+} t_bande;
+
+typedef enum {
+    ETAPE_LUT = 0,          // opération ponctuelle réversible : tables directe et inverse
+    ETAPE_DIFFERENCE,       // différence compressée par bandes de HISTORY_BAND_ROWS lignes
+    ETAPE_IMAGE             // dimensions changées : l'autre version entière de l'image (en tuiles en 24/32 bits)
+} t_type_etape;
+
+typedef struct {
+    t_type_etape type;
+    char label[48];
+    size_t taille;          // mémoire occupée par l'étape
+    unsigned char lut[256];
+    unsigned char inverse[256];
+    int nbBandes;
+    t_bande *bandes;
+    t_image *image;         // image 8 bits
+    t_tiled24 *versions[2]; // image 24/32 bits : versions avant et après l'étape, partagées avec la référence
+} t_etape;
+
+struct s_history {
+    size_t budget;
+    size_t taille;          // somme des tailles des étapes
+    t_etape **etapes;
+    int nbEtapes;
+    int capacite;
+    int position;           // étapes [0, position) annulables, [position, nbEtapes) rétablissables
+
+    // Opération en cours, entre history_begin et history_end
+    bool enCours;
+    bool lutValide;
+    unsigned char lut[256];
+    unsigned char inverse[256];
+    t_image *avant;         // copie de l'image 8 bits avant l'opération (sans table réversible)
+
+    // Images 24/32 bits : copie en tuiles de l'image telle qu'à la fin de la dernière opération, mise à jour
+    // bande par bande ; elle tient lieu d'image précédente (NULL : à reconstruire à la prochaine opération)
+    t_tiled24 *reference;
+};
+
+// --- Lignes d'une image ---
+
+// Octets par ligne : lignes du fichier padding compris pour les images 8 bits, que les opérations
+// traitent aussi ; si les lignes ne sont pas régulières, la zone des pixels forme une seule ligne
+static size_t octets_ligne(const t_image *img) {
+    if (img->type == IMAGE_BMP8) {
+        const t_bmp8 *b = img->bmp8;
+        return b->height > 0 && b->dataSize % b->height == 0 ? b->dataSize / b->height : b->dataSize;
+    }
+    return (size_t)img->bmp24->width * sizeof(t_pixel);
+}
+
+static int nb_lignes(const t_image *img) {
+    if (img->type == IMAGE_BMP8) {
+        const t_bmp8 *b = img->bmp8;
+        return b->height > 0 && b->dataSize % b->height == 0 ? (int)b->height : 1;
+    }
+    return img->bmp24->height;
+}
+
+static uint8_t *ligne(const t_image *img, int i) {
+    if (img->type == IMAGE_BMP8) {
+        return img->bmp8->data + (size_t)i * octets_ligne(img);
+    }
+    return (uint8_t *)img->bmp24->data[i];
+}
+
+static bool memes_dimensions(const t_image *a, const t_image *b) {
+    if (a->type != b->type) {
+        return false;
+    }
+    if (a->type == IMAGE_BMP8) {
+        return a->bmp8->width == b->bmp8->width && a->bmp8->height == b->bmp8->height &&
+               a->bmp8->dataSize == b->bmp8->dataSize;
+    }
+    return a->bmp24->width == b->bmp24->width && a->bmp24->height == b->bmp24->height &&
+           a->bmp24->colorDepth == b->bmp24->colorDepth;
+}
+
+static size_t taille_image(const t_image *img) {
+    return (size_t)nb_lignes(img) * octets_ligne(img);
+}
+
+// Copie complète (en-têtes, palette et pixels) ; NULL si la mémoire manque
+static t_image *copier_image(const t_image *img) {
+    t_image *copie = malloc(sizeof(t_image));
+    if (copie == NULL) {
+        return NULL;
+    }
+    copie->type = img->type;
+    if (img->type == IMAGE_BMP8) {
+        t_bmp8 *b = malloc(sizeof(t_bmp8));
+        unsigned char *data = b != NULL ? malloc(img->bmp8->dataSize) : NULL;
+        if (data == NULL) {
+            free(b);
+            free(copie);
+            return NULL;
+        }
+        *b = *img->bmp8;
+        memcpy(data, img->bmp8->data, img->bmp8->dataSize);
+        b->data = data;
+        b->ownsData = 1;
+        copie->bmp8 = b;
+        return copie;
+    }
+
+    const t_bmp24 *src = img->bmp24;
+    t_bmp24 *b = bmp24_allocate(src->width, src->height, src->colorDepth);
+    if (b == NULL) {
+        free(copie);
+        return NULL;
+    }
+    b->header = src->header;
+    b->header_info = src->header_info;
+    for (int i = 0; i < src->height; i++) {
+        memcpy(b->data[i], src->data[i], (size_t)src->width * sizeof(t_pixel));
+    }
+    copie->bmp24 = b;
+    return copie;
+}
+
+// --- Version de référence (images 24/32 bits) ---
+
+// Image étiquetée dont les lignes sont celles d'une version en tuiles
+static t_image vue_tuiles(t_tiled24 *version) {
+    t_image vue;
+    vue.type = IMAGE_BMP24;
+    vue.bmp24 = &version->image;
+    return vue;
+}
+
+static void oublier_reference(t_history *history) {
+    tiled24_free(history->reference);
+    history->reference = NULL;
+}
+
+// Vrai si la référence existe et a la forme de img (son contenu est alors celui de img)
+static bool reference_valide(const t_history *history, const t_image *img) {
+    if (history->reference == NULL) {
+        return false;
+    }
+    t_image vue = vue_tuiles(history->reference);
+    return memes_dimensions(&vue, img);
+}
+
+// --- Tables de correspondance ---
+
+// Valeurs d'octets présentes dans les canaux de l'image (en 32 bits par pixel, l'alpha est compté aussi :
+// l'ensemble est seulement plus grand)
+static void valeurs_presentes(const t_image *img, bool presente[256]) {
+    const t_kernels *k = kernels_get();
+    memset(presente, 0, 256 * sizeof(bool));
+    int lignes = nb_lignes(img);
+    size_t octets = octets_ligne(img);
+    for (int i = 0; i < lignes; i++) {
+        // Histogramme partiel par bloc : les compteurs du noyau sont sur 32 bits
+        for (size_t debut = 0; debut < octets; debut += BMP_IO_CHUNK) {
+            unsigned int partiel[256] = {0};
+            size_t n = octets - debut < BMP_IO_CHUNK ? octets - debut : BMP_IO_CHUNK;
+            k->histogram(ligne(img, i) + debut, n, partiel);
+            for (int v = 0; v < 256; v++) {
+                presente[v] = presente[v] || partiel[v] != 0;
+            }
+        }
+    }
+}
+
+// Table inverse de lut sur les valeurs présentes ; false si deux valeurs présentes ont la même image
+static bool inverser_lut(const unsigned char lut[256], const bool presente[256], unsigned char inverse[256]) {
+    bool prise[256] = {false};
+    for (int v = 0; v < 256; v++) {
+        inverse[v] = (unsigned char)v;
+    }
+    for (int v = 0; v < 256; v++) {
+        if (presente[v]) {
+            if (prise[lut[v]]) {
+                return false;
+            }
+            prise[lut[v]] = true;
+            inverse[lut[v]] = (unsigned char)v;
+        }
+    }
+    return true;
+}
+
+static void appliquer_lut(t_image *img, const unsigned char lut[256]) {
+    if (img->type == IMAGE_BMP8) {
+        kernels_get()->applyLut(img->bmp8->data, img->bmp8->dataSize, lut);
+        return;
+    }
+    for (int i = 0; i < img->bmp24->height; i++) {
+        bmp24_applyLutRow(img->bmp24->data[i], img->bmp24->width, lut);
+    }
+}
+
+// Applique lut à la référence, si elle suit img ; sinon elle est oubliée
+static void appliquer_lut_reference(t_history *history, const t_image *img, const unsigned char lut[256]) {
+    if (!reference_valide(history, img)) {
+        oublier_reference(history);
+        return;
+    }
+    t_tiled24 *reference = history->reference;
+    if (tiled24_detachRows(reference, 0, reference->image.height) != BMP_OK) {
+        oublier_reference(history);
+        return;
+    }
+    t_image vue = vue_tuiles(reference);
+    appliquer_lut(&vue, lut);
+}
+
+// --- Différences compressées ---
+
+static size_t ecrire_varint(uint8_t *out, size_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        out[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    out[n++] = (uint8_t)v;
+    return n;
+}
+
+static size_t lire_varint(const uint8_t *in, size_t *pos) {
+    size_t v = 0;
+    for (int decalage = 0;; decalage += 7) {
+        uint8_t octet = in[(*pos)++];
+        v |= (size_t)(octet & 0x7F) << decalage;
+        if ((octet & 0x80) == 0) {
+            return v;
+        }
+    }
+}
+
+// Différence x de n octets codée en suites (zéros, littéraux, octets littéraux) : une zone inchangée ne coûte
+// que sa longueur. Renvoie la taille écrite dans out (n octets au plus), 0 si le codage ne réduit pas x.
+static size_t compresser(const uint8_t *x, size_t n, uint8_t *out) {
+    size_t i = 0, o = 0;
+    while (i < n) {
+        size_t zeros = i;
+        while (zeros < n && x[zeros] == 0) {
+            zeros++;
+        }
+        if (zeros == n) {
+            break;          // zéros finaux implicites
+        }
+        // Littéraux jusqu'à une suite d'au moins 8 zéros (plus courte, elle coûte moins en littéraux)
+        size_t fin = zeros;
+        while (fin < n) {
+            if (x[fin] != 0) {
+                fin++;
+                continue;
+            }
+            size_t z = fin;
+            while (z < n && x[z] == 0) {
+                z++;
+            }
+            if (z - fin >= 8 || z == n) {
+                break;
+            }
+            fin = z;
+        }
+        uint8_t entete[2 * 10];
+        size_t e = ecrire_varint(entete, zeros - i);
+        e += ecrire_varint(entete + e, fin - zeros);
+        if (o + e + (fin - zeros) >= n) {
+            return 0;
+        }
+        memcpy(out + o, entete, e);
+        memcpy(out + o + e, x + zeros, fin - zeros);
+        o += e + (fin - zeros);
+        i = fin;
+    }
+    return o;
+}
+
+// Reconstitue dans x (n octets) la différence d'une bande
+static void decompresser(const t_bande *bande, uint8_t *x, size_t n) {
+    if (bande->brut) {
+        memcpy(x, bande->data, n);
+        return;
+    }
+    memset(x, 0, n);
+    size_t pos = 0, i = 0;
+    while (pos < bande->size) {
+        i += lire_varint(bande->data, &pos);
+        size_t litteraux = lire_varint(bande->data, &pos);
+        memcpy(x + i, bande->data + pos, litteraux);
+        pos += litteraux;
+        i += litteraux;
+    }
+}
+
+static void liberer_etape(t_etape *etape) {
+    if (etape != NULL) {
+        if (etape->bandes != NULL) {
+            for (int b = 0; b < etape->nbBandes; b++) {
+                free(etape->bandes[b].data);
+            }
+            free(etape->bandes);
+        }
+        bmp_close(etape->image);
+        tiled24_free(etape->versions[0]);
+        tiled24_free(etape->versions[1]);
+        free(etape);
+    }
+}
+
+// Différence entre avant et img, bande par bande ; false si la mémoire manque
+static bool calculer_difference(t_etape *etape, const t_image *avant, const t_image *img) {
+    int lignes = nb_lignes(img);
+    size_t octets = octets_ligne(img);
+    etape->nbBandes = (lignes + HISTORY_BAND_ROWS - 1) / HISTORY_BAND_ROWS;
+    etape->bandes = calloc((size_t)etape->nbBandes, sizeof(t_bande));
+    uint8_t *x = malloc((size_t)HISTORY_BAND_ROWS * octets);
+    if (etape->bandes == NULL || x == NULL) {
+        free(x);
+        return false;
+    }
+    etape->taille += (size_t)etape->nbBandes * sizeof(t_bande);
+
+    for (int b = 0; b < etape->nbBandes; b++) {
+        int debut = b * HISTORY_BAND_ROWS;
+        int fin = debut + HISTORY_BAND_ROWS < lignes ? debut + HISTORY_BAND_ROWS : lignes;
+        size_t n = (size_t)(fin - debut) * octets;
+        uint8_t change = 0;
+        for (int i = debut; i < fin; i++) {
+            const uint8_t *a = ligne(avant, i), *c = ligne(img, i);
+            uint8_t *d = x + (size_t)(i - debut) * octets;
+            for (size_t j = 0; j < octets; j++) {
+                d[j] = a[j] ^ c[j];
+                change |= d[j];
+            }
+        }
+        if (change == 0) {
+            continue;
+        }
+
+        t_bande *bande = &etape->bandes[b];
+        bande->data = malloc(n);
+        if (bande->data == NULL) {
+            free(x);
+            return false;
+        }
+        bande->size = compresser(x, n, bande->data);
+        if (bande->size == 0) {
+            memcpy(bande->data, x, n);
+            bande->size = n;
+            bande->brut = true;
+        } else {
+            unsigned char *ajuste = realloc(bande->data, bande->size);
+            if (ajuste != NULL) {
+                bande->data = ajuste;
+            }
+        }
+        etape->taille += bande->size;
+    }
+    free(x);
+    return true;
+}
+
+// img ^= différence de l'étape (annule ou rétablit) ; BMP_ERR_MEMORY si le tampon de bande manque
+static t_bmp_status appliquer_difference(const t_etape *etape, t_image *img) {
+    int lignes = nb_lignes(img);
+    size_t octets = octets_ligne(img);
+    uint8_t *x = malloc((size_t)HISTORY_BAND_ROWS * octets);
+    if (x == NULL) {
+        return BMP_ERR_MEMORY;
+    }
+    for (int b = 0; b < etape->nbBandes; b++) {
+        if (etape->bandes[b].data == NULL) {
+            continue;
+        }
+        int debut = b * HISTORY_BAND_ROWS;
+        int fin = debut + HISTORY_BAND_ROWS < lignes ? debut + HISTORY_BAND_ROWS : lignes;
+        decompresser(&etape->bandes[b], x, (size_t)(fin - debut) * octets);
+        for (int i = debut; i < fin; i++) {
+            uint8_t *c = ligne(img, i);
+            const uint8_t *d = x + (size_t)(i - debut) * octets;
+            for (size_t j = 0; j < octets; j++) {
+                c[j] ^= d[j];
+            }
+        }
+    }
+    free(x);
+    return BMP_OK;
+}
+
+// Recopie dans la référence les bandes de img que l'étape a modifiées : les autres bandes sont restées
+// identiques. En cas d'échec, la référence est oubliée.
+static void mettre_a_jour_reference(t_history *history, const t_etape *etape, const t_image *img) {
+    if (!reference_valide(history, img)) {
+        oublier_reference(history);
+        return;
+    }
+    t_tiled24 *reference = history->reference;
+    int lignes = nb_lignes(img);
+    size_t octets = octets_ligne(img);
+    for (int b = 0; b < etape->nbBandes; b++) {
+        if (etape->bandes[b].data == NULL) {
+            continue;
+        }
+        int debut = b * HISTORY_BAND_ROWS;
+        int fin = debut + HISTORY_BAND_ROWS < lignes ? debut + HISTORY_BAND_ROWS : lignes;
+        if (tiled24_detachRows(reference, debut, fin - debut) != BMP_OK) {
+            oublier_reference(history);
+            return;
+        }
+        for (int i = debut; i < fin; i++) {
+            memcpy(reference->image.data[i], ligne(img, i), octets);
+        }
+    }
+}
+
+// --- Pile des étapes ---
+
+static void oublier_en_cours(t_history *history) {
+    bmp_close(history->avant);
+    history->avant = NULL;
+    history->enCours = false;
+    history->lutValide = false;
+}
+
+// Oublie les étapes rétablissables, ajoute etape puis libère les plus anciennes au-delà du budget
+static void empiler(t_history *history, t_etape *etape) {
+    while (history->nbEtapes > history->position) {
+        t_etape *e = history->etapes[--history->nbEtapes];
+        history->taille -= e->taille;
+        liberer_etape(e);
+    }
+    if (history->nbEtapes == history->capacite) {
+        int capacite = history->capacite > 0 ? history->capacite * 2 : 16;
+        t_etape **etapes = realloc(history->etapes, (size_t)capacite * sizeof(t_etape *));
+        if (etapes == NULL) {
+            // Sans place pour la nouvelle étape, on ne peut plus rien annuler de façon sûre
+            history_clear(history);
+            liberer_etape(etape);
+            return;
+        }
+        history->etapes = etapes;
+        history->capacite = capacite;
+    }
+    history->etapes[history->nbEtapes++] = etape;
+    history->position = history->nbEtapes;
+    history->taille += etape->taille;
+
+    int oubliees = 0;
+    while (history->budget > 0 && history->taille > history->budget && oubliees < history->nbEtapes) {
+        history->taille -= history->etapes[oubliees]->taille;
+        liberer_etape(history->etapes[oubliees]);
+        oubliees++;
+    }
+    if (oubliees > 0) {
+        memmove(history->etapes, history->etapes + oubliees,
+                (size_t)(history->nbEtapes - oubliees) * sizeof(t_etape *));
+        history->nbEtapes -= oubliees;
+        history->position = history->nbEtapes;
+    }
+}
+
+// --- Interface ---
+
+t_history *history_create(size_t budget) {
+    t_history *history = calloc(1, sizeof(t_history));
+    if (history != NULL) {
+        history->budget = budget;
+    }
+    return history;
+}
+
+void history_free(t_history *history) {
+    if (history != NULL) {
+        history_clear(history);
+        free(history->etapes);
+        free(history);
+    }
+}
+
+void history_clear(t_history *history) {
+    if (history == NULL) {
+        return;
+    }
+    oublier_en_cours(history);
+    for (int i = 0; i < history->nbEtapes; i++) {
+        liberer_etape(history->etapes[i]);
+    }
+    history->nbEtapes = 0;
+    history->position = 0;
+    history->taille = 0;
+    oublier_reference(history);
+}
+
+t_bmp_status history_begin(t_history *history, const t_image *img, const unsigned char *lut) {
+    if (history == NULL || img == NULL || img->type == IMAGE_NONE) {
+        return BMP_ERR_ARGUMENT;
+    }
+    oublier_en_cours(history);
+
+    if (lut != NULL) {
+        bool presente[256];
+        valeurs_presentes(img, presente);
+        if (inverser_lut(lut, presente, history->inverse)) {
+            memcpy(history->lut, lut, sizeof(history->lut));
+            history->lutValide = true;
+            history->enCours = true;
+            return BMP_OK;
+        }
+    }
+
+    // Image 24/32 bits : la référence sert d'image précédente, seule sa première construction copie l'image
+    if (img->type == IMAGE_BMP24) {
+        if (!reference_valide(history, img)) {
+            oublier_reference(history);
+            history->reference = tiled24_fromBmp24(img->bmp24, NULL);
+            if (history->reference == NULL) {
+                history_clear(history);
+                return BMP_ERR_MEMORY;
+            }
+        }
+        history->enCours = true;
+        return BMP_OK;
+    }
+
+    history->avant = copier_image(img);
+    if (history->avant == NULL) {
+        history_clear(history);
+        return BMP_ERR_MEMORY;
+    }
+    history->enCours = true;
+    return BMP_OK;
+}
+
+t_bmp_status history_end(t_history *history, const t_image *img, t_bmp_status status, const char *label) {
+    if (history == NULL || !history->enCours) {
+        return status;
+    }
+    if (status != BMP_OK || img == NULL) {
+        // L'opération a pu modifier une partie de l'image avant d'échouer
+        oublier_en_cours(history);
+        oublier_reference(history);
+        return status;
+    }
+
+    t_etape *etape = calloc(1, sizeof(t_etape));
+    if (etape == NULL) {
+        history_clear(history);
+        return status;
+    }
+    snprintf(etape->label, sizeof(etape->label), "%s", label != NULL ? label : "");
+    etape->taille = sizeof(t_etape);
+
+    t_image vue;
+    const t_image *avant = history->avant;
+    if (avant == NULL && history->reference != NULL) {
+        vue = vue_tuiles(history->reference);
+        avant = &vue;
+    }
+
+    if (history->lutValide) {
+        etape->type = ETAPE_LUT;
+        memcpy(etape->lut, history->lut, sizeof(etape->lut));
+        memcpy(etape->inverse, history->inverse, sizeof(etape->inverse));
+        appliquer_lut_reference(history, img, etape->lut);
+    } else if (avant == NULL) {
+        // Référence oubliée pendant l'opération : plus d'image précédente
+        liberer_etape(etape);
+        history_clear(history);
+        return status;
+    } else if (!memes_dimensions(avant, img)) {
+        // L'image précédente passe à l'étape. En 24/32 bits, c'est l'ancienne référence ; la nouvelle (seule
+        // copie complète, les dimensions ayant changé) est partagée avec l'étape par un instantané, et ses
+        // tuiles ne sont dupliquées que lorsqu'une opération suivante les modifie
+        etape->type = ETAPE_IMAGE;
+        if (history->avant != NULL) {
+            etape->image = history->avant;
+            history->avant = NULL;
+            etape->taille += taille_image(etape->image);
+        } else {
+            etape->versions[0] = history->reference;
+            history->reference = tiled24_fromBmp24(img->bmp24, NULL);
+            etape->versions[1] = tiled24_snapshot(history->reference, NULL);
+            if (etape->versions[1] == NULL) {
+                liberer_etape(etape);
+                history_clear(history);
+                return status;
+            }
+            // Borne haute : la version après ne coûte que les tuiles que la référence ne partage plus
+            t_image vues[2] = { vue_tuiles(etape->versions[0]), vue_tuiles(etape->versions[1]) };
+            etape->taille += taille_image(&vues[0]) + taille_image(&vues[1]);
+        }
+    } else {
+        etape->type = ETAPE_DIFFERENCE;
+        if (!calculer_difference(etape, avant, img)) {
+            liberer_etape(etape);
+            history_clear(history);
+            return status;
+        }
+        if (history->avant == NULL) {
+            mettre_a_jour_reference(history, etape, img);
+        }
+    }
+    oublier_en_cours(history);
+    empiler(history, etape);
+    return status;
+}
+
+// Échange le contenu de deux images (même pointeur t_image pour l'appelant)
+static void echanger_images(t_image *a, t_image *b) {
+    t_image tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+// Remplace l'image 24/32 bits img par une copie de version, qui devient aussi la référence (instantané : aucun
+// pixel copié). Renvoie BMP_ERR_MEMORY sans rien changer si la copie échoue.
+static t_bmp_status restaurer_version(t_history *history, t_image *img, t_tiled24 *version) {
+    t_bmp24 *copie = tiled24_toBmp24(version, NULL);
+    if (copie == NULL) {
+        return BMP_ERR_MEMORY;
+    }
+    bmp24_free(img->bmp24);
+    img->bmp24 = copie;
+    oublier_reference(history);
+    history->reference = tiled24_snapshot(version, NULL);    // NULL : reconstruite à la prochaine opération
+    return BMP_OK;
+}
+
+t_bmp_status history_undo(t_history *history, t_image *img) {
+    if (history == NULL || img == NULL || history->position == 0) {
+        return BMP_ERR_ARGUMENT;
+    }
+
+    t_etape *etape = history->etapes[history->position - 1];
+    t_bmp_status res = BMP_OK;
+    switch (etape->type) {
+        case ETAPE_LUT:
+            appliquer_lut(img, etape->inverse);
+            if (history->reference != NULL) {
+                appliquer_lut_reference(history, img, etape->inverse);
+            }
+            break;
+        case ETAPE_DIFFERENCE:
+            res = appliquer_difference(etape, img);
+            if (res == BMP_OK && history->reference != NULL) {
+                mettre_a_jour_reference(history, etape, img);
+            }
+            break;
+        case ETAPE_IMAGE:
+            if (etape->image != NULL) {
+                echanger_images(img, etape->image);
+            } else {
+                res = restaurer_version(history, img, etape->versions[0]);
+            }
+            break;
+    }
+    if (res == BMP_OK) {
+        history->position--;
+    }
+    return res;
+}
+
+t_bmp_status history_redo(t_history *history, t_image *img) {
+    if (history == NULL || img == NULL || history->position == history->nbEtapes) {
+        return BMP_ERR_ARGUMENT;
+    }
+
+    t_etape *etape = history->etapes[history->position];
+    t_bmp_status res = BMP_OK;
+    switch (etape->type) {
+        case ETAPE_LUT:
+            appliquer_lut(img, etape->lut);
+            if (history->reference != NULL) {
+                appliquer_lut_reference(history, img, etape->lut);
+            }
+            break;
+        case ETAPE_DIFFERENCE:
+            res = appliquer_difference(etape, img);
+            if (res == BMP_OK && history->reference != NULL) {
+                mettre_a_jour_reference(history, etape, img);
+            }
+            break;
+        case ETAPE_IMAGE:
+            if (etape->image != NULL) {
+                echanger_images(img, etape->image);
+            } else {
+                res = restaurer_version(history, img, etape->versions[1]);
+            }
+            break;
+    }
+    if (res == BMP_OK) {
+        history->position++;
+    }
+    return res;
+}
+
+const char *history_undoLabel(const t_history *history) {
+    return history != NULL && history->position > 0 ? history->etapes[history->position - 1]->label : NULL;
+}
+
+const char *history_redoLabel(const t_history *history) {
+    return history != NULL && history->position < history->nbEtapes ? history->etapes[history->position]->label
+                                                                      : NULL;
+}
+
+size_t history_memory(const t_history *history) {
+    return history != NULL ? history->taille : 0;
+}
@@ -0,0 +1,58 @@
+/*
+* Fichier : history.h
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Historique annuler / rétablir des opérations appliquées à une image 8 ou 24/32 bits. Chaque étape
+ *           garde le moins possible : la table de correspondance d'une opération ponctuelle réversible, sinon
+ *           la différence (ou exclusif) avant / après, compressée par bandes de lignes, et l'image précédente
+ *           seulement quand les dimensions changent. Les étapes les plus anciennes sont oubliées au-delà d'un
+ *           budget mémoire. Pour une image 24/32 bits, l'historique garde en plus une version de référence en
+ *           tuiles (tiled24), dont seules les bandes modifiées sont recopiées après chaque opération : elle tient
+ *           lieu d'image précédente, sans copie de l'image entière avant chaque opération.
+ */
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stddef.h>
+#include "bmp_io.h"
+
+// Lignes par bande de différence : une bande inchangée ne coûte rien
+#define HISTORY_BAND_ROWS 32
+
+// Budget mémoire par défaut des étapes gardées, en octets
+#define HISTORY_BUDGET_DEFAULT ((size_t)256 << 20)
+
+typedef struct s_history t_history;
+
+// Historique vide ; budget : mémoire maximale des étapes gardées (0 : illimité). Renvoie NULL en cas d'échec.
+t_history *history_create(size_t budget);
+void history_free(t_history *history);
+
+// Oublie toutes les étapes (nouvelle image)
+void history_clear(t_history *history);
+
+// Encadre une opération sur img : history_begin avant, history_end après, avec le résultat de l'opération.
+// lut (optionnelle) : table de correspondance de l'opération si elle transforme chaque octet des canaux
+// indépendamment (négatif, luminosité, seuil, égalisation) ; si elle est réversible sur les valeurs présentes
+// dans l'image, seule la table est gardée. Sinon la différence est calculée par rapport à une copie de l'image
+// 8 bits, ou à la version de référence d'une image 24/32 bits (construite à la première opération, puis après
+// chaque changement de dimensions). Entre deux opérations, img ne doit être modifiée que par history_undo et
+// history_redo ; sinon, appeler history_clear.
+// En cas d'échec de history_begin (mémoire), l'historique est vidé : l'opération ne pourra pas être annulée.
+t_bmp_status history_begin(t_history *history, const t_image *img, const unsigned char *lut);
+
+// Enregistre l'étape si status vaut BMP_OK (label : nom affiché, tronqué) ; renvoie status
+t_bmp_status history_end(t_history *history, const t_image *img, t_bmp_status status, const char *label);
+
+// Annule la dernière étape, ou rétablit la dernière étape annulée. Renvoie BMP_ERR_ARGUMENT s'il n'y en a pas.
+t_bmp_status history_undo(t_history *history, t_image *img);
+t_bmp_status history_redo(t_history *history, t_image *img);
+
+// Nom de l'étape que history_undo / history_redo traiterait, NULL s'il n'y en a pas
+const char *history_undoLabel(const t_history *history);
+const char *history_redoLabel(const t_history *history);
+
+// Mémoire occupée par les étapes gardées, en octets
+size_t history_memory(const t_history *history);
+
+#endif // HISTORY_H
@@ -0,0 +1,1206 @@
+/*
+* Fichier : kernels.c
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Implémente les noyaux de calcul en version scalaire (référence) et vectorisée
+ *           (SSE4, AVX2, AVX-512) ainsi que la sélection de la meilleure version au démarrage.
+ *           Les versions vectorielles produisent exactement les mêmes octets que la version scalaire :
+ *           les sommes flottantes sont faites dans le même ordre et sans FMA (-ffp-contract=off).
+ */
+
+#include "kernels.h"
+#include <string.h>
+#include <pthread.h>
+#include <math.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+// --- Versions scalaires (référence) ---
+
+static void invert_scalar(uint8_t *p, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        p[i] = 255 - p[i];
+    }
+}
+
+static int borner_valeur(int value) {
+    if (value > 255) return 255;
+    if (value < -255) return -255;
+    return value;
+}
+
+static void addSat_scalar(uint8_t *p, size_t n, int value) {
+    value = borner_valeur(value);
+    for (size_t i = 0; i < n; i++) {
+        int v = p[i] + value;
+        p[i] = (v > 255) ? 255 : (v < 0 ? 0 : v);
+    }
+}
+
+static void threshold_scalar(uint8_t *p, size_t n, int threshold) {
+    for (size_t i = 0; i < n; i++) {
+        p[i] = (p[i] >= threshold) ? 255 : 0;
+    }
+}
+
+static void applyLut_scalar(uint8_t *p, size_t n, const uint8_t lut[256]) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        uint8_t a = lut[p[i]], b = lut[p[i + 1]], c = lut[p[i + 2]], d = lut[p[i + 3]];
+        p[i] = a;
+        p[i + 1] = b;
+        p[i + 2] = c;
+        p[i + 3] = d;
+    }
+    for (; i < n; i++) {
+        p[i] = lut[p[i]];
+    }
+}
+
+static void histogram_scalar(const uint8_t *p, size_t n, unsigned int hist[256]) {
+    for (size_t i = 0; i < n; i++) {
+        hist[p[i]]++;
+    }
+}
+
+// Quatre sous-histogrammes : évite que deux octets consécutifs égaux sérialisent les incréments
+static void histogram_banks(const uint8_t *p, size_t n, unsigned int hist[256]) {
+    unsigned int banks[4][256];
+    memset(banks, 0, sizeof(banks));
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        banks[0][p[i]]++;
+        banks[1][p[i + 1]]++;
+        banks[2][p[i + 2]]++;
+        banks[3][p[i + 3]]++;
+    }
+    for (; i < n; i++) {
+        banks[0][p[i]]++;
+    }
+
+    for (int v = 0; v < 256; v++) {
+        hist[v] += banks[0][v] + banks[1][v] + banks[2][v] + banks[3][v];
+    }
+}
+
+static void swapRB_scalar(uint8_t *dst, const uint8_t *src, size_t npixels) {
+    for (size_t i = 0; i < npixels; i++) {
+        dst[3 * i]     = src[3 * i + 2];
+        dst[3 * i + 1] = src[3 * i + 1];
+        dst[3 * i + 2] = src[3 * i];
+    }
+}
+
+static void invert4_scalar(uint8_t *p, size_t npixels) {
+    for (size_t i = 0; i < npixels; i++) {
+        p[4 * i]     = 255 - p[4 * i];
+        p[4 * i + 1] = 255 - p[4 * i + 1];
+        p[4 * i + 2] = 255 - p[4 * i + 2];
+    }
+}
+
+static void addSat4_scalar(uint8_t *p, size_t npixels, int value) {
+    value = borner_valeur(value);
+    for (size_t i = 0; i < npixels; i++) {
+        for (int c = 0; c < 3; c++) {
+            int v = p[4 * i + c] + value;
+            p[4 * i + c] = (v > 255) ? 255 : (v < 0 ? 0 : v);
+        }
+    }
+}
+
+static void swapRB4_scalar(uint8_t *dst, const uint8_t *src, size_t npixels) {
+    for (size_t i = 0; i < npixels; i++) {
+        dst[4 * i]     = src[4 * i + 2];
+        dst[4 * i + 1] = src[4 * i + 1];
+        dst[4 * i + 2] = src[4 * i];
+        dst[4 * i + 3] = src[4 * i + 3];
+    }
+}
+
+static void swapRB3to4_scalar(uint8_t *dst, const uint8_t *src, size_t npixels) {
+    for (size_t i = 0; i < npixels; i++) {
+        dst[4 * i]     = src[3 * i + 2];
+        dst[4 * i + 1] = src[3 * i + 1];
+        dst[4 * i + 2] = src[3 * i];
+        dst[4 * i + 3] = 255;
+    }
+}
+
+static void swapRB4to3_scalar(uint8_t *dst, const uint8_t *src, size_t npixels) {
+    for (size_t i = 0; i < npixels; i++) {
+        dst[3 * i]     = src[4 * i + 2];
+        dst[3 * i + 1] = src[4 * i + 1];
+        dst[3 * i + 2] = src[4 * i];
+    }
+}
+
+// Saturation dans [0, 255] puis arrondi (identique à bmp8_applyFilter / bmp24_convolution)
+static uint8_t saturer(float sum, t_kernel_rounding rounding) {
+    if (sum > 255) return 255;
+    if (sum < 0) return 0;
+    return (uint8_t)(rounding == KERNEL_ROUND_NEAREST ? roundf(sum) : sum);
+}
+
+static void convolveRow_scalar(uint8_t *dst, const uint8_t *const *rows, size_t begin, size_t end,
+                               int step, const float *kernel, int kernelSize, t_kernel_rounding rounding) {
+    int n = kernelSize / 2;
+    for (size_t x = begin; x < end; x++) {
+        float sum = 0.0f;
+        for (int ky = 0; ky < kernelSize; ky++) {
+            const uint8_t *p = rows[ky] + x - (size_t)n * step;
+            for (int kx = 0; kx < kernelSize; kx++) {
+                sum += kernel[ky * kernelSize + kx] * p[kx * step];
+            }
+        }
+        dst[x] = saturer(sum, rounding);
+    }
+}
+
+
+// Saturation d'une somme pondérée en virgule fixe, arrondie au plus proche
+static uint8_t saturer_q(int32_t sum) {
+    if (sum < 0) {
+        return 0;
+    }
+    sum = (sum + (1 << (KERNEL_RESAMPLE_BITS - 1))) >> KERNEL_RESAMPLE_BITS;
+    return (uint8_t)(sum > 255 ? 255 : sum);
+}
+
+static void resampleRow_scalar(uint8_t *dst, const uint8_t *src, int dstWidth, int channels,
+                               const int32_t *starts, const int16_t *weights, int taps) {
+    for (int x = 0; x < dstWidth; x++) {
+        const uint8_t *p = src + (size_t)starts[x] * channels;
+        const int16_t *w = weights + (size_t)x * taps;
+        for (int c = 0; c < channels; c++) {
+            int32_t sum = 0;
+            for (int k = 0; k < taps; k++) {
+                sum += w[k] * p[k * channels + c];
+            }
+            dst[(size_t)x * channels + c] = saturer_q(sum);
+        }
+    }
+}
+
+static void resampleColumn_scalar(uint8_t *dst, const uint8_t *const *rows, size_t begin, size_t end,
+                                  const int16_t *weights, int taps) {
+    for (size_t i = begin; i < end; i++) {
+        int32_t sum = 0;
+        for (int k = 0; k < taps; k++) {
+            sum += weights[k] * rows[k][i];
+        }
+        dst[i] = saturer_q(sum);
+    }
+}
+
+static void blur5Column_scalar(uint16_t *dst, const uint8_t *const *rows, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        dst[i] = (uint16_t)(rows[0][i] + rows[4][i] + 4 * (rows[1][i] + rows[3][i]) + 6 * rows[2][i]);
+    }
+}
+
+static void transpose_scalar(uint8_t *const *dst, size_t dstCol, const uint8_t *const *src, size_t srcCol,
+                             size_t rows, size_t cols, int bpp) {
+    // Tailles constantes par cas : chaque copie devient un simple déplacement
+    for (size_t r = 0; r < rows; r++) {
+        const uint8_t *s = src[r] + srcCol * bpp;
+        size_t o = (dstCol + r) * bpp;
+        if (bpp == 1) {
+            for (size_t c = 0; c < cols; c++) dst[c][o] = s[c];
+        } else if (bpp == 3) {
+            for (size_t c = 0; c < cols; c++) memcpy(dst[c] + o, s + c * 3, 3);
+        } else {
+            for (size_t c = 0; c < cols; c++) memcpy(dst[c] + o, s + c * 4, 4);
+        }
+    }
+}
+
+static void reverse_scalar(uint8_t *dst, const uint8_t *src, size_t npixels, int bpp) {
+    const uint8_t *s = src + npixels * bpp;
+    if (bpp == 1) {
+        for (size_t i = 0; i < npixels; i++) dst[i] = *--s;
+    } else if (bpp == 3) {
+        for (size_t i = 0; i < npixels; i++) memcpy(dst + i * 3, s -= 3, 3);
+    } else {
+        for (size_t i = 0; i < npixels; i++) memcpy(dst + i * 4, s -= 4, 4);
+    }
+}
+
+static void warpBilinear_scalar(uint8_t *dst, const uint8_t *const *rows, const int32_t *coords, size_t n,
+                                int bpp) {
+    const int un = 1 << KERNEL_WARP_BITS;
+    for (size_t i = 0; i < n; i++, dst += bpp) {
+        int32_t cx = coords[2 * i], cy = coords[2 * i + 1];
+        int fx = cx & (un - 1), fy = cy & (un - 1);
+        const uint8_t *h = rows[cy >> KERNEL_WARP_BITS] + (size_t)(cx >> KERNEL_WARP_BITS) * bpp;
+        const uint8_t *b = rows[(cy >> KERNEL_WARP_BITS) + 1] + (size_t)(cx >> KERNEL_WARP_BITS) * bpp;
+        for (int c = 0; c < bpp; c++) {
+            int haut = (un - fx) * h[c] + fx * h[c + bpp];
+            int bas = (un - fx) * b[c] + fx * b[c + bpp];
+            dst[c] = (uint8_t)(((un - fy) * haut + fy * bas + un * un / 2) >> (2 * KERNEL_WARP_BITS));
+        }
+    }
+}
+
+// Parties d'un bloc rows x cols hors des sous-blocs pleins de b x b pixels (bande de droite, puis bas)
+static void transpose_bords(uint8_t *const *dst, size_t dstCol, const uint8_t *const *src, size_t srcCol,
+                            size_t rows, size_t cols, int bpp, size_t b) {
+    size_t rPleins = rows - rows % b, cPleins = cols - cols % b;
+    if (cPleins < cols) {
+        transpose_scalar(dst + cPleins, dstCol, src, srcCol + cPleins, rows, cols - cPleins, bpp);
+    }
+    if (rPleins < rows) {
+        transpose_scalar(dst, dstCol + rPleins, src + rPleins, srcCol, rows - rPleins, cPleins, bpp);
+    }
+}
+
+#ifdef KERNELS_X86
+
+// --- Versions SSE4 (SSSE3 + SSE4.1) ---
+
+__attribute__((target("sse4.1")))
+static void invert_sse4(uint8_t *p, size_t n) {
+    const __m128i ones = _mm_set1_epi8((char)0xFF);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        _mm_storeu_si128((__m128i *)(p + i), _mm_xor_si128(v, ones));
+    }
+    invert_scalar(p + i, n - i);
+}
+
+__attribute__((target("sse4.1")))
+static void addSat_sse4(uint8_t *p, size_t n, int value) {
+    value = borner_valeur(value);
+    const __m128i delta = _mm_set1_epi8((char)(value >= 0 ? value : -value));
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        v = (value >= 0) ? _mm_adds_epu8(v, delta) : _mm_subs_epu8(v, delta);
+        _mm_storeu_si128((__m128i *)(p + i), v);
+    }
+    addSat_scalar(p + i, n - i, value);
+}
+
+__attribute__((target("sse4.1")))
+static void threshold_sse4(uint8_t *p, size_t n, int threshold) {
+    if (threshold <= 0 || threshold > 255) {
+        threshold_scalar(p, n, threshold);
+        return;
+    }
+    // p >= t  <=>  max(p, t) == p
+    const __m128i t = _mm_set1_epi8((char)threshold);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        _mm_storeu_si128((__m128i *)(p + i), _mm_cmpeq_epi8(_mm_max_epu8(v, t), v));
+    }
+    threshold_scalar(p + i, n - i, threshold);
+}
+
+// 16 octets = 5 pixels complets + 1 octet recopié tel quel (réécrit à l'itération suivante)
+__attribute__((target("sse4.1")))
+static void swapRB_sse4(uint8_t *dst, const uint8_t *src, size_t npixels) {
+    const __m128i masque = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15);
+    size_t nbytes = npixels * 3;
+    size_t o = 0;
+    for (; o + 16 <= nbytes; o += 15) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + o));
+        _mm_storeu_si128((__m128i *)(dst + o), _mm_shuffle_epi8(v, masque));
+    }
+    swapRB_scalar(dst + o, src + o, (nbytes - o) / 3);
+}
+
+// Motif d'addition pour pixels RGBA : value sur R, G, B et 0 sur A
+static uint32_t motif_rgb(int value) {
+    uint32_t v = (uint8_t)value;
+    return v | (v << 8) | (v << 16);
+}
+
+__attribute__((target("sse4.1")))
+static void invert4_sse4(uint8_t *p, size_t npixels) {
+    const __m128i masque = _mm_set1_epi32(0x00FFFFFF);
+    size_t i = 0;
+    for (; i + 4 <= npixels; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + 4 * i));
+        _mm_storeu_si128((__m128i *)(p + 4 * i), _mm_xor_si128(v, masque));
+    }
+    invert4_scalar(p + 4 * i, npixels - i);
+}
+
+__attribute__((target("sse4.1")))
+static void addSat4_sse4(uint8_t *p, size_t npixels, int value) {
+    value = borner_valeur(value);
+    const __m128i delta = _mm_set1_epi32((int)motif_rgb(value >= 0 ? value : -value));
+    size_t i = 0;
+    for (; i + 4 <= npixels; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + 4 * i));
+        v = (value >= 0) ? _mm_adds_epu8(v, delta) : _mm_subs_epu8(v, delta);
+        _mm_storeu_si128((__m128i *)(p + 4 * i), v);
+    }
+    addSat4_scalar(p + 4 * i, npixels - i, value);
+}
+
+__attribute__((target("sse4.1")))
+static void swapRB4_sse4(uint8_t *dst, const uint8_t *src, size_t npixels) {
+    const __m128i masque = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    size_t i = 0;
+    for (; i + 4 <= npixels; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + 4 * i));
+        _mm_storeu_si128((__m128i *)(dst + 4 * i), _mm_shuffle_epi8(v, masque));
+    }
+    swapRB4_scalar(dst + 4 * i, src + 4 * i, npixels - i);
+}
+
+// 12 octets source -> 4 pixels de 4 octets (on lit 16 octets, les 4 derniers sont ignorés)
+__attribute__((target("sse4.1")))
+static void swapRB3to4_sse4(uint8_t *dst, const uint8_t *src, size_t npixels) {
+    const __m128i masque = _mm_setr_epi8(2, 1, 0, -128, 5, 4, 3, -128, 8, 7, 6, -128, 11, 10, 9, -128);
+    const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+    size_t i = 0;
+    for (; 3 * i + 16 <= 3 * npixels; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + 3 * i));
+        _mm_storeu_si128((__m128i *)(dst + 4 * i), _mm_or_si128(_mm_shuffle_epi8(v, masque), alpha));
+    }
+    swapRB3to4_scalar(dst + 4 * i, src + 3 * i, npixels - i);
+}
+
+// 4 pixels de 4 octets -> 12 octets (on écrit 16 octets, les 4 derniers sont réécrits ensuite)
+__attribute__((target("sse4.1")))
+static void swapRB4to3_sse4(uint8_t *dst, const uint8_t *src, size_t npixels) {
+    const __m128i masque = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -128, -128, -128, -128);
+    size_t i = 0;
+    for (; 3 * i + 16 <= 3 * npixels; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + 4 * i));
+        _mm_storeu_si128((__m128i *)(dst + 3 * i), _mm_shuffle_epi8(v, masque));
+    }
+    swapRB4to3_scalar(dst + 3 * i, src + 4 * i, npixels - i);
+}
+
+__attribute__((target("sse4.1")))
+static void convolveRow_sse4(uint8_t *dst, const uint8_t *const *rows, size_t begin, size_t end,
+                             int step, const float *kernel, int kernelSize, t_kernel_rounding rounding) {
+    int n = kernelSize / 2;
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 max = _mm_set1_ps(255.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    size_t x = begin;
+    for (; x + 4 <= end; x += 4) {
+        __m128 sum = _mm_setzero_ps();
+        for (int ky = 0; ky < kernelSize; ky++) {
+            const uint8_t *p = rows[ky] + x - (size_t)n * step;
+            for (int kx = 0; kx < kernelSize; kx++) {
+                int32_t octets;
+                memcpy(&octets, p + kx * step, 4);
+                __m128 pix = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(octets)));
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(kernel[ky * kernelSize + kx]), pix));
+            }
+        }
+        sum = _mm_min_ps(_mm_max_ps(sum, zero), max);
+        __m128 t = _mm_round_ps(sum, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+        if (rounding == KERNEL_ROUND_NEAREST) {
+            t = _mm_add_ps(t, _mm_and_ps(_mm_cmpge_ps(_mm_sub_ps(sum, t), half), one));
+        }
+        __m128i v = _mm_cvttps_epi32(t);
+        v = _mm_packus_epi16(_mm_packus_epi32(v, v), v);
+        int32_t res = _mm_cvtsi128_si32(v);
+        memcpy(dst + x, &res, 4);
+    }
+    convolveRow_scalar(dst, rows, x, end, step, kernel, kernelSize, rounding);
+}
+
+// Deux poids consécutifs dans chaque mot de 32 bits, pour _mm_madd_epi16
+static int32_t paire_poids(int16_t a, int16_t b) {
+    return (int32_t)((uint32_t)(uint16_t)a | ((uint32_t)(uint16_t)b << 16));
+}
+
+// Les sommes sont entières : mêmes octets que la version scalaire (saturation par les packs)
+__attribute__((target("sse4.1")))
+static void resampleRow_sse4(uint8_t *dst, const uint8_t *src, int dstWidth, int channels,
+                             const int32_t *starts, const int16_t *weights, int taps) {
+    const __m128i arrondi = _mm_set1_epi32(1 << (KERNEL_RESAMPLE_BITS - 1));
+    const __m128i zero = _mm_setzero_si128();
+
+    for (int x = 0; x < dstWidth; x++) {
+        const uint8_t *p = src + (size_t)starts[x] * channels;
+        const int16_t *w = weights + (size_t)x * taps;
+        __m128i acc = _mm_setzero_si128();
+        int k = 0;
+
+        if (channels == 1) {
+            // Huit échantillons consécutifs par itération
+            for (; k + 8 <= taps; k += 8) {
+                __m128i pix = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(p + k)));
+                acc = _mm_add_epi32(acc, _mm_madd_epi16(pix, _mm_loadu_si128((const __m128i *)(w + k))));
+            }
+            acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+            acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+            int32_t sum = _mm_cvtsi128_si32(acc);
+            for (; k < taps; k++) {
+                sum += w[k] * p[k];
+            }
+            dst[x] = saturer_q(sum);
+            continue;
+        }
+
+        // Un pixel (3 ou 4 canaux, lus sur 4 octets) par moitié de registre, deux pixels par madd
+        for (; k + 2 <= taps; k += 2) {
+            int32_t a, b;
+            memcpy(&a, p + k * channels, 4);
+            memcpy(&b, p + (k + 1) * channels, 4);
+            __m128i ab = _mm_unpacklo_epi16(_mm_cvtepu8_epi16(_mm_cvtsi32_si128(a)),
+                                            _mm_cvtepu8_epi16(_mm_cvtsi32_si128(b)));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(ab, _mm_set1_epi32(paire_poids(w[k], w[k + 1]))));
+        }
+        if (k < taps) {
+            int32_t a;
+            memcpy(&a, p + k * channels, 4);
+            __m128i az = _mm_unpacklo_epi16(_mm_cvtepu8_epi16(_mm_cvtsi32_si128(a)), zero);
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(az, _mm_set1_epi32(paire_poids(w[k], 0))));
+        }
+        acc = _mm_srai_epi32(_mm_add_epi32(acc, arrondi), KERNEL_RESAMPLE_BITS);
+        __m128i v = _mm_packs_epi32(acc, acc);
+        int32_t res = _mm_cvtsi128_si32(_mm_packus_epi16(v, v));
+        memcpy(dst + (size_t)x * channels, &res, (size_t)channels);
+    }
+}
+
+__attribute__((target("sse4.1")))
+static void resampleColumn_sse4(uint8_t *dst, const uint8_t *const *rows, size_t begin, size_t end,
+                                const int16_t *weights, int taps) {
+    const __m128i arrondi = _mm_set1_epi32(1 << (KERNEL_RESAMPLE_BITS - 1));
+    const __m128i zero = _mm_setzero_si128();
+
+    size_t i = begin;
+    for (; i + 16 <= end; i += 16) {
+        __m128i s0 = zero, s1 = zero, s2 = zero, s3 = zero;
+        for (int k = 0; k < taps; k += 2) {
+            // Octets de deux lignes entrelacés en mots de 16 bits : a0 b0 a1 b1 ...
+            __m128i a = _mm_loadu_si128((const __m128i *)(rows[k] + i));
+            __m128i b = k + 1 < taps ? _mm_loadu_si128((const __m128i *)(rows[k + 1] + i)) : zero;
+            __m128i wp = _mm_set1_epi32(paire_poids(weights[k], k + 1 < taps ? weights[k + 1] : 0));
+            __m128i alo = _mm_unpacklo_epi8(a, zero), ahi = _mm_unpackhi_epi8(a, zero);
+            __m128i blo = _mm_unpacklo_epi8(b, zero), bhi = _mm_unpackhi_epi8(b, zero);
+            s0 = _mm_add_epi32(s0, _mm_madd_epi16(_mm_unpacklo_epi16(alo, blo), wp));
+            s1 = _mm_add_epi32(s1, _mm_madd_epi16(_mm_unpackhi_epi16(alo, blo), wp));
+            s2 = _mm_add_epi32(s2, _mm_madd_epi16(_mm_unpacklo_epi16(ahi, bhi), wp));
+            s3 = _mm_add_epi32(s3, _mm_madd_epi16(_mm_unpackhi_epi16(ahi, bhi), wp));
+        }
+        s0 = _mm_srai_epi32(_mm_add_epi32(s0, arrondi), KERNEL_RESAMPLE_BITS);
+        s1 = _mm_srai_epi32(_mm_add_epi32(s1, arrondi), KERNEL_RESAMPLE_BITS);
+        s2 = _mm_srai_epi32(_mm_add_epi32(s2, arrondi), KERNEL_RESAMPLE_BITS);
+        s3 = _mm_srai_epi32(_mm_add_epi32(s3, arrondi), KERNEL_RESAMPLE_BITS);
+        __m128i v = _mm_packus_epi16(_mm_packs_epi32(s0, s1), _mm_packs_epi32(s2, s3));
+        _mm_storeu_si128((__m128i *)(dst + i), v);
+    }
+    resampleColumn_scalar(dst, rows, i, end, weights, taps);
+}
+
+// Pixels de 3 octets <-> mots de 32 bits (quatre pixels par registre)
+static const int8_t masque_3vers4[16] = { 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1 };
+static const int8_t masque_4vers3[16] = { 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1 };
+
+__attribute__((target("sse4.1")))
+static __m128i charger_3(const uint8_t *p) {
+    int32_t fin;
+    memcpy(&fin, p + 8, 4);
+    __m128i v = _mm_insert_epi32(_mm_loadl_epi64((const __m128i *)p), fin, 2);
+    return _mm_shuffle_epi8(v, _mm_loadu_si128((const __m128i *)masque_3vers4));
+}
+
+__attribute__((target("sse4.1")))
+static void ranger_3(uint8_t *p, __m128i v) {
+    v = _mm_shuffle_epi8(v, _mm_loadu_si128((const __m128i *)masque_4vers3));
+    int32_t fin = _mm_extract_epi32(v, 2);
+    _mm_storel_epi64((__m128i *)p, v);
+    memcpy(p + 8, &fin, 4);
+}
+
+// Transposition par blocs de 16 x 16 octets ou 4 x 4 pixels de 32 bits (dépliés depuis 3 octets si besoin).
+// Octets : quatre étages d'entrelacement du registre i avec le registre i + 8 (épi8 à épi64) ; les lignes
+// sont chargées dans l'ordre bit-inversé pour que la colonne c sorte dans l'ordre dans le registre c.
+__attribute__((target("sse4.1")))
+static void transpose_sse4(uint8_t *const *dst, size_t dstCol, const uint8_t *const *src, size_t srcCol,
+                           size_t rows, size_t cols, int bpp) {
+    static const int inverse[16] = { 0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15 };
+    if (bpp == 1) {
+        for (size_t r0 = 0; r0 + 16 <= rows; r0 += 16) {
+            for (size_t c0 = 0; c0 + 16 <= cols; c0 += 16) {
+                __m128i a[16], b[16];
+                for (int i = 0; i < 16; i++) {
+                    a[inverse[i]] = _mm_loadu_si128((const __m128i *)(src[r0 + i] + srcCol + c0));
+                }
+                for (int i = 0; i < 8; i++) {
+                    b[2 * i] = _mm_unpacklo_epi8(a[i], a[i + 8]);
+                    b[2 * i + 1] = _mm_unpackhi_epi8(a[i], a[i + 8]);
+                }
+                for (int i = 0; i < 8; i++) {
+                    a[2 * i] = _mm_unpacklo_epi16(b[i], b[i + 8]);
+                    a[2 * i + 1] = _mm_unpackhi_epi16(b[i], b[i + 8]);
+                }
+                for (int i = 0; i < 8; i++) {
+                    b[2 * i] = _mm_unpacklo_epi32(a[i], a[i + 8]);
+                    b[2 * i + 1] = _mm_unpackhi_epi32(a[i], a[i + 8]);
+                }
+                for (int i = 0; i < 8; i++) {
+                    a[2 * i] = _mm_unpacklo_epi64(b[i], b[i + 8]);
+                    a[2 * i + 1] = _mm_unpackhi_epi64(b[i], b[i + 8]);
+                }
+                for (int i = 0; i < 16; i++) {
+                    _mm_storeu_si128((__m128i *)(dst[c0 + i] + dstCol + r0), a[i]);
+                }
+            }
+        }
+        transpose_bords(dst, dstCol, src, srcCol, rows, cols, bpp, 16);
+        return;
+    }
+
+    for (size_t r0 = 0; r0 + 4 <= rows; r0 += 4) {
+        for (size_t c0 = 0; c0 + 4 <= cols; c0 += 4) {
+            __m128i l[4];
+            for (int i = 0; i < 4; i++) {
+                const uint8_t *p = src[r0 + i] + (srcCol + c0) * bpp;
+                l[i] = bpp == 3 ? charger_3(p) : _mm_loadu_si128((const __m128i *)p);
+            }
+            __m128i t0 = _mm_unpacklo_epi32(l[0], l[1]), t1 = _mm_unpackhi_epi32(l[0], l[1]);
+            __m128i t2 = _mm_unpacklo_epi32(l[2], l[3]), t3 = _mm_unpackhi_epi32(l[2], l[3]);
+            __m128i o[4] = { _mm_unpacklo_epi64(t0, t2), _mm_unpackhi_epi64(t0, t2),
+                             _mm_unpacklo_epi64(t1, t3), _mm_unpackhi_epi64(t1, t3) };
+            for (int i = 0; i < 4; i++) {
+                uint8_t *p = dst[c0 + i] + (dstCol + r0) * bpp;
+                if (bpp == 3) {
+                    ranger_3(p, o[i]);
+                } else {
+                    _mm_storeu_si128((__m128i *)p, o[i]);
+                }
+            }
+        }
+    }
+    transpose_bords(dst, dstCol, src, srcCol, rows, cols, bpp, 4);
+}
+
+__attribute__((target("sse4.1")))
+static void reverse_sse4(uint8_t *dst, const uint8_t *src, size_t npixels, int bpp) {
+    static const int8_t masque_1[16] = { 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 };
+    static const int8_t masque_3[16] = { 9, 10, 11, 6, 7, 8, 3, 4, 5, 0, 1, 2, -1, -1, -1, -1 };
+    size_t i = 0;
+    if (bpp == 1) {
+        const __m128i m = _mm_loadu_si128((const __m128i *)masque_1);
+        for (; i + 16 <= npixels; i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(src + npixels - i - 16));
+            _mm_storeu_si128((__m128i *)(dst + i), _mm_shuffle_epi8(v, m));
+        }
+    } else if (bpp == 3) {
+        const __m128i m = _mm_loadu_si128((const __m128i *)masque_3);
+        for (; i + 4 <= npixels; i += 4) {
+            const uint8_t *p = src + (npixels - i - 4) * 3;
+            int32_t fin;
+            memcpy(&fin, p + 8, 4);
+            __m128i v = _mm_shuffle_epi8(_mm_insert_epi32(_mm_loadl_epi64((const __m128i *)p), fin, 2), m);
+            fin = _mm_extract_epi32(v, 2);
+            _mm_storel_epi64((__m128i *)(dst + i * 3), v);
+            memcpy(dst + i * 3 + 8, &fin, 4);
+        }
+    } else {
+        for (; i + 4 <= npixels; i += 4) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(src + (npixels - i - 4) * 4));
+            _mm_storeu_si128((__m128i *)(dst + i * 4), _mm_shuffle_epi32(v, 0x1B));
+        }
+    }
+    reverse_scalar(dst + i * bpp, src, npixels - i, bpp);
+}
+
+// Poids (u - f, f) rangés en deux mots de 16 bits dans chaque voie de 32 bits (pour pmaddwd)
+static int32_t paire_fraction(int f) {
+    return (int32_t)(((uint32_t)f << 16) | (uint32_t)((1 << KERNEL_WARP_BITS) - f));
+}
+
+// Interpolation sans gather : les deux pixels voisins de chaque ligne sont lus ensemble (8 octets, ou 2 en
+// 8 bits) puis multipliés par pmaddwd, haut et bas étant ensuite combinés par un second pmaddwd.
+// bpp 3 et 4 : un pixel par registre, quatre pixels rangés à la fois ; bpp 1 : quatre pixels par registre.
+__attribute__((target("sse4.1")))
+static void warpBilinear_sse4(uint8_t *dst, const uint8_t *const *rows, const int32_t *coords, size_t n,
+                              int bpp) {
+    const int un = 1 << KERNEL_WARP_BITS;
+    const __m128i arrondi = _mm_set1_epi32(un * un / 2);
+    size_t i = 0;
+    if (bpp == 1) {
+        const __m128i masque = _mm_set1_epi32(un - 1);
+        const __m128i unv = _mm_set1_epi32(un);
+        for (; i + 4 <= n; i += 4) {
+            const int32_t *c = coords + 2 * i;
+            __m128 c0 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)c));
+            __m128 c1 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)(c + 4)));
+            __m128i fx = _mm_and_si128(_mm_castps_si128(_mm_shuffle_ps(c0, c1, _MM_SHUFFLE(2, 0, 2, 0))), masque);
+            __m128i fy = _mm_and_si128(_mm_castps_si128(_mm_shuffle_ps(c0, c1, _MM_SHUFFLE(3, 1, 3, 1))), masque);
+            __m128i wx = _mm_or_si128(_mm_sub_epi32(unv, fx), _mm_slli_epi32(fx, 16));
+            __m128i wy = _mm_or_si128(_mm_sub_epi32(unv, fy), _mm_slli_epi32(fy, 16));
+
+            uint16_t h[4], b[4];
+            for (int k = 0; k < 4; k++) {
+                int x = c[2 * k] >> KERNEL_WARP_BITS, y = c[2 * k + 1] >> KERNEL_WARP_BITS;
+                memcpy(&h[k], rows[y] + x, 2);
+                memcpy(&b[k], rows[y + 1] + x, 2);
+            }
+            __m128i v = _mm_setr_epi16((short)h[0], (short)h[1], (short)h[2], (short)h[3],
+                                       (short)b[0], (short)b[1], (short)b[2], (short)b[3]);
+            __m128i haut = _mm_madd_epi16(_mm_cvtepu8_epi16(v), wx);
+            __m128i bas = _mm_madd_epi16(_mm_cvtepu8_epi16(_mm_srli_si128(v, 8)), wx);
+            __m128i r = _mm_madd_epi16(_mm_or_si128(haut, _mm_slli_epi32(bas, 16)), wy);
+            r = _mm_srli_epi32(_mm_add_epi32(r, arrondi), 2 * KERNEL_WARP_BITS);
+            r = _mm_packus_epi16(_mm_packs_epi32(r, r), r);
+            int32_t quatre = _mm_cvtsi128_si32(r);
+            memcpy(dst + i, &quatre, 4);
+        }
+    } else {
+        // Les deux pixels voisins, canal par canal en mots de 16 bits (le 4e canal est nul en 24 bits)
+        const __m128i ordre = bpp == 4
+            ? _mm_setr_epi8(0, -1, 4, -1, 1, -1, 5, -1, 2, -1, 6, -1, 3, -1, 7, -1)
+            : _mm_setr_epi8(0, -1, 3, -1, 1, -1, 4, -1, 2, -1, 5, -1, -1, -1, -1, -1);
+        for (; i + 4 <= n; i += 4) {
+            __m128i r[4];
+            for (int k = 0; k < 4; k++) {
+                int32_t cx = coords[2 * (i + k)], cy = coords[2 * (i + k) + 1];
+                size_t x = (size_t)(cx >> KERNEL_WARP_BITS) * bpp;
+                int y = cy >> KERNEL_WARP_BITS;
+                __m128i wx = _mm_set1_epi32(paire_fraction(cx & (un - 1)));
+                __m128i wy = _mm_set1_epi32(paire_fraction(cy & (un - 1)));
+                __m128i h = _mm_shuffle_epi8(_mm_loadl_epi64((const __m128i *)(rows[y] + x)), ordre);
+                __m128i b = _mm_shuffle_epi8(_mm_loadl_epi64((const __m128i *)(rows[y + 1] + x)), ordre);
+                __m128i haut = _mm_madd_epi16(h, wx);
+                __m128i bas = _mm_madd_epi16(b, wx);
+                __m128i s = _mm_madd_epi16(_mm_or_si128(haut, _mm_slli_epi32(bas, 16)), wy);
+                r[k] = _mm_srli_epi32(_mm_add_epi32(s, arrondi), 2 * KERNEL_WARP_BITS);
+            }
+            __m128i v = _mm_packus_epi16(_mm_packs_epi32(r[0], r[1]), _mm_packs_epi32(r[2], r[3]));
+            if (bpp == 4) {
+                _mm_storeu_si128((__m128i *)(dst + i * 4), v);
+            } else {
+                ranger_3(dst + i * 3, v);
+            }
+        }
+    }
+    warpBilinear_scalar(dst + i * bpp, rows, coords + 2 * i, n - i, bpp);
+}
+
+// 6 * c calculé comme (c << 2) + (c << 1) : tout tient sur 16 bits, sans multiplication
+__attribute__((target("sse4.1")))
+static void blur5Column_sse4(uint16_t *dst, const uint8_t *const *rows, size_t begin, size_t end) {
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m128i a = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(rows[0] + i)));
+        __m128i b = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(rows[1] + i)));
+        __m128i c = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(rows[2] + i)));
+        __m128i d = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(rows[3] + i)));
+        __m128i e = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(rows[4] + i)));
+        __m128i v = _mm_add_epi16(_mm_add_epi16(a, e), _mm_slli_epi16(_mm_add_epi16(b, d), 2));
+        v = _mm_add_epi16(v, _mm_add_epi16(_mm_slli_epi16(c, 2), _mm_slli_epi16(c, 1)));
+        _mm_storeu_si128((__m128i *)(dst + i), v);
+    }
+    blur5Column_scalar(dst, rows, i, end);
+}
+
+// --- Versions AVX2 ---
+
+__attribute__((target("avx2")))
+static void invert_avx2(uint8_t *p, size_t n) {
+    const __m256i ones = _mm256_set1_epi8((char)0xFF);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+        _mm256_storeu_si256((__m256i *)(p + i), _mm256_xor_si256(v, ones));
+    }
+    invert_scalar(p + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void addSat_avx2(uint8_t *p, size_t n, int value) {
+    value = borner_valeur(value);
+    const __m256i delta = _mm256_set1_epi8((char)(value >= 0 ? value : -value));
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+        v = (value >= 0) ? _mm256_adds_epu8(v, delta) : _mm256_subs_epu8(v, delta);
+        _mm256_storeu_si256((__m256i *)(p + i), v);
+    }
+    addSat_scalar(p + i, n - i, value);
+}
+
+__attribute__((target("avx2")))
+static void threshold_avx2(uint8_t *p, size_t n, int threshold) {
+    if (threshold <= 0 || threshold > 255) {
+        threshold_scalar(p, n, threshold);
+        return;
+    }
+    const __m256i t = _mm256_set1_epi8((char)threshold);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+        _mm256_storeu_si256((__m256i *)(p + i), _mm256_cmpeq_epi8(_mm256_max_epu8(v, t), v));
+    }
+    threshold_scalar(p + i, n - i, threshold);
+}
+
+__attribute__((target("avx2")))
+static void invert4_avx2(uint8_t *p, size_t npixels) {
+    const __m256i masque = _mm256_set1_epi32(0x00FFFFFF);
+    size_t i = 0;
+    for (; i + 8 <= npixels; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + 4 * i));
+        _mm256_storeu_si256((__m256i *)(p + 4 * i), _mm256_xor_si256(v, masque));
+    }
+    invert4_scalar(p + 4 * i, npixels - i);
+}
+
+__attribute__((target("avx2")))
+static void addSat4_avx2(uint8_t *p, size_t npixels, int value) {
+    value = borner_valeur(value);
+    const __m256i delta = _mm256_set1_epi32((int)motif_rgb(value >= 0 ? value : -value));
+    size_t i = 0;
+    for (; i + 8 <= npixels; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + 4 * i));
+        v = (value >= 0) ? _mm256_adds_epu8(v, delta) : _mm256_subs_epu8(v, delta);
+        _mm256_storeu_si256((__m256i *)(p + 4 * i), v);
+    }
+    addSat4_scalar(p + 4 * i, npixels - i, value);
+}
+
+// Avec des pixels de 4 octets, pshufb reste dans sa voie de 128 bits : l'AVX2 s'applique directement
+__attribute__((target("avx2")))
+static void swapRB4_avx2(uint8_t *dst, const uint8_t *src, size_t npixels) {
+    const __m256i masque = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                            2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    size_t i = 0;
+    for (; i + 8 <= npixels; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(src + 4 * i));
+        _mm256_storeu_si256((__m256i *)(dst + 4 * i), _mm256_shuffle_epi8(v, masque));
+    }
+    swapRB4_scalar(dst + 4 * i, src + 4 * i, npixels - i);
+}
+
+__attribute__((target("avx2")))
+static void convolveRow_avx2(uint8_t *dst, const uint8_t *const *rows, size_t begin, size_t end,
+                             int step, const float *kernel, int kernelSize, t_kernel_rounding rounding) {
+    int n = kernelSize / 2;
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 max = _mm256_set1_ps(255.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    size_t x = begin;
+    for (; x + 8 <= end; x += 8) {
+        __m256 sum = _mm256_setzero_ps();
+        for (int ky = 0; ky < kernelSize; ky++) {
+            const uint8_t *p = rows[ky] + x - (size_t)n * step;
+            for (int kx = 0; kx < kernelSize; kx++) {
+                __m128i octets = _mm_loadl_epi64((const __m128i *)(p + kx * step));
+                __m256 pix = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(octets));
+                sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(kernel[ky * kernelSize + kx]), pix));
+            }
+        }
+        sum = _mm256_min_ps(_mm256_max_ps(sum, zero), max);
+        __m256 t = _mm256_round_ps(sum, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+        if (rounding == KERNEL_ROUND_NEAREST) {
+            __m256 frac = _mm256_sub_ps(sum, t);
+            t = _mm256_add_ps(t, _mm256_and_ps(_mm256_cmp_ps(frac, half, _CMP_GE_OQ), one));
+        }
+        __m256i v = _mm256_cvttps_epi32(t);
+        __m128i v16 = _mm_packus_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        _mm_storel_epi64((__m128i *)(dst + x), _mm_packus_epi16(v16, v16));
+    }
+    convolveRow_scalar(dst, rows, x, end, step, kernel, kernelSize, rounding);
+}
+
+// Même découpage que resampleColumn_sse4 ; unpack et pack travaillent dans chaque voie de 128 bits,
+// ce qui laisse les 32 octets dans l'ordre
+__attribute__((target("avx2")))
+static void resampleColumn_avx2(uint8_t *dst, const uint8_t *const *rows, size_t begin, size_t end,
+                                const int16_t *weights, int taps) {
+    const __m256i arrondi = _mm256_set1_epi32(1 << (KERNEL_RESAMPLE_BITS - 1));
+    const __m256i zero = _mm256_setzero_si256();
+
+    size_t i = begin;
+    for (; i + 32 <= end; i += 32) {
+        __m256i s0 = zero, s1 = zero, s2 = zero, s3 = zero;
+        for (int k = 0; k < taps; k += 2) {
+            __m256i a = _mm256_loadu_si256((const __m256i *)(rows[k] + i));
+            __m256i b = k + 1 < taps ? _mm256_loadu_si256((const __m256i *)(rows[k + 1] + i)) : zero;
+            __m256i wp = _mm256_set1_epi32(paire_poids(weights[k], k + 1 < taps ? weights[k + 1] : 0));
+            __m256i alo = _mm256_unpacklo_epi8(a, zero), ahi = _mm256_unpackhi_epi8(a, zero);
+            __m256i blo = _mm256_unpacklo_epi8(b, zero), bhi = _mm256_unpackhi_epi8(b, zero);
+            s0 = _mm256_add_epi32(s0, _mm256_madd_epi16(_mm256_unpacklo_epi16(alo, blo), wp));
+            s1 = _mm256_add_epi32(s1, _mm256_madd_epi16(_mm256_unpackhi_epi16(alo, blo), wp));
+            s2 = _mm256_add_epi32(s2, _mm256_madd_epi16(_mm256_unpacklo_epi16(ahi, bhi), wp));
+            s3 = _mm256_add_epi32(s3, _mm256_madd_epi16(_mm256_unpackhi_epi16(ahi, bhi), wp));
+        }
+        s0 = _mm256_srai_epi32(_mm256_add_epi32(s0, arrondi), KERNEL_RESAMPLE_BITS);
+        s1 = _mm256_srai_epi32(_mm256_add_epi32(s1, arrondi), KERNEL_RESAMPLE_BITS);
+        s2 = _mm256_srai_epi32(_mm256_add_epi32(s2, arrondi), KERNEL_RESAMPLE_BITS);
+        s3 = _mm256_srai_epi32(_mm256_add_epi32(s3, arrondi), KERNEL_RESAMPLE_BITS);
+        __m256i v = _mm256_packus_epi16(_mm256_packs_epi32(s0, s1), _mm256_packs_epi32(s2, s3));
+        _mm256_storeu_si256((__m256i *)(dst + i), v);
+    }
+    resampleColumn_sse4(dst, rows, i, end, weights, taps);
+}
+
+// Transposition 8 x 8 de pixels de 32 bits (dépliés depuis 3 octets si besoin) : entrelacements 32 et
+// 64 bits dans chaque voie de 128 bits, puis échange des voies ; octets isolés : version SSE4
+__attribute__((target("avx2")))
+static void transpose_avx2(uint8_t *const *dst, size_t dstCol, const uint8_t *const *src, size_t srcCol,
+                           size_t rows, size_t cols, int bpp) {
+    if (bpp == 1) {
+        transpose_sse4(dst, dstCol, src, srcCol, rows, cols, bpp);
+        return;
+    }
+    static const int8_t masque_haut[16] = { 4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1, 13, 14, 15, -1 };
+    const __m128i bas3 = _mm_loadu_si128((const __m128i *)masque_3vers4);
+    const __m128i haut3 = _mm_loadu_si128((const __m128i *)masque_haut);
+    const __m128i vers3 = _mm_loadu_si128((const __m128i *)masque_4vers3);
+
+    for (size_t r0 = 0; r0 + 8 <= rows; r0 += 8) {
+        for (size_t c0 = 0; c0 + 8 <= cols; c0 += 8) {
+            __m256i l[8];
+            for (int i = 0; i < 8; i++) {
+                const uint8_t *p = src[r0 + i] + (srcCol + c0) * bpp;
+                if (bpp == 3) {
+                    // Pixels 0 à 3 dans les octets 0 à 11, pixels 4 à 7 dans les octets 12 à 23 (lus depuis p + 8)
+                    __m128i lo = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)p), bas3);
+                    __m128i hi = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(p + 8)), haut3);
+                    l[i] = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+                } else {
+                    l[i] = _mm256_loadu_si256((const __m256i *)p);
+                }
+            }
+            __m256i t[8], u[8];
+            for (int i = 0; i < 4; i++) {
+                t[2 * i] = _mm256_unpacklo_epi32(l[2 * i], l[2 * i + 1]);
+                t[2 * i + 1] = _mm256_unpackhi_epi32(l[2 * i], l[2 * i + 1]);
+            }
+            for (int i = 0; i < 2; i++) {
+                u[4 * i] = _mm256_unpacklo_epi64(t[4 * i], t[4 * i + 2]);
+                u[4 * i + 1] = _mm256_unpackhi_epi64(t[4 * i], t[4 * i + 2]);
+                u[4 * i + 2] = _mm256_unpacklo_epi64(t[4 * i + 1], t[4 * i + 3]);
+                u[4 * i + 3] = _mm256_unpackhi_epi64(t[4 * i + 1], t[4 * i + 3]);
+            }
+            for (int i = 0; i < 4; i++) {
+                l[i] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x20);
+                l[i + 4] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x31);
+            }
+            for (int i = 0; i < 8; i++) {
+                uint8_t *p = dst[c0 + i] + (dstCol + r0) * bpp;
+                if (bpp == 3) {
+                    __m128i lo = _mm_shuffle_epi8(_mm256_castsi256_si128(l[i]), vers3);
+                    __m128i hi = _mm_shuffle_epi8(_mm256_extracti128_si256(l[i], 1), vers3);
+                    _mm_storeu_si128((__m128i *)p, _mm_or_si128(lo, _mm_slli_si128(hi, 12)));
+                    _mm_storel_epi64((__m128i *)(p + 16), _mm_srli_si128(hi, 4));
+                } else {
+                    _mm256_storeu_si256((__m256i *)p, l[i]);
+                }
+            }
+        }
+    }
+    transpose_bords(dst, dstCol, src, srcCol, rows, cols, bpp, 8);
+}
+
+__attribute__((target("avx2")))
+static void reverse_avx2(uint8_t *dst, const uint8_t *src, size_t npixels, int bpp) {
+    size_t i = 0;
+    if (bpp == 1) {
+        // Retournement dans chaque voie, puis échange des deux voies
+        const __m256i m = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                                           15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+        for (; i + 32 <= npixels; i += 32) {
+            __m256i v = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(src + npixels - i - 32)), m);
+            _mm256_storeu_si256((__m256i *)(dst + i), _mm256_permute4x64_epi64(v, 0x4E));
+        }
+    } else if (bpp == 4) {
+        const __m256i m = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+        for (; i + 8 <= npixels; i += 8) {
+            __m256i v = _mm256_loadu_si256((const __m256i *)(src + (npixels - i - 8) * 4));
+            _mm256_storeu_si256((__m256i *)(dst + i * 4), _mm256_permutevar8x32_epi32(v, m));
+        }
+    }
+    reverse_sse4(dst + i * bpp, src, npixels - i, bpp);
+}
+
+__attribute__((target("avx2")))
+static void blur5Column_avx2(uint16_t *dst, const uint8_t *const *rows, size_t begin, size_t end) {
+    size_t i = begin;
+    for (; i + 16 <= end; i += 16) {
+        __m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(rows[0] + i)));
+        __m256i b = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(rows[1] + i)));
+        __m256i c = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(rows[2] + i)));
+        __m256i d = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(rows[3] + i)));
+        __m256i e = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(rows[4] + i)));
+        __m256i v = _mm256_add_epi16(_mm256_add_epi16(a, e), _mm256_slli_epi16(_mm256_add_epi16(b, d), 2));
+        v = _mm256_add_epi16(v, _mm256_add_epi16(_mm256_slli_epi16(c, 2), _mm256_slli_epi16(c, 1)));
+        _mm256_storeu_si256((__m256i *)(dst + i), v);
+    }
+    blur5Column_sse4(dst, rows, i, end);
+}
+
+// --- Versions AVX-512 (F + BW) ---
+
+__attribute__((target("avx512f,avx512bw")))
+static void invert_avx512(uint8_t *p, size_t n) {
+    const __m512i ones = _mm512_set1_epi8((char)0xFF);
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m512i v = _mm512_loadu_si512((const void *)(p + i));
+        _mm512_storeu_si512((void *)(p + i), _mm512_xor_si512(v, ones));
+    }
+    invert_scalar(p + i, n - i);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void addSat_avx512(uint8_t *p, size_t n, int value) {
+    value = borner_valeur(value);
+    const __m512i delta = _mm512_set1_epi8((char)(value >= 0 ? value : -value));
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m512i v = _mm512_loadu_si512((const void *)(p + i));
+        v = (value >= 0) ? _mm512_adds_epu8(v, delta) : _mm512_subs_epu8(v, delta);
+        _mm512_storeu_si512((void *)(p + i), v);
+    }
+    addSat_scalar(p + i, n - i, value);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void threshold_avx512(uint8_t *p, size_t n, int threshold) {
+    if (threshold <= 0 || threshold > 255) {
+        threshold_scalar(p, n, threshold);
+        return;
+    }
+    const __m512i t = _mm512_set1_epi8((char)threshold);
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m512i v = _mm512_loadu_si512((const void *)(p + i));
+        __mmask64 m = _mm512_cmpge_epu8_mask(v, t);
+        _mm512_storeu_si512((void *)(p + i), _mm512_movm_epi8(m));
+    }
+    threshold_scalar(p + i, n - i, threshold);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void invert4_avx512(uint8_t *p, size_t npixels) {
+    const __m512i masque = _mm512_set1_epi32(0x00FFFFFF);
+    size_t i = 0;
+    for (; i + 16 <= npixels; i += 16) {
+        __m512i v = _mm512_loadu_si512((const void *)(p + 4 * i));
+        _mm512_storeu_si512((void *)(p + 4 * i), _mm512_xor_si512(v, masque));
+    }
+    invert4_scalar(p + 4 * i, npixels - i);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void addSat4_avx512(uint8_t *p, size_t npixels, int value) {
+    value = borner_valeur(value);
+    const __m512i delta = _mm512_set1_epi32((int)motif_rgb(value >= 0 ? value : -value));
+    size_t i = 0;
+    for (; i + 16 <= npixels; i += 16) {
+        __m512i v = _mm512_loadu_si512((const void *)(p + 4 * i));
+        v = (value >= 0) ? _mm512_adds_epu8(v, delta) : _mm512_subs_epu8(v, delta);
+        _mm512_storeu_si512((void *)(p + 4 * i), v);
+    }
+    addSat4_scalar(p + 4 * i, npixels - i, value);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void swapRB4_avx512(uint8_t *dst, const uint8_t *src, size_t npixels) {
+    const __m512i masque = _mm512_broadcast_i32x4(
+        _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15));
+    size_t i = 0;
+    for (; i + 16 <= npixels; i += 16) {
+        __m512i v = _mm512_loadu_si512((const void *)(src + 4 * i));
+        _mm512_storeu_si512((void *)(dst + 4 * i), _mm512_shuffle_epi8(v, masque));
+    }
+    swapRB4_scalar(dst + 4 * i, src + 4 * i, npixels - i);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void convolveRow_avx512(uint8_t *dst, const uint8_t *const *rows, size_t begin, size_t end,
+                               int step, const float *kernel, int kernelSize, t_kernel_rounding rounding) {
+    int n = kernelSize / 2;
+    const __m512 zero = _mm512_setzero_ps();
+    const __m512 max = _mm512_set1_ps(255.0f);
+    const __m512 half = _mm512_set1_ps(0.5f);
+    const __m512 one = _mm512_set1_ps(1.0f);
+
+    size_t x = begin;
+    for (; x + 16 <= end; x += 16) {
+        __m512 sum = _mm512_setzero_ps();
+        for (int ky = 0; ky < kernelSize; ky++) {
+            const uint8_t *p = rows[ky] + x - (size_t)n * step;
+            for (int kx = 0; kx < kernelSize; kx++) {
+                __m128i octets = _mm_loadu_si128((const __m128i *)(p + kx * step));
+                __m512 pix = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(octets));
+                sum = _mm512_add_ps(sum, _mm512_mul_ps(_mm512_set1_ps(kernel[ky * kernelSize + kx]), pix));
+            }
+        }
+        sum = _mm512_min_ps(_mm512_max_ps(sum, zero), max);
+        __m512 t = _mm512_roundscale_ps(sum, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+        if (rounding == KERNEL_ROUND_NEAREST) {
+            __mmask16 m = _mm512_cmp_ps_mask(_mm512_sub_ps(sum, t), half, _CMP_GE_OQ);
+            t = _mm512_mask_add_ps(t, m, t, one);
+        }
+        _mm_storeu_si128((__m128i *)(dst + x), _mm512_cvtepi32_epi8(_mm512_cvttps_epi32(t)));
+    }
+    convolveRow_scalar(dst, rows, x, end, step, kernel, kernelSize, rounding);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void resampleColumn_avx512(uint8_t *dst, const uint8_t *const *rows, size_t begin, size_t end,
+                                  const int16_t *weights, int taps) {
+    const __m512i arrondi = _mm512_set1_epi32(1 << (KERNEL_RESAMPLE_BITS - 1));
+    const __m512i zero = _mm512_setzero_si512();
+
+    size_t i = begin;
+    for (; i + 64 <= end; i += 64) {
+        __m512i s0 = zero, s1 = zero, s2 = zero, s3 = zero;
+        for (int k = 0; k < taps; k += 2) {
+            __m512i a = _mm512_loadu_si512((const void *)(rows[k] + i));
+            __m512i b = k + 1 < taps ? _mm512_loadu_si512((const void *)(rows[k + 1] + i)) : zero;
+            __m512i wp = _mm512_set1_epi32(paire_poids(weights[k], k + 1 < taps ? weights[k + 1] : 0));
+            __m512i alo = _mm512_unpacklo_epi8(a, zero), ahi = _mm512_unpackhi_epi8(a, zero);
+            __m512i blo = _mm512_unpacklo_epi8(b, zero), bhi = _mm512_unpackhi_epi8(b, zero);
+            s0 = _mm512_add_epi32(s0, _mm512_madd_epi16(_mm512_unpacklo_epi16(alo, blo), wp));
+            s1 = _mm512_add_epi32(s1, _mm512_madd_epi16(_mm512_unpackhi_epi16(alo, blo), wp));
+            s2 = _mm512_add_epi32(s2, _mm512_madd_epi16(_mm512_unpacklo_epi16(ahi, bhi), wp));
+            s3 = _mm512_add_epi32(s3, _mm512_madd_epi16(_mm512_unpackhi_epi16(ahi, bhi), wp));
+        }
+        s0 = _mm512_srai_epi32(_mm512_add_epi32(s0, arrondi), KERNEL_RESAMPLE_BITS);
+        s1 = _mm512_srai_epi32(_mm512_add_epi32(s1, arrondi), KERNEL_RESAMPLE_BITS);
+        s2 = _mm512_srai_epi32(_mm512_add_epi32(s2, arrondi), KERNEL_RESAMPLE_BITS);
+        s3 = _mm512_srai_epi32(_mm512_add_epi32(s3, arrondi), KERNEL_RESAMPLE_BITS);
+        __m512i v = _mm512_packus_epi16(_mm512_packs_epi32(s0, s1), _mm512_packs_epi32(s2, s3));
+        _mm512_storeu_si512((void *)(dst + i), v);
+    }
+    resampleColumn_avx2(dst, rows, i, end, weights, taps);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void blur5Column_avx512(uint16_t *dst, const uint8_t *const *rows, size_t begin, size_t end) {
+    size_t i = begin;
+    for (; i + 32 <= end; i += 32) {
+        __m512i a = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i *)(rows[0] + i)));
+        __m512i b = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i *)(rows[1] + i)));
+        __m512i c = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i *)(rows[2] + i)));
+        __m512i d = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i *)(rows[3] + i)));
+        __m512i e = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i *)(rows[4] + i)));
+        __m512i v = _mm512_add_epi16(_mm512_add_epi16(a, e), _mm512_slli_epi16(_mm512_add_epi16(b, d), 2));
+        v = _mm512_add_epi16(v, _mm512_add_epi16(_mm512_slli_epi16(c, 2), _mm512_slli_epi16(c, 1)));
+        _mm512_storeu_si512((void *)(dst + i), v);
+    }
+    blur5Column_avx2(dst, rows, i, end);
+}
+
+#endif // KERNELS_X86
+
+// --- Sélection ---
+
+static t_kernels table;
+static int table_prete = 0;
+
+void kernels_setLevel(t_cpu_level level) {
+    t_cpu_level max = cpu_detect();
+    if (level > max) {
+        level = max;
+    }
+
+    table.level = CPU_LEVEL_SCALAR;
+    table.invert = invert_scalar;
+    table.addSat = addSat_scalar;
+    table.threshold = threshold_scalar;
+    table.applyLut = applyLut_scalar;
+    table.histogram = histogram_scalar;
+    table.swapRB = swapRB_scalar;
+    table.invert4 = invert4_scalar;
+    table.addSat4 = addSat4_scalar;
+    table.swapRB4 = swapRB4_scalar;
+    table.swapRB3to4 = swapRB3to4_scalar;
+    table.swapRB4to3 = swapRB4to3_scalar;
+    table.convolveRow = convolveRow_scalar;
+    table.resampleRow = resampleRow_scalar;
+    table.resampleColumn = resampleColumn_scalar;
+    table.blur5Column = blur5Column_scalar;
+    table.transpose = transpose_scalar;
+    table.reverse = reverse_scalar;
+    table.warpBilinear = warpBilinear_scalar;
+
+#ifdef KERNELS_X86
+    // Chaque niveau hérite des noyaux du niveau inférieur qu'il ne redéfinit pas
+    // (applyLut et les permutations d'octets sur des triplets ne gagnent rien à des registres
+    // plus larges que 128 bits, pshufb ne traversant pas les voies de 128 bits ; warpBilinear est
+    // limité par ses lectures dispersées).
+    if (level >= CPU_LEVEL_SSE4) {
+        table.level = CPU_LEVEL_SSE4;
+        table.invert = invert_sse4;
+        table.addSat = addSat_sse4;
+        table.threshold = threshold_sse4;
+        table.histogram = histogram_banks;
+        table.swapRB = swapRB_sse4;
+        table.invert4 = invert4_sse4;
+        table.addSat4 = addSat4_sse4;
+        table.swapRB4 = swapRB4_sse4;
+        table.swapRB3to4 = swapRB3to4_sse4;
+        table.swapRB4to3 = swapRB4to3_sse4;
+        table.convolveRow = convolveRow_sse4;
+        table.resampleRow = resampleRow_sse4;
+        table.resampleColumn = resampleColumn_sse4;
+        table.blur5Column = blur5Column_sse4;
+        table.transpose = transpose_sse4;
+        table.reverse = reverse_sse4;
+        table.warpBilinear = warpBilinear_sse4;
+    }
+    if (level >= CPU_LEVEL_AVX2) {
+        table.level = CPU_LEVEL_AVX2;
+        table.invert = invert_avx2;
+        table.addSat = addSat_avx2;
+        table.threshold = threshold_avx2;
+        table.invert4 = invert4_avx2;
+        table.addSat4 = addSat4_avx2;
+        table.swapRB4 = swapRB4_avx2;
+        table.convolveRow = convolveRow_avx2;
+        table.resampleColumn = resampleColumn_avx2;
+        table.blur5Column = blur5Column_avx2;
+        table.transpose = transpose_avx2;
+        table.reverse = reverse_avx2;
+    }
+    if (level >= CPU_LEVEL_AVX512) {
+        table.level = CPU_LEVEL_AVX512;
+        table.invert = invert_avx512;
+        table.addSat = addSat_avx512;
+        table.threshold = threshold_avx512;
+        table.invert4 = invert4_avx512;
+        table.addSat4 = addSat4_avx512;
+        table.swapRB4 = swapRB4_avx512;
+        table.convolveRow = convolveRow_avx512;
+        table.resampleColumn = resampleColumn_avx512;
+        table.blur5Column = blur5Column_avx512;
+    }
+#endif
+
+    table_prete = 1;
+}
+
+void kernels_init(void) {
+    kernels_setLevel(cpu_selectLevel());
+}
+
+// Initialisation par défaut, exécutée une seule fois même si plusieurs threads appellent kernels_get
+static void initialiser_table(void) {
+    if (!table_prete) {
+        kernels_init();
+    }
+}
+
+const t_kernels *kernels_get(void) {
+    static pthread_once_t une_fois = PTHREAD_ONCE_INIT;
+    pthread_once(&une_fois, initialiser_table);
+    return &table;
+}
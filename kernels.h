@@ -0,0 +1,95 @@
+/*
+* Fichier : kernels.h
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Table de dispatch des noyaux de calcul critiques (opérations ponctuelles, convolutions,
+ *           histogrammes, conversion BGR/RGB). Chaque noyau existe en version scalaire et, sur x86,
+ *           en versions SSE4 / AVX2 / AVX-512 ; la meilleure est choisie une seule fois au démarrage.
+ */
+
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "cpu.h"
+
+// Mode d'arrondi du résultat d'une convolution (après saturation dans [0, 255])
+typedef enum {
+    KERNEL_ROUND_TRUNC   = 0,   // troncature (comportement de bmp8_applyFilter)
+    KERNEL_ROUND_NEAREST = 1    // arrondi au plus proche, 0.5 vers le haut (comportement de bmp24)
+} t_kernel_rounding;
+
+// Poids des noyaux de rééchantillonnage : entiers signés de somme 1 << KERNEL_RESAMPLE_BITS
+#define KERNEL_RESAMPLE_BITS 14
+// Octets lisibles exigés après la fin d'une ligne source de resampleRow
+#define KERNEL_RESAMPLE_PADDING 16
+// Bits de fraction des coordonnées source de warpBilinear (1/128 de pixel)
+#define KERNEL_WARP_BITS 7
+
+typedef struct {
+    t_cpu_level level;
+
+    // p[i] = 255 - p[i]
+    void (*invert)(uint8_t *p, size_t n);
+    // p[i] = sature(p[i] + value)
+    void (*addSat)(uint8_t *p, size_t n, int value);
+    // p[i] = (p[i] >= threshold) ? 255 : 0
+    void (*threshold)(uint8_t *p, size_t n, int threshold);
+    // p[i] = lut[p[i]]
+    void (*applyLut)(uint8_t *p, size_t n, const uint8_t lut[256]);
+    // hist[v] += nombre d'octets égaux à v (hist doit être initialisé)
+    void (*histogram)(const uint8_t *p, size_t n, unsigned int hist[256]);
+    // Échange des octets 0 et 2 de chaque triplet : BGR <-> RGB (dst et src disjoints)
+    void (*swapRB)(uint8_t *dst, const uint8_t *src, size_t npixels);
+    // Variantes pour pixels de 4 octets (R, G, B, A) : l'octet alpha n'est jamais modifié
+    void (*invert4)(uint8_t *p, size_t npixels);
+    void (*addSat4)(uint8_t *p, size_t npixels, int value);
+    // BGRA <-> RGBA (alpha recopié)
+    void (*swapRB4)(uint8_t *dst, const uint8_t *src, size_t npixels);
+    // BGR -> RGBA ou RGB -> BGRA (alpha = 255)
+    void (*swapRB3to4)(uint8_t *dst, const uint8_t *src, size_t npixels);
+    // BGRA -> RGB ou RGBA -> BGR (alpha ignoré)
+    void (*swapRB4to3)(uint8_t *dst, const uint8_t *src, size_t npixels);
+    // Convolution d'une ligne : pour chaque octet x de [begin, end),
+    // dst[x] = arrondi(sature(somme kernel[ky][kx] * rows[ky][x + (kx - n) * step]))
+    // rows contient les kernelSize lignes sources centrées sur la ligne traitée,
+    // kernel est stocké à plat (kernelSize * kernelSize, ligne par ligne).
+    void (*convolveRow)(uint8_t *dst, const uint8_t *const *rows, size_t begin, size_t end,
+                        int step, const float *kernel, int kernelSize, t_kernel_rounding rounding);
+    // Rééchantillonnage horizontal, poids en virgule fixe (KERNEL_RESAMPLE_BITS bits), taps poids par pixel :
+    // dst[x * channels + c] = sature(arrondi(somme weights[x * taps + k] * src[(starts[x] + k) * channels + c]))
+    // channels vaut 1, 3 ou 4 ; src doit rester lisible KERNEL_RESAMPLE_PADDING octets après la ligne.
+    void (*resampleRow)(uint8_t *dst, const uint8_t *src, int dstWidth, int channels,
+                        const int32_t *starts, const int16_t *weights, int taps);
+    // Rééchantillonnage vertical : dst[i] = sature(arrondi(somme weights[k] * rows[k][i])), i dans [begin, end)
+    void (*resampleColumn)(uint8_t *dst, const uint8_t *const *rows, size_t begin, size_t end,
+                           const int16_t *weights, int taps);
+    // Flou binomial vertical non normalisé (pyramides) : pour i dans [begin, end),
+    // dst[i] = rows[0][i] + 4 * rows[1][i] + 6 * rows[2][i] + 4 * rows[3][i] + rows[4][i]  (au plus 16 * 255)
+    void (*blur5Column)(uint16_t *dst, const uint8_t *const *rows, size_t begin, size_t end);
+    // Transposition d'un bloc de pixels de bpp octets (1, 3 ou 4) : pour r < rows et c < cols,
+    // pixel dstCol + r de la ligne dst[c] = pixel srcCol + c de la ligne src[r]
+    void (*transpose)(uint8_t *const *dst, size_t dstCol, const uint8_t *const *src, size_t srcCol,
+                      size_t rows, size_t cols, int bpp);
+    // Ligne retournée : pixel i de dst = pixel npixels - 1 - i de src (dst et src disjoints, bpp = 1, 3 ou 4)
+    void (*reverse)(uint8_t *dst, const uint8_t *src, size_t npixels, int bpp);
+    // Interpolation bilinéaire de n pixels de bpp octets (1, 3 ou 4) : coords[2i] et coords[2i + 1] sont les
+    // coordonnées source x et y du pixel i en virgule fixe (KERNEL_WARP_BITS bits), les pixels x à x + 2 des
+    // lignes rows[y] et rows[y + 1] devant exister. Avec u = 1 << KERNEL_WARP_BITS et fx, fy les fractions :
+    // haut = (u - fx) * rows[y][x] + fx * rows[y][x + 1], bas de même sur rows[y + 1],
+    // dst = ((u - fy) * haut + fy * bas + u * u / 2) >> (2 * KERNEL_WARP_BITS), canal par canal
+    void (*warpBilinear)(uint8_t *dst, const uint8_t *const *rows, const int32_t *coords, size_t n, int bpp);
+} t_kernels;
+
+// Sélectionne les implémentations selon cpu_selectLevel() (à appeler au démarrage)
+void kernels_init(void);
+
+// Force un niveau donné (borné par le matériel) ; utile pour comparer les chemins de code.
+// kernels_init et kernels_setLevel ne doivent pas être appelés pendant que d'autres threads filtrent.
+void kernels_setLevel(t_cpu_level level);
+
+// Table courante (initialisée à la demande, une seule fois même depuis plusieurs threads,
+// si kernels_init n'a pas été appelé)
+const t_kernels *kernels_get(void);
+
+#endif // KERNELS_H
@@ -11,25 +11,228 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include "bmp8.h"
-#include "bmp24.h"
-
-// Variables globales pour stocker les images chargées
-t_bmp8 *image8 = NULL;
-t_bmp24 *image24 = NULL;
-int image_type = 0; // 0: aucune, 8: BMP 8 bits, 24: BMP 24 bits
+#include "bmp_io.h"
+#include "kernels.h"
+#include "batch.h"
+#include "server.h"
+#include "stream.h"
+#include "resize.h"
+#include "dzi.h"
+#include "transform.h"
+#include "warp.h"
+#include "history.h"
+#include "chain.h"
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+// Variable globale pour stocker l'image chargée (8 ou 24 bits selon image->type)
+t_image *image = NULL;
+
+// Historique des opérations appliquées à l'image chargée (annuler / rétablir)
+t_history *historique = NULL;
+
+// Mode différé (--lazy) : les filtres choisis sont mémorisés sous forme de chaîne (voir chain.h) puis appliqués
+// ensemble, opérations ponctuelles fusionnées, juste avant la prochaine action qui a besoin de l'image
+int mode_differe = 0;
+char filtres_differes[1024] = "";
+int nb_differes = 0;
+
+// Aperçu (--proxy) : copie réduite de l'image, au plus APERCU_COTE_MAX pixels de côté, à laquelle chaque filtre
+// différé est appliqué aussitôt (noyaux mis à l'échelle, voir chain_applyScaled) avant d'être enregistrée dans
+// fichier_apercu. L'image entière n'est calculée qu'à l'application des filtres en attente.
+#define APERCU_COTE_MAX 1024
+t_image *apercu = NULL;
+double echelle_apercu = 1;
+const char *fichier_apercu = NULL;
+
+// Oublie les filtres différés en attente sans les appliquer
+void discard_operations() {
+    filtres_differes[0] = '\0';
+    nb_differes = 0;
+}
 
 // Fonction utilitaire pour libérer la mémoire et nettoyer
 void cleanup_images() {
-    if (image8 != NULL) {
-        bmp8_free(image8);
-        image8 = NULL;
+    bmp_close(image);
+    image = NULL;
+    bmp_close(apercu);
+    apercu = NULL;
+    history_clear(historique);
+    discard_operations();
+}
+
+// Enregistre l'aperçu pour la visionneuse de l'opérateur
+void save_proxy(t_bmp_status status) {
+    if (status == BMP_OK) {
+        status = bmp_save(fichier_apercu, apercu);
+    }
+    if (status == BMP_OK) {
+        printf("Apercu %dx%d mis a jour : %s\n", apercu->type == IMAGE_BMP8 ? (int)apercu->bmp8->width :
+               apercu->bmp24->width, apercu->type == IMAGE_BMP8 ? (int)apercu->bmp8->height :
+               apercu->bmp24->height, fichier_apercu);
+    } else {
+        printf("Erreur : apercu indisponible (%s).\n", bmp_strerror(status));
+    }
+}
+
+// Recrée l'aperçu à partir de l'image entière, après son chargement ou toute opération qui l'a modifiée
+void refresh_proxy() {
+    if (fichier_apercu == NULL) {
+        return;
+    }
+    bmp_close(apercu);
+    apercu = NULL;
+    if (image == NULL) {
+        return;
+    }
+
+    int width = image->type == IMAGE_BMP8 ? (int)image->bmp8->width : image->bmp24->width;
+    int height = image->type == IMAGE_BMP8 ? (int)image->bmp8->height : image->bmp24->height;
+    int cote = width > height ? width : height;
+    echelle_apercu = cote > APERCU_COTE_MAX ? (double)cote / APERCU_COTE_MAX : 1;
+    int w = (int)(width / echelle_apercu + 0.5);
+    int h = (int)(height / echelle_apercu + 0.5);
+    w = w > 0 ? w : 1;
+    h = h > 0 ? h : 1;
+
+    t_bmp_status status = BMP_ERR_MEMORY;
+    apercu = malloc(sizeof(t_image));
+    if (apercu != NULL) {
+        apercu->type = image->type;
+        if (image->type == IMAGE_BMP8) {
+            apercu->bmp8 = resize_bmp8(image->bmp8, w, h, RESIZE_BILINEAR, 0, &status);
+        } else {
+            apercu->bmp24 = resize_bmp24(image->bmp24, w, h, RESIZE_BILINEAR, 0, &status);
+        }
+        if (status != BMP_OK) {
+            free(apercu);
+            apercu = NULL;
+        }
+    }
+    if (apercu == NULL) {
+        printf("Erreur : apercu indisponible (%s).\n", bmp_strerror(status));
+        return;
+    }
+    save_proxy(BMP_OK);
+}
+
+// Applique aussitôt le filtre spec (élément de chaîne) à l'aperçu
+void update_proxy(const char *spec) {
+    if (apercu == NULL) {
+        return;
+    }
+    t_bmp_status status;
+    t_chain *chain = chain_parse(spec, &status, NULL, 0);
+    if (chain != NULL) {
+        t_chain_scratch scratch = {0};
+        status = chain_applyScaled(chain, apercu, echelle_apercu, &scratch);
+        chain_freeScratch(&scratch);
+        chain_free(chain);
+    }
+    save_proxy(status);
+}
+
+// Affiche le résultat d'une opération : la bibliothèque n'écrit rien, c'est le menu qui informe
+void report(t_bmp_status status, const char *succes) {
+    if (status == BMP_OK) {
+        printf("%s\n", succes);
+    } else {
+        printf("Erreur : %s.\n", bmp_strerror(status));
+    }
+}
+
+// Début d'une opération enregistrée dans l'historique ; lut : sa table de correspondance si elle est ponctuelle
+void begin_operation(const unsigned char *lut) {
+    if (history_begin(historique, image, lut) == BMP_ERR_MEMORY) {
+        printf("Memoire insuffisante : cette operation ne pourra pas etre annulee.\n");
+    }
+}
+
+// Fin d'une opération : enregistrée si elle a réussi ; renvoie son résultat
+t_bmp_status end_operation(t_bmp_status status, const char *label) {
+    return history_end(historique, image, status, label);
+}
+
+// Applique les filtres différés en attente, en une seule étape de l'historique
+void flush_operations() {
+    if (nb_differes == 0 || image == NULL) {
+        discard_operations();
+        return;
+    }
+
+    t_bmp_status status;
+    char message[128];
+    t_chain *chain = chain_parse(filtres_differes, &status, message, sizeof(message));
+    int nb = nb_differes;
+    discard_operations();
+    if (chain == NULL) {
+        printf("Erreur : %s.\n", message[0] != '\0' ? message : bmp_strerror(status));
+        return;
+    }
+
+    // Chaîne réduite à une table : l'historique ne garde que la table (voir history_begin)
+    unsigned char lut[256];
+    t_chain_scratch scratch = {0};
+    char label[48];
+    snprintf(label, sizeof(label), "%d filtre(s) differe(s)", nb);
+    begin_operation(chain_pointLut(chain, image->type, lut) ? lut : NULL);
+    status = end_operation(chain_apply(chain, image, &scratch), label);
+    if (status == BMP_OK) {
+        printf("%d filtre(s) differe(s) applique(s) en %d passage(s) sur l'image.\n", nb,
+               chain_passCount(chain, image->type));
+    } else {
+        printf("Erreur : %s.\n", bmp_strerror(status));
+    }
+    chain_freeScratch(&scratch);
+    chain_free(chain);
+    // L'aperçu approché est remplacé par la réduction du résultat exact
+    refresh_proxy();
+}
+
+// En mode différé, ajoute le filtre spec (élément de chaîne) aux filtres en attente et renvoie 1 ; renvoie 0
+// sinon, le filtre devant être appliqué tout de suite
+int defer_operation(const char *spec) {
+    if (!mode_differe) {
+        return 0;
+    }
+    // Plus de place : ce qui attend est appliqué d'abord
+    if (strlen(filtres_differes) + strlen(spec) + 2 > sizeof(filtres_differes)) {
+        flush_operations();
+    }
+    size_t n = strlen(filtres_differes);
+    snprintf(filtres_differes + n, sizeof(filtres_differes) - n, "%s%s", n > 0 ? "," : "", spec);
+    nb_differes++;
+    printf("Filtre differe (%d en attente) : %s\n", nb_differes, spec);
+    update_proxy(spec);
+    return 1;
+}
+
+// Tables de correspondance des opérations ponctuelles : les noyaux des filtres appliqués aux 256 valeurs
+const unsigned char *lut_negative(unsigned char lut[256]) {
+    for (int v = 0; v < 256; v++) {
+        lut[v] = (unsigned char)v;
+    }
+    kernels_get()->invert(lut, 256);
+    return lut;
+}
+
+const unsigned char *lut_brightness(unsigned char lut[256], int value) {
+    for (int v = 0; v < 256; v++) {
+        lut[v] = (unsigned char)v;
     }
-    if (image24 != NULL) {
-        bmp24_free(image24);
-        image24 = NULL;
+    kernels_get()->addSat(lut, 256, value);
+    return lut;
+}
+
+const unsigned char *lut_threshold(unsigned char lut[256], int threshold) {
+    for (int v = 0; v < 256; v++) {
+        lut[v] = (unsigned char)v;
     }
-    image_type = 0;
+    kernels_get()->threshold(lut, 256, threshold);
+    return lut;
 }
 
 // Fonction pour charger une image
@@ -41,28 +244,26 @@ void load_image() {
     // Nettoyer les images précédentes
     cleanup_images();
 
-    // Essayer de charger comme BMP 8 bits d'abord
-    image8 = bmp8_loadImage(filename);
-    if (image8 != NULL) {
-        image_type = 8;
-        printf("Image 8 bits chargée avec succès.\n");
+    // Un seul passage : l'en-tête décide du chargeur (8, 24 ou 32 bits)
+    t_bmp_status status;
+    image = bmp_openParallel(filename, 0, &status);
+    if (image == NULL) {
+        printf("Impossible de charger l'image (%s). Verifiez le nom du fichier et le format.\n",
+               bmp_strerror(status));
         return;
     }
 
-    // Essayer de charger comme BMP 24 bits
-    image24 = bmp24_loadImage(filename);
-    if (image24 != NULL) {
-        image_type = 24;
-        printf("Image 24 bits chargee avec succes.\n");
-        return;
+    if (image->type == IMAGE_BMP8) {
+        printf("Image 8 bits chargée avec succès.\n");
+    } else {
+        printf("Image %d bits chargee avec succes.\n", image->bmp24->colorDepth);
     }
-
-    printf("Impossible de charger l'image. Verifiez le nom du fichier et le format.\n");
+    refresh_proxy();
 }
 
 // Fonction pour sauvegarder une image
 void save_image() {
-    if (image_type == 0) {
+    if (image == NULL) {
         printf("Aucune image chargée. Veuillez d'abord charger une image.\n");
         return;
     }
@@ -70,32 +271,34 @@ void save_image() {
     char filename[256];
     printf("Entrez le nom du fichier de sortie (avec extension .bmp) : ");
     scanf("%255s", filename);
+    flush_operations();
 
-    if (image_type == 8) {
-        bmp8_saveImage(filename, image8);
-    } else if (image_type == 24) {
-        bmp24_saveImage(filename, image24);
+    t_bmp_status status = bmp_save(filename, image);
+    if (status == BMP_OK) {
+        printf("Image sauvegardée dans %s\n", filename);
+    } else {
+        printf("Erreur : sauvegarde de %s impossible (%s).\n", filename, bmp_strerror(status));
     }
 }
 
 // Fonction pour afficher les infos de l'image
 void display_image_info() {
-    if (image_type == 0) {
+    if (image == NULL) {
         printf("Aucune image chargee. Veuillez d'abord charger une image.\n");
         return;
     }
 
-    if (image_type == 8) {
-        bmp8_printInfo(image8);
-    } else if (image_type == 24) {
-        bmp24_printInfo(image24);
-    }
+    flush_operations();
+    bmp_printInfo(image);
 }
 
 // Fonction pour appliquer les filtres BMP 8 bits
 void apply_filters_bmp8() {
+    t_bmp8 *image8 = image->bmp8;
     int choix_filtre = 0;
     int valeur;
+    unsigned char lut[256];
+    char spec[32];
 
     while (1) {
         printf("\n-- Filtres BMP 8 bits --\n");
@@ -113,23 +316,43 @@ void apply_filters_bmp8() {
 
         switch (choix_filtre) {
             case 1:
-                bmp8_negative(image8);
+                if (defer_operation("negative")) {
+                    break;
+                }
+                begin_operation(lut_negative(lut));
+                report(end_operation(bmp8_negative(image8), "Negatif"), "Filtre négatif appliqué avec succès.");
                 break;
             case 2:
                 printf("Entrez la valeur de luminosite (-255 à +255) : ");
                 scanf("%d", &valeur);
-                bmp8_brightness(image8, valeur);
+                // Au-delà de 255 en valeur absolue, la saturation donne le même résultat
+                snprintf(spec, sizeof(spec), "brightness:%d", valeur < -255 ? -255 : valeur > 255 ? 255 : valeur);
+                if (defer_operation(spec)) {
+                    break;
+                }
+                begin_operation(lut_brightness(lut, valeur));
+                report(end_operation(bmp8_brightness(image8, valeur), "Luminosite"), "Luminosité ajustée.");
                 break;
             case 3:
                 printf("Entrez le seuil de binarisation (0 à 255) : ");
                 scanf("%d", &valeur);
-                bmp8_threshold(image8, valeur);
+                snprintf(spec, sizeof(spec), "threshold:%d", valeur);
+                // Un seuil invalide est refusé tout de suite, comme sans le mode différé
+                if (valeur >= 0 && valeur <= 255 && defer_operation(spec)) {
+                    break;
+                }
+                begin_operation(lut_threshold(lut, valeur));
+                report(end_operation(bmp8_threshold(image8, valeur), "Binarisation"),
+                       "Binarisation appliquée avec succès.");
                 break;
             // Dans main.c, remplacez le case 4 dans apply_filters_bmp8() par :
 
             case 4: {
+                if (defer_operation("equalize")) {
+                    break;
+                }
                 // Calculer l'histogramme
-                unsigned int *hist = bmp8_computeHistogram(image8);
+                uint64_t *hist = bmp8_computeHistogram(image8);
                 if (hist == NULL) {
                     printf("Erreur lors du calcul de l'histogramme.\n");
                     break;
@@ -143,9 +366,13 @@ void apply_filters_bmp8() {
                     break;
                 }
 
-                // Appliquer l'égalisation
-                bmp8_equalize(image8, hist_eq);
-                printf("Égalisation d'histogramme appliquée avec succès.\n");
+                // Appliquer l'égalisation (table de correspondance hist_eq)
+                for (int v = 0; v < 256; v++) {
+                    lut[v] = (unsigned char)hist_eq[v];
+                }
+                begin_operation(lut);
+                report(end_operation(bmp8_equalize(image8, hist_eq), "Egalisation"),
+                       "Égalisation d'histogramme appliquée avec succès.");
 
                 // Libérer la mémoire
                 free(hist);
@@ -160,8 +387,11 @@ void apply_filters_bmp8() {
 
 // Fonction pour appliquer les filtres BMP 24 bits
 void apply_filters_bmp24() {
+    t_bmp24 *image24 = image->bmp24;
     int choix_filtre = 0;
     int valeur;
+    unsigned char lut[256];
+    char spec[32];
 
     while (1) {
         printf("\n-- Filtres BMP 24 bits --\n");
@@ -183,35 +413,66 @@ void apply_filters_bmp24() {
 
         switch (choix_filtre) {
             case 1:
-                bmp24_negative(image24);
+                if (defer_operation("negative")) {
+                    break;
+                }
+                begin_operation(lut_negative(lut));
+                report(end_operation(bmp24_negative(image24), "Negatif"), "Filtre négatif appliqué avec succès.");
                 break;
             case 2:
                 printf("Entrez la valeur de luminosite (-255 à +255) : ");
                 scanf("%d", &valeur);
-                bmp24_brightness(image24, valeur);
+                // Au-delà de 255 en valeur absolue, la saturation donne le même résultat
+                snprintf(spec, sizeof(spec), "brightness:%d", valeur < -255 ? -255 : valeur > 255 ? 255 : valeur);
+                if (defer_operation(spec)) {
+                    break;
+                }
+                begin_operation(lut_brightness(lut, valeur));
+                report(end_operation(bmp24_brightness(image24, valeur), "Luminosite"), "Luminosité ajustée.");
                 break;
             case 3:
-                bmp24_grayscale(image24);
+                if (defer_operation("grayscale")) {
+                    break;
+                }
+                begin_operation(NULL);
+                report(end_operation(bmp24_grayscale(image24), "Niveaux de gris"),
+                       "Filtre niveaux de gris appliqué avec succès.");
                 break;
             case 4:
-                bmp24_boxBlur(image24);
-                printf("Filtre flou applique avec succes.\n");
+                if (defer_operation("box")) {
+                    break;
+                }
+                begin_operation(NULL);
+                report(end_operation(bmp24_boxBlur(image24), "Flou"), "Filtre flou applique avec succes.");
                 break;
             case 5:
-                bmp24_gaussianBlur(image24);
-                printf("Filtre flou gaussien applique avec succes.\n");
+                if (defer_operation("gaussian")) {
+                    break;
+                }
+                begin_operation(NULL);
+                report(end_operation(bmp24_gaussianBlur(image24), "Flou gaussien"),
+                       "Filtre flou gaussien applique avec succes.");
                 break;
             case 6:
-                bmp24_sharpen(image24);
-                printf("Filtre nettete applique avec succes.\n");
+                if (defer_operation("sharpen")) {
+                    break;
+                }
+                begin_operation(NULL);
+                report(end_operation(bmp24_sharpen(image24), "Nettete"), "Filtre nettete applique avec succes.");
                 break;
             case 7:
-                bmp24_outline(image24);
-                printf("Filtre contours applique avec succes.\n");
+                if (defer_operation("outline")) {
+                    break;
+                }
+                begin_operation(NULL);
+                report(end_operation(bmp24_outline(image24), "Contours"), "Filtre contours applique avec succes.");
                 break;
             case 8:
-                bmp24_emboss(image24);
-                printf("Filtre relief applique avec succes.\n");
+                if (defer_operation("emboss")) {
+                    break;
+                }
+                begin_operation(NULL);
+                report(end_operation(bmp24_emboss(image24), "Relief"), "Filtre relief applique avec succes.");
                 break;
             default:
                 printf("Choix de filtre invalide.\n");
@@ -221,23 +482,377 @@ void apply_filters_bmp24() {
 
 // Fonction pour appliquer les filtres selon le type d'image
 void apply_filters() {
-    if (image_type == 0) {
+    if (image == NULL) {
         printf("Aucune image chargee. Veuillez d'abord charger une image.\n");
         return;
     }
 
-    if (image_type == 8) {
+    if (image->type == IMAGE_BMP8) {
         apply_filters_bmp8();
-    } else if (image_type == 24) {
+    } else {
         apply_filters_bmp24();
     }
 }
 
-int main() {
+// Redimensionnement de l'image chargée (nouvelle taille et filtre demandés à l'utilisateur)
+void resize_current_image() {
+    if (image == NULL) {
+        printf("Aucune image chargee. Veuillez d'abord charger une image.\n");
+        return;
+    }
+
+    int width, height, choix;
+    printf("Nouvelle largeur : ");
+    scanf("%d", &width);
+    printf("Nouvelle hauteur : ");
+    scanf("%d", &height);
+    printf("Filtre (1. Bilineaire, 2. Bicubique, 3. Lanczos3) : ");
+    scanf("%d", &choix);
+    if (width <= 0 || height <= 0 || choix < 1 || choix > 3) {
+        printf("Dimensions ou filtre invalides.\n");
+        return;
+    }
+
+    flush_operations();
+    begin_operation(NULL);
+    report(end_operation(resize_image(image, width, height, (t_resize_filter)(choix - 1), 0), "Redimensionnement"),
+           "Image redimensionnee avec succes.");
+    refresh_proxy();
+}
+
+// Rotation, miroir ou transposition de l'image chargée
+void transform_current_image() {
+    if (image == NULL) {
+        printf("Aucune image chargee. Veuillez d'abord charger une image.\n");
+        return;
+    }
+
+    int choix;
+    printf("1. Rotation 90 (sens horaire)\n");
+    printf("2. Rotation 180\n");
+    printf("3. Rotation 270 (sens antihoraire)\n");
+    printf("4. Miroir gauche-droite\n");
+    printf("5. Miroir haut-bas\n");
+    printf("6. Transposition\n");
+    printf("7. Transposition par l'autre diagonale\n");
+    printf(">>> Votre choix : ");
+    scanf("%d", &choix);
+    if (choix < 1 || choix > 7) {
+        printf("Choix de transformation invalide.\n");
+        return;
+    }
+
+    static const char *noms[] = {"Rotation 90", "Rotation 180", "Rotation 270", "Miroir gauche-droite",
+                                 "Miroir haut-bas", "Transposition", "Transposition (autre diagonale)"};
+    flush_operations();
+    begin_operation(NULL);
+    report(end_operation(transform_image(image, (t_transform)(choix - 1), 0), noms[choix - 1]),
+           "Transformation appliquee avec succes.");
+    refresh_proxy();
+}
+
+// Annule la dernière opération de l'historique ; en mode différé, les filtres en attente sont d'abord abandonnés
+void undo_operation() {
+    if (nb_differes > 0) {
+        printf("Filtres en attente abandonnes : %s\n", filtres_differes);
+        discard_operations();
+        refresh_proxy();
+        return;
+    }
+
+    const char *label = history_undoLabel(historique);
+    if (image == NULL || label == NULL) {
+        printf("Aucune operation a annuler.\n");
+        return;
+    }
+
+    t_bmp_status status = history_undo(historique, image);
+    if (status == BMP_OK) {
+        printf("Operation annulee : %s\n", label);
+        refresh_proxy();
+    } else {
+        printf("Erreur : %s.\n", bmp_strerror(status));
+    }
+}
+
+// Rétablit la dernière opération annulée
+void redo_operation() {
+    flush_operations();
+    const char *label = history_redoLabel(historique);
+    if (image == NULL || label == NULL) {
+        printf("Aucune operation a retablir.\n");
+        return;
+    }
+
+    t_bmp_status status = history_redo(historique, image);
+    if (status == BMP_OK) {
+        printf("Operation retablie : %s\n", label);
+        refresh_proxy();
+    } else {
+        printf("Erreur : %s.\n", bmp_strerror(status));
+    }
+}
+
+// Mode flux : BMP lu sur l'entrée standard, résultat écrit sur la sortie standard (messages sur stderr)
+int run_pipe(const char *spec) {
+    t_bmp_status status;
+    char message[128];
+    t_chain *chain = chain_parse(spec, &status, message, sizeof(message));
+    if (chain == NULL) {
+        fprintf(stderr, "Erreur : %s.\n", message[0] != '\0' ? message : bmp_strerror(status));
+        return 2;
+    }
+
+#ifdef _WIN32
+    // Pas de conversion des fins de ligne sur des données binaires
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+    status = stream_run(stdin, stdout, chain);
+    chain_free(chain);
+    if (status != BMP_OK) {
+        fprintf(stderr, "Erreur : %s.\n", bmp_strerror(status));
+        return 1;
+    }
+    return 0;
+}
+
+// Export Deep Zoom : --dzi <entrée.bmp> <base> [--tile N] [--overlap N] [--jobs N]
+int run_dzi(int argc, char **argv) {
+    t_dzi_options options;
+    dzi_defaultOptions(&options);
+    if (argc < 4 || argc % 2 != 0) {
+        fprintf(stderr, "Usage : %s --dzi <entree.bmp> <base> [--tile N] [--overlap N] [--jobs N]\n", argv[0]);
+        return 2;
+    }
+    for (int i = 4; i < argc; i += 2) {
+        char *fin;
+        long valeur = strtol(argv[i + 1], &fin, 10);
+        if (*fin != '\0' || valeur < 0 || valeur > 65536) {
+            fprintf(stderr, "Erreur : valeur invalide pour %s.\n", argv[i]);
+            return 2;
+        }
+        if (strcmp(argv[i], "--tile") == 0 && valeur > 0) {
+            options.tileSize = (int)valeur;
+        } else if (strcmp(argv[i], "--overlap") == 0) {
+            options.overlap = (int)valeur;
+        } else if (strcmp(argv[i], "--jobs") == 0 && valeur <= 1024) {
+            options.threads = (int)valeur;
+        } else {
+            fprintf(stderr, "Erreur : option inconnue ou valeur invalide : %s %s.\n", argv[i], argv[i + 1]);
+            return 2;
+        }
+    }
+
+    t_bmp_status status;
+    t_image *img = bmp_openParallel(argv[2], options.threads, &status);
+    if (img == NULL) {
+        fprintf(stderr, "Erreur : %s : %s.\n", argv[2], bmp_strerror(status));
+        return 1;
+    }
+    status = img->type == IMAGE_BMP24 ? dzi_export(img->bmp24, argv[3], &options) : BMP_ERR_DEPTH;
+    bmp_close(img);
+    if (status != BMP_OK) {
+        fprintf(stderr, "Erreur : %s.\n", bmp_strerror(status));
+        return 1;
+    }
+    return 0;
+}
+
+// Lit count réels séparés par des virgules ; renvoie 0 si succès, -1 sinon
+int parse_numbers(const char *text, double *values, int count) {
+    for (int i = 0; i < count; i++) {
+        char *fin;
+        values[i] = strtod(text, &fin);
+        if (fin == text || *fin != (i + 1 < count ? ',' : '\0')) {
+            return -1;
+        }
+        text = fin + 1;
+    }
+    return 0;
+}
+
+// Déformation : --warp <entrée.bmp> <sortie.bmp> (--rotate DEG | --affine a,b,c,d,e,f | --perspective h0,...,h8)
+//               [--size LxH] [--sampling nearest|bilinear] [--jobs N]
+int run_warp(int argc, char **argv) {
+    t_warp_matrix m;
+    int matrice = 0, width = 0, height = 0, threads = 0;
+    double angle = 0.0;
+    t_warp_sampling sampling = WARP_BILINEAR;
+    if (argc < 6 || argc % 2 != 0) {
+        fprintf(stderr, "Usage : %s --warp <entree.bmp> <sortie.bmp> (--rotate DEG | --affine a,b,c,d,e,f | "
+                        "--perspective h0,...,h8) [--size LxH] [--sampling nearest|bilinear] [--jobs N]\n", argv[0]);
+        return 2;
+    }
+    for (int i = 4; i < argc; i += 2) {
+        const char *valeur = argv[i + 1];
+        char *fin;
+        int valide = 1;
+        if (strcmp(argv[i], "--rotate") == 0) {
+            angle = strtod(valeur, &fin);
+            valide = fin != valeur && *fin == '\0';
+            matrice = 1;
+        } else if (strcmp(argv[i], "--affine") == 0) {
+            double v[6];
+            valide = parse_numbers(valeur, v, 6) == 0;
+            if (valide) {
+                warp_affine(&m, v[0], v[1], v[2], v[3], v[4], v[5]);
+            }
+            matrice = 2;
+        } else if (strcmp(argv[i], "--perspective") == 0) {
+            valide = parse_numbers(valeur, m.m, 9) == 0;
+            matrice = 2;
+        } else if (strcmp(argv[i], "--size") == 0) {
+            valide = sscanf(valeur, "%dx%d", &width, &height) == 2 && width > 0 && height > 0;
+        } else if (strcmp(argv[i], "--sampling") == 0) {
+            valide = warp_parseSampling(valeur, &sampling) == 0;
+        } else if (strcmp(argv[i], "--jobs") == 0) {
+            long n = strtol(valeur, &fin, 10);
+            valide = *fin == '\0' && n >= 0 && n <= 1024;
+            threads = (int)n;
+        } else {
+            valide = 0;
+        }
+        if (!valide) {
+            fprintf(stderr, "Erreur : option inconnue ou valeur invalide : %s %s.\n", argv[i], valeur);
+            return 2;
+        }
+    }
+    if (matrice == 0) {
+        fprintf(stderr, "Erreur : indiquez --rotate, --affine ou --perspective.\n");
+        return 2;
+    }
+
+    t_bmp_status status;
+    t_image *img = bmp_openParallel(argv[2], threads, &status);
+    if (img == NULL) {
+        fprintf(stderr, "Erreur : %s : %s.\n", argv[2], bmp_strerror(status));
+        return 1;
+    }
+    int srcWidth = img->type == IMAGE_BMP8 ? (int)img->bmp8->width : img->bmp24->width;
+    int srcHeight = img->type == IMAGE_BMP8 ? (int)img->bmp8->height : img->bmp24->height;
+    if (width == 0) {
+        width = srcWidth;
+        height = srcHeight;
+    }
+    if (matrice == 1) {
+        // Rotation autour du centre de la source, ramené au centre de la sortie
+        warp_rotation(&m, angle, srcWidth / 2.0, srcHeight / 2.0);
+        m.m[2] += (width - srcWidth) / 2.0;
+        m.m[5] += (height - srcHeight) / 2.0;
+    }
+
+    status = warp_image(img, width, height, &m, sampling, threads);
+    if (status == BMP_OK) {
+        status = bmp_save(argv[3], img);
+    }
+    bmp_close(img);
+    if (status != BMP_OK) {
+        fprintf(stderr, "Erreur : %s.\n", bmp_strerror(status));
+        return 1;
+    }
+    return 0;
+}
+
+// Découpe : --crop <entrée.bmp> <sortie.bmp> LxH+X+Y, le rectangle étant écrit sans copie de l'image
+int run_crop(int argc, char **argv) {
+    t_bmp_rect rect;
+    if (argc != 5 || bmp_parseRect(argv[4], &rect) != 0) {
+        fprintf(stderr, "Usage : %s --crop <entree.bmp> <sortie.bmp> LxH+X+Y\n", argv[0]);
+        return 2;
+    }
+
+    t_bmp_status status;
+    t_image *img = bmp_open(argv[2], &status);
+    if (img == NULL) {
+        fprintf(stderr, "Erreur : %s : %s.\n", argv[2], bmp_strerror(status));
+        return 1;
+    }
+    int width = img->type == IMAGE_BMP8 ? (int)img->bmp8->width : img->bmp24->width;
+    int height = img->type == IMAGE_BMP8 ? (int)img->bmp8->height : img->bmp24->height;
+    if (!bmp_clipRect(&rect, width, height)) {
+        status = BMP_ERR_ARGUMENT;
+    } else {
+        status = bmp_saveRect(argv[3], img, &rect);
+    }
+    bmp_close(img);
+    if (status != BMP_OK) {
+        fprintf(stderr, "Erreur : %s.\n", bmp_strerror(status));
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
     int choix_principal = 0;
 
+    // Détection des extensions SIMD une seule fois au démarrage, avant tout thread
+    kernels_init();
+
+    // Mode serveur : travaux reçus sur une socket Unix ou l'entrée standard (voir server.h)
+    if (argc > 1 && strcmp(argv[1], "--serve") == 0) {
+        t_server_options options;
+        if (server_parseArgs(argc, argv, &options) != 0) {
+            return 2;
+        }
+        return server_run(&options) == 0 ? 0 : 1;
+    }
+
+    // Mode flux : --pipe <chaîne>, pour s'insérer entre deux commandes reliées par des tubes
+    if (argc > 1 && strcmp(argv[1], "--pipe") == 0) {
+        if (argc != 3) {
+            fprintf(stderr, "Usage : %s --pipe <filtres> < entree.bmp > sortie.bmp\n", argv[0]);
+            return 2;
+        }
+        return run_pipe(argv[2]);
+    }
+
+    // Export en tuiles Deep Zoom pour les visionneuses web (voir dzi.h)
+    if (argc > 1 && strcmp(argv[1], "--dzi") == 0) {
+        return run_dzi(argc, argv);
+    }
+
+    // Déformation affine ou perspective (voir warp.h)
+    if (argc > 1 && strcmp(argv[1], "--warp") == 0) {
+        return run_warp(argc, argv);
+    }
+
+    // Découpe d'un rectangle (voir bmp_saveRect)
+    if (argc > 1 && strcmp(argv[1], "--crop") == 0) {
+        return run_crop(argc, argv);
+    }
+
+    // Menu en mode différé : filtres appliqués ensemble, après fusion, avant la sauvegarde ou l'affichage
+    if (argc == 2 && strcmp(argv[1], "--lazy") == 0) {
+        mode_differe = 1;
+    } else if (argc == 3 && strcmp(argv[1], "--proxy") == 0) {
+        // Mode différé avec aperçu immédiat sur une copie réduite
+        mode_differe = 1;
+        fichier_apercu = argv[2];
+    } else if (argc > 1) {
+        // Avec des arguments : traitement par lot sans menu (voir batch.h)
+        t_batch_options options;
+        if (batch_parseArgs(argc, argv, &options) != 0) {
+            return 2;
+        }
+        printf("Jeu d'instructions : %s\n", cpu_levelName(kernels_get()->level));
+        return batch_run(&options) == 0 ? 0 : 1;
+    }
+
+    // Historique borné : les étapes les plus anciennes sont oubliées au-delà du budget
+    historique = history_create(HISTORY_BUDGET_DEFAULT);
+
     printf("=== EDITEUR D'IMAGES BMP ===\n");
     printf("Support des formats BMP 8 bits et 24 bits\n");
+    printf("Jeu d'instructions : %s\n", cpu_levelName(kernels_get()->level));
+    if (mode_differe) {
+        printf("Mode differe : les filtres sont appliques ensemble avant la prochaine autre action\n");
+    }
+    if (fichier_apercu != NULL) {
+        printf("Apercu : chaque filtre est applique aussitot a une copie reduite (%d pixels de cote au plus), "
+               "enregistree dans %s\n", APERCU_COTE_MAX, fichier_apercu);
+    }
 
     while (1) {
         printf("\n=== Menu Principal ===\n");
@@ -245,10 +860,28 @@ int main() {
         printf("2. Sauvegarder une image\n");
         printf("3. Appliquer un filtre\n");
         printf("4. Afficher les informations de l'image\n");
-        printf("5. Quitter\n");
+        printf("5. Redimensionner l'image\n");
+        printf("6. Rotation / miroir\n");
+        if (nb_differes > 0) {
+            printf("7. Annuler (%d filtre(s) en attente)\n", nb_differes);
+        } else if (history_undoLabel(historique) != NULL) {
+            printf("7. Annuler (%s)\n", history_undoLabel(historique));
+        } else {
+            printf("7. Annuler\n");
+        }
+        if (history_redoLabel(historique) != NULL) {
+            printf("8. Retablir (%s)\n", history_redoLabel(historique));
+        } else {
+            printf("8. Retablir\n");
+        }
+        printf("9. Quitter\n");
 
-        if (image_type != 0) {
-            printf("Image actuellement chargee : %d bits\n", image_type);
+        if (image != NULL) {
+            printf("Image actuellement chargee : %d bits\n",
+                   image->type == IMAGE_BMP8 ? 8 : image->bmp24->colorDepth);
+        }
+        if (nb_differes > 0) {
+            printf("Filtres en attente : %s\n", filtres_differes);
         }
 
         printf(">>> Votre choix : ");
@@ -272,12 +905,29 @@ int main() {
                 break;
 
             case 5:
+                resize_current_image();
+                break;
+
+            case 6:
+                transform_current_image();
+                break;
+
+            case 7:
+                undo_operation();
+                break;
+
+            case 8:
+                redo_operation();
+                break;
+
+            case 9:
                 cleanup_images();
+                history_free(historique);
                 printf("Merci d'avoir utilise notre code! \n");
                 exit(0);
 
             default:
-                printf("Choix invalide. Veuillez entrer un nombre entre 1 et 5.\n");
+                printf("Choix invalide. Veuillez entrer un nombre entre 1 et 9.\n");
         }
     }
 
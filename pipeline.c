@@ -0,0 +1,352 @@
+/*
+* Fichier : pipeline.c
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Implémente le pipeline lecture -> calcul -> écriture : deux files bornées (mutex + conditions),
+ *           un compteur de budget mémoire et trois groupes de threads. Le dernier thread d'un étage ferme
+ *           la file de sortie, ce qui termine l'étage suivant une fois la file vidée.
+ */
+
+#include "pipeline.h"
+#include "threadpool.h"
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+// Image en vol entre deux étages
+typedef struct {
+    t_pipeline_job *job;
+    t_image *image;
+    size_t cost;            // part du budget réservée pour cette image
+    double start;
+} t_item;
+
+// File bornée de t_item *
+typedef struct {
+    t_item **items;
+    int capacity;
+    int head;
+    int count;
+    int closed;
+    pthread_mutex_t lock;
+    pthread_cond_t notEmpty;
+    pthread_cond_t notFull;
+} t_queue;
+
+typedef struct {
+    const t_pipeline_config *config;
+    const t_chain *chain;
+    t_pipeline_job *jobs;
+    t_item *items;
+    int nbJobs;
+
+    t_queue decoded;        // lecteurs -> calcul
+    t_queue filtered;       // calcul -> écrivains
+
+    pthread_mutex_t lock;   // protège les champs ci-dessous
+    pthread_cond_t budgetFree;
+    int next;               // prochaine image à lire
+    size_t used;            // budget consommé
+    int readersLeft;
+    int workersLeft;
+    int nextWorker;         // attribution des tampons de calcul
+    int failures;
+
+    t_chain_scratch *scratch;
+} t_pipeline;
+
+static double maintenant_ms(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// --- File bornée ---
+
+static int file_init(t_queue *q, int capacity) {
+    q->items = malloc(sizeof(t_item *) * capacity);
+    if (q->items == NULL) {
+        return -1;
+    }
+    q->capacity = capacity;
+    q->head = 0;
+    q->count = 0;
+    q->closed = 0;
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->notEmpty, NULL);
+    pthread_cond_init(&q->notFull, NULL);
+    return 0;
+}
+
+static void file_detruire(t_queue *q) {
+    pthread_mutex_destroy(&q->lock);
+    pthread_cond_destroy(&q->notEmpty);
+    pthread_cond_destroy(&q->notFull);
+    free(q->items);
+}
+
+// Bloque tant que la file est pleine : c'est la contre-pression sur l'étage précédent
+static void file_pousser(t_queue *q, t_item *item) {
+    pthread_mutex_lock(&q->lock);
+    while (q->count == q->capacity) {
+        pthread_cond_wait(&q->notFull, &q->lock);
+    }
+    q->items[(q->head + q->count) % q->capacity] = item;
+    q->count++;
+    pthread_cond_signal(&q->notEmpty);
+    pthread_mutex_unlock(&q->lock);
+}
+
+// Renvoie NULL quand la file est fermée et vide
+static t_item *file_retirer(t_queue *q) {
+    pthread_mutex_lock(&q->lock);
+    while (q->count == 0 && !q->closed) {
+        pthread_cond_wait(&q->notEmpty, &q->lock);
+    }
+    t_item *item = NULL;
+    if (q->count > 0) {
+        item = q->items[q->head];
+        q->head = (q->head + 1) % q->capacity;
+        q->count--;
+        pthread_cond_signal(&q->notFull);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return item;
+}
+
+static void file_fermer(t_queue *q) {
+    pthread_mutex_lock(&q->lock);
+    q->closed = 1;
+    pthread_cond_broadcast(&q->notEmpty);
+    pthread_mutex_unlock(&q->lock);
+}
+
+// --- Budget mémoire ---
+
+// Attend que l'image tienne dans le budget ; une image seule passe toujours, même plus grande que le budget
+static void budget_reserver(t_pipeline *p, size_t cost) {
+    pthread_mutex_lock(&p->lock);
+    while (p->config->memoryBudget > 0 && p->used > 0 && p->used + cost > p->config->memoryBudget) {
+        pthread_cond_wait(&p->budgetFree, &p->lock);
+    }
+    p->used += cost;
+    pthread_mutex_unlock(&p->lock);
+}
+
+static void budget_liberer(t_pipeline *p, size_t cost) {
+    pthread_mutex_lock(&p->lock);
+    p->used -= cost;
+    pthread_cond_broadcast(&p->budgetFree);
+    pthread_mutex_unlock(&p->lock);
+}
+
+// Fin de parcours d'une image (succès ou échec) : libération et notification
+static void terminer(t_pipeline *p, t_item *item, const char *error, t_bmp_status status) {
+    bmp_close(item->image);
+    item->image = NULL;
+    budget_liberer(p, item->cost);
+
+    item->job->ok = error == NULL;
+    item->job->error = error;
+    item->job->status = status;
+    item->job->ms = maintenant_ms() - item->start;
+    if (error != NULL) {
+        pthread_mutex_lock(&p->lock);
+        p->failures++;
+        pthread_mutex_unlock(&p->lock);
+    }
+    if (p->config->onDone != NULL) {
+        p->config->onDone(item->job, p->config->user);
+    }
+}
+
+// --- Étages ---
+
+static void *etape_lecture(void *arg) {
+    t_pipeline *p = arg;
+
+    while (1) {
+        pthread_mutex_lock(&p->lock);
+        int i = p->next < p->nbJobs ? p->next++ : -1;
+        pthread_mutex_unlock(&p->lock);
+        if (i < 0) {
+            break;
+        }
+
+        t_item *item = &p->items[i];
+        item->job = &p->jobs[i];
+        item->image = NULL;
+        item->start = maintenant_ms();
+
+        // Coût estimé avant le décodage : la taille du fichier, proche de la taille décodée
+        struct stat st;
+        int scale = p->config->decodeScale;
+        item->cost = stat(item->job->input, &st) == 0 ? (size_t)st.st_size / ((size_t)scale * scale) : 0;
+        budget_reserver(p, item->cost);
+
+        t_bmp_status status;
+        item->image = scale > 1 ? bmp_openScaled(item->job->input, scale, &status)
+                                : bmp_openParallel(item->job->input, p->config->decodeThreads, &status);
+        if (item->image == NULL) {
+            terminer(p, item, "lecture", status);
+            continue;
+        }
+        file_pousser(&p->decoded, item);
+    }
+
+    pthread_mutex_lock(&p->lock);
+    int dernier = --p->readersLeft == 0;
+    pthread_mutex_unlock(&p->lock);
+    if (dernier) {
+        file_fermer(&p->decoded);
+    }
+    return NULL;
+}
+
+static void *etape_calcul(void *arg) {
+    t_pipeline *p = arg;
+
+    pthread_mutex_lock(&p->lock);
+    t_chain_scratch *scratch = &p->scratch[p->nextWorker++];
+    pthread_mutex_unlock(&p->lock);
+
+    t_item *item;
+    while ((item = file_retirer(&p->decoded)) != NULL) {
+        t_bmp_status status = p->config->cache != NULL
+                               ? cache_applyChain(p->config->cache, p->chain, &item->image, scratch, &item->job->reused)
+                               : chain_apply(p->chain, item->image, scratch);
+        if (status != BMP_OK) {
+            terminer(p, item, "filtres", status);
+            continue;
+        }
+        file_pousser(&p->filtered, item);
+    }
+
+    pthread_mutex_lock(&p->lock);
+    int dernier = --p->workersLeft == 0;
+    pthread_mutex_unlock(&p->lock);
+    if (dernier) {
+        file_fermer(&p->filtered);
+    }
+    return NULL;
+}
+
+static void *etape_ecriture(void *arg) {
+    t_pipeline *p = arg;
+
+    t_item *item;
+    while ((item = file_retirer(&p->filtered)) != NULL) {
+        t_bmp_status status = bmp_save(item->job->output, item->image);
+        terminer(p, item, status == BMP_OK ? NULL : "ecriture", status);
+    }
+    return NULL;
+}
+
+// --- Exécution ---
+
+// Lance jusqu'à n threads d'un étage ; ceux qui n'ont pas pu démarrer sont retirés de *restants et,
+// si plus aucun ne reste, la file de sortie de l'étage est fermée. Renvoie le nombre de threads lancés.
+static int lancer(t_pipeline *p, pthread_t *threads, int n, void *(*etape)(void *),
+                  int *restants, t_queue *sortie) {
+    int lances = 0;
+    while (lances < n && pthread_create(&threads[lances], NULL, etape, p) == 0) {
+        lances++;
+    }
+    if (restants != NULL && lances < n) {
+        pthread_mutex_lock(&p->lock);
+        *restants -= n - lances;
+        int dernier = *restants == 0;
+        pthread_mutex_unlock(&p->lock);
+        if (dernier) {
+            file_fermer(sortie);
+        }
+    }
+    return lances;
+}
+
+void pipeline_defaultConfig(t_pipeline_config *config) {
+    config->readers = 1;
+    config->workers = threadpool_cpuCount();
+    config->writers = 1;
+    config->queueCapacity = 2 * config->workers;
+    config->memoryBudget = (size_t)512 << 20;
+    config->decodeThreads = 1;
+    config->decodeScale = 1;
+    config->cache = NULL;
+    config->onDone = NULL;
+    config->user = NULL;
+}
+
+int pipeline_run(const t_pipeline_config *config, const t_chain *chain, t_pipeline_job *jobs, int nbJobs) {
+    if (config == NULL || chain == NULL || (jobs == NULL && nbJobs > 0) || nbJobs < 0 ||
+        config->readers < 1 || config->workers < 1 || config->writers < 1 || config->queueCapacity < 1) {
+        return -1;
+    }
+
+    t_pipeline p = {0};
+    p.config = config;
+    p.chain = chain;
+    p.jobs = jobs;
+    p.nbJobs = nbJobs;
+    p.readersLeft = config->readers;
+    p.workersLeft = config->workers;
+
+    int nbThreads = config->readers + config->workers + config->writers;
+    p.items = calloc(nbJobs > 0 ? nbJobs : 1, sizeof(t_item));
+    p.scratch = calloc(config->workers, sizeof(t_chain_scratch));
+    pthread_t *threads = malloc(sizeof(pthread_t) * nbThreads);
+    if (p.items == NULL || p.scratch == NULL || threads == NULL) {
+        free(p.items);
+        free(p.scratch);
+        free(threads);
+        return -1;
+    }
+    if (file_init(&p.decoded, config->queueCapacity) != 0) {
+        free(p.items);
+        free(p.scratch);
+        free(threads);
+        return -1;
+    }
+    if (file_init(&p.filtered, config->queueCapacity) != 0) {
+        file_detruire(&p.decoded);
+        free(p.items);
+        free(p.scratch);
+        free(threads);
+        return -1;
+    }
+    pthread_mutex_init(&p.lock, NULL);
+    pthread_cond_init(&p.budgetFree, NULL);
+
+    for (int i = 0; i < nbJobs; i++) {
+        jobs[i].ok = 0;
+        jobs[i].error = NULL;
+        jobs[i].status = BMP_OK;
+        jobs[i].ms = 0;
+        jobs[i].reused = 0;
+    }
+
+    // Démarrage de l'aval vers l'amont : un étage sans aucun thread ferme sa file de sortie et
+    // l'étage suivant se termine aussitôt, sans qu'aucune image ne soit lue
+    int nbWriters = lancer(&p, threads, config->writers, etape_ecriture, NULL, NULL);
+    int nbWorkers = nbWriters > 0 ? lancer(&p, threads + nbWriters, config->workers, etape_calcul,
+                                           &p.workersLeft, &p.filtered) : 0;
+    int nbReaders = nbWorkers > 0 ? lancer(&p, threads + nbWriters + nbWorkers, config->readers, etape_lecture,
+                                           &p.readersLeft, &p.decoded) : 0;
+    for (int i = 0; i < nbWriters + nbWorkers + nbReaders; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    int failures = nbReaders > 0 ? p.failures : -1;
+
+    for (int i = 0; i < config->workers; i++) {
+        chain_freeScratch(&p.scratch[i]);
+    }
+    pthread_mutex_destroy(&p.lock);
+    pthread_cond_destroy(&p.budgetFree);
+    file_detruire(&p.decoded);
+    file_detruire(&p.filtered);
+    free(p.items);
+    free(p.scratch);
+    free(threads);
+    return failures;
+}
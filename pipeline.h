@@ -0,0 +1,48 @@
+/*
+* Fichier : pipeline.h
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Exécuteur en trois étages (lecture -> calcul -> écriture) reliés par des files bornées.
+ *           Les lecteurs décodent les fichiers suivants pendant que les threads de calcul appliquent la
+ *           chaîne et que les écrivains encodent les résultats. Une file pleine bloque l'étage précédent
+ *           et un budget mémoire limite le volume d'images décodées en vol.
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stddef.h>
+#include "chain.h"
+#include "cache.h"
+
+// Une image à traiter et son résultat
+typedef struct {
+    const char *input;
+    const char *output;
+    int ok;                 // 1 si l'image a été écrite
+    const char *error;      // étape en échec sinon ("lecture", "filtres", "ecriture")
+    t_bmp_status status;    // cause de l'échec (voir bmp_strerror)
+    double ms;              // durée de la lecture au début de l'écriture comprise
+    int reused;             // opérations de la chaîne relues du cache (voir cache_applyChain)
+} t_pipeline_job;
+
+typedef struct {
+    int readers;            // threads de lecture (>= 1)
+    int workers;            // threads de calcul (>= 1)
+    int writers;            // threads d'écriture (>= 1)
+    int queueCapacity;      // profondeur de chaque file entre deux étages (>= 1)
+    size_t memoryBudget;    // octets d'images en vol, estimés d'après la taille des fichiers (0 : illimité)
+    int decodeThreads;      // threads par chargement d'image 24/32 bits (1 : séquentiel, voir bmp_openParallel)
+    int decodeScale;        // réduction au chargement : 1, 2, 4 ou 8 (voir bmp_openScaled)
+    t_result_cache *cache;  // cache de résultats sur disque (NULL : aucun)
+    // Appelée (depuis n'importe quel étage) quand une image est terminée ou en échec
+    void (*onDone)(const t_pipeline_job *job, void *user);
+    void *user;
+} t_pipeline_config;
+
+// Configuration par défaut : 1 lecteur, un thread de calcul par cœur, 1 écrivain, 512 Mo
+void pipeline_defaultConfig(t_pipeline_config *config);
+
+// Traite les nbJobs images ; renvoie le nombre d'échecs, ou -1 si le pipeline n'a pas pu démarrer
+int pipeline_run(const t_pipeline_config *config, const t_chain *chain, t_pipeline_job *jobs, int nbJobs);
+
+#endif // PIPELINE_H
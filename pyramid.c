@@ -0,0 +1,445 @@
+/*
+* Fichier : pyramid.c
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Implémente les pyramides : calcul des dimensions et du bloc commun, réduction d'un niveau (flou
+ *           vertical 1 4 6 4 1 par le noyau blur5Column sur les seules lignes conservées, puis flou horizontal
+ *           limité aux colonnes paires), expansion pour les niveaux laplaciens, découpage en tranches de lignes.
+ */
+
+#include "pyramid.h"
+#include "kernels.h"
+#include "threadpool.h"
+#include "bmp_size.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Lignes source et produites d'une réduction, partagées par ses tranches
+typedef struct {
+    const t_kernels *k;
+    const uint8_t *const *src;
+    int srcWidth;
+    int srcHeight;
+    uint8_t *const *dst;
+    int dstWidth;
+    int channels;
+} t_reduction;
+
+// Niveau grossier et niveau fin d'une expansion, partagés par ses tranches
+typedef struct {
+    const t_pyramid_level *src;
+    t_pyramid_level *dst;
+    int channels;
+} t_etage;
+
+static void *allouer_aligne(size_t size) {
+#ifdef _WIN32
+    return _aligned_malloc(size, PYRAMID_ALIGN);
+#else
+    void *p = NULL;
+    if (posix_memalign(&p, PYRAMID_ALIGN, size) != 0) {
+        return NULL;
+    }
+    return p;
+#endif
+}
+
+static void liberer_aligne(void *p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+static int borner(int v, int max) {
+    return v < 0 ? 0 : (v > max ? max : v);
+}
+
+// --- Réduction ---
+
+// Flou horizontal 1 4 6 4 1 d'une ligne déjà floutée verticalement, aux seules colonnes paires ; la somme
+// des poids des deux passes vaut 256
+static void decimer_ligne(uint8_t *dst, const uint16_t *t, int srcWidth, int dstWidth, int ch) {
+    int dernier = srcWidth - 1;
+    for (int x = 0; x < dstWidth; x++) {
+        int cx = 2 * x;
+        uint8_t *o = dst + (size_t)x * ch;
+        if (cx >= 2 && cx + 2 <= dernier) {
+            const uint16_t *q = t + (size_t)(cx - 2) * ch;
+            for (int c = 0; c < ch; c++) {
+                uint32_t sum = (uint32_t)q[c] + q[4 * ch + c] + 4u * (q[ch + c] + q[3 * ch + c]) + 6u * q[2 * ch + c];
+                o[c] = (uint8_t)((sum + 128) >> 8);
+            }
+        } else {
+            const uint16_t *a = t + (size_t)borner(cx - 2, dernier) * ch;
+            const uint16_t *b = t + (size_t)borner(cx - 1, dernier) * ch;
+            const uint16_t *m = t + (size_t)cx * ch;
+            const uint16_t *d = t + (size_t)borner(cx + 1, dernier) * ch;
+            const uint16_t *e = t + (size_t)borner(cx + 2, dernier) * ch;
+            for (int c = 0; c < ch; c++) {
+                uint32_t sum = (uint32_t)a[c] + e[c] + 4u * (b[c] + d[c]) + 6u * m[c];
+                o[c] = (uint8_t)((sum + 128) >> 8);
+            }
+        }
+    }
+}
+
+// Lignes [debut, fin) de l'image réduite
+static int reduire_tranche(void *arg, int debut, int fin) {
+    const t_reduction *r = arg;
+    size_t octets = (size_t)r->srcWidth * r->channels;
+    uint16_t *flou = malloc(octets * sizeof(uint16_t));
+    if (flou == NULL) {
+        return BMP_ERR_MEMORY;
+    }
+
+    const uint8_t *lignes[5];
+    for (int y = debut; y < fin; y++) {
+        for (int k = 0; k < 5; k++) {
+            lignes[k] = r->src[borner(2 * y + k - 2, r->srcHeight - 1)];
+        }
+        r->k->blur5Column(flou, lignes, 0, octets);
+        decimer_ligne(r->dst[y], flou, r->srcWidth, r->dstWidth, r->channels);
+    }
+
+    free(flou);
+    return BMP_OK;
+}
+
+// Réduction de lignes d'octets entrelacés (channels octets par pixel) vers (w + 1) / 2 x (h + 1) / 2 pixels
+static t_bmp_status reduire(const uint8_t *const *src, int width, int height, uint8_t *const *dst, int channels,
+                            int threads) {
+    t_reduction r = { kernels_get(), src, width, height, dst, (width + 1) / 2, channels };
+    int lignes = (height + 1) / 2;
+    int n = threadpool_threadsFor(threads, (size_t)r.dstWidth * channels * (size_t)lignes);
+    return (t_bmp_status)threadpool_split(n, lignes, reduire_tranche, &r);
+}
+
+// --- Expansion (niveaux laplaciens) ---
+
+// Ligne y du niveau fin reconstruite depuis le niveau grossier src, multipliée par 64 :
+// poids 1 6 1 sur les positions paires, 4 4 sur les impaires, dans chaque dimension
+static void etendre_ligne(uint32_t *dst, uint16_t *col, const t_pyramid_level *src, int y, int width, int ch) {
+    int i = y / 2, dernier = src->height - 1;
+    size_t octets = (size_t)src->width * ch;
+    const uint8_t *a, *b, *c = NULL;
+    if (y % 2 == 0) {
+        a = src->pixels + (size_t)borner(i - 1, dernier) * src->stride;
+        b = src->pixels + (size_t)i * src->stride;
+        c = src->pixels + (size_t)borner(i + 1, dernier) * src->stride;
+        for (size_t n = 0; n < octets; n++) {
+            col[n] = (uint16_t)(a[n] + 6 * b[n] + c[n]);
+        }
+    } else {
+        a = src->pixels + (size_t)i * src->stride;
+        b = src->pixels + (size_t)borner(i + 1, dernier) * src->stride;
+        for (size_t n = 0; n < octets; n++) {
+            col[n] = (uint16_t)(4 * (a[n] + b[n]));
+        }
+    }
+
+    int max = src->width - 1;
+    for (int x = 0; x < width; x++) {
+        int j = x / 2;
+        uint32_t *o = dst + (size_t)x * ch;
+        const uint16_t *m = col + (size_t)j * ch;
+        const uint16_t *d = col + (size_t)borner(j + 1, max) * ch;
+        if (x % 2 == 0) {
+            const uint16_t *g = col + (size_t)borner(j - 1, max) * ch;
+            for (int k = 0; k < ch; k++) {
+                o[k] = (uint32_t)g[k] + 6u * m[k] + d[k];
+            }
+        } else {
+            for (int k = 0; k < ch; k++) {
+                o[k] = 4u * ((uint32_t)m[k] + d[k]);
+            }
+        }
+    }
+}
+
+// Lignes [debut, fin) du niveau laplacien de dst (niveau fin), src étant le niveau grossier suivant
+static int laplacien_tranche(void *arg, int debut, int fin) {
+    const t_etage *e = arg;
+    t_pyramid_level *niv = e->dst;
+    size_t octets = (size_t)niv->width * e->channels;
+    uint16_t *col = malloc((size_t)e->src->width * e->channels * sizeof(uint16_t));
+    uint32_t *etendue = malloc(octets * sizeof(uint32_t));
+    if (col == NULL || etendue == NULL) {
+        free(col);
+        free(etendue);
+        return BMP_ERR_MEMORY;
+    }
+
+    for (int y = debut; y < fin; y++) {
+        etendre_ligne(etendue, col, e->src, y, niv->width, e->channels);
+        const uint8_t *g = niv->pixels + (size_t)y * niv->stride;
+        int16_t *l = niv->laplacian + (size_t)y * niv->laplacianStride;
+        for (size_t n = 0; n < octets; n++) {
+            l[n] = (int16_t)(g[n] - (int)((etendue[n] + 32) >> 6));
+        }
+    }
+
+    free(col);
+    free(etendue);
+    return BMP_OK;
+}
+
+// --- Construction ---
+
+// Dimensions des niveaux et bloc commun ; seul le niveau 0 reste à remplir
+static t_pyramid *allouer_pyramide(int width, int height, int channels, int maxLevels, t_bmp_status *status) {
+    if (maxLevels <= 0 || maxLevels > PYRAMID_MAX_LEVELS) {
+        maxLevels = PYRAMID_MAX_LEVELS;
+    }
+    t_pyramid *p = calloc(1, sizeof(t_pyramid));
+    if (p == NULL) {
+        bmp_setStatus(status, BMP_ERR_MEMORY);
+        return NULL;
+    }
+    p->channels = channels;
+
+    size_t total = 0;
+    int w = width, h = height;
+    while (p->count < maxLevels) {
+        t_pyramid_level *niv = &p->levels[p->count++];
+        size_t octets, taille;
+        niv->width = w;
+        niv->height = h;
+        if (!bmp_mulSize((size_t)w, (size_t)channels, &octets) ||
+            !bmp_addSize(octets, PYRAMID_ALIGN - 1, &niv->stride)) {
+            free(p);
+            bmp_setStatus(status, BMP_ERR_TOO_LARGE);
+            return NULL;
+        }
+        niv->stride -= niv->stride % PYRAMID_ALIGN;
+        if (!bmp_mulSize(niv->stride, (size_t)h, &taille) || !bmp_addSize(total, taille, &total)) {
+            free(p);
+            bmp_setStatus(status, BMP_ERR_TOO_LARGE);
+            return NULL;
+        }
+        if (w == 1 && h == 1) {
+            break;
+        }
+        w = (w + 1) / 2;
+        h = (h + 1) / 2;
+    }
+
+    p->block = allouer_aligne(total);
+    if (p->block == NULL) {
+        free(p);
+        bmp_setStatus(status, BMP_ERR_MEMORY);
+        return NULL;
+    }
+    uint8_t *curseur = p->block;
+    for (int k = 0; k < p->count; k++) {
+        p->levels[k].pixels = curseur;
+        curseur += p->levels[k].stride * (size_t)p->levels[k].height;
+    }
+    return p;
+}
+
+// Niveaux 1 à count - 1, chacun depuis le précédent
+static t_bmp_status reduire_niveaux(t_pyramid *p, int threads) {
+    if (p->count < 2) {
+        return BMP_OK;
+    }
+    // Pointeurs de lignes des deux niveaux en cours, le niveau 1 étant le plus haut des niveaux produits
+    const uint8_t **src = malloc((size_t)p->levels[0].height * sizeof(uint8_t *));
+    uint8_t **dst = malloc((size_t)p->levels[1].height * sizeof(uint8_t *));
+    if (src == NULL || dst == NULL) {
+        free(src);
+        free(dst);
+        return BMP_ERR_MEMORY;
+    }
+
+    t_bmp_status res = BMP_OK;
+    for (int k = 1; k < p->count && res == BMP_OK; k++) {
+        const t_pyramid_level *a = &p->levels[k - 1];
+        const t_pyramid_level *b = &p->levels[k];
+        for (int y = 0; y < a->height; y++) {
+            src[y] = a->pixels + (size_t)y * a->stride;
+        }
+        for (int y = 0; y < b->height; y++) {
+            dst[y] = b->pixels + (size_t)y * b->stride;
+        }
+        res = reduire(src, a->width, a->height, dst, p->channels, threads);
+    }
+
+    free(src);
+    free(dst);
+    return res;
+}
+
+t_pyramid *pyramid_fromBmp8(const t_bmp8 *img, int maxLevels, int threads, t_bmp_status *status) {
+    size_t rowSize;
+    if (img == NULL || img->data == NULL || img->width == 0 || img->height == 0 ||
+        img->width > INT32_MAX || img->height > INT32_MAX) {
+        bmp_setStatus(status, BMP_ERR_ARGUMENT);
+        return NULL;
+    }
+    if (!bmp_rowSize(img->width, 8, &rowSize)) {
+        bmp_setStatus(status, BMP_ERR_TOO_LARGE);
+        return NULL;
+    }
+
+    t_pyramid *p = allouer_pyramide((int)img->width, (int)img->height, 1, maxLevels, status);
+    if (p == NULL) {
+        return NULL;
+    }
+    for (unsigned int y = 0; y < img->height; y++) {
+        memcpy(p->levels[0].pixels + (size_t)y * p->levels[0].stride, img->data + (size_t)y * rowSize, img->width);
+    }
+
+    t_bmp_status res = reduire_niveaux(p, threads);
+    if (res != BMP_OK) {
+        pyramid_free(p);
+        bmp_setStatus(status, res);
+        return NULL;
+    }
+    bmp_setStatus(status, BMP_OK);
+    return p;
+}
+
+t_pyramid *pyramid_fromBmp24(const t_bmp24 *img, int maxLevels, int threads, t_bmp_status *status) {
+    if (img == NULL || img->data == NULL || img->width <= 0 || img->height <= 0) {
+        bmp_setStatus(status, BMP_ERR_ARGUMENT);
+        return NULL;
+    }
+
+    t_pyramid *p = allouer_pyramide(img->width, img->height, (int)sizeof(t_pixel), maxLevels, status);
+    if (p == NULL) {
+        return NULL;
+    }
+    for (int y = 0; y < img->height; y++) {
+        memcpy(p->levels[0].pixels + (size_t)y * p->levels[0].stride, img->data[y],
+               (size_t)img->width * sizeof(t_pixel));
+    }
+
+    t_bmp_status res = reduire_niveaux(p, threads);
+    if (res != BMP_OK) {
+        pyramid_free(p);
+        bmp_setStatus(status, res);
+        return NULL;
+    }
+    bmp_setStatus(status, BMP_OK);
+    return p;
+}
+
+t_bmp_status pyramid_buildLaplacian(t_pyramid *p, int threads) {
+    if (p == NULL) {
+        return BMP_ERR_ARGUMENT;
+    }
+    if (p->laplacianBlock != NULL || p->count < 2) {
+        return BMP_OK;
+    }
+
+    // Lignes de 16 bits alignées comme celles des niveaux (tailles déjà vérifiées à l'allocation)
+    size_t total = 0;
+    for (int k = 0; k < p->count - 1; k++) {
+        t_pyramid_level *niv = &p->levels[k];
+        size_t parLigne = PYRAMID_ALIGN / sizeof(int16_t);
+        niv->laplacianStride = ((size_t)niv->width * p->channels + parLigne - 1) / parLigne * parLigne;
+        size_t taille;
+        if (!bmp_mulSize(niv->laplacianStride * sizeof(int16_t), (size_t)niv->height, &taille) ||
+            !bmp_addSize(total, taille, &total)) {
+            return BMP_ERR_TOO_LARGE;
+        }
+    }
+    p->laplacianBlock = allouer_aligne(total);
+    if (p->laplacianBlock == NULL) {
+        return BMP_ERR_MEMORY;
+    }
+    int16_t *curseur = p->laplacianBlock;
+    for (int k = 0; k < p->count - 1; k++) {
+        p->levels[k].laplacian = curseur;
+        curseur += p->levels[k].laplacianStride * (size_t)p->levels[k].height;
+    }
+
+    t_etage e = { NULL, NULL, p->channels };
+    for (int k = 0; k < p->count - 1; k++) {
+        e.src = &p->levels[k + 1];
+        e.dst = &p->levels[k];
+        int n = threadpool_threadsFor(threads, e.dst->laplacianStride * sizeof(int16_t) * (size_t)e.dst->height);
+        int res = threadpool_split(n, e.dst->height, laplacien_tranche, &e);
+        if (res != BMP_OK) {
+            return (t_bmp_status)res;
+        }
+    }
+    return BMP_OK;
+}
+
+t_bmp24 *pyramid_reduceBmp24(const t_bmp24 *img, int threads, t_bmp_status *status) {
+    if (img == NULL || img->data == NULL || img->width <= 0 || img->height <= 0) {
+        bmp_setStatus(status, BMP_ERR_ARGUMENT);
+        return NULL;
+    }
+    int width = (img->width + 1) / 2, height = (img->height + 1) / 2;
+    t_bmp24 *out = bmp24_allocate(width, height, img->colorDepth);
+    const uint8_t **src = malloc((size_t)img->height * sizeof(uint8_t *));
+    uint8_t **dst = malloc((size_t)height * sizeof(uint8_t *));
+    if (out == NULL || src == NULL || dst == NULL) {
+        bmp24_free(out);
+        free(src);
+        free(dst);
+        bmp_setStatus(status, BMP_ERR_MEMORY);
+        return NULL;
+    }
+    out->header_info.compression = img->header_info.compression;
+
+    for (int y = 0; y < img->height; y++) {
+        src[y] = (const uint8_t *)img->data[y];
+    }
+    for (int y = 0; y < height; y++) {
+        dst[y] = (uint8_t *)out->data[y];
+    }
+    t_bmp_status res = reduire(src, img->width, img->height, dst, (int)sizeof(t_pixel), threads);
+    free(src);
+    free(dst);
+    if (res != BMP_OK) {
+        bmp24_free(out);
+        out = NULL;
+    }
+    bmp_setStatus(status, res);
+    return out;
+}
+
+// --- Export des niveaux ---
+
+t_bmp8 *pyramid_levelToBmp8(const t_pyramid *p, int level, const t_bmp8 *model) {
+    if (p == NULL || model == NULL || p->channels != 1 || level < 0 || level >= p->count) {
+        return NULL;
+    }
+    const t_pyramid_level *niv = &p->levels[level];
+    t_bmp8 *img = bmp8_allocateLike(model, (unsigned int)niv->width, (unsigned int)niv->height);
+    if (img == NULL) {
+        return NULL;
+    }
+    size_t rowSize = img->dataSize / img->height;
+    for (int y = 0; y < niv->height; y++) {
+        memcpy(img->data + (size_t)y * rowSize, niv->pixels + (size_t)y * niv->stride, (size_t)niv->width);
+    }
+    return img;
+}
+
+t_bmp24 *pyramid_levelToBmp24(const t_pyramid *p, int level, int colorDepth) {
+    if (p == NULL || p->channels != (int)sizeof(t_pixel) || level < 0 || level >= p->count) {
+        return NULL;
+    }
+    const t_pyramid_level *niv = &p->levels[level];
+    t_bmp24 *img = bmp24_allocate(niv->width, niv->height, colorDepth);
+    if (img == NULL) {
+        return NULL;
+    }
+    for (int y = 0; y < niv->height; y++) {
+        memcpy(img->data[y], niv->pixels + (size_t)y * niv->stride, (size_t)niv->width * sizeof(t_pixel));
+    }
+    return img;
+}
+
+void pyramid_free(t_pyramid *p) {
+    if (p != NULL) {
+        liberer_aligne(p->block);
+        liberer_aligne(p->laplacianBlock);
+        free(p);
+    }
+}
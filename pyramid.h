@@ -0,0 +1,62 @@
+/*
+* Fichier : pyramid.h
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Pyramides gaussiennes et laplaciennes des images 8 et 24/32 bits, pour l'analyse multi-échelle
+ *           et les aperçus zoomables. Chaque niveau est obtenu à partir du précédent par un flou binomial
+ *           5x5 (1 4 6 4 1) fusionné avec la décimation par 2 : seules les lignes et colonnes conservées
+ *           sont calculées, si bien qu'un niveau coûte environ le quart du précédent. Tous les niveaux
+ *           partagent un unique bloc aligné ; les lignes de chaque niveau sont réparties sur plusieurs threads.
+ */
+
+#ifndef PYRAMID_H
+#define PYRAMID_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "bmp8.h"
+#include "bmp24.h"
+
+#define PYRAMID_ALIGN 64
+#define PYRAMID_MAX_LEVELS 32
+
+// Niveau k : pixels + y * stride pointe sur la ligne y (width * channels octets entrelacés utiles)
+typedef struct {
+    int width;
+    int height;
+    size_t stride;              // octets entre deux lignes (multiple de PYRAMID_ALIGN)
+    uint8_t *pixels;            // dans le bloc commun de la pyramide
+    size_t laplacianStride;     // éléments entre deux lignes de laplacian
+    int16_t *laplacian;         // G(k) - expand(G(k+1)) ; NULL avant pyramid_buildLaplacian et au dernier niveau
+} t_pyramid_level;
+
+// Les lignes sont rangées dans l'ordre des données de l'image source (ordre du fichier pour t_bmp8)
+typedef struct {
+    int channels;               // 1 (t_bmp8) ou sizeof(t_pixel) (t_bmp24 ; l'alpha est filtré comme le reste)
+    int count;                  // nombre de niveaux, le niveau 0 étant une copie de l'image
+    t_pyramid_level levels[PYRAMID_MAX_LEVELS];
+    uint8_t *block;
+    int16_t *laplacianBlock;
+} t_pyramid;
+
+// Pyramide gaussienne : chaque niveau fait (w + 1) / 2 x (h + 1) / 2 pixels, jusqu'à 1 x 1 ou maxLevels niveaux
+// (maxLevels <= 0 : sans limite). Bords par répétition du dernier pixel. threads <= 0 : nombre de cœurs.
+// Renvoie NULL en cas d'échec, avec la cause dans *status (optionnel).
+t_pyramid *pyramid_fromBmp8(const t_bmp8 *img, int maxLevels, int threads, t_bmp_status *status);
+t_pyramid *pyramid_fromBmp24(const t_bmp24 *img, int maxLevels, int threads, t_bmp_status *status);
+
+// Ajoute les niveaux laplaciens (un second bloc, en entiers signés de 16 bits) : l'expansion de G(k+1)
+// (poids 1 6 1 / 8 et 4 4 / 8 par dimension) ajoutée à laplacian redonne exactement G(k)
+t_bmp_status pyramid_buildLaplacian(t_pyramid *p, int threads);
+
+// Niveau suivant seul, (w + 1) / 2 x (h + 1) / 2 pixels, par la même réduction que les pyramides : pour
+// descendre niveau par niveau sans garder toute la pyramide en mémoire (voir dzi.h)
+t_bmp24 *pyramid_reduceBmp24(const t_bmp24 *img, int threads, t_bmp_status *status);
+
+// Copie d'un niveau dans une nouvelle image : en-tête et palette de model pour le 8 bits, profondeur 24 ou 32
+// pour le 24 bits. NULL si le niveau ou le nombre de canaux ne correspond pas, ou en cas de mémoire insuffisante.
+t_bmp8 *pyramid_levelToBmp8(const t_pyramid *p, int level, const t_bmp8 *model);
+t_bmp24 *pyramid_levelToBmp24(const t_pyramid *p, int level, int colorDepth);
+
+void pyramid_free(t_pyramid *p);
+
+#endif // PYRAMID_H
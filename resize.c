@@ -0,0 +1,382 @@
+/*
+* Fichier : resize.c
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Implémente le redimensionnement : calcul des tables de poids (double précision puis virgule
+ *           fixe de somme exacte), passe horizontale vers une image intermédiaire de largeur finale, passe
+ *           verticale vers l'image de sortie, chaque passe découpée en bandes de lignes (pthreads).
+ */
+
+#include "resize.h"
+#include "kernels.h"
+#include "threadpool.h"
+#include "bmp_size.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#define PI 3.14159265358979323846
+
+static const char *noms_filtres[] = { "bilinear", "bicubic", "lanczos" };
+
+// Table de poids d'une passe : pour la sortie i, taps poids appliqués aux échantillons starts[i] ...
+typedef struct {
+    int taps;
+    int32_t *starts;
+    int16_t *weights;       // dstLen * taps, en virgule fixe (somme 1 << KERNEL_RESAMPLE_BITS par sortie)
+} t_poids;
+
+// Paramètres d'une passe, partagés par les bandes de lignes (une par thread)
+typedef struct {
+    const t_kernels *k;
+    const uint8_t *const *src;
+    uint8_t *const *dst;
+    int srcWidth;
+    int dstWidth;
+    int channels;
+    const t_poids *poids;
+} t_passe;
+
+static double rayon_filtre(t_resize_filter filter) {
+    switch (filter) {
+        case RESIZE_BILINEAR: return 1.0;
+        case RESIZE_BICUBIC:  return 2.0;
+        default:              return 3.0;
+    }
+}
+
+static double sinc(double x) {
+    if (x == 0.0) {
+        return 1.0;
+    }
+    x *= PI;
+    return sin(x) / x;
+}
+
+static double evaluer_filtre(t_resize_filter filter, double x) {
+    x = fabs(x);
+    switch (filter) {
+        case RESIZE_BILINEAR:
+            return x < 1.0 ? 1.0 - x : 0.0;
+        case RESIZE_BICUBIC: {
+            const double a = -0.5;
+            if (x < 1.0) {
+                return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+            }
+            if (x < 2.0) {
+                return (((x - 5.0) * x + 8.0) * x - 4.0) * a;
+            }
+            return 0.0;
+        }
+        default:
+            return x < 3.0 ? sinc(x) * sinc(x / 3.0) : 0.0;
+    }
+}
+
+static void liberer_poids(t_poids *p) {
+    free(p->starts);
+    free(p->weights);
+    p->starts = NULL;
+    p->weights = NULL;
+}
+
+// Poids de srcLen échantillons vers dstLen : fenêtre centrée sur (i + 0.5) * srcLen / dstLen, coupée
+// aux bords puis renormalisée. La fenêtre est recalée pour que starts[i] + taps ne dépasse jamais srcLen.
+static t_bmp_status calculer_poids(int srcLen, int dstLen, t_resize_filter filter, t_poids *p) {
+    double echelle = (double)srcLen / dstLen;
+    double etirement = echelle > 1.0 ? echelle : 1.0;
+    double rayon = rayon_filtre(filter) * etirement;
+    int taps = (int)ceil(rayon) * 2 + 1;
+    if (taps > srcLen) {
+        taps = srcLen;
+    }
+
+    p->taps = taps;
+    p->starts = malloc((size_t)dstLen * sizeof(int32_t));
+    p->weights = calloc((size_t)dstLen * taps, sizeof(int16_t));
+    double *w = malloc((size_t)taps * sizeof(double));
+    if (p->starts == NULL || p->weights == NULL || w == NULL) {
+        free(w);
+        liberer_poids(p);
+        return BMP_ERR_MEMORY;
+    }
+
+    const int un = 1 << KERNEL_RESAMPLE_BITS;
+    for (int i = 0; i < dstLen; i++) {
+        double centre = (i + 0.5) * echelle;
+        int xmin = (int)floor(centre - rayon + 0.5);
+        int xmax = (int)floor(centre + rayon + 0.5);
+        if (xmin < 0) xmin = 0;
+        if (xmax > srcLen) xmax = srcLen;
+        if (xmax - xmin > taps) xmax = xmin + taps;
+
+        int n = xmax - xmin;
+        double total = 0.0;
+        int plusFort = 0;
+        for (int k = 0; k < n; k++) {
+            w[k] = evaluer_filtre(filter, (xmin + k + 0.5 - centre) / etirement);
+            total += w[k];
+            if (w[k] > w[plusFort]) {
+                plusFort = k;
+            }
+        }
+
+        int debut = xmin;
+        if (debut + taps > srcLen) {
+            debut = srcLen - taps;
+        }
+        p->starts[i] = debut;
+
+        // Quantification, puis l'écart d'arrondi est reporté sur le poids le plus fort : une zone
+        // uniforme reste exactement uniforme
+        int16_t *q = p->weights + (size_t)i * taps + (xmin - debut);
+        int somme = 0;
+        for (int k = 0; k < n; k++) {
+            q[k] = (int16_t)lround(total != 0.0 ? w[k] / total * un : (k == plusFort ? un : 0));
+            somme += q[k];
+        }
+        q[plusFort] = (int16_t)(q[plusFort] + un - somme);
+    }
+
+    free(w);
+    return BMP_OK;
+}
+
+// Bande [debut, fin) d'une passe (voir threadpool_split)
+static int passe_horizontale(void *arg, int debut, int fin) {
+    const t_passe *b = arg;
+    const t_poids *p = b->poids;
+    size_t octets = (size_t)b->srcWidth * b->channels;
+
+    // Copie de la ligne source suivie d'une marge : les noyaux lisent chaque pixel sur 4 octets
+    uint8_t *ligne = malloc(octets + KERNEL_RESAMPLE_PADDING);
+    if (ligne == NULL) {
+        return BMP_ERR_MEMORY;
+    }
+    memset(ligne + octets, 0, KERNEL_RESAMPLE_PADDING);
+
+    for (int y = debut; y < fin; y++) {
+        memcpy(ligne, b->src[y], octets);
+        b->k->resampleRow(b->dst[y], ligne, b->dstWidth, b->channels, p->starts, p->weights, p->taps);
+    }
+
+    free(ligne);
+    return BMP_OK;
+}
+
+static int passe_verticale(void *arg, int debut, int fin) {
+    const t_passe *b = arg;
+    const t_poids *p = b->poids;
+    size_t octets = (size_t)b->dstWidth * b->channels;
+
+    const uint8_t **lignes = malloc((size_t)p->taps * sizeof(uint8_t *));
+    if (lignes == NULL) {
+        return BMP_ERR_MEMORY;
+    }
+
+    for (int y = debut; y < fin; y++) {
+        for (int k = 0; k < p->taps; k++) {
+            lignes[k] = b->src[p->starts[y] + k];
+        }
+        b->k->resampleColumn(b->dst[y], lignes, 0, octets, p->weights + (size_t)y * p->taps, p->taps);
+    }
+
+    free(lignes);
+    return BMP_OK;
+}
+
+// Redimensionnement de lignes d'octets entrelacés (channels octets par pixel)
+static t_bmp_status redimensionner(const uint8_t *const *src, int srcWidth, int srcHeight, uint8_t *const *dst,
+                                   int dstWidth, int dstHeight, int channels, t_resize_filter filter,
+                                   int threads) {
+    size_t octets = (size_t)dstWidth * channels;
+    if (srcWidth == dstWidth && srcHeight == dstHeight) {
+        for (int y = 0; y < dstHeight; y++) {
+            memcpy(dst[y], src[y], octets);
+        }
+        return BMP_OK;
+    }
+
+    size_t total;
+    if (!bmp_mulSize(octets, (size_t)dstHeight, &total)) {
+        return BMP_ERR_TOO_LARGE;
+    }
+    threads = threadpool_threadsFor(threads, total);
+
+    t_poids px = { 0, NULL, NULL };
+    t_poids py = { 0, NULL, NULL };
+    uint8_t *intermediaire = NULL;
+    uint8_t **lignesInter = NULL;
+    const uint8_t *const *entree = src;     // source de la passe verticale
+    t_bmp_status res = BMP_OK;
+
+    if (srcWidth != dstWidth) {
+        uint8_t *const *sortie = dst;
+        if (srcHeight != dstHeight) {
+            // Image intermédiaire : hauteur source, largeur finale
+            size_t taille;
+            if (!bmp_mulSize(octets, (size_t)srcHeight, &taille)) {
+                return BMP_ERR_TOO_LARGE;
+            }
+            intermediaire = malloc(taille);
+            lignesInter = malloc((size_t)srcHeight * sizeof(uint8_t *));
+            if (intermediaire == NULL || lignesInter == NULL) {
+                free(intermediaire);
+                free(lignesInter);
+                return BMP_ERR_MEMORY;
+            }
+            for (int y = 0; y < srcHeight; y++) {
+                lignesInter[y] = intermediaire + (size_t)y * octets;
+            }
+            sortie = lignesInter;
+            entree = (const uint8_t *const *)lignesInter;
+        }
+
+        res = calculer_poids(srcWidth, dstWidth, filter, &px);
+        if (res == BMP_OK) {
+            t_passe b = { kernels_get(), src, sortie, srcWidth, dstWidth, channels, &px };
+            res = (t_bmp_status)threadpool_split(threads, srcHeight, passe_horizontale, &b);
+        }
+    }
+
+    if (res == BMP_OK && srcHeight != dstHeight) {
+        res = calculer_poids(srcHeight, dstHeight, filter, &py);
+        if (res == BMP_OK) {
+            t_passe b = { kernels_get(), entree, dst, dstWidth, dstWidth, channels, &py };
+            res = (t_bmp_status)threadpool_split(threads, dstHeight, passe_verticale, &b);
+        }
+    }
+
+    liberer_poids(&px);
+    liberer_poids(&py);
+    free(intermediaire);
+    free(lignesInter);
+    return res;
+}
+
+static bool filtre_valide(t_resize_filter filter) {
+    return filter == RESIZE_BILINEAR || filter == RESIZE_BICUBIC || filter == RESIZE_LANCZOS3;
+}
+
+t_bmp24 *resize_bmp24(const t_bmp24 *src, int width, int height, t_resize_filter filter, int threads,
+                      t_bmp_status *status) {
+    if (src == NULL || src->data == NULL || width <= 0 || height <= 0 || !filtre_valide(filter)) {
+        bmp_setStatus(status, BMP_ERR_ARGUMENT);
+        return NULL;
+    }
+
+    t_bmp24 *dst = bmp24_allocate(width, height, src->colorDepth);
+    const uint8_t **lignesSrc = malloc((size_t)src->height * sizeof(uint8_t *));
+    uint8_t **lignesDst = malloc((size_t)height * sizeof(uint8_t *));
+    if (dst == NULL || lignesSrc == NULL || lignesDst == NULL) {
+        bmp_setStatus(status, BMP_ERR_MEMORY);
+        bmp24_free(dst);
+        free(lignesSrc);
+        free(lignesDst);
+        return NULL;
+    }
+    dst->header = src->header;
+    dst->header_info = src->header_info;
+    dst->header_info.width = width;
+    dst->header_info.height = src->header_info.height < 0 ? -height : height;
+
+    for (int y = 0; y < src->height; y++) {
+        lignesSrc[y] = (const uint8_t *)src->data[y];
+    }
+    for (int y = 0; y < height; y++) {
+        lignesDst[y] = (uint8_t *)dst->data[y];
+    }
+
+    // Tous les octets d'un t_pixel sont rééchantillonnés, alpha compris en mode 32 bits
+    t_bmp_status res = redimensionner(lignesSrc, src->width, src->height, lignesDst, width, height,
+                                      (int)sizeof(t_pixel), filter, threads);
+    free(lignesSrc);
+    free(lignesDst);
+    if (res != BMP_OK) {
+        bmp_setStatus(status, res);
+        bmp24_free(dst);
+        return NULL;
+    }
+    bmp_setStatus(status, BMP_OK);
+    return dst;
+}
+
+t_bmp8 *resize_bmp8(const t_bmp8 *src, int width, int height, t_resize_filter filter, int threads,
+                    t_bmp_status *status) {
+    if (src == NULL || src->data == NULL || width <= 0 || height <= 0 || !filtre_valide(filter)) {
+        bmp_setStatus(status, BMP_ERR_ARGUMENT);
+        return NULL;
+    }
+
+    // Lignes dans l'ordre du fichier : le rééchantillonnage est symétrique, l'orientation est conservée
+    t_bmp8 *dst = bmp8_allocateLike(src, (unsigned int)width, (unsigned int)height);
+    const uint8_t **lignesSrc = malloc((size_t)src->height * sizeof(uint8_t *));
+    uint8_t **lignesDst = malloc((size_t)height * sizeof(uint8_t *));
+    if (dst == NULL || lignesSrc == NULL || lignesDst == NULL) {
+        bmp_setStatus(status, dst == NULL ? BMP_ERR_TOO_LARGE : BMP_ERR_MEMORY);
+        bmp8_free(dst);
+        free(lignesSrc);
+        free(lignesDst);
+        return NULL;
+    }
+
+    size_t srcRow = src->dataSize / src->height;
+    size_t dstRow = dst->dataSize / dst->height;
+    for (unsigned int y = 0; y < src->height; y++) {
+        lignesSrc[y] = src->data + (size_t)y * srcRow;
+    }
+    for (int y = 0; y < height; y++) {
+        lignesDst[y] = dst->data + (size_t)y * dstRow;
+    }
+
+    t_bmp_status res = redimensionner(lignesSrc, (int)src->width, (int)src->height, lignesDst, width, height, 1,
+                                      filter, threads);
+    free(lignesSrc);
+    free(lignesDst);
+    if (res != BMP_OK) {
+        bmp_setStatus(status, res);
+        bmp8_free(dst);
+        return NULL;
+    }
+    bmp_setStatus(status, BMP_OK);
+    return dst;
+}
+
+t_bmp_status resize_image(t_image *img, int width, int height, t_resize_filter filter, int threads) {
+    if (img == NULL || img->type == IMAGE_NONE) {
+        return BMP_ERR_ARGUMENT;
+    }
+
+    t_bmp_status res;
+    if (img->type == IMAGE_BMP8) {
+        t_bmp8 *nouvelle = resize_bmp8(img->bmp8, width, height, filter, threads, &res);
+        if (nouvelle != NULL) {
+            bmp8_free(img->bmp8);
+            img->bmp8 = nouvelle;
+        }
+    } else {
+        t_bmp24 *nouvelle = resize_bmp24(img->bmp24, width, height, filter, threads, &res);
+        if (nouvelle != NULL) {
+            bmp24_free(img->bmp24);
+            img->bmp24 = nouvelle;
+        }
+    }
+    return res;
+}
+
+int resize_parseFilter(const char *name, t_resize_filter *filter) {
+    if (name == NULL) {
+        return -1;
+    }
+    for (int i = 0; i < 3; i++) {
+        if (strcmp(name, noms_filtres[i]) == 0) {
+            *filter = (t_resize_filter)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char *resize_filterName(t_resize_filter filter) {
+    return filtre_valide(filter) ? noms_filtres[filter] : "?";
+}
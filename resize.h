@@ -0,0 +1,39 @@
+/*
+* Fichier : resize.h
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Redimensionnement des images 8 et 24/32 bits (bilinéaire, bicubique, Lanczos3). Deux passes
+ *           séparables, horizontale puis verticale, avec des tables de poids précalculées par colonne et
+ *           par ligne de sortie, en virgule fixe : les noyaux resampleRow / resampleColumn de kernels.h
+ *           donnent les mêmes octets à tous les niveaux SIMD. Chaque passe est découpée en bandes de
+ *           lignes réparties sur plusieurs threads.
+ */
+
+#ifndef RESIZE_H
+#define RESIZE_H
+
+#include "bmp_io.h"
+
+typedef enum {
+    RESIZE_BILINEAR = 0,    // bilinear : triangle, rayon 1
+    RESIZE_BICUBIC,         // bicubic  : cubique de Keys (a = -0.5), rayon 2
+    RESIZE_LANCZOS3         // lanczos  : sinc fenêtré, rayon 3
+} t_resize_filter;
+
+// Nouvelle image de width x height pixels, src étant inchangée. En réduction, le noyau est élargi
+// du rapport de réduction (chaque pixel de sortie couvre toute sa zone source). threads <= 0 : nombre
+// de cœurs. Renvoie NULL en cas d'échec, avec la cause dans *status (optionnel).
+t_bmp24 *resize_bmp24(const t_bmp24 *src, int width, int height, t_resize_filter filter, int threads,
+                      t_bmp_status *status);
+t_bmp8 *resize_bmp8(const t_bmp8 *src, int width, int height, t_resize_filter filter, int threads,
+                    t_bmp_status *status);
+
+// Remplace l'image de img par sa version redimensionnée (même type) ; img est inchangée en cas d'échec
+t_bmp_status resize_image(t_image *img, int width, int height, t_resize_filter filter, int threads);
+
+// Filtre d'après son nom ("bilinear", "bicubic", "lanczos") ; renvoie 0 si succès, -1 sinon
+int resize_parseFilter(const char *name, t_resize_filter *filter);
+
+// Nom d'un filtre
+const char *resize_filterName(t_resize_filter filter);
+
+#endif // RESIZE_H
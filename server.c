@@ -0,0 +1,467 @@
+/*
+* Fichier : server.c
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Implémente le mode serveur. Un thread par connexion lit les requêtes et les soumet au pool ;
+ *           chaque thread du pool garde son t_chain_scratch et répond directement sur la connexion.
+ *           Disponible uniquement sur les systèmes POSIX (sockets Unix).
+ */
+
+#include "server.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#ifndef _WIN32
+
+#include "bmp_io.h"
+#include "chain.h"
+#include "threadpool.h"
+#include <ctype.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+typedef struct s_server t_server;
+
+// Connexion cliente (ou entrée/sortie standard)
+typedef struct s_connection {
+    t_server *server;
+    int in;
+    int out;
+    pthread_mutex_t lock;       // écritures sur out et compteur pending
+    pthread_cond_t idle;
+    int pending;                // requêtes soumises sans réponse
+    struct s_connection *next;  // liste des connexions actives du serveur
+} t_connection;
+
+struct s_server {
+    t_threadpool *pool;
+    t_chain_scratch *scratch;   // un par thread du pool
+    int listenFd;
+    pthread_mutex_t lock;       // stop, connexions
+    pthread_cond_t noConnection;
+    int stop;
+    t_connection *connections;
+};
+
+// Une requête en cours
+typedef struct {
+    t_connection *conn;
+    long number;
+    char *input;
+    char *output;
+    char *chain;
+} t_request;
+
+static double maintenant_ms(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// Écriture complète d'une ligne de réponse, sérialisée par connexion
+static void repondre(t_connection *conn, const char *format, ...) {
+    char ligne[256];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(ligne, sizeof(ligne), format, args);
+    va_end(args);
+    if (n < 0) {
+        return;
+    }
+    if ((size_t)n >= sizeof(ligne)) {
+        n = sizeof(ligne) - 1;
+    }
+
+    pthread_mutex_lock(&conn->lock);
+    for (int ecrit = 0; ecrit < n;) {
+        ssize_t r = write(conn->out, ligne + ecrit, n - ecrit);
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r <= 0) {
+            break;      // client parti : la réponse est perdue
+        }
+        ecrit += (int)r;
+    }
+    pthread_mutex_unlock(&conn->lock);
+}
+
+// Exécution d'une requête par un thread du pool
+static void executer(void *arg, int worker) {
+    t_request *req = arg;
+    t_connection *conn = req->conn;
+    double debut = maintenant_ms();
+    const char *erreur = NULL;
+    t_bmp_status status = BMP_OK;
+    char message[128];
+
+    t_chain *chain = chain_parse(req->chain, &status, message, sizeof(message));
+    t_image *img = NULL;
+    if (chain == NULL) {
+        erreur = "chaine";
+    } else if ((img = bmp_open(req->input, &status)) == NULL) {
+        erreur = "lecture";
+    } else if ((status = chain_apply(chain, img, &conn->server->scratch[worker])) != BMP_OK) {
+        erreur = "filtres";
+    } else if ((status = bmp_save(req->output, img)) != BMP_OK) {
+        erreur = "ecriture";
+    }
+    bmp_close(img);
+    chain_free(chain);
+
+    if (erreur == NULL) {
+        repondre(conn, "%ld OK %.1f ms\n", req->number, maintenant_ms() - debut);
+    } else {
+        // La cause détaillée suit l'étape : message d'analyse pour une chaîne, bmp_strerror sinon
+        const char *cause = chain == NULL && message[0] != '\0' ? message : bmp_strerror(status);
+        repondre(conn, "%ld ERR %s %s\n", req->number, erreur, cause);
+    }
+
+    free(req->input);
+    free(req->output);
+    free(req->chain);
+    free(req);
+
+    pthread_mutex_lock(&conn->lock);
+    if (--conn->pending == 0) {
+        pthread_cond_broadcast(&conn->idle);
+    }
+    pthread_mutex_unlock(&conn->lock);
+}
+
+static char *copier(const char *debut, size_t n) {
+    char *s = malloc(n + 1);
+    if (s != NULL) {
+        memcpy(s, debut, n);
+        s[n] = '\0';
+    }
+    return s;
+}
+
+// Découpe "<entrée> <sortie> <chaîne...>" ; renvoie NULL si la ligne est incomplète
+static t_request *analyser_requete(const char *ligne) {
+    const char *champs[2];
+    size_t longueurs[2];
+    const char *c = ligne;
+
+    for (int i = 0; i < 2; i++) {
+        while (isspace((unsigned char)*c)) c++;
+        champs[i] = c;
+        while (*c != '\0' && !isspace((unsigned char)*c)) c++;
+        longueurs[i] = (size_t)(c - champs[i]);
+        if (longueurs[i] == 0) {
+            return NULL;
+        }
+    }
+    while (isspace((unsigned char)*c)) c++;
+    size_t reste = strlen(c);
+    while (reste > 0 && isspace((unsigned char)c[reste - 1])) reste--;
+    if (reste == 0) {
+        return NULL;
+    }
+
+    t_request *req = calloc(1, sizeof(t_request));
+    if (req == NULL) {
+        return NULL;
+    }
+    req->input = copier(champs[0], longueurs[0]);
+    req->output = copier(champs[1], longueurs[1]);
+    req->chain = copier(c, reste);
+    if (req->input == NULL || req->output == NULL || req->chain == NULL) {
+        free(req->input);
+        free(req->output);
+        free(req->chain);
+        free(req);
+        return NULL;
+    }
+    return req;
+}
+
+static void arreter_serveur(t_server *server) {
+    pthread_mutex_lock(&server->lock);
+    server->stop = 1;
+    if (server->listenFd >= 0) {
+        shutdown(server->listenFd, SHUT_RDWR);      // débloque accept
+    }
+    for (t_connection *c = server->connections; c != NULL; c = c->next) {
+        shutdown(c->in, SHUT_RD);                   // débloque les lectures des autres clients
+    }
+    pthread_mutex_unlock(&server->lock);
+}
+
+// Lit les requêtes d'une connexion jusqu'à la fin du flux, puis attend ses réponses
+static void servir(t_connection *conn) {
+    int fd = dup(conn->in);
+    FILE *flux = fd >= 0 ? fdopen(fd, "r") : NULL;
+    if (flux == NULL) {
+        if (fd >= 0) close(fd);
+        return;
+    }
+
+    char *ligne = NULL;
+    size_t capacite = 0;
+    long numero = 0;
+    while (getline(&ligne, &capacite, flux) > 0) {
+        char *debut = ligne;
+        while (isspace((unsigned char)*debut)) debut++;
+        if (*debut == '\0' || *debut == '#') {
+            continue;
+        }
+        numero++;
+
+        if (strncmp(debut, "shutdown", 8) == 0 && (debut[8] == '\0' || isspace((unsigned char)debut[8]))) {
+            repondre(conn, "%ld OK shutdown\n", numero);
+            arreter_serveur(conn->server);
+            break;
+        }
+
+        t_request *req = analyser_requete(debut);
+        if (req == NULL) {
+            repondre(conn, "%ld ERR syntaxe attendu : <entrée> <sortie> <chaîne>\n", numero);
+            continue;
+        }
+        req->conn = conn;
+        req->number = numero;
+
+        pthread_mutex_lock(&conn->lock);
+        conn->pending++;
+        pthread_mutex_unlock(&conn->lock);
+        if (threadpool_submit(conn->server->pool, executer, req) != 0) {
+            pthread_mutex_lock(&conn->lock);
+            conn->pending--;
+            pthread_mutex_unlock(&conn->lock);
+            repondre(conn, "%ld ERR memoire %s\n", numero, bmp_strerror(BMP_ERR_MEMORY));
+            free(req->input);
+            free(req->output);
+            free(req->chain);
+            free(req);
+        }
+    }
+    free(ligne);
+    fclose(flux);
+
+    // Les réponses en attente utilisent encore la connexion
+    pthread_mutex_lock(&conn->lock);
+    while (conn->pending > 0) {
+        pthread_cond_wait(&conn->idle, &conn->lock);
+    }
+    pthread_mutex_unlock(&conn->lock);
+}
+
+static t_connection *ouvrir_connexion(t_server *server, int in, int out) {
+    t_connection *conn = calloc(1, sizeof(t_connection));
+    if (conn == NULL) {
+        return NULL;
+    }
+    conn->server = server;
+    conn->in = in;
+    conn->out = out;
+    pthread_mutex_init(&conn->lock, NULL);
+    pthread_cond_init(&conn->idle, NULL);
+    return conn;
+}
+
+static void fermer_connexion(t_connection *conn) {
+    pthread_mutex_destroy(&conn->lock);
+    pthread_cond_destroy(&conn->idle);
+    free(conn);
+}
+
+// Thread d'une connexion socket : inscrite dans la liste du serveur le temps du service
+static void *thread_connexion(void *arg) {
+    t_connection *conn = arg;
+    t_server *server = conn->server;
+
+    servir(conn);
+
+    pthread_mutex_lock(&server->lock);
+    for (t_connection **c = &server->connections; *c != NULL; c = &(*c)->next) {
+        if (*c == conn) {
+            *c = conn->next;
+            break;
+        }
+    }
+    close(conn->in);
+    if (server->connections == NULL) {
+        pthread_cond_broadcast(&server->noConnection);
+    }
+    pthread_mutex_unlock(&server->lock);
+
+    fermer_connexion(conn);
+    return NULL;
+}
+
+static int ecouter(t_server *server, const char *chemin) {
+    struct sockaddr_un adresse;
+    if (strlen(chemin) >= sizeof(adresse.sun_path)) {
+        printf("Erreur : chemin de socket trop long.\n");
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        printf("Erreur : création de la socket impossible.\n");
+        return -1;
+    }
+    memset(&adresse, 0, sizeof(adresse));
+    adresse.sun_family = AF_UNIX;
+    strcpy(adresse.sun_path, chemin);
+
+    unlink(chemin);     // socket laissée par une exécution précédente
+    if (bind(fd, (struct sockaddr *)&adresse, sizeof(adresse)) != 0 || listen(fd, 16) != 0) {
+        printf("Erreur : impossible d'écouter sur %s.\n", chemin);
+        close(fd);
+        return -1;
+    }
+    printf("Serveur à l'écoute sur %s\n", chemin);
+    fflush(stdout);
+
+    server->listenFd = fd;
+    while (1) {
+        int client = accept(fd, NULL, NULL);
+        if (client < 0) {
+            if (errno == EINTR) continue;
+            break;      // arrêt demandé (shutdown de la socket) ou erreur
+        }
+
+        pthread_mutex_lock(&server->lock);
+        int stop = server->stop;
+        pthread_mutex_unlock(&server->lock);
+        t_connection *conn = stop ? NULL : ouvrir_connexion(server, client, client);
+        if (conn == NULL) {
+            close(client);
+            if (stop) break;
+            continue;
+        }
+
+        pthread_mutex_lock(&server->lock);
+        conn->next = server->connections;
+        server->connections = conn;
+        pthread_mutex_unlock(&server->lock);
+
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, thread_connexion, conn) != 0) {
+            pthread_mutex_lock(&server->lock);
+            server->connections = conn->next;
+            pthread_mutex_unlock(&server->lock);
+            close(client);
+            fermer_connexion(conn);
+            continue;
+        }
+        pthread_detach(thread);
+    }
+
+    // Attente de la fin des connexions encore ouvertes (débloquées par arreter_serveur)
+    arreter_serveur(server);
+    pthread_mutex_lock(&server->lock);
+    while (server->connections != NULL) {
+        pthread_cond_wait(&server->noConnection, &server->lock);
+    }
+    server->listenFd = -1;
+    pthread_mutex_unlock(&server->lock);
+
+    close(fd);
+    unlink(chemin);
+    return 0;
+}
+
+// Entrée/sortie standard : la bibliothèque n'écrit rien, la sortie standard ne porte que les réponses
+static int servir_entree_standard(t_server *server) {
+    fflush(stdout);
+    int sortie = dup(STDOUT_FILENO);
+    if (sortie < 0) {
+        return -1;
+    }
+
+    t_connection *conn = ouvrir_connexion(server, STDIN_FILENO, sortie);
+    if (conn == NULL) {
+        close(sortie);
+        return -1;
+    }
+    servir(conn);
+    fermer_connexion(conn);
+
+    fflush(stdout);
+    dup2(sortie, STDOUT_FILENO);
+    close(sortie);
+    return 0;
+}
+
+int server_run(const t_server_options *options) {
+    // Un client qui se déconnecte ne doit pas tuer le serveur pendant une écriture
+    signal(SIGPIPE, SIG_IGN);
+
+    t_server server = {0};
+    server.listenFd = -1;
+    pthread_mutex_init(&server.lock, NULL);
+    pthread_cond_init(&server.noConnection, NULL);
+
+    server.pool = threadpool_create(options->jobs);
+    int nbThreads = threadpool_size(server.pool);
+    server.scratch = calloc(nbThreads > 0 ? nbThreads : 1, sizeof(t_chain_scratch));
+
+    int res = -1;
+    if (server.pool != NULL && server.scratch != NULL) {
+        res = strcmp(options->socketPath, "-") == 0 ? servir_entree_standard(&server)
+                                                    : ecouter(&server, options->socketPath);
+    } else {
+        printf("Erreur : initialisation du serveur impossible.\n");
+    }
+
+    threadpool_destroy(server.pool);
+    for (int i = 0; i < nbThreads; i++) {
+        chain_freeScratch(&server.scratch[i]);
+    }
+    free(server.scratch);
+    pthread_mutex_destroy(&server.lock);
+    pthread_cond_destroy(&server.noConnection);
+    return res;
+}
+
+#else
+
+int server_run(const t_server_options *options) {
+    (void)options;
+    printf("Erreur : le mode serveur n'est disponible que sur les systèmes POSIX.\n");
+    return -1;
+}
+
+#endif // _WIN32
+
+int server_parseArgs(int argc, char **argv, t_server_options *options) {
+    options->socketPath = NULL;
+    options->jobs = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            printf("Erreur : valeur manquante après %s.\n", argv[i]);
+            return -1;
+        }
+        if (strcmp(argv[i], "--serve") == 0) {
+            options->socketPath = argv[++i];
+        } else if (strcmp(argv[i], "--jobs") == 0) {
+            char *fin;
+            long jobs = strtol(argv[++i], &fin, 10);
+            if (*fin != '\0' || jobs < 0 || jobs > 1024) {
+                printf("Erreur : --jobs attend un entier entre 0 et 1024.\n");
+                return -1;
+            }
+            options->jobs = (int)jobs;
+        } else {
+            printf("Erreur : option inconnue %s.\n", argv[i]);
+            return -1;
+        }
+    }
+
+    if (options->socketPath == NULL) {
+        printf("Usage : %s --serve <socket|-> [--jobs N]\n", argv[0]);
+        return -1;
+    }
+    return 0;
+}
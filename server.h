@@ -0,0 +1,29 @@
+/*
+* Fichier : server.h
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Mode serveur : un processus de longue durée reçoit des travaux ligne par ligne, sur une socket
+ *           Unix locale ou sur l'entrée standard, et les exécute sur un pool de threads persistant dont
+ *           les tampons de convolution sont conservés d'un travail à l'autre.
+ *
+ *           Requête (une ligne) : <entrée.bmp> <sortie.bmp> <chaîne de filtres>
+ *           Réponse (une ligne) : <n> OK <durée> ms   ou   <n> ERR <étape> <cause>
+ *           où n est le numéro de la requête dans la connexion (à partir de 1) ; les réponses peuvent
+ *           arriver dans le désordre. La ligne "shutdown" arrête le serveur. Les chemins ne doivent pas
+ *           contenir d'espaces.
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+typedef struct {
+    const char *socketPath;     // chemin de la socket Unix, ou "-" pour l'entrée/sortie standard
+    int jobs;                   // threads de calcul, 0 : nombre de cœurs
+} t_server_options;
+
+// Analyse de "--serve <socket|-> [--jobs N]" ; renvoie 0 si succès, -1 sinon
+int server_parseArgs(int argc, char **argv, t_server_options *options);
+
+// Exécute le serveur jusqu'à "shutdown" (ou la fin de l'entrée standard) ; renvoie 0 si succès, -1 sinon
+int server_run(const t_server_options *options);
+
+#endif // SERVER_H
@@ -0,0 +1,508 @@
+/*
+* Fichier : stream.c
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Implémente le traitement en flux. Les en-têtes sont lus sans retour en arrière (l'écart
+ *           jusqu'aux pixels est lu et ignoré), puis chaque ligne est décodée, passée d'étape en étape et
+ *           réencodée. Une convolution garde les lignes précédente, courante et suivante et émet la ligne
+ *           courante dès que la suivante est arrivée.
+ */
+
+#include "stream.h"
+#include "kernels.h"
+#include "bmp_size.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Taille des noyaux de la chaîne (3x3)
+#define TAILLE_NOYAU 3
+
+// Une étape du plan d'exécution de la chaîne appliquée ligne par ligne
+typedef struct {
+    const t_chain_op *op;       // opération seule, NULL pour des opérations fusionnées
+    const t_chain_step *step;
+    float **kernel;             // convolution : noyau partagé de la chaîne
+    float flat[TAILLE_NOYAU * TAILLE_NOYAU];
+    void *lignes[3];            // convolution : lignes précédente, courante et suivante, dans l'ordre d'arrivée
+    void *sortie;               // convolution : ligne filtrée transmise à l'étape suivante
+    int recues;
+} t_etape;
+
+typedef struct {
+    FILE *out;
+    t_image_type type;
+    int width;
+    int bits;                   // profondeur écrite
+    bool ordreImage;            // les lignes arrivent du haut vers le bas de l'image
+    size_t rowSize;             // octets d'une ligne du fichier, padding compris
+    size_t rowBytes;            // octets d'une ligne en mémoire (8 bits : ligne du fichier)
+    unsigned char *ligneFichier;
+    t_etape *etapes;
+    int nbEtapes;
+    t_bmp_status status;
+} t_flux;
+
+// --- Lecture sans positionnement ---
+
+static t_bmp_status lire(FILE *in, void *dst, size_t size) {
+    return fread(dst, 1, size, in) == size ? BMP_OK : BMP_ERR_READ;
+}
+
+// Avance de n octets en les lisant : un tube ne permet pas fseek
+static t_bmp_status sauter(FILE *in, size_t n) {
+    unsigned char tampon[4096];
+    while (n > 0) {
+        size_t bloc = n < sizeof(tampon) ? n : sizeof(tampon);
+        if (fread(tampon, 1, bloc, in) != bloc) {
+            return BMP_ERR_READ;
+        }
+        n -= bloc;
+    }
+    return BMP_OK;
+}
+
+static t_bmp_status ecrire(FILE *out, const void *src, size_t size) {
+    return fwrite(src, 1, size, out) == size ? BMP_OK : BMP_ERR_WRITE;
+}
+
+// --- Étapes ---
+
+static void transmettre(t_flux *f, int e, void *ligne);
+
+// Filtre la ligne courante d'une convolution ; precedente ou suivante vaut NULL au bord de l'image
+static void convoluer(t_flux *f, t_etape *etape, void *precedente, void *courante, void *suivante) {
+    // Fenêtre dans l'ordre de l'image : une image stockée du bas vers le haut arrive à l'envers
+    void *haut = f->ordreImage ? precedente : suivante;
+    void *bas = f->ordreImage ? suivante : precedente;
+    int nb = 0;
+    if (haut != NULL) nb++;
+    int row = nb;
+    nb += bas != NULL ? 2 : 1;
+
+    if (f->type == IMAGE_BMP8) {
+        // Comme bmp8_applyFilter : bords recopiés, intérieur tronqué
+        memcpy(etape->sortie, courante, f->rowBytes);
+        if (nb == 3 && f->width - 1 > 1) {
+            const uint8_t *fenetre[3] = {haut, courante, bas};
+            kernels_get()->convolveRow(etape->sortie, fenetre, 1, f->width - 1, 1, etape->flat,
+                                       TAILLE_NOYAU, KERNEL_ROUND_TRUNC);
+        }
+    } else {
+        const t_pixel *fenetre[3];
+        int i = 0;
+        if (haut != NULL) fenetre[i++] = haut;
+        fenetre[i++] = courante;
+        if (bas != NULL) fenetre[i++] = bas;
+        bmp24_filterRow(etape->sortie, fenetre, nb, row, f->width, etape->kernel, etape->flat, TAILLE_NOYAU);
+    }
+    transmettre(f, (int)(etape - f->etapes) + 1, etape->sortie);
+}
+
+// Opération ponctuelle ou opérations fusionnées, appliquées sur place
+static void appliquer_point(t_flux *f, const t_etape *etape, void *ligne) {
+    const t_chain_op *op = etape->op;
+    if (op == NULL) {
+        if (f->type == IMAGE_BMP8) {
+            kernels_get()->applyLut(ligne, f->rowBytes, etape->step->lut);
+        } else if (etape->step->type == CHAIN_STEP_LUT) {
+            bmp24_applyLutRow(ligne, f->width, etape->step->lut);
+        } else {
+            bmp24_grayscaleLutRow(ligne, f->width, etape->step->hasBefore ? etape->step->before : NULL,
+                                  etape->step->lut);
+        }
+        return;
+    }
+    if (f->type == IMAGE_BMP8) {
+        // Padding compris, comme les fonctions bmp8_* qui traitent tout dataSize
+        const t_kernels *k = kernels_get();
+        if (op->type == CHAIN_NEGATIVE) {
+            k->invert(ligne, f->rowBytes);
+        } else if (op->type == CHAIN_BRIGHTNESS) {
+            k->addSat(ligne, f->rowBytes, op->value);
+        } else if (op->type == CHAIN_THRESHOLD) {
+            k->threshold(ligne, f->rowBytes, op->value);
+        }
+    } else {
+        if (op->type == CHAIN_NEGATIVE) {
+            bmp24_negativeRow(ligne, f->width);
+        } else if (op->type == CHAIN_BRIGHTNESS) {
+            bmp24_brightnessRow(ligne, f->width, op->value);
+        } else if (op->type == CHAIN_GRAYSCALE) {
+            bmp24_grayscaleRow(ligne, f->width);
+        }
+    }
+}
+
+// Fait passer une ligne par l'étape e puis les suivantes ; après la dernière étape, elle est écrite
+static void transmettre(t_flux *f, int e, void *ligne) {
+    if (f->status != BMP_OK) {
+        return;
+    }
+    if (e == f->nbEtapes) {
+        if (f->type == IMAGE_BMP8) {
+            f->status = ecrire(f->out, ligne, f->rowSize);
+        } else {
+            bmp24_encodeRow(ligne, f->width, f->bits, f->ligneFichier, f->rowSize);
+            f->status = ecrire(f->out, f->ligneFichier, f->rowSize);
+        }
+        return;
+    }
+
+    t_etape *etape = &f->etapes[e];
+    if (etape->kernel == NULL) {
+        appliquer_point(f, etape, ligne);
+        transmettre(f, e + 1, ligne);
+        return;
+    }
+
+    // Rotation des trois lignes : la plus ancienne reçoit la nouvelle
+    void *libre = etape->lignes[0];
+    etape->lignes[0] = etape->lignes[1];
+    etape->lignes[1] = etape->lignes[2];
+    etape->lignes[2] = libre;
+    memcpy(libre, ligne, f->rowBytes);
+    etape->recues++;
+
+    // La ligne courante peut être filtrée dès que sa suivante est arrivée
+    if (etape->recues >= 2) {
+        convoluer(f, etape, etape->recues >= 3 ? etape->lignes[0] : NULL, etape->lignes[1], etape->lignes[2]);
+    }
+}
+
+// Fin de l'image : chaque convolution émet sa dernière ligne, qui n'a pas de suivante
+static void vider(t_flux *f, int e) {
+    for (; e < f->nbEtapes && f->status == BMP_OK; e++) {
+        t_etape *etape = &f->etapes[e];
+        if (etape->kernel != NULL && etape->recues >= 1) {
+            convoluer(f, etape, etape->recues >= 2 ? etape->lignes[1] : NULL, etape->lignes[2], NULL);
+        }
+    }
+}
+
+static void liberer_etapes(t_flux *f) {
+    for (int e = 0; e < f->nbEtapes; e++) {
+        for (int i = 0; i < 3; i++) {
+            free(f->etapes[e].lignes[i]);
+        }
+        free(f->etapes[e].sortie);
+    }
+    free(f->etapes);
+    f->etapes = NULL;
+    f->nbEtapes = 0;
+}
+
+// Étapes du plan d'exécution de la chaîne pour ce flux (opérations ponctuelles déjà fusionnées)
+static t_bmp_status preparer_etapes(t_flux *f, const t_chain *chain) {
+    int p = f->type == IMAGE_BMP8 ? 0 : 1;
+    const t_chain_step *plan = chain->plan[p];
+    f->etapes = calloc(chain->nbSteps[p] > 0 ? chain->nbSteps[p] : 1, sizeof(t_etape));
+    if (f->etapes == NULL) {
+        return BMP_ERR_MEMORY;
+    }
+    for (int s = 0; s < chain->nbSteps[p]; s++) {
+        t_etape *etape = &f->etapes[f->nbEtapes++];
+        etape->step = &plan[s];
+        if (plan[s].type != CHAIN_STEP_OP) {
+            continue;
+        }
+        const t_chain_op *op = &chain->ops[plan[s].first];
+        etape->op = op;
+        if (op->type >= CHAIN_BOX_BLUR) {
+            etape->kernel = chain->kernels[op->type - CHAIN_BOX_BLUR];
+            for (int ky = 0; ky < TAILLE_NOYAU; ky++) {
+                for (int kx = 0; kx < TAILLE_NOYAU; kx++) {
+                    etape->flat[ky * TAILLE_NOYAU + kx] = etape->kernel[ky][kx];
+                }
+            }
+            for (int l = 0; l < 3; l++) {
+                etape->lignes[l] = malloc(f->rowBytes);
+            }
+            etape->sortie = malloc(f->rowBytes);
+            if (etape->lignes[0] == NULL || etape->lignes[1] == NULL || etape->lignes[2] == NULL ||
+                etape->sortie == NULL) {
+                return BMP_ERR_MEMORY;
+            }
+        }
+    }
+    return BMP_OK;
+}
+
+// Lecture de height lignes, chacune transmise à la chaîne dès son arrivée
+static t_bmp_status traiter_lignes(t_flux *f, FILE *in, int height, const t_bmp24_format *fmt) {
+    void *ligne = f->type == IMAGE_BMP8 ? NULL : malloc(f->rowBytes);
+    if (f->type != IMAGE_BMP8 && ligne == NULL) {
+        return BMP_ERR_MEMORY;
+    }
+
+    for (int i = 0; i < height && f->status == BMP_OK; i++) {
+        f->status = lire(in, f->ligneFichier, f->rowSize);
+        if (f->status != BMP_OK) {
+            break;
+        }
+        if (f->type == IMAGE_BMP8) {
+            transmettre(f, 0, f->ligneFichier);
+        } else {
+            bmp24_decodeRow(fmt, f->ligneFichier, ligne);
+            transmettre(f, 0, ligne);
+        }
+    }
+    vider(f, 0);
+
+    free(ligne);
+    return f->status;
+}
+
+static bool contient(const t_chain *chain, t_chain_op_type type) {
+    for (int i = 0; i < chain->count; i++) {
+        if (chain->ops[i].type == type) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Transformation géométrique ou opération limitée à un rectangle : les lignes ne peuvent plus être traitées
+// une à une dans l'ordre du fichier
+static bool image_entiere_requise(const t_chain *chain) {
+    for (int i = 0; i < chain->count; i++) {
+        if (chain_isGeometric(chain->ops[i].type) || chain->ops[i].hasRect) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// --- Formats ---
+
+// Fichier entier en mémoire, pour les transformations géométriques qui ont besoin de toute l'image et
+// changent les dimensions, et pour les rectangles : lecture jusqu'à la fin de l'entrée, décodage, chaîne, encodage
+static t_bmp_status traiter_fichier_entier(FILE *in, FILE *out, const t_chain *chain, const unsigned char *raw,
+                                           size_t lu) {
+    size_t capacite = (size_t)1 << 20, taille = lu;
+    unsigned char *buffer = malloc(capacite);
+    if (buffer == NULL) {
+        return BMP_ERR_MEMORY;
+    }
+    memcpy(buffer, raw, lu);
+    for (;;) {
+        if (taille == capacite) {
+            unsigned char *agrandi = capacite <= SIZE_MAX / 2 ? realloc(buffer, capacite * 2) : NULL;
+            if (agrandi == NULL) {
+                free(buffer);
+                return BMP_ERR_MEMORY;
+            }
+            buffer = agrandi;
+            capacite *= 2;
+        }
+        size_t n = fread(buffer + taille, 1, capacite - taille, in);
+        taille += n;
+        if (n == 0) {
+            break;
+        }
+    }
+    if (ferror(in)) {
+        free(buffer);
+        return BMP_ERR_READ;
+    }
+
+    t_bmp_status res;
+    t_image *img = bmp_decode(buffer, taille, &res);
+    free(buffer);
+    if (img == NULL) {
+        return res;
+    }
+    t_chain_scratch scratch = {0};
+    res = chain_apply(chain, img, &scratch);
+    chain_freeScratch(&scratch);
+
+    size_t size = res == BMP_OK ? bmp_encodedSize(img) : 0;
+    if (res == BMP_OK && size == 0) {
+        res = BMP_ERR_TOO_LARGE;
+    }
+    unsigned char *sortie = res == BMP_OK ? malloc(size) : NULL;
+    if (res == BMP_OK && sortie == NULL) {
+        res = BMP_ERR_MEMORY;
+    }
+    size_t ecrits = 0;
+    if (res == BMP_OK) {
+        res = bmp_encode(img, sortie, size, &ecrits);
+    }
+    if (res == BMP_OK) {
+        res = ecrire(out, sortie, ecrits);
+    }
+    free(sortie);
+    bmp_close(img);
+    return res;
+}
+
+// Image 8 bits entière : en-tête, palette et pixels sont réunis dans un tampon décodé sur place
+static t_bmp_status traiter_image_bmp8(FILE *in, FILE *out, const t_chain *chain, const unsigned char *raw,
+                                       const t_bmp8 *entete) {
+    size_t size;
+    if (!bmp_addSize(BMP8_DATA_OFFSET, entete->dataSize, &size)) {
+        return BMP_ERR_TOO_LARGE;
+    }
+    unsigned char *buffer = malloc(size);
+    if (buffer == NULL) {
+        return BMP_ERR_MEMORY;
+    }
+    memcpy(buffer, raw, HEADER_SIZE + INFO_SIZE);
+    t_bmp_status res = lire(in, buffer + HEADER_SIZE + INFO_SIZE, size - (HEADER_SIZE + INFO_SIZE));
+
+    t_bmp8 *bmp8 = res == BMP_OK ? bmp8_decodeInPlace(buffer, size, &res) : NULL;
+    if (bmp8 != NULL) {
+        t_image img = {.type = IMAGE_BMP8, .bmp8 = bmp8};
+        t_chain_scratch scratch = {0};
+        res = chain_apply(chain, &img, &scratch);
+        chain_freeScratch(&scratch);
+        if (res == BMP_OK) {
+            res = ecrire(out, buffer, size);   // les pixels filtrés sont restés dans buffer
+        }
+        bmp8_free(bmp8);
+    }
+    free(buffer);
+    return res;
+}
+
+static t_bmp_status traiter_bmp8(FILE *in, FILE *out, const t_chain *chain, const unsigned char *raw) {
+    t_bmp8 entete;
+    t_bmp_status res = bmp8_parseHeader(&entete, raw);
+    if (res != BMP_OK) {
+        return res;
+    }
+    if (contient(chain, CHAIN_EQUALIZE)) {
+        return traiter_image_bmp8(in, out, chain, raw, &entete);
+    }
+
+    // Palette juste après les 54 octets et pixels juste après la palette, comme bmp8_readFromFile ;
+    // l'ordre des lignes du fichier est conservé, comme dans les fonctions bmp8_*
+    unsigned char palette[1024];
+    res = lire(in, palette, sizeof(palette));
+    if (res != BMP_OK) {
+        return res;
+    }
+
+    t_flux f = {0};
+    f.out = out;
+    f.type = IMAGE_BMP8;
+    f.width = (int)entete.width;
+    f.bits = 8;
+    f.ordreImage = true;
+    f.rowSize = entete.dataSize / entete.height;
+    f.rowBytes = f.rowSize;
+    f.ligneFichier = malloc(f.rowSize);
+    res = f.ligneFichier != NULL ? preparer_etapes(&f, chain) : BMP_ERR_MEMORY;
+    if (res == BMP_OK) {
+        res = ecrire(out, raw, HEADER_SIZE + INFO_SIZE);
+    }
+    if (res == BMP_OK) {
+        res = ecrire(out, palette, sizeof(palette));
+    }
+    if (res == BMP_OK) {
+        res = traiter_lignes(&f, in, (int)entete.height, NULL);
+    }
+    liberer_etapes(&f);
+    free(f.ligneFichier);
+    return res;
+}
+
+static t_bmp_status traiter_bmp24(FILE *in, FILE *out, const t_chain *chain, const t_bmp_header *header,
+                                  const t_bmp_info *info) {
+    if (contient(chain, CHAIN_THRESHOLD) || contient(chain, CHAIN_EQUALIZE)) {
+        return BMP_ERR_DEPTH;   // comme chain_apply, avant d'avoir écrit quoi que ce soit
+    }
+
+    t_bmp24_format fmt;
+    t_bmp_status res = bmp24_parseFormat(info, &fmt);
+    if (res != BMP_OK) {
+        return res;
+    }
+    size_t lu = HEADER_SIZE + INFO_SIZE;
+    if (fmt.nbMasks > 0) {
+        res = lire(in, fmt.masks, fmt.nbMasks * sizeof(uint32_t));
+        if (res != BMP_OK) {
+            return res;
+        }
+        lu += fmt.nbMasks * sizeof(uint32_t);
+    }
+    if (header->offset < lu) {
+        return BMP_ERR_FORMAT;  // pixels placés avant la fin des en-têtes : impossible sans revenir en arrière
+    }
+    res = sauter(in, header->offset - lu);
+    if (res != BMP_OK) {
+        return res;
+    }
+
+    // En-têtes de sortie : même orientation que l'entrée, pour émettre les lignes dans leur ordre d'arrivée
+    t_bmp24 modele = {.header = *header, .header_info = *info, .width = fmt.width, .height = fmt.height,
+                      .colorDepth = info->bits, .data = NULL};
+    t_bmp_header h;
+    t_bmp_info i;
+    t_bmp_v4ext ext;
+    size_t rowSize, fileSize;
+    if (!bmp24_prepareHeaders(&modele, fmt.topDown, &h, &i, &ext, &rowSize, &fileSize)) {
+        return BMP_ERR_TOO_LARGE;
+    }
+
+    t_flux f = {0};
+    f.out = out;
+    f.type = IMAGE_BMP24;
+    f.width = fmt.width;
+    f.bits = i.bits;
+    f.ordreImage = fmt.topDown;
+    f.rowSize = rowSize;        // même profondeur en entrée et en sortie : même taille de ligne que fmt.rowSize
+    f.rowBytes = (size_t)fmt.width * sizeof(t_pixel);
+    f.ligneFichier = malloc(f.rowSize);
+    res = f.ligneFichier != NULL ? preparer_etapes(&f, chain) : BMP_ERR_MEMORY;
+    if (res == BMP_OK) {
+        res = ecrire(out, &h, sizeof(h));
+    }
+    if (res == BMP_OK) {
+        res = ecrire(out, &i, sizeof(i));
+    }
+    if (res == BMP_OK && i.size == INFO_V4_SIZE) {
+        res = ecrire(out, &ext, sizeof(ext));
+    }
+    if (res == BMP_OK) {
+        res = traiter_lignes(&f, in, fmt.height, &fmt);
+    }
+    liberer_etapes(&f);
+    free(f.ligneFichier);
+    return res;
+}
+
+t_bmp_status stream_run(FILE *in, FILE *out, const t_chain *chain) {
+    if (in == NULL || out == NULL || chain == NULL) {
+        return BMP_ERR_ARGUMENT;
+    }
+
+    unsigned char raw[HEADER_SIZE + INFO_SIZE];
+    t_bmp_status res = lire(in, raw, sizeof(raw));
+    if (res != BMP_OK) {
+        return res;
+    }
+    t_bmp_header header;
+    t_bmp_info info;
+    memcpy(&header, raw, HEADER_SIZE);
+    memcpy(&info, raw + HEADER_SIZE, INFO_SIZE);
+    if (header.type != BMP_TYPE) {
+        return BMP_ERR_FORMAT;
+    }
+
+    // Même aiguillage que bmp_open
+    if (image_entiere_requise(chain)) {
+        res = traiter_fichier_entier(in, out, chain, raw, sizeof(raw));
+    } else if (info.bits == 8 && info.compression == BI_RGB) {
+        res = traiter_bmp8(in, out, chain, raw);
+    } else if ((info.bits == 24 && info.compression == BI_RGB) ||
+               (info.bits == 32 && (info.compression == BI_RGB || info.compression == BI_BITFIELDS ||
+                                    info.compression == BI_ALPHABITFIELDS))) {
+        res = traiter_bmp24(in, out, chain, &header, &info);
+    } else {
+        res = BMP_ERR_UNSUPPORTED;
+    }
+
+    if (fflush(out) != 0 && res == BMP_OK) {
+        res = BMP_ERR_WRITE;
+    }
+    return res;
+}
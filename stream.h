@@ -0,0 +1,24 @@
+/*
+* Fichier : stream.h
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Traitement en flux : un BMP est lu ligne par ligne depuis un flux non positionnable (tube,
+ *           entrée standard), chaque ligne traverse la chaîne de filtres et repart aussitôt vers le flux de
+ *           sortie. Seules quelques lignes sont en mémoire : une par étape ponctuelle, une fenêtre de trois
+ *           lignes par convolution. Les lignes sont écrites dans l'ordre où elles arrivent : une image
+ *           stockée du haut vers le bas ressort du haut vers le bas (hauteur négative), sans tampon d'image.
+ *           Exemple : cat entree.bmp | iprocess --pipe "gaussian,negative" | autre_outil
+ */
+
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stdio.h>
+#include "chain.h"
+
+// Lit un BMP complet depuis in, applique chain et écrit le résultat dans out. L'égalisation d'histogramme
+// a besoin de toute l'image : une chaîne qui en contient est appliquée à l'image entière (8 bits). De même pour
+// les transformations géométriques (rotations, miroirs) et des opérations limitées à un rectangle, le fichier
+// entier étant alors lu avant d'être traité.
+t_bmp_status stream_run(FILE *in, FILE *out, const t_chain *chain);
+
+#endif // STREAM_H
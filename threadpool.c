@@ -0,0 +1,265 @@
+/*
+* Fichier : threadpool.c
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Implémente le pool de threads : file chaînée de tâches protégée par un mutex, une condition
+ *           pour réveiller les threads et une autre pour signaler la fin de toutes les tâches.
+ */
+
+#include "threadpool.h"
+#include <stdlib.h>
+#include <pthread.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+typedef struct s_task {
+    t_task_fn fn;
+    void *arg;
+    struct s_task *next;
+} t_task;
+
+struct s_threadpool {
+    pthread_t *threads;
+    int nbThreads;
+    t_task *head;
+    t_task *tail;
+    int pending;            // tâches en file ou en cours d'exécution
+    int stop;
+    pthread_mutex_t lock;
+    pthread_cond_t work;    // une tâche est disponible (ou arrêt demandé)
+    pthread_cond_t idle;    // pending est retombé à zéro
+};
+
+// Argument de démarrage d'un thread
+typedef struct {
+    t_threadpool *pool;
+    int index;
+} t_worker_arg;
+
+// Tranche de threadpool_split
+typedef struct {
+    t_range_fn fn;
+    void *arg;
+    int begin;
+    int end;
+    int res;
+} t_range;
+
+static void *boucle_worker(void *param) {
+    t_worker_arg *wa = param;
+    t_threadpool *pool = wa->pool;
+    int index = wa->index;
+    free(wa);
+
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        while (pool->head == NULL && !pool->stop) {
+            pthread_cond_wait(&pool->work, &pool->lock);
+        }
+        if (pool->head == NULL && pool->stop) {
+            break;
+        }
+
+        t_task *task = pool->head;
+        pool->head = task->next;
+        if (pool->head == NULL) {
+            pool->tail = NULL;
+        }
+        pthread_mutex_unlock(&pool->lock);
+
+        task->fn(task->arg, index);
+        free(task);
+
+        pthread_mutex_lock(&pool->lock);
+        pool->pending--;
+        if (pool->pending == 0) {
+            pthread_cond_broadcast(&pool->idle);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+int threadpool_cpuCount(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+t_threadpool *threadpool_create(int nbThreads) {
+    if (nbThreads <= 0) {
+        nbThreads = threadpool_cpuCount();
+    }
+
+    t_threadpool *pool = calloc(1, sizeof(t_threadpool));
+    if (pool == NULL) {
+        return NULL;
+    }
+    pool->threads = malloc(sizeof(pthread_t) * nbThreads);
+    if (pool->threads == NULL) {
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->idle, NULL);
+
+    for (int i = 0; i < nbThreads; i++) {
+        t_worker_arg *wa = malloc(sizeof(t_worker_arg));
+        if (wa != NULL) {
+            wa->pool = pool;
+            wa->index = i;
+        }
+        if (wa == NULL || pthread_create(&pool->threads[i], NULL, boucle_worker, wa) != 0) {
+            free(wa);
+            // Les threads déjà lancés sont arrêtés proprement
+            pool->nbThreads = i;
+            threadpool_destroy(pool);
+            return NULL;
+        }
+    }
+    pool->nbThreads = nbThreads;
+    return pool;
+}
+
+int threadpool_submit(t_threadpool *pool, t_task_fn fn, void *arg) {
+    if (pool == NULL || fn == NULL) {
+        return -1;
+    }
+
+    t_task *task = malloc(sizeof(t_task));
+    if (task == NULL) {
+        return -1;
+    }
+    task->fn = fn;
+    task->arg = arg;
+    task->next = NULL;
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->tail != NULL) {
+        pool->tail->next = task;
+    } else {
+        pool->head = task;
+    }
+    pool->tail = task;
+    pool->pending++;
+    pthread_cond_signal(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+void threadpool_wait(t_threadpool *pool) {
+    if (pool == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->idle, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+int threadpool_size(const t_threadpool *pool) {
+    return pool != NULL ? pool->nbThreads : 0;
+}
+
+void threadpool_destroy(t_threadpool *pool) {
+    if (pool == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->nbThreads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work);
+    pthread_cond_destroy(&pool->idle);
+    free(pool->threads);
+    free(pool);
+}
+
+static void *executer_tranche(void *arg) {
+    t_range *r = arg;
+    r->res = r->fn(r->arg, r->begin, r->end);
+    return NULL;
+}
+
+int threadpool_split(int nbThreads, int total, t_range_fn fn, void *arg) {
+    if (total <= 0) {
+        return 0;
+    }
+    if (nbThreads <= 0) {
+        nbThreads = threadpool_cpuCount();
+    }
+    if (nbThreads > total) {
+        nbThreads = total;
+    }
+    if (nbThreads == 1) {
+        return fn(arg, 0, total);
+    }
+
+    t_range *tranches = malloc(sizeof(t_range) * nbThreads);
+    pthread_t *threads = malloc(sizeof(pthread_t) * nbThreads);
+    int *lances = calloc(nbThreads, sizeof(int));
+    if (tranches == NULL || threads == NULL || lances == NULL) {
+        free(tranches);
+        free(threads);
+        free(lances);
+        return fn(arg, 0, total);
+    }
+
+    for (int t = 0; t < nbThreads; t++) {
+        tranches[t].fn = fn;
+        tranches[t].arg = arg;
+        tranches[t].begin = (int)((long long)total * t / nbThreads);
+        tranches[t].end = (int)((long long)total * (t + 1) / nbThreads);
+    }
+    for (int t = 1; t < nbThreads; t++) {
+        lances[t] = pthread_create(&threads[t], NULL, executer_tranche, &tranches[t]) == 0;
+    }
+    for (int t = 0; t < nbThreads; t++) {
+        if (!lances[t]) {
+            executer_tranche(&tranches[t]);
+        }
+    }
+
+    int res = 0;
+    for (int t = 0; t < nbThreads; t++) {
+        if (lances[t]) {
+            pthread_join(threads[t], NULL);
+        }
+        if (res == 0) {
+            res = tranches[t].res;
+        }
+    }
+
+    free(tranches);
+    free(threads);
+    free(lances);
+    return res;
+}
+
+int threadpool_threadsFor(int nbThreads, size_t bytes) {
+    if (nbThreads <= 0) {
+        nbThreads = threadpool_cpuCount();
+    }
+    if ((size_t)nbThreads > 1 + bytes / THREADPOOL_MIN_BYTES) {
+        nbThreads = (int)(1 + bytes / THREADPOOL_MIN_BYTES);
+    }
+    return nbThreads;
+}
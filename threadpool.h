@@ -0,0 +1,49 @@
+/*
+* Fichier : threadpool.h
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Pool de threads de taille fixe (pthreads) avec une file de tâches. Chaque tâche reçoit
+ *           l'indice du thread qui l'exécute, ce qui permet d'associer des tampons de travail par thread.
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <stddef.h>
+
+typedef void (*t_task_fn)(void *arg, int worker);
+
+typedef struct s_threadpool t_threadpool;
+
+// Crée un pool de nbThreads threads (nbThreads <= 0 : nombre de cœurs)
+t_threadpool *threadpool_create(int nbThreads);
+
+// Ajoute une tâche à la file ; renvoie 0 si succès, -1 sinon
+int threadpool_submit(t_threadpool *pool, t_task_fn fn, void *arg);
+
+// Attend que toutes les tâches soumises soient terminées
+void threadpool_wait(t_threadpool *pool);
+
+// Nombre de threads du pool
+int threadpool_size(const t_threadpool *pool);
+
+// Termine les tâches en cours, arrête les threads et libère le pool
+void threadpool_destroy(t_threadpool *pool);
+
+// Nombre de cœurs disponibles (au moins 1)
+int threadpool_cpuCount(void);
+
+// Découpe [0, total) en nbThreads tranches contiguës (nbThreads <= 0 : nombre de cœurs) et exécute
+// fn(arg, début, fin) sur chacune, dans des threads créés pour l'occasion ; le thread appelant traite la
+// première tranche, ainsi que celles dont le thread n'a pas pu être créé. Renvoie le premier code non nul
+// renvoyé par fn (dans l'ordre des tranches), 0 si toutes ont réussi.
+typedef int (*t_range_fn)(void *arg, int begin, int end);
+int threadpool_split(int nbThreads, int total, t_range_fn fn, void *arg);
+
+// Octets produits minimum par thread : en dessous, le coût de création des threads domine
+#define THREADPOOL_MIN_BYTES ((size_t)1 << 16)
+
+// Nombre de threads à passer à threadpool_split pour produire bytes octets : nbThreads (nombre de cœurs
+// si <= 0), limité à un thread par tranche de THREADPOOL_MIN_BYTES octets
+int threadpool_threadsFor(int nbThreads, size_t bytes);
+
+#endif // THREADPOOL_H
@@ -0,0 +1,268 @@
+/*
+* Fichier : tiled24.c
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Implémente le stockage en tuiles à copie sur écriture des images 24/32 bits : compteurs de
+ *           références atomiques, instantanés, détachement des tuiles avant écriture et filtres appliqués
+ *           par les vues bmp24_view sur les seules lignes touchées.
+ */
+
+#include "tiled24.h"
+#include "bmp_size.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct s_tile24 {
+    atomic_int refs;        // images qui référencent la tuile ; modifiable seulement à 1
+    int rows;
+    t_pixel pixels[];       // rows lignes de image.width pixels
+};
+
+// --- Tuiles ---
+
+static t_tile24 *allouer_tuile(int width, int rows) {
+    size_t taille;
+    if (!bmp_mulSize((size_t)width * sizeof(t_pixel), (size_t)rows, &taille) ||
+        !bmp_addSize(taille, sizeof(t_tile24), &taille)) {
+        return NULL;
+    }
+    t_tile24 *tuile = malloc(taille);
+    if (tuile == NULL) {
+        return NULL;
+    }
+    atomic_init(&tuile->refs, 1);
+    tuile->rows = rows;
+    return tuile;
+}
+
+// La dernière image qui référence la tuile la libère
+static void relacher_tuile(t_tile24 *tuile) {
+    if (tuile != NULL && atomic_fetch_sub_explicit(&tuile->refs, 1, memory_order_acq_rel) == 1) {
+        free(tuile);
+    }
+}
+
+// Fait pointer les lignes de la tuile t dans la table image.data
+static void indexer_tuile(t_tiled24 *img, int t) {
+    t_pixel *pixels = img->tiles[t]->pixels;
+    t_pixel **lignes = img->image.data + (size_t)t * TILED24_TILE_ROWS;
+    for (int i = 0; i < img->tiles[t]->rows; i++) {
+        lignes[i] = pixels + (size_t)i * img->image.width;
+    }
+}
+
+// Image de mêmes en-têtes et dimensions que modele, table de lignes allouée, sans tuiles
+static t_tiled24 *allouer_structure(const t_bmp24 *modele, t_bmp_status *status) {
+    t_tiled24 *img = malloc(sizeof(t_tiled24));
+    if (img == NULL) {
+        bmp_setStatus(status, BMP_ERR_MEMORY);
+        return NULL;
+    }
+    img->image = *modele;
+    img->nbTiles = (modele->height + TILED24_TILE_ROWS - 1) / TILED24_TILE_ROWS;
+    img->image.data = malloc((size_t)modele->height * sizeof(t_pixel *));
+    img->tiles = calloc((size_t)img->nbTiles, sizeof(t_tile24 *));
+    if (img->image.data == NULL || img->tiles == NULL) {
+        free(img->image.data);
+        free(img->tiles);
+        free(img);
+        bmp_setStatus(status, BMP_ERR_MEMORY);
+        return NULL;
+    }
+    return img;
+}
+
+// --- Création et libération ---
+
+t_tiled24 *tiled24_fromBmp24(const t_bmp24 *img, t_bmp_status *status) {
+    if (img == NULL || img->data == NULL || img->width <= 0 || img->height <= 0) {
+        bmp_setStatus(status, BMP_ERR_ARGUMENT);
+        return NULL;
+    }
+
+    t_tiled24 *res = allouer_structure(img, status);
+    if (res == NULL) {
+        return NULL;
+    }
+    size_t octets = (size_t)img->width * sizeof(t_pixel);
+    for (int t = 0; t < res->nbTiles; t++) {
+        int y0 = t * TILED24_TILE_ROWS;
+        int lignes = img->height - y0 < TILED24_TILE_ROWS ? img->height - y0 : TILED24_TILE_ROWS;
+        res->tiles[t] = allouer_tuile(img->width, lignes);
+        if (res->tiles[t] == NULL) {
+            tiled24_free(res);
+            bmp_setStatus(status, BMP_ERR_MEMORY);
+            return NULL;
+        }
+        for (int i = 0; i < lignes; i++) {
+            memcpy(res->tiles[t]->pixels + (size_t)i * img->width, img->data[y0 + i], octets);
+        }
+        indexer_tuile(res, t);
+    }
+
+    bmp_setStatus(status, BMP_OK);
+    return res;
+}
+
+t_bmp24 *tiled24_toBmp24(const t_tiled24 *img, t_bmp_status *status) {
+    if (img == NULL || img->tiles == NULL) {
+        bmp_setStatus(status, BMP_ERR_ARGUMENT);
+        return NULL;
+    }
+
+    t_bmp24 *res = bmp24_allocate(img->image.width, img->image.height, img->image.colorDepth);
+    if (res == NULL) {
+        bmp_setStatus(status, BMP_ERR_MEMORY);
+        return NULL;
+    }
+    res->header = img->image.header;
+    res->header_info = img->image.header_info;
+    for (int i = 0; i < img->image.height; i++) {
+        memcpy(res->data[i], img->image.data[i], (size_t)img->image.width * sizeof(t_pixel));
+    }
+
+    bmp_setStatus(status, BMP_OK);
+    return res;
+}
+
+t_tiled24 *tiled24_snapshot(const t_tiled24 *img, t_bmp_status *status) {
+    if (img == NULL || img->tiles == NULL) {
+        bmp_setStatus(status, BMP_ERR_ARGUMENT);
+        return NULL;
+    }
+
+    t_tiled24 *res = allouer_structure(&img->image, status);
+    if (res == NULL) {
+        return NULL;
+    }
+    for (int t = 0; t < img->nbTiles; t++) {
+        atomic_fetch_add_explicit(&img->tiles[t]->refs, 1, memory_order_relaxed);
+        res->tiles[t] = img->tiles[t];
+    }
+    memcpy(res->image.data, img->image.data, (size_t)img->image.height * sizeof(t_pixel *));
+
+    bmp_setStatus(status, BMP_OK);
+    return res;
+}
+
+void tiled24_free(t_tiled24 *img) {
+    if (img != NULL) {
+        if (img->tiles != NULL) {
+            for (int t = 0; t < img->nbTiles; t++) {
+                relacher_tuile(img->tiles[t]);
+            }
+        }
+        free(img->tiles);
+        free(img->image.data);
+        free(img);
+    }
+}
+
+// --- Écriture ---
+
+t_bmp_status tiled24_detachRows(t_tiled24 *img, int y, int height) {
+    if (img == NULL || img->tiles == NULL || y < 0 || height <= 0 || y >= img->image.height ||
+        height > img->image.height - y) {
+        return BMP_ERR_ARGUMENT;
+    }
+
+    for (int t = y / TILED24_TILE_ROWS; t <= (y + height - 1) / TILED24_TILE_ROWS; t++) {
+        t_tile24 *tuile = img->tiles[t];
+        // Seule référence : les écritures des anciens propriétaires sont visibles (acquire), rien à copier
+        if (atomic_load_explicit(&tuile->refs, memory_order_acquire) == 1) {
+            continue;
+        }
+        t_tile24 *copie = allouer_tuile(img->image.width, tuile->rows);
+        if (copie == NULL) {
+            return BMP_ERR_MEMORY;
+        }
+        memcpy(copie->pixels, tuile->pixels, (size_t)tuile->rows * img->image.width * sizeof(t_pixel));
+        img->tiles[t] = copie;
+        indexer_tuile(img, t);
+        relacher_tuile(tuile);
+    }
+    return BMP_OK;
+}
+
+t_bmp_status tiled24_view(t_tiled24 *img, const t_bmp_rect *rect, t_bmp24_view *view) {
+    if (img == NULL || rect == NULL) {
+        return BMP_ERR_ARGUMENT;
+    }
+
+    // La table de lignes de la vue est celle de l'image : le détachement y est visible
+    t_bmp_status res = bmp24_view(&img->image, rect->x, rect->y, rect->width, rect->height, view);
+    if (res != BMP_OK) {
+        return res;
+    }
+    return tiled24_detachRows(img, rect->y, rect->height);
+}
+
+int tiled24_sharedTiles(const t_tiled24 *img) {
+    int partagees = 0;
+    if (img != NULL && img->tiles != NULL) {
+        for (int t = 0; t < img->nbTiles; t++) {
+            if (atomic_load_explicit(&img->tiles[t]->refs, memory_order_relaxed) > 1) {
+                partagees++;
+            }
+        }
+    }
+    return partagees;
+}
+
+// --- Fonctions de traitement d'image ---
+
+// Vue sur le rectangle à traiter (image entière si rect vaut NULL). Un rectangle hors de l'image n'est pas
+// une erreur : view->image vaut alors NULL et il n'y a rien à faire.
+static t_bmp_status vue_a_traiter(t_tiled24 *img, const t_bmp_rect *rect, t_bmp24_view *view) {
+    if (img == NULL) {
+        return BMP_ERR_ARGUMENT;
+    }
+    t_bmp_rect r = {0, 0, img->image.width, img->image.height};
+    if (rect != NULL) {
+        r = *rect;
+        if (!bmp_clipRect(&r, img->image.width, img->image.height)) {
+            view->image = NULL;
+            return BMP_OK;
+        }
+    }
+    return tiled24_view(img, &r, view);
+}
+
+t_bmp_status tiled24_negative(t_tiled24 *img, const t_bmp_rect *rect) {
+    t_bmp24_view vue;
+    t_bmp_status res = vue_a_traiter(img, rect, &vue);
+    if (res != BMP_OK || vue.image == NULL) {
+        return res;
+    }
+    return bmp24_viewNegative(&vue);
+}
+
+t_bmp_status tiled24_brightness(t_tiled24 *img, int value, const t_bmp_rect *rect) {
+    t_bmp24_view vue;
+    t_bmp_status res = vue_a_traiter(img, rect, &vue);
+    if (res != BMP_OK || vue.image == NULL) {
+        return res;
+    }
+    return bmp24_viewBrightness(&vue, value);
+}
+
+t_bmp_status tiled24_grayscale(t_tiled24 *img, const t_bmp_rect *rect) {
+    t_bmp24_view vue;
+    t_bmp_status res = vue_a_traiter(img, rect, &vue);
+    if (res != BMP_OK || vue.image == NULL) {
+        return res;
+    }
+    return bmp24_viewGrayscale(&vue);
+}
+
+t_bmp_status tiled24_applyFilter(t_tiled24 *img, float **kernel, int kernelSize, const t_bmp_rect *rect) {
+    if (kernel == NULL || kernelSize <= 0 || kernelSize % 2 == 0) {
+        return BMP_ERR_ARGUMENT;
+    }
+    t_bmp24_view vue;
+    t_bmp_status res = vue_a_traiter(img, rect, &vue);
+    if (res != BMP_OK || vue.image == NULL) {
+        return res;
+    }
+    return bmp24_viewApplyFilter(&vue, kernel, kernelSize);
+}
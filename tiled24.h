@@ -0,0 +1,60 @@
+/*
+* Fichier : tiled24.h
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Stockage en tuiles d'une image 24/32 bits, partagées par comptage de références et copiées à la
+ *           première écriture (copie sur écriture). Garder plusieurs versions d'une image (originale, aperçu,
+ *           courante) ne coûte qu'un instantané (un pointeur par tuile et par ligne, aucun pixel copié), et un
+ *           filtre limité à une partie de l'image ne duplique que les tuiles qu'il modifie.
+ */
+
+#ifndef TILED24_H
+#define TILED24_H
+
+#include <stddef.h>
+#include "bmp24.h"
+#include "bmp_io.h"
+
+// Lignes par tuile. Une tuile couvre toute la largeur de l'image : ses lignes restent contiguës, si bien que
+// la table de lignes d'un t_bmp24 peut pointer dedans et que les fonctions bmp24_* s'appliquent telles quelles.
+#define TILED24_TILE_ROWS 32
+
+// Tuile : TILED24_TILE_ROWS lignes de pixels (moins pour la dernière) et son compteur de références
+typedef struct s_tile24 t_tile24;
+
+typedef struct {
+    t_bmp24 image;          // en-têtes et dimensions ; image.data pointe dans les tuiles (lecture seule)
+    int nbTiles;
+    t_tile24 **tiles;       // tiles[t] : lignes t * TILED24_TILE_ROWS et suivantes, du haut vers le bas
+} t_tiled24;
+
+// --- Création et libération ---
+// Fonctions silencieuses : NULL en cas d'échec, avec la cause dans *status (optionnel)
+t_tiled24 *tiled24_fromBmp24(const t_bmp24 *img, t_bmp_status *status);
+t_bmp24 *tiled24_toBmp24(const t_tiled24 *img, t_bmp_status *status);
+
+// Instantané : nouvelle image qui partage toutes les tuiles de img (aucun pixel copié)
+t_tiled24 *tiled24_snapshot(const t_tiled24 *img, t_bmp_status *status);
+
+// Libère l'image ; une tuile n'est libérée que par la dernière image qui la référence
+void tiled24_free(t_tiled24 *img);
+
+// --- Écriture ---
+// Rend propres à img les tuiles des lignes [y, y + height) : celles encore partagées sont copiées et la
+// table image.data mise à jour. Les instantanés pris avant gardent les anciennes valeurs.
+t_bmp_status tiled24_detachRows(t_tiled24 *img, int y, int height);
+
+// Vue modifiable sur un rectangle (voir bmp24_view), après détachement des tuiles qu'il recouvre
+t_bmp_status tiled24_view(t_tiled24 *img, const t_bmp_rect *rect, t_bmp24_view *view);
+
+// Nombre de tuiles encore partagées avec au moins une autre image
+int tiled24_sharedTiles(const t_tiled24 *img);
+
+// --- Fonctions de traitement d'image (résultats identiques aux versions bmp24_*) ---
+// rect : rectangle à traiter, coupé aux bords de l'image (NULL : image entière). Seules les tuiles qu'il
+// recouvre sont copiées ; les convolutions lisent leur voisinage dans les tuiles voisines sans les copier.
+t_bmp_status tiled24_negative(t_tiled24 *img, const t_bmp_rect *rect);
+t_bmp_status tiled24_brightness(t_tiled24 *img, int value, const t_bmp_rect *rect);
+t_bmp_status tiled24_grayscale(t_tiled24 *img, const t_bmp_rect *rect);
+t_bmp_status tiled24_applyFilter(t_tiled24 *img, float **kernel, int kernelSize, const t_bmp_rect *rect);
+
+#endif // TILED24_H
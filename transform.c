@@ -0,0 +1,295 @@
+/*
+* Fichier : transform.c
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Implémente les transformations géométriques. Toutes se ramènent à des tableaux de pointeurs de
+ *           lignes, éventuellement pris à l'envers : un quart de tour est une transposition dont les lignes
+ *           source ou destination sont inversées, un demi-tour un miroir gauche-droite des lignes inversées.
+ */
+
+#include "transform.h"
+#include "kernels.h"
+#include "threadpool.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+static const char *noms_transformations[] = {
+    "rotate90", "rotate180", "rotate270", "fliph", "flipv", "transpose", "transverse"
+};
+
+#define NB_TRANSFORMATIONS ((int)(sizeof(noms_transformations) / sizeof(noms_transformations[0])))
+
+// Travail partagé par les tranches d'une transformation
+typedef struct {
+    const t_kernels *k;
+    uint8_t *const *dst;
+    const uint8_t *const *src;
+    int width;                  // dimensions de la source
+    int height;
+    int bpp;
+    t_transform op;
+    bool surPlace;              // dst et src désignent les mêmes lignes (miroirs et demi-tour)
+} t_travail;
+
+int transform_swapsAxes(t_transform op) {
+    return op == TRANSFORM_ROTATE90 || op == TRANSFORM_ROTATE270 || op == TRANSFORM_TRANSPOSE ||
+           op == TRANSFORM_TRANSVERSE;
+}
+
+static bool transformation_valide(t_transform op) {
+    return (int)op >= 0 && (int)op < NB_TRANSFORMATIONS;
+}
+
+// Même transformation vue dans des lignes rangées du bas vers le haut (image 8 bits dans l'ordre du fichier)
+static t_transform lignes_inversees(t_transform op) {
+    switch (op) {
+        case TRANSFORM_ROTATE90: return TRANSFORM_ROTATE270;
+        case TRANSFORM_ROTATE270: return TRANSFORM_ROTATE90;
+        case TRANSFORM_TRANSPOSE: return TRANSFORM_TRANSVERSE;
+        case TRANSFORM_TRANSVERSE: return TRANSFORM_TRANSPOSE;
+        default: return op;
+    }
+}
+
+// Colonnes de blocs [debut, fin) de la source, chacune devenant une bande de lignes de la sortie
+static int transposer_tranche(void *arg, int debut, int fin) {
+    const t_travail *t = arg;
+    for (int cb = debut; cb < fin; cb++) {
+        size_t c0 = (size_t)cb * TRANSFORM_TILE;
+        size_t cols = (size_t)t->width - c0 < TRANSFORM_TILE ? (size_t)t->width - c0 : TRANSFORM_TILE;
+        for (size_t r0 = 0; r0 < (size_t)t->height; r0 += TRANSFORM_TILE) {
+            size_t rows = (size_t)t->height - r0 < TRANSFORM_TILE ? (size_t)t->height - r0 : TRANSFORM_TILE;
+            t->k->transpose(t->dst + c0, r0, t->src + r0, c0, rows, cols, t->bpp);
+        }
+    }
+    return BMP_OK;
+}
+
+// Paires de lignes [debut, fin) : la ligne y et la ligne height - 1 - y
+static int retourner_tranche(void *arg, int debut, int fin) {
+    const t_travail *t = arg;
+    size_t octets = (size_t)t->width * t->bpp;
+    uint8_t *copie = NULL;
+    if (t->surPlace) {
+        copie = malloc(2 * octets);
+        if (copie == NULL) {
+            return BMP_ERR_MEMORY;
+        }
+    }
+
+    for (int y = debut; y < fin; y++) {
+        int a = y, b = t->height - 1 - y;
+        const uint8_t *sa = t->src[a], *sb = t->src[b];
+        if (t->op != TRANSFORM_FLIP_H) {
+            sa = t->src[b];
+            sb = t->src[a];
+        }
+        if (t->surPlace) {
+            memcpy(copie, sa, octets);
+            memcpy(copie + octets, sb, octets);
+            sa = copie;
+            sb = copie + octets;
+        }
+        if (t->op == TRANSFORM_FLIP_V) {
+            memcpy(t->dst[a], sa, octets);
+            memcpy(t->dst[b], sb, octets);
+        } else {
+            t->k->reverse(t->dst[a], sa, (size_t)t->width, t->bpp);
+            if (a != b) {
+                t->k->reverse(t->dst[b], sb, (size_t)t->width, t->bpp);
+            }
+        }
+    }
+
+    free(copie);
+    return BMP_OK;
+}
+
+// Transformation de lignes de width x height pixels de bpp octets ; dst contient les lignes de sortie
+// (width lignes si les axes sont échangés) et peut être src pour les miroirs et le demi-tour
+static t_bmp_status transformer(uint8_t **dst, const uint8_t **src, int width, int height, int bpp,
+                                t_transform op, int threads) {
+    t_travail t = { kernels_get(), dst, src, width, height, bpp, op, (const uint8_t **)dst == src };
+    int n = threadpool_threadsFor(threads, (size_t)width * height * bpp);
+
+    if (!transform_swapsAxes(op)) {
+        return (t_bmp_status)threadpool_split(n, (height + 1) / 2, retourner_tranche, &t);
+    }
+
+    // Quart de tour horaire : lignes source prises du bas vers le haut ; antihoraire : lignes produites
+    // remplies du bas vers le haut ; transverse : les deux
+    if (op == TRANSFORM_ROTATE90 || op == TRANSFORM_TRANSVERSE) {
+        for (int i = 0, j = height - 1; i < j; i++, j--) {
+            const uint8_t *p = src[i];
+            src[i] = src[j];
+            src[j] = p;
+        }
+    }
+    if (op == TRANSFORM_ROTATE270 || op == TRANSFORM_TRANSVERSE) {
+        for (int i = 0, j = width - 1; i < j; i++, j--) {
+            uint8_t *p = dst[i];
+            dst[i] = dst[j];
+            dst[j] = p;
+        }
+    }
+    return (t_bmp_status)threadpool_split(n, (width + TRANSFORM_TILE - 1) / TRANSFORM_TILE, transposer_tranche, &t);
+}
+
+t_bmp24 *transform_bmp24(const t_bmp24 *src, t_transform op, int threads, t_bmp_status *status) {
+    if (src == NULL || src->data == NULL || !transformation_valide(op)) {
+        bmp_setStatus(status, BMP_ERR_ARGUMENT);
+        return NULL;
+    }
+    bool echange = transform_swapsAxes(op);
+    int width = echange ? src->height : src->width;
+    int height = echange ? src->width : src->height;
+
+    t_bmp24 *dst = bmp24_allocate(width, height, src->colorDepth);
+    const uint8_t **lignesSrc = malloc((size_t)src->height * sizeof(uint8_t *));
+    uint8_t **lignesDst = malloc((size_t)height * sizeof(uint8_t *));
+    if (dst == NULL || lignesSrc == NULL || lignesDst == NULL) {
+        bmp_setStatus(status, BMP_ERR_MEMORY);
+        bmp24_free(dst);
+        free(lignesSrc);
+        free(lignesDst);
+        return NULL;
+    }
+    dst->header = src->header;
+    dst->header_info = src->header_info;
+    dst->header_info.width = width;
+    dst->header_info.height = src->header_info.height < 0 ? -height : height;
+
+    for (int y = 0; y < src->height; y++) {
+        lignesSrc[y] = (const uint8_t *)src->data[y];
+    }
+    for (int y = 0; y < height; y++) {
+        lignesDst[y] = (uint8_t *)dst->data[y];
+    }
+
+    t_bmp_status res = transformer(lignesDst, lignesSrc, src->width, src->height, (int)sizeof(t_pixel), op,
+                                   threads);
+    free(lignesSrc);
+    free(lignesDst);
+    if (res != BMP_OK) {
+        bmp_setStatus(status, res);
+        bmp24_free(dst);
+        return NULL;
+    }
+    bmp_setStatus(status, BMP_OK);
+    return dst;
+}
+
+// Pointeurs des lignes d'une image 8 bits, dans l'ordre du fichier
+static uint8_t **lignes_bmp8(const t_bmp8 *img) {
+    uint8_t **lignes = malloc((size_t)img->height * sizeof(uint8_t *));
+    if (lignes != NULL) {
+        size_t rowSize = img->dataSize / img->height;
+        for (unsigned int y = 0; y < img->height; y++) {
+            lignes[y] = img->data + (size_t)y * rowSize;
+        }
+    }
+    return lignes;
+}
+
+// Lignes d'une image 8 bits rangées du bas vers le haut (hauteur positive dans l'en-tête)
+static bool bas_en_haut(const t_bmp8 *img) {
+    int32_t hauteur;
+    memcpy(&hauteur, img->header + 22, sizeof(hauteur));
+    return hauteur > 0;
+}
+
+t_bmp8 *transform_bmp8(const t_bmp8 *src, t_transform op, int threads, t_bmp_status *status) {
+    if (src == NULL || src->data == NULL || src->width == 0 || src->height == 0 ||
+        src->width > INT32_MAX || src->height > INT32_MAX || !transformation_valide(op)) {
+        bmp_setStatus(status, BMP_ERR_ARGUMENT);
+        return NULL;
+    }
+    bool echange = transform_swapsAxes(op);
+    t_bmp8 *dst = bmp8_allocateLike(src, echange ? src->height : src->width, echange ? src->width : src->height);
+    uint8_t **lignesSrc = lignes_bmp8(src);
+    uint8_t **lignesDst = dst != NULL ? lignes_bmp8(dst) : NULL;
+    if (dst == NULL || lignesSrc == NULL || lignesDst == NULL) {
+        bmp_setStatus(status, BMP_ERR_MEMORY);
+        bmp8_free(dst);
+        free(lignesSrc);
+        free(lignesDst);
+        return NULL;
+    }
+
+    t_bmp_status res = transformer(lignesDst, (const uint8_t **)lignesSrc, (int)src->width, (int)src->height, 1,
+                                   bas_en_haut(src) ? lignes_inversees(op) : op, threads);
+    free(lignesSrc);
+    free(lignesDst);
+    if (res != BMP_OK) {
+        bmp_setStatus(status, res);
+        bmp8_free(dst);
+        return NULL;
+    }
+    bmp_setStatus(status, BMP_OK);
+    return dst;
+}
+
+t_bmp_status transform_image(t_image *img, t_transform op, int threads) {
+    if (img == NULL || img->type == IMAGE_NONE || !transformation_valide(op)) {
+        return BMP_ERR_ARGUMENT;
+    }
+
+    t_bmp_status res;
+    if (!transform_swapsAxes(op)) {
+        // Miroirs et demi-tour : chaque paire de lignes est réécrite sur place
+        uint8_t **lignes;
+        int width, height, bpp;
+        if (img->type == IMAGE_BMP8) {
+            lignes = lignes_bmp8(img->bmp8);
+            width = (int)img->bmp8->width;
+            height = (int)img->bmp8->height;
+            bpp = 1;
+        } else {
+            lignes = malloc((size_t)img->bmp24->height * sizeof(uint8_t *));
+            width = img->bmp24->width;
+            height = img->bmp24->height;
+            bpp = (int)sizeof(t_pixel);
+            for (int y = 0; lignes != NULL && y < height; y++) {
+                lignes[y] = (uint8_t *)img->bmp24->data[y];
+            }
+        }
+        if (lignes == NULL) {
+            return BMP_ERR_MEMORY;
+        }
+        res = transformer(lignes, (const uint8_t **)lignes, width, height, bpp, op, threads);
+        free(lignes);
+        return res;
+    }
+
+    if (img->type == IMAGE_BMP8) {
+        t_bmp8 *nouvelle = transform_bmp8(img->bmp8, op, threads, &res);
+        if (nouvelle != NULL) {
+            bmp8_free(img->bmp8);
+            img->bmp8 = nouvelle;
+        }
+    } else {
+        t_bmp24 *nouvelle = transform_bmp24(img->bmp24, op, threads, &res);
+        if (nouvelle != NULL) {
+            bmp24_free(img->bmp24);
+            img->bmp24 = nouvelle;
+        }
+    }
+    return res;
+}
+
+int transform_parse(const char *name, t_transform *op) {
+    if (name == NULL) {
+        return -1;
+    }
+    for (int i = 0; i < NB_TRANSFORMATIONS; i++) {
+        if (strcmp(name, noms_transformations[i]) == 0) {
+            *op = (t_transform)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char *transform_name(t_transform op) {
+    return transformation_valide(op) ? noms_transformations[op] : "?";
+}
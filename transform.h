@@ -0,0 +1,47 @@
+/*
+* Fichier : transform.h
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Transformations géométriques sans perte des images 8 et 24/32 bits : rotations d'un quart,
+ *           d'un demi et de trois quarts de tour, miroirs, transpositions. Les quarts de tour parcourent
+ *           l'image par blocs de TRANSFORM_TILE x TRANSFORM_TILE pixels (noyau SIMD transpose), les miroirs
+ *           retournent les lignes (noyau reverse) ; le travail est réparti sur plusieurs threads.
+ */
+
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include "bmp_io.h"
+
+// Côté des blocs parcourus par les transpositions : deux blocs de 64 x 64 pixels tiennent dans le cache L1
+#define TRANSFORM_TILE 64
+
+// Sens donnés pour l'image affichée (première ligne en haut)
+typedef enum {
+    TRANSFORM_ROTATE90 = 0,     // rotate90   : quart de tour dans le sens horaire
+    TRANSFORM_ROTATE180,        // rotate180
+    TRANSFORM_ROTATE270,        // rotate270  : quart de tour dans le sens antihoraire
+    TRANSFORM_FLIP_H,           // fliph      : miroir gauche-droite
+    TRANSFORM_FLIP_V,           // flipv      : miroir haut-bas
+    TRANSFORM_TRANSPOSE,        // transpose  : symétrie par la diagonale haut-gauche / bas-droite
+    TRANSFORM_TRANSVERSE        // transverse : symétrie par l'autre diagonale
+} t_transform;
+
+// Vrai si la transformation échange largeur et hauteur
+int transform_swapsAxes(t_transform op);
+
+// Nouvelle image transformée, src étant inchangée. threads <= 0 : nombre de cœurs.
+// Renvoie NULL en cas d'échec, avec la cause dans *status (optionnel).
+t_bmp24 *transform_bmp24(const t_bmp24 *src, t_transform op, int threads, t_bmp_status *status);
+t_bmp8 *transform_bmp8(const t_bmp8 *src, t_transform op, int threads, t_bmp_status *status);
+
+// Transforme l'image de img : sur place pour les miroirs et le demi-tour, par une nouvelle image sinon
+// (img est alors inchangée en cas d'échec)
+t_bmp_status transform_image(t_image *img, t_transform op, int threads);
+
+// Transformation d'après son nom ("rotate90", "fliph", ...) ; renvoie 0 si succès, -1 sinon
+int transform_parse(const char *name, t_transform *op);
+
+// Nom d'une transformation
+const char *transform_name(t_transform op);
+
+#endif // TRANSFORM_H
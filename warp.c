@@ -0,0 +1,387 @@
+/*
+* Fichier : warp.c
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Implémente les déformations : inversion de la matrice, coordonnées source de chaque ligne de tuile
+ *           par un pas constant (une division par pixel pour une homographie), puis échantillonnage. Les pixels
+ *           dont les quatre voisins sont dans la source passent par le noyau SIMD warpBilinear, les autres
+ *           (bords, extérieur) par un chemin scalaire qui complète avec du noir.
+ */
+
+#include "warp.h"
+#include "kernels.h"
+#include "threadpool.h"
+#include "bmp_size.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#define PI 3.14159265358979323846
+
+// Unité des coordonnées en virgule fixe
+#define UN (1 << KERNEL_WARP_BITS)
+
+static const char *noms_echantillonnages[] = { "nearest", "bilinear" };
+
+// Travail partagé par les tuiles d'une déformation
+typedef struct {
+    const t_kernels *k;
+    const uint8_t *const *src;      // lignes source, de haut en bas
+    int srcWidth;
+    int srcHeight;
+    uint8_t *const *dst;            // lignes de sortie, de haut en bas
+    int dstWidth;
+    int dstHeight;
+    int bpp;
+    double inv[9];                  // sortie -> source, normalisée (inv[8] = 1 pour une affinité)
+    bool affine;
+    t_warp_sampling sampling;
+    int colonnes;                   // tuiles par ligne de tuiles
+} t_travail;
+
+void warp_affine(t_warp_matrix *m, double a, double b, double c, double d, double e, double f) {
+    m->m[0] = a; m->m[1] = b; m->m[2] = c;
+    m->m[3] = d; m->m[4] = e; m->m[5] = f;
+    m->m[6] = 0.0; m->m[7] = 0.0; m->m[8] = 1.0;
+}
+
+void warp_rotation(t_warp_matrix *m, double degrees, double cx, double cy) {
+    // Axe y vers le bas : un angle positif tourne dans le sens horaire à l'écran
+    double co = cos(degrees * PI / 180.0), si = sin(degrees * PI / 180.0);
+    warp_affine(m, co, -si, cx - co * cx + si * cy, si, co, cy - si * cx - co * cy);
+}
+
+int warp_invert(const t_warp_matrix *m, t_warp_matrix *inverse) {
+    const double *a = m->m;
+    double c0 = a[4] * a[8] - a[5] * a[7];
+    double c1 = a[5] * a[6] - a[3] * a[8];
+    double c2 = a[3] * a[7] - a[4] * a[6];
+    double det = a[0] * c0 + a[1] * c1 + a[2] * c2;
+    if (!isfinite(det) || fabs(det) < 1e-12) {
+        return -1;
+    }
+
+    // Comatrice transposée divisée par le déterminant
+    double r[9] = {
+        c0, a[2] * a[7] - a[1] * a[8], a[1] * a[5] - a[2] * a[4],
+        c1, a[0] * a[8] - a[2] * a[6], a[2] * a[3] - a[0] * a[5],
+        c2, a[1] * a[6] - a[0] * a[7], a[0] * a[4] - a[1] * a[3]
+    };
+    for (int i = 0; i < 9; i++) {
+        inverse->m[i] = r[i] / det;
+    }
+    return 0;
+}
+
+// Coordonnée source (en pixels, centre du pixel 0 en 0) en virgule fixe, bornée à [-1, max] : au-delà, tous
+// les voisins sont hors de la source et le résultat ne change plus (NaN est envoyé à l'extérieur)
+static int32_t en_virgule_fixe(double v, double max) {
+    v = v > -1.0 ? v : -1.0;
+    v = v < max ? v : max;
+    // Arrondi au plus proche par troncature d'une valeur positive (pas d'appel à lrint)
+    return (int32_t)((v + 1.0) * UN + 0.5) - UN;
+}
+
+// Coordonnées source des n pixels de la ligne y à partir de la colonne x0 : l'origine de la ligne est calculée
+// une fois, puis chaque pixel n'ajoute qu'un multiple du pas (colonne 0 de la matrice inverse)
+static void calculer_coordonnees(const t_travail *t, int x0, int y, int n, int32_t *coords) {
+    const double *m = t->inv;
+    double px = x0 + 0.5, py = y + 0.5;
+    double X = m[0] * px + m[1] * py + m[2];
+    double Y = m[3] * px + m[4] * py + m[5];
+    double maxX = t->srcWidth, maxY = t->srcHeight;
+
+    if (t->affine) {
+        for (int i = 0; i < n; i++) {
+            coords[2 * i] = en_virgule_fixe(X + i * m[0] - 0.5, maxX);
+            coords[2 * i + 1] = en_virgule_fixe(Y + i * m[3] - 0.5, maxY);
+        }
+        return;
+    }
+
+    double W = m[6] * px + m[7] * py + m[8];
+    for (int i = 0; i < n; i++) {
+        double w = W + i * m[6];
+        if (w > 0.0) {
+            coords[2 * i] = en_virgule_fixe((X + i * m[0]) / w - 0.5, maxX);
+            coords[2 * i + 1] = en_virgule_fixe((Y + i * m[3]) / w - 0.5, maxY);
+        } else {
+            // Point à l'infini ou derrière l'horizon : hors de la source
+            coords[2 * i] = -UN;
+            coords[2 * i + 1] = -UN;
+        }
+    }
+}
+
+// Partie entière d'une coordonnée en virgule fixe (>= -UN, donc sans décalage de valeur négative)
+static int partie_entiere(int32_t c) {
+    return ((c + UN) >> KERNEL_WARP_BITS) - 1;
+}
+
+// Pixel (x, y) de la source, ou NULL s'il est à l'extérieur
+static const uint8_t *pixel_source(const t_travail *t, int x, int y) {
+    if (x < 0 || y < 0 || x >= t->srcWidth || y >= t->srcHeight) {
+        return NULL;
+    }
+    return t->src[y] + (size_t)x * t->bpp;
+}
+
+// Interpolation bilinéaire d'un pixel dont des voisins peuvent manquer (comptés noirs) : même arithmétique
+// que warpBilinear
+static void echantillonner_bord(const t_travail *t, uint8_t *dst, int32_t cx, int32_t cy) {
+    // Coordonnée bornée à l'extérieur : aucun voisin n'a de poids dans la source
+    if (cx <= -UN || cy <= -UN || cx >= t->srcWidth * UN || cy >= t->srcHeight * UN) {
+        memset(dst, 0, (size_t)t->bpp);
+        return;
+    }
+    int x = partie_entiere(cx), y = partie_entiere(cy);
+    int fx = (cx + UN) & (UN - 1), fy = (cy + UN) & (UN - 1);
+    const uint8_t *p00 = pixel_source(t, x, y), *p01 = pixel_source(t, x + 1, y);
+    const uint8_t *p10 = pixel_source(t, x, y + 1), *p11 = pixel_source(t, x + 1, y + 1);
+    for (int c = 0; c < t->bpp; c++) {
+        int haut = (UN - fx) * (p00 != NULL ? p00[c] : 0) + fx * (p01 != NULL ? p01[c] : 0);
+        int bas = (UN - fx) * (p10 != NULL ? p10[c] : 0) + fx * (p11 != NULL ? p11[c] : 0);
+        dst[c] = (uint8_t)(((UN - fy) * haut + fy * bas + UN * UN / 2) >> (2 * KERNEL_WARP_BITS));
+    }
+}
+
+// Vrai si le noyau peut lire les pixels x à x + 2 des lignes y et y + 1
+static bool interieur(const t_travail *t, int32_t cx, int32_t cy) {
+    return cx >= 0 && cy >= 0 && (cx >> KERNEL_WARP_BITS) + 2 < t->srcWidth &&
+           (cy >> KERNEL_WARP_BITS) + 1 < t->srcHeight;
+}
+
+static void echantillonner_bilineaire(const t_travail *t, uint8_t *dst, const int32_t *coords, int n) {
+    int i = 0;
+    while (i < n) {
+        // Suite de pixels intérieurs, confiée au noyau d'un seul appel
+        int j = i;
+        while (j < n && interieur(t, coords[2 * j], coords[2 * j + 1])) {
+            j++;
+        }
+        if (j > i) {
+            t->k->warpBilinear(dst + (size_t)i * t->bpp, t->src, coords + 2 * i, (size_t)(j - i), t->bpp);
+            i = j;
+        }
+        while (i < n && !interieur(t, coords[2 * i], coords[2 * i + 1])) {
+            echantillonner_bord(t, dst + (size_t)i * t->bpp, coords[2 * i], coords[2 * i + 1]);
+            i++;
+        }
+    }
+}
+
+static void echantillonner_proche(const t_travail *t, uint8_t *dst, const int32_t *coords, int n) {
+    for (int i = 0; i < n; i++, dst += t->bpp) {
+        const uint8_t *p = pixel_source(t, partie_entiere(coords[2 * i] + UN / 2),
+                                        partie_entiere(coords[2 * i + 1] + UN / 2));
+        if (p == NULL) {
+            memset(dst, 0, (size_t)t->bpp);
+        } else if (t->bpp == 4) {
+            memcpy(dst, p, 4);
+        } else if (t->bpp == 3) {
+            memcpy(dst, p, 3);
+        } else {
+            *dst = *p;
+        }
+    }
+}
+
+// Tuiles [debut, fin) de la sortie, numérotées ligne par ligne
+static int deformer_tuiles(void *arg, int debut, int fin) {
+    const t_travail *t = arg;
+    int32_t *coords = malloc(2 * WARP_TILE * sizeof(int32_t));
+    if (coords == NULL) {
+        return BMP_ERR_MEMORY;
+    }
+
+    for (int tuile = debut; tuile < fin; tuile++) {
+        int x0 = (tuile % t->colonnes) * WARP_TILE;
+        int y0 = (tuile / t->colonnes) * WARP_TILE;
+        int n = t->dstWidth - x0 < WARP_TILE ? t->dstWidth - x0 : WARP_TILE;
+        int y1 = t->dstHeight - y0 < WARP_TILE ? t->dstHeight : y0 + WARP_TILE;
+        for (int y = y0; y < y1; y++) {
+            uint8_t *ligne = t->dst[y] + (size_t)x0 * t->bpp;
+            calculer_coordonnees(t, x0, y, n, coords);
+            if (t->sampling == WARP_BILINEAR) {
+                echantillonner_bilineaire(t, ligne, coords, n);
+            } else {
+                echantillonner_proche(t, ligne, coords, n);
+            }
+        }
+    }
+
+    free(coords);
+    return BMP_OK;
+}
+
+static bool echantillonnage_valide(t_warp_sampling sampling) {
+    return sampling == WARP_NEAREST || sampling == WARP_BILINEAR;
+}
+
+// Déformation de lignes d'octets entrelacés (bpp octets par pixel), rangées de haut en bas
+static t_bmp_status deformer(uint8_t *const *dst, int dstWidth, int dstHeight, const uint8_t *const *src,
+                             int srcWidth, int srcHeight, int bpp, const t_warp_matrix *m,
+                             t_warp_sampling sampling, int threads) {
+    t_travail t = { kernels_get(), src, srcWidth, srcHeight, dst, dstWidth, dstHeight, bpp, { 0 }, false,
+                    sampling, (dstWidth + WARP_TILE - 1) / WARP_TILE };
+    t_warp_matrix inverse;
+    if (warp_invert(m, &inverse) != 0) {
+        return BMP_ERR_ARGUMENT;
+    }
+    memcpy(t.inv, inverse.m, sizeof(t.inv));
+
+    // Affinité : la dernière ligne de l'inverse est (0, 0, k), ramenée à (0, 0, 1) pour éviter la division
+    if (t.inv[6] == 0.0 && t.inv[7] == 0.0) {
+        for (int i = 0; i < 6; i++) {
+            t.inv[i] /= t.inv[8];
+        }
+        t.inv[8] = 1.0;
+        t.affine = true;
+    }
+
+    size_t total;
+    if (!bmp_mulSize((size_t)dstWidth * bpp, (size_t)dstHeight, &total)) {
+        return BMP_ERR_TOO_LARGE;
+    }
+    threads = threadpool_threadsFor(threads, total);
+    int lignes = (dstHeight + WARP_TILE - 1) / WARP_TILE;
+    return (t_bmp_status)threadpool_split(threads, t.colonnes * lignes, deformer_tuiles, &t);
+}
+
+// Les coordonnées en virgule fixe doivent tenir sur 32 bits
+static bool taille_valide(int width, int height) {
+    return width > 0 && height > 0 && width < (INT32_MAX >> KERNEL_WARP_BITS) - 2 &&
+           height < (INT32_MAX >> KERNEL_WARP_BITS) - 2;
+}
+
+t_bmp24 *warp_bmp24(const t_bmp24 *src, int width, int height, const t_warp_matrix *m, t_warp_sampling sampling,
+                    int threads, t_bmp_status *status) {
+    if (src == NULL || src->data == NULL || m == NULL || !taille_valide(src->width, src->height) ||
+        !taille_valide(width, height) || !echantillonnage_valide(sampling)) {
+        bmp_setStatus(status, BMP_ERR_ARGUMENT);
+        return NULL;
+    }
+
+    t_bmp24 *dst = bmp24_allocate(width, height, src->colorDepth);
+    const uint8_t **lignesSrc = malloc((size_t)src->height * sizeof(uint8_t *));
+    uint8_t **lignesDst = malloc((size_t)height * sizeof(uint8_t *));
+    if (dst == NULL || lignesSrc == NULL || lignesDst == NULL) {
+        bmp_setStatus(status, BMP_ERR_MEMORY);
+        bmp24_free(dst);
+        free(lignesSrc);
+        free(lignesDst);
+        return NULL;
+    }
+    dst->header = src->header;
+    dst->header_info = src->header_info;
+    dst->header_info.width = width;
+    dst->header_info.height = src->header_info.height < 0 ? -height : height;
+
+    for (int y = 0; y < src->height; y++) {
+        lignesSrc[y] = (const uint8_t *)src->data[y];
+    }
+    for (int y = 0; y < height; y++) {
+        lignesDst[y] = (uint8_t *)dst->data[y];
+    }
+
+    // Tous les octets d'un t_pixel sont interpolés, alpha compris en mode 32 bits
+    t_bmp_status res = deformer(lignesDst, width, height, lignesSrc, src->width, src->height,
+                                (int)sizeof(t_pixel), m, sampling, threads);
+    free(lignesSrc);
+    free(lignesDst);
+    if (res != BMP_OK) {
+        bmp_setStatus(status, res);
+        bmp24_free(dst);
+        return NULL;
+    }
+    bmp_setStatus(status, BMP_OK);
+    return dst;
+}
+
+// Pointeurs des lignes d'une image 8 bits de haut en bas, quel que soit l'ordre du fichier
+static uint8_t **lignes_affichees(const t_bmp8 *img) {
+    uint8_t **lignes = malloc((size_t)img->height * sizeof(uint8_t *));
+    if (lignes != NULL) {
+        int32_t hauteur;
+        memcpy(&hauteur, img->header + 22, sizeof(hauteur));
+        size_t rowSize = img->dataSize / img->height;
+        for (unsigned int y = 0; y < img->height; y++) {
+            unsigned int rang = hauteur > 0 ? img->height - 1 - y : y;
+            lignes[y] = img->data + (size_t)rang * rowSize;
+        }
+    }
+    return lignes;
+}
+
+t_bmp8 *warp_bmp8(const t_bmp8 *src, int width, int height, const t_warp_matrix *m, t_warp_sampling sampling,
+                  int threads, t_bmp_status *status) {
+    if (src == NULL || src->data == NULL || m == NULL || src->width > INT32_MAX || src->height > INT32_MAX ||
+        !taille_valide((int)src->width, (int)src->height) || !taille_valide(width, height) ||
+        !echantillonnage_valide(sampling)) {
+        bmp_setStatus(status, BMP_ERR_ARGUMENT);
+        return NULL;
+    }
+
+    t_bmp8 *dst = bmp8_allocateLike(src, (unsigned int)width, (unsigned int)height);
+    uint8_t **lignesSrc = lignes_affichees(src);
+    uint8_t **lignesDst = dst != NULL ? lignes_affichees(dst) : NULL;
+    if (dst == NULL || lignesSrc == NULL || lignesDst == NULL) {
+        bmp_setStatus(status, dst == NULL ? BMP_ERR_TOO_LARGE : BMP_ERR_MEMORY);
+        bmp8_free(dst);
+        free(lignesSrc);
+        free(lignesDst);
+        return NULL;
+    }
+
+    t_bmp_status res = deformer(lignesDst, width, height, (const uint8_t **)lignesSrc, (int)src->width,
+                                (int)src->height, 1, m, sampling, threads);
+    free(lignesSrc);
+    free(lignesDst);
+    if (res != BMP_OK) {
+        bmp_setStatus(status, res);
+        bmp8_free(dst);
+        return NULL;
+    }
+    bmp_setStatus(status, BMP_OK);
+    return dst;
+}
+
+t_bmp_status warp_image(t_image *img, int width, int height, const t_warp_matrix *m, t_warp_sampling sampling,
+                        int threads) {
+    if (img == NULL || img->type == IMAGE_NONE) {
+        return BMP_ERR_ARGUMENT;
+    }
+
+    t_bmp_status res;
+    if (img->type == IMAGE_BMP8) {
+        t_bmp8 *nouvelle = warp_bmp8(img->bmp8, width, height, m, sampling, threads, &res);
+        if (nouvelle != NULL) {
+            bmp8_free(img->bmp8);
+            img->bmp8 = nouvelle;
+        }
+    } else {
+        t_bmp24 *nouvelle = warp_bmp24(img->bmp24, width, height, m, sampling, threads, &res);
+        if (nouvelle != NULL) {
+            bmp24_free(img->bmp24);
+            img->bmp24 = nouvelle;
+        }
+    }
+    return res;
+}
+
+int warp_parseSampling(const char *name, t_warp_sampling *sampling) {
+    if (name == NULL) {
+        return -1;
+    }
+    for (int i = 0; i < 2; i++) {
+        if (strcmp(name, noms_echantillonnages[i]) == 0) {
+            *sampling = (t_warp_sampling)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char *warp_samplingName(t_warp_sampling sampling) {
+    return echantillonnage_valide(sampling) ? noms_echantillonnages[sampling] : "?";
+}
@@ -0,0 +1,59 @@
+/*
+* Fichier : warp.h
+ * Auteur  : Thibault Michaud et Eloi Cheng
+ * Rôle    : Déformations géométriques des images 8 et 24/32 bits par une matrice 3 x 3 : affinités (rotation
+ *           d'un angle quelconque, redressement, changement d'échelle) et homographies (perspective).
+ *           Chaque pixel de sortie est cherché dans la source par la matrice inverse, les coordonnées étant
+ *           obtenues par un pas constant le long de chaque ligne ; l'échantillonnage (plus proche voisin ou
+ *           bilinéaire, noyau warpBilinear) est fait par tuiles de WARP_TILE x WARP_TILE pixels réparties
+ *           sur plusieurs threads. Les pixels qui tombent hors de la source sont noirs.
+ */
+
+#ifndef WARP_H
+#define WARP_H
+
+#include "bmp_io.h"
+
+// Côté des tuiles de sortie : les pixels source lus par une tuile restent proches en mémoire, même tournés
+#define WARP_TILE 64
+
+// Matrice 3 x 3 rangée ligne par ligne : (x', y', w') = M (x, y, 1), le point image étant (x' / w', y' / w').
+// Les coordonnées sont continues, (0, 0) étant le coin haut-gauche de l'image et (largeur, hauteur) le coin
+// bas-droite ; une affinité a pour dernière ligne (0, 0, 1).
+typedef struct {
+    double m[9];
+} t_warp_matrix;
+
+typedef enum {
+    WARP_NEAREST = 0,       // nearest  : plus proche voisin
+    WARP_BILINEAR           // bilinear : interpolation bilinéaire (1/128 de pixel)
+} t_warp_sampling;
+
+// Affinité x' = a x + b y + c, y' = d x + e y + f
+void warp_affine(t_warp_matrix *m, double a, double b, double c, double d, double e, double f);
+
+// Rotation de degrees degrés dans le sens horaire (image affichée) autour du point (cx, cy)
+void warp_rotation(t_warp_matrix *m, double degrees, double cx, double cy);
+
+// Inverse de m ; renvoie 0 si succès, -1 si la matrice n'est pas inversible
+int warp_invert(const t_warp_matrix *m, t_warp_matrix *inverse);
+
+// Nouvelle image de width x height pixels : le pixel source (x, y) est envoyé en M (x, y), src étant
+// inchangée. threads <= 0 : nombre de cœurs. Renvoie NULL en cas d'échec (BMP_ERR_ARGUMENT si la matrice
+// n'est pas inversible), avec la cause dans *status (optionnel).
+t_bmp24 *warp_bmp24(const t_bmp24 *src, int width, int height, const t_warp_matrix *m, t_warp_sampling sampling,
+                    int threads, t_bmp_status *status);
+t_bmp8 *warp_bmp8(const t_bmp8 *src, int width, int height, const t_warp_matrix *m, t_warp_sampling sampling,
+                  int threads, t_bmp_status *status);
+
+// Remplace l'image de img par sa version déformée (même type) ; img est inchangée en cas d'échec
+t_bmp_status warp_image(t_image *img, int width, int height, const t_warp_matrix *m, t_warp_sampling sampling,
+                        int threads);
+
+// Échantillonnage d'après son nom ("nearest", "bilinear") ; renvoie 0 si succès, -1 sinon
+int warp_parseSampling(const char *name, t_warp_sampling *sampling);
+
+// Nom d'un échantillonnage
+const char *warp_samplingName(t_warp_sampling sampling);
+
+#endif // WARP_H